@@ -371,7 +371,9 @@ static m64p_error write_configlist_file(void)
     config_section *curr_section;
     const char *configpath;
     char *filepath;
+    char *tmpfilepath;
     FILE *fPtr;
+    int write_error;
 
     /* get the full pathname to the config file and try to open it */
     configpath = ConfigGetUserConfigPath();
@@ -382,14 +384,23 @@ static m64p_error write_configlist_file(void)
     if (filepath == NULL)
         return M64ERR_NO_MEMORY;
 
-    fPtr = osal_file_open(filepath, "wb");
+    /* write to a temporary file first and replace the config file
+     * afterwards, so the config file is never partially written */
+    tmpfilepath = combinepath(configpath, MUPEN64PLUS_CFG_NAME ".tmp");
+    if (tmpfilepath == NULL)
+    {
+        free(filepath);
+        return M64ERR_NO_MEMORY;
+    }
+
+    fPtr = osal_file_open(tmpfilepath, "wb");
     if (fPtr == NULL)
     {
-        DebugMessage(M64MSG_ERROR, "Couldn't open configuration file '%s' for writing.", filepath);
+        DebugMessage(M64MSG_ERROR, "Couldn't open configuration file '%s' for writing.", tmpfilepath);
+        free(tmpfilepath);
         free(filepath);
         return M64ERR_FILES;
     }
-    free(filepath);
 
     /* write out header */
     fprintf(fPtr, "# Mupen64Plus Configuration File\n");
@@ -421,7 +432,27 @@ static m64p_error write_configlist_file(void)
         curr_section = curr_section->next;
     }
 
-    fclose(fPtr);
+    write_error = ferror(fPtr);
+    if (fclose(fPtr) != 0 || write_error)
+    {
+        DebugMessage(M64MSG_ERROR, "Couldn't write configuration file '%s'.", tmpfilepath);
+        remove(tmpfilepath);
+        free(tmpfilepath);
+        free(filepath);
+        return M64ERR_FILES;
+    }
+
+    if (osal_file_rename(tmpfilepath, filepath) != 0)
+    {
+        DebugMessage(M64MSG_ERROR, "Couldn't replace configuration file '%s'.", filepath);
+        remove(tmpfilepath);
+        free(tmpfilepath);
+        free(filepath);
+        return M64ERR_FILES;
+    }
+
+    free(tmpfilepath);
+    free(filepath);
     return M64ERR_SUCCESS;
 }
 
@@ -43,6 +43,7 @@
 #include "main/cheat.h"
 #include "main/eventloop.h"
 #include "main/main.h"
+#include "main/rewind.h"
 #include "main/rom.h"
 #include "main/savestates.h"
 #include "main/util.h"
@@ -50,6 +51,7 @@
 #include "main/workqueue.h"
 #include "main/screenshot.h"
 #include "main/netplay.h"
+#include "backends/plugins_compat/plugins_compat.h"
 #include "plugin/plugin.h"
 #include "vidext.h"
 
@@ -90,6 +92,7 @@ EXPORT m64p_error CALL CoreStartup(int APIVersion, const char *ConfigPath, const
     plugin_connect(M64PLUGIN_CORE, NULL);
 
     savestates_init();
+    netplay_init();
 
     /* next, start up the configuration handling code by loading and parsing the config file */
     if (ConfigInit(ConfigPath, DataPath) != M64ERR_SUCCESS)
@@ -111,7 +114,7 @@ EXPORT m64p_error CALL CoreStartup(int APIVersion, const char *ConfigPath, const
     /* The ROM database contains MD5 hashes, goodnames, and some game-specific parameters */
     romdatabase_open();
 
-    workqueue_init();
+    workqueue_init(ConfigGetParamInt(g_CoreConfig, "WorkqueueThreads"));
 
     l_CoreInit = 1;
     return M64ERR_SUCCESS;
@@ -127,6 +130,8 @@ EXPORT m64p_error CALL CoreShutdown(void)
     ConfigShutdown();
     workqueue_shutdown();
     savestates_deinit();
+    netplay_deinit();
+    rewind_deinit();
 
     /* if the calling code is using SDL, don't shut it down */
     if (!l_CallerUsingSDL)
@@ -232,6 +237,23 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
             if (ParamPtr == NULL || ParamInt < 1984 || ParamInt > 2048 || ParamInt % 4 != 0)
                 return M64ERR_INPUT_ASSERT;
             return open_pif((const unsigned char *) ParamPtr, ParamInt);
+        case M64CMD_REWIND_INIT:
+            if (g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            // ParamInt is the size of the rewind buffer in MiB,
+            // ParamPtr points to the amount of VIs between snapshots
+            if (ParamPtr == NULL || ParamInt <= 0 || ParamInt > 4096 || *(int*)ParamPtr <= 0)
+                return M64ERR_INPUT_ASSERT;
+            return rewind_init((size_t)ParamInt * 1024 * 1024, (unsigned int)*(int*)ParamPtr);
+        case M64CMD_REWIND_CLOSE:
+            if (g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            rewind_deinit();
+            return M64ERR_SUCCESS;
+        case M64CMD_REWIND_STEP_BACK:
+            if (!g_EmulatorRunning || netplay_is_init())
+                return M64ERR_INVALID_STATE;
+            return rewind_request_step_back();
         case M64CMD_ROM_GET_HEADER:
             if (!l_ROMOpen && !l_DiskOpen)
                 return M64ERR_INVALID_STATE;
@@ -301,10 +323,37 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
         case M64CMD_STATE_SAVE:
             if (!g_EmulatorRunning)
                 return M64ERR_INVALID_STATE;
-            if (ParamPtr != NULL && (ParamInt < 1 || ParamInt > 3))
+            if (ParamPtr != NULL && (ParamInt < 1 || ParamInt > 4))
                 return M64ERR_INPUT_INVALID;
             main_state_save(ParamInt, (char *) ParamPtr);
             return M64ERR_SUCCESS;
+        case M64CMD_STATE_GET_MEMORY_SIZE:
+            if (ParamPtr == NULL)
+                return M64ERR_INPUT_ASSERT;
+            *(int *)ParamPtr = (int)savestates_get_m64p_size();
+            return M64ERR_SUCCESS;
+        case M64CMD_STATE_SAVE_MEMORY:
+            if (!g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            if (ParamPtr == NULL || ParamInt <= 0)
+                return M64ERR_INPUT_ASSERT;
+            return savestates_save_memory(ParamPtr, (size_t)ParamInt);
+        case M64CMD_STATE_LOAD_MEMORY:
+            if (!g_EmulatorRunning || netplay_is_init())
+                return M64ERR_INVALID_STATE;
+            if (ParamPtr == NULL || ParamInt <= 0)
+                return M64ERR_INPUT_ASSERT;
+            return savestates_load_memory(ParamPtr, (size_t)ParamInt);
+        case M64CMD_INPUT_PLAYBACK:
+            if (ParamPtr != NULL && ParamInt <= 0)
+                return M64ERR_INPUT_INVALID;
+            return input_plugin_compat_set_playback((const uint32_t *) ParamPtr, (size_t)ParamInt);
+        case M64CMD_RDRAM_GET_HASH:
+            if (!g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            if (ParamPtr == NULL)
+                return M64ERR_INPUT_ASSERT;
+            return main_get_rdram_hash((uint64_t *) ParamPtr);
         case M64CMD_STATE_SET_SLOT:
             if (ParamInt < 0 || ParamInt > 9)
                 return M64ERR_INPUT_INVALID;
@@ -379,6 +428,14 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
                 return M64ERR_INCOMPATIBLE;
         case M64CMD_NETPLAY_CLOSE:
             return netplay_stop();
+        case M64CMD_NETPLAY_SET_ROLLBACK:
+            if (g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            return netplay_set_rollback(ParamInt);
+        case M64CMD_NETPLAY_GET_STATS:
+            if (ParamPtr == NULL)
+                return M64ERR_INPUT_INVALID;
+            return netplay_get_stats((m64p_netplay_stats*) ParamPtr);
         default:
             return M64ERR_INPUT_INVALID;
     }
@@ -463,4 +520,27 @@ EXPORT m64p_error CALL CoreGetRomSettings(m64p_rom_settings *RomSettings, int Ro
     return M64ERR_SUCCESS;
 }
 
+EXPORT m64p_error CALL CoreLookupRomSettings(m64p_rom_settings *RomSettings, int RomSettingsLength, const m64p_rom_header *RomHeader, const unsigned char *MD5Digest)
+{
+    int i;
+
+    if (!l_CoreInit)
+        return M64ERR_NOT_INIT;
+    if (RomSettings == NULL || RomHeader == NULL || MD5Digest == NULL)
+        return M64ERR_INPUT_ASSERT;
+    if (RomSettingsLength < (int)sizeof(m64p_rom_settings))
+        return M64ERR_INPUT_INVALID;
+
+    /* the rom database is read-only after CoreStartup(),
+     * so this doesn't need to be serialized */
+    memset(RomSettings, 0, sizeof(m64p_rom_settings));
+    rom_lookup_settings(RomSettings, RomHeader, MD5Digest);
+
+    for (i = 0; i < 16; i++)
+        sprintf(RomSettings->MD5 + i*2, "%02X", MD5Digest[i]);
+    RomSettings->MD5[32] = '\0';
+
+    return M64ERR_SUCCESS;
+}
+
 
@@ -133,6 +133,17 @@ typedef m64p_error (*ptr_CoreGetRomSettings)(m64p_rom_settings *, int, int, int)
 EXPORT m64p_error CALL CoreGetRomSettings(m64p_rom_settings *, int, int, int);
 #endif
 
+/* CoreLookupRomSettings()
+ *
+ * This function will retrieve the ROM settings from the mupen64plus INI file for
+ * the ROM image corresponding to the given big-endian ROM header and MD5 digest,
+ * the same way M64CMD_ROM_OPEN does, without opening the ROM image.
+ */
+typedef m64p_error (*ptr_CoreLookupRomSettings)(m64p_rom_settings *, int, const m64p_rom_header *, const unsigned char *);
+#if defined(M64P_CORE_PROTOTYPES)
+EXPORT m64p_error CALL CoreLookupRomSettings(m64p_rom_settings *, int, const m64p_rom_header *, const unsigned char *);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
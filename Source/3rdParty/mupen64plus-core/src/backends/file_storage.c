@@ -22,6 +22,15 @@
 #include "file_storage.h"
 
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef USE_SDL3
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_thread.h>
+#else
+#include <SDL.h>
+#include <SDL_thread.h>
+#endif
 
 #include "api/callbacks.h"
 #include "api/m64p_types.h"
@@ -30,12 +39,362 @@
 #include "main/util.h"
 #include "main/netplay.h"
 
+/* Saves are written back to disk by a flush thread, the emulation thread
+ * only copies the saved bytes into the cache and records the dirty range.
+ * Adjacent dirty ranges are coalesced and the whole storage is written to
+ * a temporary file which then replaces the storage file, so a crash never
+ * leaves a partially written save behind.
+ *
+ * l_cache_lock protects the cache list, the pending buffers and the dirty
+ * ranges and is only held for short copies. l_flush_lock is held while the
+ * caches are written to disk, changing the list requires both locks. */
+
+enum { FILE_STORAGE_MAX_RANGES = 16 };
+enum { FILE_STORAGE_FLUSH_INTERVAL = 1000 }; /* ms */
+
+struct file_storage_range
+{
+    size_t start;
+    size_t end;
+};
+
+struct file_storage_cache
+{
+    const char* filename;
+    size_t size;
+    /* copy of the storage data, updated on every save */
+    uint8_t* pending;
+    /* copy of the storage data which is written to disk */
+    uint8_t* image;
+    struct file_storage_range ranges[FILE_STORAGE_MAX_RANGES];
+    size_t ranges_count;
+    int needs_write;
+    int write_failed;
+    struct file_storage_cache* next;
+};
+
+static struct file_storage_cache* l_caches = NULL;
+static int l_flush_requested = 0;
+static int l_quit = 0;
+
+static SDL_Thread* l_flush_thread = NULL;
+#ifdef USE_SDL3
+static SDL_Mutex* l_cache_lock = NULL;
+static SDL_Mutex* l_flush_lock = NULL;
+static SDL_Condition* l_flush_cond = NULL;
+#else
+static SDL_mutex* l_cache_lock = NULL;
+static SDL_mutex* l_flush_lock = NULL;
+static SDL_cond* l_flush_cond = NULL;
+#endif
+
+static void signal_flush_thread(void)
+{
+#ifdef USE_SDL3
+    SDL_SignalCondition(l_flush_cond);
+#else
+    SDL_CondSignal(l_flush_cond);
+#endif
+}
+
+static void report_write_error(const char* filename, file_status_t err)
+{
+    switch(err)
+    {
+    case file_open_error:
+        DebugMessage(M64MSG_WARNING, "couldn't open storage file '%s' for writing", filename);
+        break;
+    case file_write_error:
+        DebugMessage(M64MSG_WARNING, "failed to write storage file '%s'", filename);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Adds [start, end) to the dirty ranges of the cache,
+ * must be called with l_cache_lock held */
+static void add_dirty_range(struct file_storage_cache* cache, size_t start, size_t end)
+{
+    struct file_storage_range* range;
+    size_t i, gap, best = 0, best_gap = SIZE_MAX;
+
+    /* merge with overlapping or adjacent ranges, the grown range
+     * may touch ranges which were already checked so start over */
+    for (i = 0; i < cache->ranges_count; ) {
+        range = &cache->ranges[i];
+        if (start <= range->end && range->start <= end) {
+            start = (range->start < start) ? range->start : start;
+            end = (range->end > end) ? range->end : end;
+            cache->ranges[i] = cache->ranges[--cache->ranges_count];
+            i = 0;
+        }
+        else {
+            ++i;
+        }
+    }
+
+    if (cache->ranges_count < FILE_STORAGE_MAX_RANGES) {
+        cache->ranges[cache->ranges_count].start = start;
+        cache->ranges[cache->ranges_count].end = end;
+        ++cache->ranges_count;
+        return;
+    }
+
+    /* out of ranges, grow the closest one */
+    for (i = 0; i < cache->ranges_count; ++i) {
+        range = &cache->ranges[i];
+        gap = (start > range->end) ? (start - range->end) : (range->start - end);
+        if (gap < best_gap) {
+            best_gap = gap;
+            best = i;
+        }
+    }
+
+    range = &cache->ranges[best];
+    range->start = (range->start < start) ? range->start : start;
+    range->end = (range->end > end) ? range->end : end;
+}
+
+/* Copies the dirty ranges into the image,
+ * must be called with l_cache_lock held */
+static void prepare_cache_write(struct file_storage_cache* cache)
+{
+    size_t i;
+
+    for (i = 0; i < cache->ranges_count; ++i) {
+        memcpy(cache->image + cache->ranges[i].start,
+               cache->pending + cache->ranges[i].start,
+               cache->ranges[i].end - cache->ranges[i].start);
+        cache->needs_write = 1;
+    }
+
+    cache->ranges_count = 0;
+}
+
+/* Writes the image to disk, must be called with l_flush_lock held */
+static void write_cache(struct file_storage_cache* cache)
+{
+    file_status_t err;
+
+    if (!cache->needs_write)
+        return;
+
+    err = replace_file(cache->filename, cache->image, cache->size);
+    if (err == file_ok) {
+        cache->needs_write = 0;
+        cache->write_failed = 0;
+        return;
+    }
+
+    /* keep needs_write set to retry on the next flush,
+     * but only report the first failure */
+    if (!cache->write_failed) {
+        cache->write_failed = 1;
+        report_write_error(cache->filename, err);
+    }
+}
+
+/* Writes all dirty caches to disk, must be called with l_flush_lock held */
+static void flush_caches(void)
+{
+    struct file_storage_cache* cache;
+    struct file_storage_cache* head;
+
+    SDL_LockMutex(l_cache_lock);
+    for (cache = l_caches; cache != NULL; cache = cache->next) {
+        prepare_cache_write(cache);
+    }
+    /* caches are only added in front and are only
+     * removed with l_flush_lock held, so the list
+     * from head onwards stays valid after unlocking */
+    head = l_caches;
+    SDL_UnlockMutex(l_cache_lock);
+
+    for (cache = head; cache != NULL; cache = cache->next) {
+        write_cache(cache);
+    }
+}
+
+static int flush_thread(void* data)
+{
+    SDL_LockMutex(l_cache_lock);
+    while (!l_quit)
+    {
+        if (!l_flush_requested) {
+#ifdef USE_SDL3
+            SDL_WaitConditionTimeout(l_flush_cond, l_cache_lock, FILE_STORAGE_FLUSH_INTERVAL);
+#else
+            SDL_CondWaitTimeout(l_flush_cond, l_cache_lock, FILE_STORAGE_FLUSH_INTERVAL);
+#endif
+        }
+
+        if (l_quit)
+            break;
+
+        l_flush_requested = 0;
+        SDL_UnlockMutex(l_cache_lock);
+
+        SDL_LockMutex(l_flush_lock);
+        flush_caches();
+        SDL_UnlockMutex(l_flush_lock);
+
+        SDL_LockMutex(l_cache_lock);
+    }
+    SDL_UnlockMutex(l_cache_lock);
+
+    return 0;
+}
+
+static void destroy_flush_objects(void)
+{
+    if (l_flush_cond != NULL) {
+#ifdef USE_SDL3
+        SDL_DestroyCondition(l_flush_cond);
+#else
+        SDL_DestroyCond(l_flush_cond);
+#endif
+    }
+    if (l_flush_lock != NULL) {
+        SDL_DestroyMutex(l_flush_lock);
+    }
+    if (l_cache_lock != NULL) {
+        SDL_DestroyMutex(l_cache_lock);
+    }
+
+    l_flush_cond = NULL;
+    l_flush_lock = NULL;
+    l_cache_lock = NULL;
+}
+
+static int start_flush_thread(void)
+{
+    l_cache_lock = SDL_CreateMutex();
+    l_flush_lock = SDL_CreateMutex();
+#ifdef USE_SDL3
+    l_flush_cond = SDL_CreateCondition();
+#else
+    l_flush_cond = SDL_CreateCond();
+#endif
+    if (l_cache_lock == NULL || l_flush_lock == NULL || l_flush_cond == NULL) {
+        destroy_flush_objects();
+        return -1;
+    }
+
+    l_quit = 0;
+    l_flush_requested = 0;
+
+    l_flush_thread = SDL_CreateThread(flush_thread, "m64pstorage", NULL);
+    if (l_flush_thread == NULL) {
+        DebugMessage(M64MSG_WARNING, "couldn't create storage flush thread: %s", SDL_GetError());
+        destroy_flush_objects();
+        return -1;
+    }
+
+    return 0;
+}
+
+static void stop_flush_thread(void)
+{
+    SDL_LockMutex(l_cache_lock);
+    l_quit = 1;
+    signal_flush_thread();
+    SDL_UnlockMutex(l_cache_lock);
+
+    SDL_WaitThread(l_flush_thread, NULL);
+    l_flush_thread = NULL;
+
+    destroy_flush_objects();
+}
+
+static int open_cache(struct file_storage* fstorage)
+{
+    struct file_storage_cache* cache;
+
+    if (l_flush_thread == NULL && start_flush_thread() != 0) {
+        return -1;
+    }
+
+    cache = malloc(sizeof(struct file_storage_cache));
+    if (cache == NULL) {
+        return -1;
+    }
+
+    cache->filename = fstorage->filename;
+    cache->size = fstorage->size;
+    cache->pending = malloc(cache->size);
+    cache->image = malloc(cache->size);
+    if (cache->pending == NULL || cache->image == NULL) {
+        free(cache->pending);
+        free(cache->image);
+        free(cache);
+        return -1;
+    }
+
+    /* the first write always contains the full storage content */
+    memcpy(cache->pending, fstorage->data, cache->size);
+    cache->ranges[0].start = 0;
+    cache->ranges[0].end = cache->size;
+    cache->ranges_count = 1;
+    cache->needs_write = 0;
+    cache->write_failed = 0;
+
+    SDL_LockMutex(l_cache_lock);
+    cache->next = l_caches;
+    l_caches = cache;
+    SDL_UnlockMutex(l_cache_lock);
+
+    fstorage->cache = cache;
+    return 0;
+}
+
+static void close_cache(struct file_storage_cache* cache)
+{
+    struct file_storage_cache** it;
+    int last;
+
+    SDL_LockMutex(l_flush_lock);
+    SDL_LockMutex(l_cache_lock);
+    for (it = &l_caches; *it != NULL; it = &(*it)->next) {
+        if (*it == cache) {
+            *it = cache->next;
+            break;
+        }
+    }
+    prepare_cache_write(cache);
+    last = (l_caches == NULL);
+    SDL_UnlockMutex(l_cache_lock);
+
+    write_cache(cache);
+    SDL_UnlockMutex(l_flush_lock);
+
+    free(cache->pending);
+    free(cache->image);
+    free(cache);
+
+    if (last) {
+        stop_flush_thread();
+    }
+}
+
+void file_storage_request_flush(void)
+{
+    if (l_flush_thread == NULL)
+        return;
+
+    SDL_LockMutex(l_cache_lock);
+    l_flush_requested = 1;
+    signal_flush_thread();
+    SDL_UnlockMutex(l_cache_lock);
+}
+
 int open_file_storage(struct file_storage* fstorage, size_t size, const char* filename)
 {
     /* ! Take ownership of filename ! */
     fstorage->filename = filename;
     fstorage->size = size;
     fstorage->first_access = 1;
+    fstorage->cache = NULL;
 
     /* allocate memory for holding data */
     fstorage->data = malloc(fstorage->size);
@@ -60,6 +419,7 @@ int open_rom_file_storage(struct file_storage* fstorage, const char* filename)
     fstorage->size = 0;
     fstorage->filename = NULL;
     fstorage->first_access = 1;
+    fstorage->cache = NULL;
 
     file_status_t err = load_file(filename, (void**)&fstorage->data, &fstorage->size);
 
@@ -73,6 +433,11 @@ int open_rom_file_storage(struct file_storage* fstorage, const char* filename)
 
 void close_file_storage(struct file_storage* fstorage)
 {
+    if (fstorage->cache != NULL) {
+        close_cache(fstorage->cache);
+        fstorage->cache = NULL;
+    }
+
     free((void*)fstorage->data);
     free((void*)fstorage->filename);
 }
@@ -90,7 +455,7 @@ static size_t file_storage_size(const void* storage)
     return fstorage->size;
 }
 
-static void file_storage_save(void* storage, size_t start, size_t size)
+static void file_storage_save_wt(void* storage, size_t start, size_t size)
 {
     if (netplay_is_init() && netplay_get_controller(0) == -1)
         return;
@@ -109,23 +474,38 @@ static void file_storage_save(void* storage, size_t start, size_t size)
         err = write_chunk_to_file(fstorage->filename, fstorage->data + start, size, start);
     }
 
-    switch(err)
-    {
-    case file_open_error:
-        DebugMessage(M64MSG_WARNING, "couldn't open storage file '%s' for writing", fstorage->filename);
-        break;
-    case file_write_error:
-        DebugMessage(M64MSG_WARNING, "failed to write storage file '%s'", fstorage->filename);
-        break;
-    default:
-        break;
+    report_write_error(fstorage->filename, err);
+}
+
+static void file_storage_save(void* storage, size_t start, size_t size)
+{
+    if (netplay_is_init() && netplay_get_controller(0) == -1)
+        return;
+
+    struct file_storage* fstorage = (struct file_storage*)storage;
+    struct file_storage_cache* cache;
+
+    /* fall back to writing through when the cache is unavailable */
+    if (fstorage->cache == NULL && open_cache(fstorage) != 0) {
+        file_storage_save_wt(storage, start, size);
+        return;
     }
+
+    cache = fstorage->cache;
+
+    SDL_LockMutex(l_cache_lock);
+    memcpy(cache->pending + start, fstorage->data + start, size);
+    add_dirty_range(cache, start, start + size);
+    SDL_UnlockMutex(l_cache_lock);
 }
 
 static void file_storage_parent_save(void* storage, size_t start, size_t size)
 {
-    struct file_storage* fstorage = (struct file_storage*)((struct file_storage*)storage)->filename;
-    file_storage_save(fstorage, start, size);
+    struct file_storage* sub = (struct file_storage*)storage;
+    struct file_storage* fstorage = (struct file_storage*)sub->filename;
+
+    /* start is relative to the subfile */
+    file_storage_save(fstorage, (size_t)(sub->data - fstorage->data) + start, size);
 }
 
 static void dummy_save(void* storage, size_t start, size_t size)
@@ -142,6 +522,16 @@ const struct storage_backend_interface g_ifile_storage =
 };
 
 
+/* writes through to disk on every save, for storages which
+ * are too large to keep an additional copy of in memory */
+const struct storage_backend_interface g_ifile_storage_wt =
+{
+    file_storage_data,
+    file_storage_size,
+    file_storage_save_wt
+};
+
+
 const struct storage_backend_interface g_ifile_storage_ro =
 {
     file_storage_data,
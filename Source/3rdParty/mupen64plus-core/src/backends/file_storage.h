@@ -25,12 +25,16 @@
 #include <stddef.h>
 #include <stdint.h>
 
+struct file_storage_cache;
+
 struct file_storage
 {
     uint8_t* data;
     size_t size;
     const char* filename;
     int first_access;
+    /* write-back cache, created on the first save */
+    struct file_storage_cache* cache;
 };
 
 
@@ -38,7 +42,11 @@ int open_file_storage(struct file_storage* storage, size_t size, const char* fil
 int open_rom_file_storage(struct file_storage* storage, const char* filename);
 void close_file_storage(struct file_storage* storage);
 
+/* asks the flush thread to write all pending saves to disk */
+void file_storage_request_flush(void);
+
 extern const struct storage_backend_interface g_ifile_storage;
+extern const struct storage_backend_interface g_ifile_storage_wt;
 extern const struct storage_backend_interface g_ifile_storage_ro;
 extern const struct storage_backend_interface g_isubfile_storage;
 
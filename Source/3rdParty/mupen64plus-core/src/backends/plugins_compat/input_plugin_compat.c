@@ -30,6 +30,7 @@
 #include "main/netplay.h"
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <api/m64p_plugin.h>
 #include <api/callbacks.h>
@@ -47,6 +48,18 @@ enum {
 enum { PAK_SWITCH_DELAY = 20 };
 enum { GB_CART_SWITCH_DELAY = 20 };
 
+/* input playback */
+static uint32_t* l_playback_values = NULL;
+static size_t l_playback_count = 0;
+static size_t l_playback_pos = 0;
+
+static void playback_input(BUTTONS* keys, size_t pos)
+{
+    keys->Value = (pos < l_playback_count)
+        ? l_playback_values[pos]
+        : 0;
+}
+
 static int is_button_released(uint32_t input, uint32_t last_input, uint32_t mask)
 {
     return ((input & mask) == 0)
@@ -80,6 +93,12 @@ static m64p_error input_plugin_get_input(void* opaque, uint32_t* input_)
 
             Controls[netplay_controller].Plugin = plugin;
             Controls[netplay_controller].Present = present;
+
+            /* the recorded input replaces the input of the local players,
+             * it is indexed by the event count so the input polled again
+             * after a rollback is the same as the input which was sent */
+            if (l_playback_values != NULL)
+                playback_input(&keys, netplay_get_event_count(cin_compat->control_id));
         }
         cin_compat->last_input = keys.Value; //disable pak switching for netplay
         cin_compat->last_pak_type = Controls[cin_compat->control_id].Plugin; //disable pak switching for netplay
@@ -90,6 +109,11 @@ static m64p_error input_plugin_get_input(void* opaque, uint32_t* input_)
         return M64ERR_SYSTEM_FAIL;
     }
 
+    /* replace input with the recorded input */
+    if (l_playback_values != NULL && !netplay_is_init()) {
+        playback_input(&keys, l_playback_pos++);
+    }
+
 
     /* has Controls[i].Plugin changed since last call */
     if (cin_compat->last_pak_type != Controls[cin_compat->control_id].Plugin) {
@@ -142,6 +166,26 @@ const struct controller_input_backend_interface
     input_plugin_get_input
 };
 
+m64p_error input_plugin_compat_set_playback(const uint32_t* values, size_t count)
+{
+    uint32_t* copy = NULL;
+
+    if (values != NULL && count > 0) {
+        copy = malloc(count * sizeof(*copy));
+        if (copy == NULL) {
+            return M64ERR_NO_MEMORY;
+        }
+        memcpy(copy, values, count * sizeof(*copy));
+    }
+
+    free(l_playback_values);
+    l_playback_values = copy;
+    l_playback_count = (copy != NULL) ? count : 0;
+    l_playback_pos = 0;
+
+    return M64ERR_SUCCESS;
+}
+
 
 static void input_plugin_rumble_exec(void* opaque, enum rumble_action action)
 {
@@ -27,6 +27,7 @@
 #include "backends/api/rumble_backend.h"
 #include "backends/api/joybus.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 /* Audio Out backend interface */
@@ -50,14 +51,19 @@ struct controller_input_compat
     unsigned int gb_switch_delay;
 
     unsigned int gb_cart_switch_enabled;
-
-    uint32_t netplay_count;
-    struct netplay_event* event_first;
 };
 
 extern const struct controller_input_backend_interface
     g_icontroller_input_backend_plugin_compat;
 
+/* replaces the input of the plugged controllers with the given
+ * values, every poll of a plugged controller uses the next value
+ * and once all values are used the buttons stay released.
+ * During netplay the value is chosen by the event count of the
+ * player instead, so polls repeated by a rollback use the same value.
+ * Passing NULL stops the playback. */
+m64p_error input_plugin_compat_set_playback(const uint32_t* values, size_t count);
+
 /* Rumble backend interface */
 
 extern const struct rumble_backend_interface
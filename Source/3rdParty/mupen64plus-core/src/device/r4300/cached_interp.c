@@ -703,10 +703,12 @@ static uint32_t update_invalid_addr(struct r4300_core* r4300, uint32_t addr)
 
     if ((addr & UINT32_C(0xc0000000)) == UINT32_C(0x80000000))
     {
-        if (invalid_code[addr>>12]) {
+        /* modified instructions are reset in both
+         * segments, see invalidate_cached_instruction */
+        if (invalid_code[addr>>12] == 1) {
             invalid_code[(addr^0x20000000)>>12] = 1;
         }
-        if (invalid_code[(addr^0x20000000)>>12]) {
+        if (invalid_code[(addr^0x20000000)>>12] == 1) {
             invalid_code[addr>>12] = 1;
         }
         return addr;
@@ -812,7 +814,7 @@ void cached_interp_init_block(struct r4300_core* r4300, uint32_t address)
     {
         uint32_t alt_addr = b->start ^ UINT32_C(0x20000000);
 
-        if (r4300->cached_interp.invalid_code[alt_addr>>12])
+        if (r4300->cached_interp.invalid_code[alt_addr>>12] == 1)
         {
             cached_interp_init_block(r4300, alt_addr);
         }
@@ -846,6 +848,15 @@ void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw,
 
     for (i = (func & 0xFFF) / 4, finished = 0; finished != 2; ++i)
     {
+        /* the following instructions are still decoded when
+         * only the modified instructions have been reset */
+        if (i > (func & 0xFFF) / 4 && i < length && !block_start_in_tlb
+         && r4300->cached_interp.invalid_code[block->start >> 12] != 1
+         && block->block[i].ops != cached_interp_NOTCOMPILED
+         && block->block[i].ops != cached_interp_NOTCOMPILED2) {
+            break;
+        }
+
         inst = block->block + i;
 
         /* set decoded instruction address */
@@ -909,8 +920,12 @@ void cached_interpreter_jump_to(struct r4300_core* r4300, uint32_t address)
         return;
     }
 
-    /* setup new block if invalid */
-    if (cinterp->invalid_code[address >> 12]) {
+    /* setup new block if invalid, when only instructions
+     * have been modified, they have already been reset */
+    if (cinterp->invalid_code[address >> 12] == 2) {
+        cinterp->invalid_code[address >> 12] = 0;
+    }
+    else if (cinterp->invalid_code[address >> 12]) {
         r4300->cached_interp.init_block(r4300, address);
     }
 
@@ -944,6 +959,42 @@ void free_blocks(struct cached_interp* cinterp)
     }
 }
 
+/* Resets the decoded instruction at the given KSEG0 or KSEG1 address in
+ * both segments, the instruction before it is reset as well because its
+ * decoding depends on the next instruction. The page is marked with 2 so
+ * the modification is still propagated to pages mapped by the TLB. */
+static void invalidate_cached_instruction(struct r4300_core* r4300, uint32_t addr)
+{
+    struct cached_interp* const cinterp = &r4300->cached_interp;
+    struct precomp_block* block;
+    size_t i, n;
+    int segment;
+
+    for (segment = 0; segment < 2; ++segment, addr ^= UINT32_C(0x20000000))
+    {
+        i = addr >> 12;
+        block = cinterp->blocks[i];
+
+        if (cinterp->invalid_code[i] == 1) {
+            continue;
+        }
+
+        if (block == NULL || block->block == NULL) {
+            cinterp->invalid_code[i] = 1;
+            continue;
+        }
+
+        n = (addr & 0xfff) / 4;
+        if (block->block[n].ops != cinterp->not_compiled) {
+            block->block[n].ops = cinterp->not_compiled;
+            if (n > 0) {
+                block->block[n - 1].ops = cinterp->not_compiled;
+            }
+            cinterp->invalid_code[i] = 2;
+        }
+    }
+}
+
 void invalidate_cached_code_hacktarux(struct r4300_core* r4300, uint32_t address, size_t size)
 {
     size_t i;
@@ -960,11 +1011,28 @@ void invalidate_cached_code_hacktarux(struct r4300_core* r4300, uint32_t address
         /* invalidate blocks (if necessary) */
         addr_max = address+size;
 
-        for(addr = address; addr < addr_max; addr += 4)
+        for(addr = address & ~UINT32_C(3); addr < addr_max; addr += 4)
         {
             i = (addr >> 12);
 
-            if (r4300->cached_interp.invalid_code[i] == 0)
+            /* the cached interpreter only re-decodes
+             * the modified instructions of a page */
+            if (r4300->emumode == EMUMODE_INTERPRETER
+             && (addr & UINT32_C(0xc0000000)) == UINT32_C(0x80000000))
+            {
+                if (r4300->cached_interp.invalid_code[i] == 1
+                 && r4300->cached_interp.invalid_code[i ^ 0x20000] == 1)
+                {
+                    /* go directly to next i */
+                    addr &= ~0xfff;
+                    addr |= 0xffc;
+                }
+                else
+                {
+                    invalidate_cached_instruction(r4300, addr);
+                }
+            }
+            else if (r4300->cached_interp.invalid_code[i] == 0)
             {
                 if (r4300->cached_interp.blocks[i] == NULL
                  || r4300->cached_interp.blocks[i]->block[(addr & 0xfff) / 4].ops != r4300->cached_interp.not_compiled)
@@ -140,7 +140,8 @@ enum r4300_cp0_registers
 
 
 
-enum { INTERRUPT_NODES_POOL_CAPACITY = 16 };
+enum { INTERRUPT_EVENTS_CAPACITY = 16 };
+enum { INTERRUPT_EVENT_TYPES = 32 };
 
 struct interrupt_event
 {
@@ -148,23 +149,15 @@ struct interrupt_event
     unsigned int count;
 };
 
-struct node
-{
-    struct interrupt_event data;
-    struct node *next;
-};
-
-struct pool
-{
-    struct node nodes [INTERRUPT_NODES_POOL_CAPACITY];
-    struct node* stack[INTERRUPT_NODES_POOL_CAPACITY];
-    size_t index;
-};
-
+/* events are sorted from the last to the first event,
+ * so the next event is at the end of the array */
 struct interrupt_queue
 {
-    struct pool pool;
-    struct node* first;
+    struct interrupt_event events[INTERRUPT_EVENTS_CAPACITY];
+    size_t size;
+    /* position of the first event of each type, -1 if there is none */
+    int slots[INTERRUPT_EVENT_TYPES];
+    unsigned char type_counts[INTERRUPT_EVENT_TYPES];
 };
 
 struct interrupt_handler
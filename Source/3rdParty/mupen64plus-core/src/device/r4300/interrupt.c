@@ -44,58 +44,149 @@
 #include "device/rcp/ai/ai_controller.h"
 #include "device/rcp/vi/vi_controller.h"
 #include "main/main.h"
+#include "main/netplay.h"
+#include "main/rewind.h"
 #include "main/savestates.h"
 
 
 /***************************************************************************
- * Pool of Single Linked List Nodes
+ * Interrupt Queue
  **************************************************************************/
 
-static struct node* alloc_node(struct pool* p);
-static void free_node(struct pool* p, struct node* node);
-static void clear_pool(struct pool* p);
+/* returns the slot of a single bit event type, -1 otherwise */
+static int event_slot(int type)
+{
+    static const int debruijn_slots[32] =
+    {
+        0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+    };
+    uint32_t bit = (uint32_t)type;
+
+    if (bit == 0 || (bit & (bit - 1)) != 0) {
+        return -1;
+    }
 
+    return debruijn_slots[(uint32_t)(bit * UINT32_C(0x077CB531)) >> 27];
+}
 
-/* node allocation/deallocation on a given pool */
-static struct node* alloc_node(struct pool* p)
+static void clear_queue(struct interrupt_queue* q)
 {
-    /* return NULL if pool is too small */
-    if (p->index >= INTERRUPT_NODES_POOL_CAPACITY) {
-        return NULL;
+    size_t i;
+
+    q->size = 0;
+
+    for (i = 0; i < INTERRUPT_EVENT_TYPES; ++i) {
+        q->slots[i] = -1;
+        q->type_counts[i] = 0;
     }
+}
 
-    return p->stack[p->index++];
+struct interrupt_event* first_event(const struct interrupt_queue* q)
+{
+    return (q->size != 0)
+        ? (struct interrupt_event*)&q->events[q->size - 1]
+        : NULL;
 }
 
-static void free_node(struct pool* p, struct node* node)
+/* inserts an event at the given position, a higher position is fired earlier */
+static int insert_event(struct interrupt_queue* q, size_t pos, int type, unsigned int count)
 {
-    if (p->index == 0 || node == NULL) {
-        return;
+    size_t i;
+    int slot;
+
+    if (q->size >= INTERRUPT_EVENTS_CAPACITY) {
+        return 0;
+    }
+
+    for (i = q->size; i > pos; --i)
+    {
+        q->events[i] = q->events[i - 1];
+
+        slot = event_slot(q->events[i].type);
+        if (slot >= 0 && q->slots[slot] == (int)(i - 1)) {
+            q->slots[slot] = (int)i;
+        }
     }
 
-    p->stack[--p->index] = node;
+    q->events[pos].type = type;
+    q->events[pos].count = count;
+    ++q->size;
+
+    slot = event_slot(type);
+    if (slot >= 0)
+    {
+        if (q->slots[slot] < (int)pos) {
+            q->slots[slot] = (int)pos;
+        }
+        ++q->type_counts[slot];
+    }
+
+    return 1;
 }
 
-/* release all nodes */
-static void clear_pool(struct pool* p)
+static void delete_event(struct interrupt_queue* q, size_t pos)
 {
     size_t i;
+    int type = q->events[pos].type;
+    int slot = event_slot(type);
+    int was_first = (slot >= 0 && q->slots[slot] == (int)pos);
+
+    for (i = pos; i + 1 < q->size; ++i)
+    {
+        q->events[i] = q->events[i + 1];
 
-    for (i = 0; i < INTERRUPT_NODES_POOL_CAPACITY; ++i) {
-        p->stack[i] = &p->nodes[i];
+        int moved_slot = event_slot(q->events[i].type);
+        if (moved_slot >= 0 && q->slots[moved_slot] == (int)(i + 1)) {
+            q->slots[moved_slot] = (int)i;
+        }
     }
 
-    p->index = 0;
-}
+    --q->size;
 
-/***************************************************************************
- * Interrupt Queue
- **************************************************************************/
+    if (slot < 0) {
+        return;
+    }
 
-static void clear_queue(struct interrupt_queue* q)
+    --q->type_counts[slot];
+
+    if (!was_first) {
+        return;
+    }
+
+    /* look for the next event of the same type */
+    q->slots[slot] = -1;
+    if (q->type_counts[slot] != 0)
+    {
+        for (i = pos; i > 0; --i)
+        {
+            if (q->events[i - 1].type == type)
+            {
+                q->slots[slot] = (int)(i - 1);
+                break;
+            }
+        }
+    }
+}
+
+/* returns the position of the first event of the given type, -1 otherwise */
+static int find_event(const struct interrupt_queue* q, int type)
 {
-    q->first = NULL;
-    clear_pool(&q->pool);
+    size_t i;
+    int slot = event_slot(type);
+
+    if (slot >= 0) {
+        return q->slots[slot];
+    }
+
+    for (i = q->size; i > 0; --i)
+    {
+        if (q->events[i - 1].type == type) {
+            return (int)(i - 1);
+        }
+    }
+
+    return -1;
 }
 
 static int before_event(const struct cp0* cp0, unsigned int evt1, unsigned int evt2, int type2)
@@ -134,8 +225,7 @@ void add_interrupt_event(struct cp0* cp0, int type, unsigned int delay)
 
 void add_interrupt_event_count(struct cp0* cp0, int type, unsigned int count)
 {
-    struct node* event;
-    struct node* e;
+    size_t pos;
     const uint32_t* cp0_regs = r4300_cp0_regs(cp0);
     unsigned int* cp0_next_interrupt = r4300_cp0_next_interrupt(cp0);
     int* cp0_cycle_count = r4300_cp0_cycle_count(cp0);
@@ -144,135 +234,80 @@ void add_interrupt_event_count(struct cp0* cp0, int type, unsigned int count)
         DebugMessage(M64MSG_WARNING, "two events of type 0x%x in interrupt queue", type);
     }
 
-    event = alloc_node(&cp0->q.pool);
-    if (event == NULL)
+    /* the new event goes after all events it doesn't fire before */
+    for (pos = cp0->q.size;
+        pos > 0 && !before_event(cp0, count, cp0->q.events[pos - 1].count, cp0->q.events[pos - 1].type);
+        --pos);
+
+    if (!insert_event(&cp0->q, pos, type, count))
     {
         DebugMessage(M64MSG_ERROR, "Failed to allocate node for new interrupt event");
         return;
     }
 
-    event->data.count = count;
-    event->data.type = type;
-
-    if (cp0->q.first == NULL)
-    {
-        cp0->q.first = event;
-        event->next = NULL;
-    }
-    else if (before_event(cp0, count, cp0->q.first->data.count, cp0->q.first->data.type))
-    {
-        event->next = cp0->q.first;
-        cp0->q.first = event;
-    }
-    else
-    {
-        for (e = cp0->q.first;
-            e->next != NULL &&
-            (!before_event(cp0, count, e->next->data.count, e->next->data.type));
-            e = e->next);
-
-        if (e->next == NULL)
-        {
-            e->next = event;
-            event->next = NULL;
-        }
-        else
-        {
-            for(; e->next != NULL && e->next->data.count == count; e = e->next);
-
-            event->next = e->next;
-            e->next = event;
-        }
-    }
-    *cp0_next_interrupt = cp0->q.first->data.count;
-    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - cp0->q.first->data.count;
+    *cp0_next_interrupt = first_event(&cp0->q)->count;
+    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - first_event(&cp0->q)->count;
 }
 
 void remove_interrupt_event(struct cp0* cp0)
 {
-    struct node* e;
+    const struct interrupt_event* e;
     const uint32_t* cp0_regs = r4300_cp0_regs(cp0);
     unsigned int* cp0_next_interrupt = r4300_cp0_next_interrupt(cp0);
     int* cp0_cycle_count = r4300_cp0_cycle_count(cp0);
 
-    e = cp0->q.first;
-    cp0->q.first = e->next;
-    free_node(&cp0->q.pool, e);
+    if (cp0->q.size != 0) {
+        delete_event(&cp0->q, cp0->q.size - 1);
+    }
+
+    e = first_event(&cp0->q);
 
-    *cp0_next_interrupt = (cp0->q.first != NULL)
-        ? cp0->q.first->data.count
+    *cp0_next_interrupt = (e != NULL)
+        ? e->count
         : 0;
 
-    *cp0_cycle_count = (cp0->q.first != NULL)
-        ? (cp0_regs[CP0_COUNT_REG] - cp0->q.first->data.count)
+    *cp0_cycle_count = (e != NULL)
+        ? (cp0_regs[CP0_COUNT_REG] - e->count)
         : 0;
 }
 
 unsigned int* get_event(const struct interrupt_queue* q, int type)
 {
-    struct node* e = q->first;
+    int pos = find_event(q, type);
 
-    if (e == NULL) {
-        return NULL;
-    }
-
-    if (e->data.type == type) {
-        return &e->data.count;
-    }
-
-    for (; e->next != NULL && e->next->data.type != type; e = e->next);
-
-    return (e->next != NULL)
-        ? &e->next->data.count
+    return (pos >= 0)
+        ? (unsigned int*)&q->events[pos].count
         : NULL;
 }
 
 int get_next_event_type(const struct interrupt_queue* q)
 {
-    return (q->first == NULL)
+    return (q->size == 0)
         ? 0
-        : q->first->data.type;
+        : first_event(q)->type;
 }
 
 void remove_event(struct interrupt_queue* q, int type)
 {
-    struct node* to_del;
-    struct node* e = q->first;
-
-    if (e == NULL) {
-        return;
-    }
+    int pos = find_event(q, type);
 
-    if (e->data.type == type)
-    {
-        q->first = e->next;
-        free_node(&q->pool, e);
-    }
-    else
-    {
-        for (; e->next != NULL && e->next->data.type != type; e = e->next);
-
-        if (e->next != NULL)
-        {
-            to_del = e->next;
-            e->next = to_del->next;
-            free_node(&q->pool, to_del);
-        }
+    if (pos >= 0) {
+        delete_event(q, (size_t)pos);
     }
 }
 
 void translate_event_queue(struct cp0* cp0, unsigned int base)
 {
-    struct node* e;
+    size_t i;
     uint32_t* cp0_regs = r4300_cp0_regs(cp0);
     int* cp0_cycle_count = r4300_cp0_cycle_count(cp0);
 
     remove_event(&cp0->q, COMPARE_INT);
     remove_event(&cp0->q, SPECIAL_INT);
 
-    for (e = cp0->q.first; e != NULL; e = e->next)
+    for (i = 0; i < cp0->q.size; ++i)
     {
-        e->data.count = (e->data.count - cp0_regs[CP0_COUNT_REG]) + base;
+        cp0->q.events[i].count = (cp0->q.events[i].count - cp0_regs[CP0_COUNT_REG]) + base;
     }
 
     cp0_regs[CP0_COUNT_REG] = base;
@@ -285,20 +320,21 @@ void translate_event_queue(struct cp0* cp0, unsigned int base)
     cp0_regs[CP0_COUNT_REG] -= cp0->count_per_op;
 
     /* Update next interrupt in case first event is COMPARE_INT */
-    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - cp0->q.first->data.count;
+    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - first_event(&cp0->q)->count;
 }
 
 int save_eventqueue_infos(const struct cp0* cp0, char *buf)
 {
     int len;
-    struct node* e;
+    size_t i;
 
     len = 0;
 
-    for (e = cp0->q.first; e != NULL; e = e->next)
+    /* events are saved from the first to the last event */
+    for (i = cp0->q.size; i > 0; --i)
     {
-        memcpy(buf + len    , &e->data.type , 4);
-        memcpy(buf + len + 4, &e->data.count, 4);
+        memcpy(buf + len    , &cp0->q.events[i - 1].type , 4);
+        memcpy(buf + len + 4, &cp0->q.events[i - 1].count, 4);
         len += 8;
     }
 
@@ -334,7 +370,6 @@ void init_interrupt(struct cp0* cp0)
 
 void r4300_check_interrupt(struct r4300_core* r4300, uint32_t cause_ip, int set_cause)
 {
-    struct node* event;
     uint32_t* cp0_regs = r4300_cp0_regs(&r4300->cp0);
     unsigned int* cp0_next_interrupt = r4300_cp0_next_interrupt(&r4300->cp0);
     int* cp0_cycle_count = r4300_cp0_cycle_count(&r4300->cp0);
@@ -351,29 +386,15 @@ void r4300_check_interrupt(struct r4300_core* r4300, uint32_t cause_ip, int set_
     }
     if (cp0_regs[CP0_STATUS_REG] & cp0_regs[CP0_CAUSE_REG] & UINT32_C(0xFF00))
     {
-        event = alloc_node(&r4300->cp0.q.pool);
-
-        if (event == NULL)
+        /* the check event fires before all other events */
+        if (!insert_event(&r4300->cp0.q, r4300->cp0.q.size, CHECK_INT, cp0_regs[CP0_COUNT_REG]))
         {
             DebugMessage(M64MSG_ERROR, "Failed to allocate node for new interrupt event");
             return;
         }
 
-        event->data.count = *cp0_next_interrupt = cp0_regs[CP0_COUNT_REG];
-        event->data.type = CHECK_INT;
+        *cp0_next_interrupt = cp0_regs[CP0_COUNT_REG];
         *cp0_cycle_count = 0;
-
-        if (r4300->cp0.q.first == NULL)
-        {
-            r4300->cp0.q.first = event;
-            event->next = NULL;
-        }
-        else
-        {
-            event->next = r4300->cp0.q.first;
-            r4300->cp0.q.first = event;
-
-        }
     }
 }
 
@@ -406,7 +427,7 @@ void compare_int_handler(void* opaque)
     cp0_regs[CP0_COUNT_REG] -= r4300->cp0.count_per_op;
 
     /* Update next interrupt in case first event is COMPARE_INT */
-    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - r4300->cp0.q.first->data.count;
+    *cp0_cycle_count = cp0_regs[CP0_COUNT_REG] - first_event(&r4300->cp0.q)->count;
 
     raise_maskable_interrupt(r4300, CP0_CAUSE_IP7);
 }
@@ -559,6 +580,24 @@ void gen_interrupt(struct r4300_core* r4300)
             return;
         }
 
+        if (savestates_get_memory_job() == savestates_job_load)
+        {
+            savestates_do_memory_job();
+            return;
+        }
+
+        if (rewind_get_job() == rewind_job_step_back)
+        {
+            if (rewind_step_back())
+                return;
+        }
+
+        if (netplay_rollback_get_job() == netplay_rollback_job_restore)
+        {
+            if (netplay_rollback_restore())
+                return;
+        }
+
         if (r4300->reset_hard_job)
         {
             call_interrupt_handler(&r4300->cp0, 11);
@@ -571,12 +610,12 @@ void gen_interrupt(struct r4300_core* r4300)
         uint32_t dest = r4300->skip_jump;
         r4300->skip_jump = 0;
 
-        *cp0_next_interrupt = (r4300->cp0.q.first != NULL)
-            ? r4300->cp0.q.first->data.count
+        *cp0_next_interrupt = (r4300->cp0.q.size != 0)
+            ? first_event(&r4300->cp0.q)->count
             : 0;
 
-        *cp0_cycle_count = (r4300->cp0.q.first != NULL)
-            ? (cp0_regs[CP0_COUNT_REG] - r4300->cp0.q.first->data.count)
+        *cp0_cycle_count = (r4300->cp0.q.size != 0)
+            ? (cp0_regs[CP0_COUNT_REG] - first_event(&r4300->cp0.q)->count)
             : 0;
 
         r4300->cp0.last_addr = dest;
@@ -584,7 +623,7 @@ void gen_interrupt(struct r4300_core* r4300)
         return;
     }
 
-    switch (r4300->cp0.q.first->data.type)
+    switch (first_event(&r4300->cp0.q)->type)
     {
         case VI_INT:
             call_interrupt_handler(&r4300->cp0, 0);
@@ -665,7 +704,7 @@ void gen_interrupt(struct r4300_core* r4300)
             break;
 
         default:
-            DebugMessage(M64MSG_ERROR, "Unknown interrupt queue event type %.8X.", r4300->cp0.q.first->data.type);
+            DebugMessage(M64MSG_ERROR, "Unknown interrupt queue event type %.8X.", first_event(&r4300->cp0.q)->type);
             remove_interrupt_event(&r4300->cp0);
             exception_general(r4300);
             break;
@@ -678,6 +717,22 @@ void gen_interrupt(struct r4300_core* r4300)
             savestates_save();
             return;
         }
+
+        if (savestates_get_memory_job() == savestates_job_save)
+        {
+            savestates_do_memory_job();
+            return;
+        }
+
+        if (rewind_get_job() == rewind_job_snapshot)
+        {
+            rewind_snapshot();
+        }
+
+        if (netplay_rollback_get_job() == netplay_rollback_job_snapshot)
+        {
+            netplay_rollback_snapshot();
+        }
     }
 }
 
@@ -26,6 +26,7 @@
 
 struct r4300_core;
 struct cp0;
+struct interrupt_event;
 struct interrupt_queue;
 
 void init_interrupt(struct cp0* cp0);
@@ -40,6 +41,7 @@ void remove_event(struct interrupt_queue* q, int type);
 void add_interrupt_event_count(struct cp0* cp0, int type, unsigned int count);
 void add_interrupt_event(struct cp0* cp0, int type, unsigned int delay);
 unsigned int* get_event(const struct interrupt_queue* q, int type);
+struct interrupt_event* first_event(const struct interrupt_queue* q);
 int get_next_event_type(const struct interrupt_queue* q);
 unsigned int add_random_interrupt_time(struct r4300_core* r4300);
 void remove_interrupt_event(struct cp0* cp0);
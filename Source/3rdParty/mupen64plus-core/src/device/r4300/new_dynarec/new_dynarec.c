@@ -29,11 +29,16 @@
 #define MAP_ANONYMOUS MAP_ANON
 #endif
 
+#define M64P_CORE_PROTOTYPES 1
 #include "new_dynarec.h"
 #include "api/m64p_types.h"
 #include "api/callbacks.h"
 #include "main/main.h"
 #include "main/rom.h"
+#include "main/util.h"
+#include "api/m64p_config.h"
+#include "osal/files.h"
+#include "osal/preproc.h"
 #include "device/memory/memory.h"
 #include "device/r4300/cached_interp.h"
 #include "device/r4300/cp0.h"
@@ -48,6 +53,10 @@
 #include <sys/mman.h>
 #endif
 
+#if defined(PROFILE)
+#include "main/profile.h"
+#endif
+
 #if defined(RECOMPILER_DEBUG) && !defined(RECOMP_DBG)
 void recomp_dbg_init(void);
 void recomp_dbg_cleanup(void);
@@ -214,6 +223,26 @@ struct ll_entry
   u_int length;
 };
 
+// The hash table maps virtual addresses to compiled code. Every address
+// hashes to a bucket of one cache line, lookups only probe the slots of
+// that bucket. A slot is only valid when its generation matches
+// ht_generation, so the whole table is cleared by a new generation.
+#define HT_BUCKETS 16384
+#define HT_WAYS 4
+
+struct ht_slot
+{
+  u_int vaddr;
+  u_int generation;
+  u_int offset; // from base_addr
+  u_int clean;  // jump_in entry
+};
+
+struct ht_bucket
+{
+  struct ht_slot slot[HT_WAYS];
+};
+
 /* linkage */
 void verify_code(void);
 void cc_interrupt(void);
@@ -290,10 +319,15 @@ static char *copy;
 static int expirep;
 static u_int dirty_entry_count;
 static u_int copy_size;
-static struct ll_entry* hash_table[65536][2];
+ALIGN(64, static struct ht_bucket hash_table[HT_BUCKETS]);
+static u_int ht_generation;
 static struct ll_entry *jump_in[4096];
 static struct ll_entry *jump_dirty[4096];
 static struct ll_entry *jump_out[4096];
+// One bit per word of every jump_in and jump_dirty page,
+// set when the list may contain an entry for the address
+static u_int jump_in_bits[4096][32];
+static u_int jump_dirty_bits[4096][32];
 static unsigned char restore_candidate[512];
 
 #if COUNT_NOTCOMPILEDS
@@ -1821,19 +1855,90 @@ static void add_stub(int type,intptr_t addr,intptr_t retaddr,int a,intptr_t b,in
   stubcount++;
 }
 
-static void remove_hash(u_int vaddr)
+static struct ht_bucket *ht_get_bucket(u_int vaddr)
 {
-  //DebugMessage(M64MSG_VERBOSE, "remove hash: %x",vaddr);
-  struct ll_entry **ht_bin=hash_table[(((vaddr)>>16)^vaddr)&0xFFFF];
-  if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) {
-    ht_bin[1]=NULL;
+  return &hash_table[((vaddr>>16)^(vaddr>>2))&(HT_BUCKETS-1)];
+}
+
+static struct ht_slot *ht_find(u_int vaddr)
+{
+  struct ht_bucket *bucket=ht_get_bucket(vaddr);
+  int n;
+  for(n=0;n<HT_WAYS;n++) {
+    if(bucket->slot[n].vaddr==vaddr&&bucket->slot[n].generation==ht_generation)
+      return &bucket->slot[n];
+  }
+  return NULL;
+}
+
+static void *ht_addr(struct ht_slot *slot)
+{
+  return (void *)((uintptr_t)base_addr+slot->offset);
+}
+
+static void *ht_addr_rx(struct ht_slot *slot)
+{
+  return (void *)((uintptr_t)base_addr_rx+slot->offset);
+}
+
+static void ht_set(struct ht_slot *slot,struct ll_entry *head)
+{
+  slot->vaddr=head->vaddr;
+  slot->generation=ht_generation;
+  slot->offset=(u_int)((uintptr_t)head->addr-(uintptr_t)base_addr);
+  slot->clean=head->addr==head->clean_addr;
+}
+
+// Insert as the first slot of the bucket,
+// the last slot is evicted when the bucket is full
+static void ht_insert(struct ll_entry *head)
+{
+  struct ht_bucket *bucket=ht_get_bucket(head->vaddr);
+  int n=HT_WAYS-1;
+  struct ht_slot *slot=ht_find(head->vaddr);
+  if(slot!=NULL) n=(int)(slot-bucket->slot);
+  for(;n>0;n--)
+    bucket->slot[n]=bucket->slot[n-1];
+  ht_set(&bucket->slot[0],head);
+}
+
+// Insert into a free slot without evicting existing
+// slots, as they are probably addresses that are
+// being accessed frequently
+static void ht_insert_free(struct ll_entry *head)
+{
+  struct ht_bucket *bucket=ht_get_bucket(head->vaddr);
+  int n;
+  for(n=0;n<HT_WAYS;n++) {
+    if(bucket->slot[n].generation!=ht_generation) {
+      ht_set(&bucket->slot[n],head);
+      return;
+    }
   }
-  if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
-    ht_bin[0]=ht_bin[1];
-    ht_bin[1]=NULL;
+}
+
+// Replace an existing slot, don't add new slots
+static void ht_replace(struct ll_entry *head)
+{
+  struct ht_slot *slot=ht_find(head->vaddr);
+  if(slot!=NULL) ht_set(slot,head);
+}
+
+static void ht_clear(void)
+{
+  if(++ht_generation==0) {
+    memset(hash_table,0,sizeof(hash_table));
+    ht_generation=1;
   }
 }
 
+static void remove_hash(u_int vaddr)
+{
+  //DebugMessage(M64MSG_VERBOSE, "remove hash: %x",vaddr);
+  struct ht_slot *slot=ht_find(vaddr);
+  if(slot!=NULL) slot->generation=0;
+}
+
 /**** Interpreted opcodes ****/
 #define UPDATE_COUNT_IN \
   struct r4300_core* r4300 = &g_dev.r4300; \
@@ -2367,6 +2472,34 @@ u_int verify_dirty(struct ll_entry * head)
     return 0;
 }
 
+static u_int *ll_bits(struct ll_entry **head)
+{
+  if(head>=jump_in&&head<(jump_in+4096)) return jump_in_bits[head-jump_in];
+  if(head>=jump_dirty&&head<(jump_dirty+4096)) return jump_dirty_bits[head-jump_dirty];
+  return NULL;
+}
+
+static int ll_bits_test(u_int *bits,u_int vaddr)
+{
+  return (bits[(vaddr>>7)&31]>>((vaddr>>2)&31))&1;
+}
+
+static void ll_bits_set(u_int *bits,u_int vaddr)
+{
+  bits[(vaddr>>7)&31]|=1<<((vaddr>>2)&31);
+}
+
+// Rebuild the bits of a list after entries have been removed
+static void ll_bits_update(struct ll_entry **head)
+{
+  u_int *bits=ll_bits(head);
+  struct ll_entry *cur;
+  if(bits==NULL) return;
+  memset(bits,0,32*sizeof(u_int));
+  for(cur=*head;cur!=NULL;cur=cur->next)
+    ll_bits_set(bits,cur->vaddr);
+}
+
 // Add virtual address mapping for 32-bit compiled block
 static struct ll_entry *ll_add_32(struct ll_entry **head,int vaddr,u_int reg32,void *addr,void *clean_addr,u_int start,void *copy,u_int length)
 {
@@ -2382,6 +2515,8 @@ static struct ll_entry *ll_add_32(struct ll_entry **head,int vaddr,u_int reg32,v
   new_entry->length=length;
   new_entry->next=*head;
   *head=new_entry;
+  u_int *bits=ll_bits(head);
+  if(bits!=NULL) ll_bits_set(bits,vaddr);
   return new_entry;
 }
 
@@ -2420,6 +2555,7 @@ static void ll_remove_matching_addrs(struct ll_entry **head,intptr_t addr,int sh
       cur=&((*cur)->next);
     }
   }
+  ll_bits_update(head);
 }
 
 // Remove all entries from linked list
@@ -2429,6 +2565,7 @@ static void ll_clear(struct ll_entry **head)
   struct ll_entry *next;
   if((cur=*head)) {
     *head=0;
+    ll_bits_update(head);
     while(cur) {
       if(cur->addr!=cur->clean_addr){ //jump_dirty
         assert(head>=jump_dirty&&head<(jump_dirty+4096));
@@ -2487,6 +2624,7 @@ static struct ll_entry *get_clean(struct r4300_core* r4300,u_int vaddr,u_int fla
   if(page>262143&&r4300->cp0.tlb.LUT_r[vaddr>>12]) page=(r4300->cp0.tlb.LUT_r[vaddr>>12]^0x80000000)>>12;
   if(page>2048) page=2048+(page&2047);
   struct ll_entry *head;
+  if(!ll_bits_test(jump_in_bits[page],vaddr)) return NULL;
   head=jump_in[page];
   while(head!=NULL) {
     if(head->vaddr==vaddr&&(head->reg32&flags)==0) {
@@ -2506,6 +2644,7 @@ static struct ll_entry *get_dirty(struct r4300_core* r4300,u_int vaddr,u_int fla
   if(vpage>262143&&r4300->cp0.tlb.LUT_r[vaddr>>12]) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
   if(vpage>2048) vpage=2048+(vpage&2047);
   struct ll_entry *head;
+  if(!ll_bits_test(jump_dirty_bits[vpage],vaddr)) return NULL;
   head=jump_dirty[vpage];
   while(head!=NULL) {
     if(head->vaddr==vaddr&&(head->reg32&flags)==0) {
@@ -2554,29 +2693,20 @@ void *dynamic_linker(void * src, u_int vaddr)
   }
 #endif
 
-  struct ll_entry **ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
-  if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[0]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
-  if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[1]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
+  struct ht_slot *slot=ht_find(vaddr);
+  if(slot!=NULL) return ht_addr_rx(slot);
 
 #ifdef DISABLE_BLOCK_LINKING
   head=get_clean(r4300,vaddr,~0);
   if(head!=NULL){
-    ht_bin[1]=ht_bin[0];
-    ht_bin[0]=head;
+    ht_insert(head);
     return (void*)(((intptr_t)head->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
   }
 #endif
 
   head=get_dirty(r4300,vaddr,~0);
   if(head!=NULL){
-    if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
-      ht_bin[0]=head; // Replace existing entry
-    }
-    else
-    {
-      ht_bin[1]=ht_bin[0];
-      ht_bin[0]=head;
-    }
+    ht_insert(head);
     return (void*)(((intptr_t)head->clean_addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
   }
 
@@ -2612,29 +2742,20 @@ void *dynamic_linker_ds(void * src, u_int vaddr)
   }
 #endif
 
-  struct ll_entry **ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
-  if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[0]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
-  if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[1]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
+  struct ht_slot *slot=ht_find(vaddr);
+  if(slot!=NULL) return ht_addr_rx(slot);
 
 #ifdef DISABLE_BLOCK_LINKING
   head=get_clean(r4300,vaddr,~0);
   if(head!=NULL){
-    ht_bin[1]=ht_bin[0];
-    ht_bin[0]=head;
+    ht_insert(head);
     return (void*)(((intptr_t)head->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
   }
 #endif
 
   head=get_dirty(r4300,vaddr,~0);
   if(head!=NULL){
-    if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
-      ht_bin[0]=head; // Replace existing entry
-    }
-    else
-    {
-      ht_bin[1]=ht_bin[0];
-      ht_bin[0]=head;
-    }
+    ht_insert(head);
     return (void*)(((intptr_t)head->clean_addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
   }
 
@@ -2648,34 +2769,231 @@ void *dynamic_linker_ds(void * src, u_int vaddr)
   return get_addr_ht(r4300->new_dynarec_hot_state.pcaddr);
 }
 
+/**** Code cache ****/
+
+// The code cache stores the entry points of the blocks which have been
+// compiled for a ROM, together with a hash of their source code.
+// When a block has to be compiled, blocks from the cache whose source
+// still matches RDRAM are compiled ahead of time in small batches,
+// so the code doesn't have to be recompiled while the game is running.
+#if !defined(RECOMP_DBG)
+
+#define CODE_CACHE_MAGIC 0x3143444E // NDC1
+#define CODE_CACHE_MAX_ENTRIES 32768
+#define CODE_CACHE_INDEX_SIZE (CODE_CACHE_MAX_ENTRIES*2)
+#define CODE_CACHE_BATCH 64
+
+struct code_cache_entry
+{
+  u_int vaddr;
+  u_int length;
+  u_int hash;
+};
+
+static struct code_cache_entry code_cache[CODE_CACHE_MAX_ENTRIES];
+static int code_cache_index[CODE_CACHE_INDEX_SIZE];
+static int code_cache_pending[CODE_CACHE_MAX_ENTRIES];
+static int code_cache_count;
+static int code_cache_pending_count;
+static int code_cache_pending_next;
+static int code_cache_precompiling;
+
+static u_int *code_cache_source(u_int vaddr,u_int length)
+{
+  u_int paddr=vaddr&0x1FFFFFFF;
+  if((vaddr>>29)!=4&&(vaddr>>29)!=5) return NULL; // KSEG0 and KSEG1 only
+  if(length==0||paddr+length>g_dev.rdram.dram_size) return NULL;
+  return (u_int *)((uintptr_t)g_dev.rdram.dram+paddr);
+}
+
+static u_int code_cache_hash(const u_int *source,u_int length)
+{
+  u_int hash=2166136261u;
+  u_int i;
+  for(i=0;i<length/4;i++)
+    hash=(hash^source[i])*16777619u;
+  return hash;
+}
+
+static int *code_cache_find(u_int vaddr)
+{
+  u_int i=((vaddr>>2)*2654435761u)&(CODE_CACHE_INDEX_SIZE-1);
+  while(code_cache_index[i]>=0&&code_cache[code_cache_index[i]].vaddr!=vaddr)
+    i=(i+1)&(CODE_CACHE_INDEX_SIZE-1);
+  return &code_cache_index[i];
+}
+
+static void code_cache_reset(void)
+{
+  memset(code_cache_index,-1,sizeof(code_cache_index));
+  code_cache_count=0;
+  code_cache_pending_count=0;
+  code_cache_pending_next=0;
+}
+
+// Schedules all blocks of the cache to be compiled ahead of time
+static void code_cache_rearm(void)
+{
+  int n;
+  for(n=0;n<code_cache_count;n++)
+    code_cache_pending[n]=n;
+  code_cache_pending_count=code_cache_count;
+  code_cache_pending_next=0;
+}
+
+// Called after a block has been compiled
+static void code_cache_record(u_int vaddr,u_int length)
+{
+  u_int *source=code_cache_source(vaddr,length);
+  int *index;
+  if(source==NULL) return;
+  index=code_cache_find(vaddr);
+  if(*index<0) {
+    if(code_cache_count==CODE_CACHE_MAX_ENTRIES) return;
+    *index=code_cache_count++;
+  }
+  code_cache[*index].vaddr=vaddr;
+  code_cache[*index].length=length;
+  code_cache[*index].hash=code_cache_hash(source,length);
+#if defined(PROFILE)
+  if(!code_cache_precompiling)
+    timed_counter_add(TIMED_COUNTER_CODE_CACHE_MISSES,1);
+#endif
+}
+
+// Compiles a batch of blocks from the cache whose source matches RDRAM,
+// blocks which don't match are kept for a later batch because the
+// game might not have loaded their code yet
+static void code_cache_precompile(void)
+{
+  struct r4300_core* r4300 = &g_dev.r4300;
+  int n;
+
+  if(code_cache_pending_count==0) return;
+
+#if defined(PROFILE)
+  timed_section_start(TIMED_SECTION_CODE_CACHE);
+#endif
+  code_cache_precompiling=1;
+  for(n=0;n<CODE_CACHE_BATCH&&code_cache_pending_count>0;n++)
+  {
+    if(code_cache_pending_next>=code_cache_pending_count) code_cache_pending_next=0;
+    struct code_cache_entry *entry=&code_cache[code_cache_pending[code_cache_pending_next]];
+    u_int *source=code_cache_source(entry->vaddr,entry->length);
+
+    if(get_clean(r4300,entry->vaddr,~0)==NULL&&get_dirty(r4300,entry->vaddr,~0)==NULL) {
+      if(source==NULL||code_cache_hash(source,entry->length)!=entry->hash) {
+        code_cache_pending_next++;
+        continue;
+      }
+      if(new_recompile_block(entry->vaddr)!=0) {
+        code_cache_pending_next++;
+        continue;
+      }
+#if defined(PROFILE)
+      timed_counter_add(TIMED_COUNTER_CODE_CACHE_HITS,1);
+#endif
+    }
+    code_cache_pending[code_cache_pending_next]=code_cache_pending[--code_cache_pending_count];
+  }
+  code_cache_precompiling=0;
+#if defined(PROFILE)
+  timed_section_end(TIMED_SECTION_CODE_CACHE);
+#endif
+}
+
+static char *code_cache_path(void)
+{
+  if(ROM_SETTINGS.MD5[0]=='\0') return NULL;
+  return formatstr("%s%s.ndc",ConfigGetUserCachePath(),ROM_SETTINGS.MD5);
+}
+
+static void code_cache_load(void)
+{
+  struct code_cache_entry entry;
+  u_int header[2];
+  char *path;
+  FILE *f;
+  u_int i;
+
+  code_cache_reset();
+
+  path=code_cache_path();
+  if(path==NULL) return;
+  f=osal_file_open(path,"rb");
+  free(path);
+  if(f==NULL) return;
+
+  if(fread(header,sizeof(header),1,f)==1&&header[0]==CODE_CACHE_MAGIC&&header[1]<=CODE_CACHE_MAX_ENTRIES) {
+    for(i=0;i<header[1]&&fread(&entry,sizeof(entry),1,f)==1;i++) {
+      if(code_cache_source(entry.vaddr,entry.length)==NULL) continue;
+      int *index=code_cache_find(entry.vaddr);
+      if(*index>=0) continue;
+      *index=code_cache_count;
+      code_cache[code_cache_count++]=entry;
+    }
+  }
+  fclose(f);
+
+  DebugMessage(M64MSG_VERBOSE, "Loaded %d blocks from the code cache", code_cache_count);
+  code_cache_rearm();
+}
+
+static void code_cache_save(void)
+{
+  u_int *data;
+  size_t size;
+  char *path;
+
+  if(code_cache_count==0) return;
+  path=code_cache_path();
+  if(path==NULL) return;
+
+  size=2*sizeof(u_int)+code_cache_count*sizeof(code_cache[0]);
+  data=malloc(size);
+  if(data==NULL) {
+    free(path);
+    return;
+  }
+  data[0]=CODE_CACHE_MAGIC;
+  data[1]=code_cache_count;
+  memcpy(data+2,code_cache,code_cache_count*sizeof(code_cache[0]));
+
+  // write to a temporary file and rename it over the cache,
+  // so a crash while writing won't leave a truncated cache behind
+  if(replace_file(path,data,size)!=file_ok)
+    DebugMessage(M64MSG_WARNING, "Failed to write code cache file '%s'", path);
+  free(data);
+  free(path);
+}
+#endif
+
 // Get address from virtual address
 // This is called from the recompiled JR/JALR instructions
 void *get_addr(u_int vaddr)
 {
   struct r4300_core* r4300 = &g_dev.r4300;
   struct ll_entry *head;
-  struct ll_entry **ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
 
   head=get_clean(r4300,vaddr,~0);
   if(head!=NULL){
-    ht_bin[1]=ht_bin[0];
-    ht_bin[0]=head;
+    ht_insert(head);
     return (void*)(((intptr_t)head->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
   }
 
   head=get_dirty(r4300,vaddr,~0);
   if(head!=NULL){
-    if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
-      ht_bin[0]=head; // Replace existing entry
-    }
-    else
-    {
-      ht_bin[1]=ht_bin[0];
-      ht_bin[0]=head;
-    }
+    ht_insert(head);
     return (void*)(((intptr_t)head->clean_addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
   }
 
+#if !defined(RECOMP_DBG)
+  // Execution continues at the returned address, so
+  // this is a safe point to compile blocks ahead of time
+  code_cache_precompile();
+  if(get_clean(r4300,vaddr,~0)!=NULL) return get_addr(vaddr);
+#endif
+
   int r=new_recompile_block(vaddr);
   if(r==0) return get_addr(vaddr);
   // Execute in unmapped page, generate pagefault execption
@@ -2689,41 +3007,27 @@ void *get_addr(u_int vaddr)
 // Look up address in hash table first
 void *get_addr_ht(u_int vaddr)
 {
-  struct ll_entry **ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
-  if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[0]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
-  if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[1]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
+  struct ht_slot *slot=ht_find(vaddr);
+  if(slot!=NULL) return ht_addr_rx(slot);
   return get_addr(vaddr);
 }
 
 void *get_addr_32(u_int vaddr,u_int flags)
 {
-  struct ll_entry **ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
-  if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[0]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
-  if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) return (void *)(((intptr_t)ht_bin[1]->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
+  struct ht_slot *slot=ht_find(vaddr);
+  if(slot!=NULL) return ht_addr_rx(slot);
 
   struct r4300_core* r4300 = &g_dev.r4300;
   struct ll_entry *head;
   head=get_clean(r4300,vaddr,flags);
   if(head!=NULL){
-    if(head->reg32==0) {
-      if(ht_bin[0]==NULL) {
-        ht_bin[0]=head;
-      }else if(ht_bin[1]==NULL) {
-        ht_bin[1]=head;
-      }
-    }
+    if(head->reg32==0) ht_insert_free(head);
     return (void*)(((intptr_t)head->addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
   }
 
   head=get_dirty(r4300,vaddr,flags);
   if(head!=NULL){
-     if(head->reg32==0) {
-      if(ht_bin[0]==NULL) {
-        ht_bin[0]=head;
-      }else if(ht_bin[1]==NULL) {
-        ht_bin[1]=head;
-      }
-     }
+    if(head->reg32==0) ht_insert_free(head);
     return (void*)(((intptr_t)head->clean_addr-(intptr_t)base_addr)+(intptr_t)base_addr_rx);
   }
 
@@ -2741,15 +3045,11 @@ void *get_addr_32(u_int vaddr,u_int flags)
 // but don't return addresses which are about to expire from the cache
 static void *check_addr(u_int vaddr)
 {
-  struct ll_entry **ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
+  struct ht_slot *slot=ht_find(vaddr);
 
-  if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
-    if((((uintptr_t)ht_bin[0]->addr-MAX_OUTPUT_BLOCK_SIZE-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
-      if(ht_bin[0]->addr==ht_bin[0]->clean_addr) return ht_bin[0]->addr; //jump_in
-  }
-  if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) {
-    if((((uintptr_t)ht_bin[1]->addr-MAX_OUTPUT_BLOCK_SIZE-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
-      if(ht_bin[1]->addr==ht_bin[1]->clean_addr) return ht_bin[1]->addr; //jump_in
+  if(slot!=NULL) {
+    if((((uintptr_t)ht_addr(slot)-MAX_OUTPUT_BLOCK_SIZE-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2)))
+      if(slot->clean) return ht_addr(slot); //jump_in
   }
 
   struct r4300_core* r4300 = &g_dev.r4300;
@@ -2758,22 +3058,12 @@ static void *check_addr(u_int vaddr)
   if(head!=NULL){
     if((((uintptr_t)head->addr-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
       // Update existing entry with current address
-      if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
-        ht_bin[0]=head;
-        return head->addr;
-      }
-      if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) {
-        ht_bin[1]=head;
+      if(slot!=NULL) {
+        ht_set(slot,head);
         return head->addr;
       }
       // Insert into hash table with low priority.
-      // Don't evict existing entries, as they are probably
-      // addresses that are being accessed frequently.
-      if(ht_bin[0]==NULL) {
-        ht_bin[0]=head;
-      }else if(ht_bin[1]==NULL) {
-        ht_bin[1]=head;
-      }
+      ht_insert_free(head);
       return head->addr;
     }
   }
@@ -2787,6 +3077,7 @@ static void invalidate_page(u_int page)
   struct ll_entry *next;
   head=jump_in[page];
   jump_in[page]=0;
+  ll_bits_update(jump_in+page);
   while(head!=NULL) {
     inv_debug("INVALIDATE: %x\n",head->vaddr);
     remove_hash(head->vaddr);
@@ -2893,6 +3184,7 @@ void invalidate_block(u_int block)
 static void invalidate_all_pages(void)
 {
   u_int page;
+  ht_clear();
   for(page=0;page<4096;page++)
     invalidate_page(page);
   for(page=0;page<1048576;page++)
@@ -2919,6 +3211,9 @@ static void invalidate_all_pages(void)
     if(page==0x80000) page=0xC0000;
   }
   tlb_speed_hacks();
+#if !defined(RECOMP_DBG)
+  code_cache_rearm();
+#endif
 }
 
 void invalidate_cached_code_new_dynarec(struct r4300_core* r4300, uint32_t address, size_t size)
@@ -2992,15 +3287,7 @@ void clean_blocks(u_int page)
               //DebugMessage(M64MSG_VERBOSE, "page=%x, addr=%x",page,head->vaddr);
               //assert(head->vaddr>>12==(page|0x80000));
               struct ll_entry *clean_head=ll_add_32(jump_in+ppage,head->vaddr,head->reg32,head->clean_addr,head->clean_addr,head->start,head->copy,head->length);
-              struct ll_entry **ht_bin=hash_table[((head->vaddr>>16)^head->vaddr)&0xFFFF];
-              if(!head->reg32) {
-                if(ht_bin[0]&&ht_bin[0]->vaddr==head->vaddr) {
-                  ht_bin[0]=clean_head; // Replace existing entry
-                }
-                if(ht_bin[1]&&ht_bin[1]->vaddr==head->vaddr) {
-                  ht_bin[1]=clean_head; // Replace existing entry
-                }
-              }
+              if(!head->reg32) ht_replace(clean_head); // Replace existing entry
             }
           }
         }
@@ -7084,7 +7371,7 @@ static void ujump_assemble(int i,struct regstat *i_regs)
   {
     int return_address=start+i*4+8;
     if(get_reg(branch_regs[i].regmap,31)>0)
-    if(i_regmap[temp]==PTEMP) emit_movimm((intptr_t)hash_table[((return_address>>16)^return_address)&0xFFFF],temp);
+    if(i_regmap[temp]==PTEMP) emit_movimm((intptr_t)ht_get_bucket(return_address),temp);
   }
   #endif
   ds_assemble(i+1,i_regs);
@@ -7117,12 +7404,12 @@ static void ujump_assemble(int i,struct regstat *i_regs)
         #ifdef REG_PREFETCH
         if(temp>=0)
         {
-          if(i_regmap[temp]!=PTEMP) emit_movimm((intptr_t)hash_table[((return_address>>16)^return_address)&0xFFFF],temp);
+          if(i_regmap[temp]!=PTEMP) emit_movimm((intptr_t)ht_get_bucket(return_address),temp);
         }
         #endif
         emit_movimm(return_address,rt); // PC into link register
         #ifdef IMM_PREFETCH
-        emit_prefetch(hash_table[((return_address>>16)^return_address)&0xFFFF]);
+        emit_prefetch(ht_get_bucket(return_address));
         #endif
       }
     }
@@ -7175,7 +7462,7 @@ static void rjump_assemble(int i,struct regstat *i_regs)
   {
     if((temp=get_reg(branch_regs[i].regmap,PTEMP))>=0) {
       int return_address=start+i*4+8;
-      if(i_regmap[temp]==PTEMP) emit_movimm((intptr_t)hash_table[((return_address>>16)^return_address)&0xFFFF],temp);
+      if(i_regmap[temp]==PTEMP) emit_movimm((intptr_t)ht_get_bucket(return_address),temp);
     }
   }
   #endif
@@ -7204,12 +7491,12 @@ static void rjump_assemble(int i,struct regstat *i_regs)
     #ifdef REG_PREFETCH
     if(temp>=0)
     {
-      if(i_regmap[temp]!=PTEMP) emit_movimm((intptr_t)hash_table[((return_address>>16)^return_address)&0xFFFF],temp);
+      if(i_regmap[temp]!=PTEMP) emit_movimm((intptr_t)ht_get_bucket(return_address),temp);
     }
     #endif
     emit_movimm(return_address,rt); // PC into link register
     #ifdef IMM_PREFETCH
-    emit_prefetch(hash_table[((return_address>>16)^return_address)&0xFFFF]);
+    emit_prefetch(ht_get_bucket(return_address));
     #endif
   }
   cc=get_reg(branch_regs[i].regmap,CCREG);
@@ -7726,7 +8013,7 @@ static void sjump_assemble(int i,struct regstat *i_regs)
         return_address=start+i*4+8;
         emit_movimm(return_address,rt); // PC into link register
         #ifdef IMM_PREFETCH
-        if(!nevertaken) emit_prefetch(hash_table[((return_address>>16)^return_address)&0xFFFF]);
+        if(!nevertaken) emit_prefetch(ht_get_bucket(return_address));
         #endif
       }
     }
@@ -8711,8 +8998,7 @@ void new_dynarec_init(void)
   int n;
   for(n=0x80000;n<0x80800;n++)
     g_dev.r4300.cached_interp.invalid_code[n]=1;
-  for(n=0;n<65536;n++)
-    hash_table[n][0]=hash_table[n][1]=NULL;
+  ht_clear();
   memset(g_dev.r4300.new_dynarec_hot_state.mini_ht,-1,sizeof(g_dev.r4300.new_dynarec_hot_state.mini_ht));
   memset(restore_candidate,0,sizeof(restore_candidate));
   copy_size=0;
@@ -8735,6 +9021,9 @@ void new_dynarec_init(void)
 
   tlb_speed_hacks();
   arch_init();
+#if !defined(RECOMP_DBG)
+  code_cache_load();
+#endif
 }
 
 void new_dynarec_cleanup(void)
@@ -8743,6 +9032,10 @@ void new_dynarec_cleanup(void)
   recomp_dbg_cleanup();
 #endif
 
+#if !defined(RECOMP_DBG)
+  code_cache_save();
+#endif
+
   int n;
   for(n=0;n<4096;n++) ll_clear(jump_in+n);
   for(n=0;n<4096;n++) ll_clear(jump_out+n);
@@ -11773,13 +12066,7 @@ int new_recompile_block(int addr)
           // replace it with the new address.
           // Don't add new entries.  We'll insert the
           // ones that actually get used in check_addr().
-          struct ll_entry **ht_bin=hash_table[((vaddr>>16)^vaddr)&0xFFFF];
-          if(ht_bin[0]&&ht_bin[0]->vaddr==vaddr) {
-            ht_bin[0]=head;
-          }
-          if(ht_bin[1]&&ht_bin[1]->vaddr==vaddr) {
-            ht_bin[1]=head;
-          }
+          ht_replace(head);
         }
         else
         {
@@ -11813,6 +12100,9 @@ int new_recompile_block(int addr)
   memcpy(copy,(char*)source,slen*4);
   u_int *ptr=(u_int*)copy;
   ptr[slen]=dirty_entry_count;
+#if !defined(RECOMP_DBG)
+  code_cache_record(start,slen*4);
+#endif
 
   #if NEW_DYNAREC >= NEW_DYNAREC_ARM
   intptr_t beginning_rx=((intptr_t)beginning-(intptr_t)base_addr)+(intptr_t)base_addr_rx;
@@ -11863,18 +12153,15 @@ int new_recompile_block(int addr)
         break;
       case 2:
         // Clear hash table
-        for(i=0;i<32;i++) {
-          struct ll_entry **ht_bin=hash_table[((expirep&2047)<<5)+i];
-          if(ht_bin[1]&&((((uintptr_t)ht_bin[1]->addr-(uintptr_t)base_addr)>>shift)==((base-(uintptr_t)base_addr)>>shift) ||
-             (((uintptr_t)ht_bin[1]->addr-(uintptr_t)base_addr-MAX_OUTPUT_BLOCK_SIZE)>>shift)==((base-(uintptr_t)base_addr)>>shift))) {
-            inv_debug("EXP: Remove hash %x -> %x\n",ht_bin[1]->vaddr,ht_bin[1]->addr);
-            ht_bin[1]=NULL;
-          }
-          if(ht_bin[0]&&((((uintptr_t)ht_bin[0]->addr-(uintptr_t)base_addr)>>shift)==((base-(uintptr_t)base_addr)>>shift) ||
-             (((uintptr_t)ht_bin[0]->addr-(uintptr_t)base_addr-MAX_OUTPUT_BLOCK_SIZE)>>shift)==((base-(uintptr_t)base_addr)>>shift))) {
-            inv_debug("EXP: Remove hash %x -> %x\n",ht_bin[0]->vaddr,ht_bin[0]->addr);
-            ht_bin[0]=ht_bin[1];
-            ht_bin[1]=NULL;
+        for(i=0;i<HT_BUCKETS/2048;i++) {
+          struct ht_bucket *bucket=&hash_table[(expirep&2047)*(HT_BUCKETS/2048)+i];
+          for(j=0;j<HT_WAYS;j++) {
+            struct ht_slot *slot=&bucket->slot[j];
+            if(slot->generation==ht_generation&&((slot->offset>>shift)==((base-(uintptr_t)base_addr)>>shift) ||
+               ((slot->offset-MAX_OUTPUT_BLOCK_SIZE)>>shift)==((base-(uintptr_t)base_addr)>>shift))) {
+              inv_debug("EXP: Remove hash %x -> %x\n",slot->vaddr,(intptr_t)ht_addr(slot));
+              slot->generation=0;
+            }
           }
         }
         break;
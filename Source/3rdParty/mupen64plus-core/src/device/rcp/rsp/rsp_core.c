@@ -368,7 +368,21 @@ void do_SP_Task(struct rsp_core* sp)
     uint32_t dp_bit_set = sp->mi->regs[MI_INTR_REG] & MI_INTR_DP;
 
     unprotect_framebuffers(&sp->dp->fb);
+#if defined(PROFILE)
+    /* task type of the OSTask header */
+    uint32_t task_type = sp->mem[0xfc0/4];
+    if (task_type == 1)
+        timed_section_start(TIMED_SECTION_GFX);
+    else if (task_type == 2)
+        timed_section_start(TIMED_SECTION_AUDIO);
+#endif
     uint32_t rsp_cycles = rsp.doRspCycles(sp->first_run) / 2;
+#if defined(PROFILE)
+    if (task_type == 1)
+        timed_section_end(TIMED_SECTION_GFX);
+    else if (task_type == 2)
+        timed_section_end(TIMED_SECTION_AUDIO);
+#endif
 
     if (sp->mi->regs[MI_INTR_REG] & MI_INTR_DP && !dp_bit_set)
     {
@@ -66,6 +66,31 @@ typedef struct cheat {
     struct list_head list;
 } cheat_t;
 
+/* the ENTRY_VI codes of the enabled cheats are compiled into a flat array
+ * of cheat_op, so applying them doesn't need to walk the cheat lists
+ * or decode the code types every VI
+ */
+enum cheat_op_type
+{
+    CHEAT_OP_WRITE_8BIT,
+    CHEAT_OP_WRITE_16BIT,
+    CHEAT_OP_EQUAL_8BIT,
+    CHEAT_OP_EQUAL_16BIT,
+    CHEAT_OP_NOT_EQUAL_8BIT,
+    CHEAT_OP_NOT_EQUAL_16BIT
+};
+
+struct cheat_op
+{
+    uint8_t type;
+    uint8_t gameshark;    /* only passes/writes while the GS button is active */
+    uint16_t value;
+    uint32_t offset;      /* RDRAM offset, already swapped with S8/S16 */
+    uint32_t address;     /* address for invalidate_r4300_cached_code */
+    uint32_t skip;        /* conditionals: amount of ops to skip when false */
+    uint32_t* old_value;  /* NULL when the old value isn't saved */
+};
+
 /* private functions */
 static uint16_t read_address_16bit(struct r4300_core* r4300, uint32_t address)
 {
@@ -194,12 +219,230 @@ static cheat_t *find_or_create_cheat(struct cheat_ctx* ctx, const char *name)
     return cheat;
 }
 
+static int add_cheat_op(struct cheat_ctx* ctx, uint8_t type, uint8_t gameshark,
+                        uint32_t address, uint32_t value, uint32_t* old_value)
+{
+    struct cheat_op* op;
+
+    if (ctx->program_size == ctx->program_capacity)
+    {
+        size_t capacity = (ctx->program_capacity == 0) ? 64 : ctx->program_capacity * 2;
+        struct cheat_op* program = realloc(ctx->program, capacity * sizeof(*program));
+        if (program == NULL)
+            return 0;
+
+        ctx->program = program;
+        ctx->program_capacity = capacity;
+    }
+
+    op = &ctx->program[ctx->program_size++];
+    op->type = type;
+    op->gameshark = gameshark;
+    op->value = (uint16_t)value;
+    op->skip = 0;
+    op->old_value = old_value;
+
+    switch (type)
+    {
+    case CHEAT_OP_WRITE_16BIT:
+    case CHEAT_OP_EQUAL_16BIT:
+    case CHEAT_OP_NOT_EQUAL_16BIT:
+        op->offset = (address & 0xFFFFFF)^S16;
+        /* mask out bit 24 which is used by GS codes to specify 8/16 bits */
+        op->address = address & 0xfeffffff;
+        break;
+    default:
+        op->offset = (address & 0xFFFFFF)^S8;
+        op->address = address;
+        break;
+    }
+
+    return 1;
+}
+
+/* compiles a single ENTRY_VI code, returns 0 when the program couldn't be grown */
+static int compile_cheat_code(struct cheat_ctx* ctx, cheat_code_t* code)
+{
+    switch (code->address & 0xFF000000)
+    {
+    /* normal cheat codes */
+    case 0x80000000:
+    case 0xA0000000:
+        return add_cheat_op(ctx, CHEAT_OP_WRITE_8BIT, 0, code->address, code->value, &code->old_value);
+    case 0x81000000:
+    case 0xA1000000:
+        return add_cheat_op(ctx, CHEAT_OP_WRITE_16BIT, 0, code->address, code->value, &code->old_value);
+    /* GS button triggers cheat code */
+    case 0x88000000:
+    case 0xA8000000:
+        return add_cheat_op(ctx, CHEAT_OP_WRITE_8BIT, 1, code->address, code->value, NULL);
+    case 0x89000000:
+    case 0xA9000000:
+        return add_cheat_op(ctx, CHEAT_OP_WRITE_16BIT, 1, code->address, code->value, NULL);
+    /* conditional cheat codes */
+    case 0xD0000000:
+    case 0xD8000000:
+        return add_cheat_op(ctx, CHEAT_OP_EQUAL_8BIT, (code->address & 0x08000000) != 0,
+                            code->address, code->value, NULL);
+    case 0xD1000000:
+    case 0xD9000000:
+        return add_cheat_op(ctx, CHEAT_OP_EQUAL_16BIT, (code->address & 0x08000000) != 0,
+                            code->address, code->value, NULL);
+    case 0xD2000000:
+    case 0xDB000000:
+        return add_cheat_op(ctx, CHEAT_OP_NOT_EQUAL_8BIT, (code->address & 0x08000000) != 0,
+                            code->address, code->value, NULL);
+    case 0xD3000000:
+    case 0xDA000000:
+        return add_cheat_op(ctx, CHEAT_OP_NOT_EQUAL_16BIT, (code->address & 0x08000000) != 0,
+                            code->address, code->value, NULL);
+    case 0xEE000000:
+        /* most likely, this doesnt do anything. */
+        return add_cheat_op(ctx, CHEAT_OP_WRITE_16BIT, 0, 0xF1000318, 0x0040, NULL) &&
+               add_cheat_op(ctx, CHEAT_OP_WRITE_16BIT, 0, 0xF100031A, 0x0000, NULL);
+    /* boot-time and unknown cheat codes don't run at ENTRY_VI */
+    default:
+        return 1;
+    }
+}
+
+static void compile_cheats(struct cheat_ctx* ctx)
+{
+    cheat_t *cheat;
+    cheat_code_t *code;
+    size_t conditions_start, code_start, i;
+
+    ctx->program_size = 0;
+    ctx->program_dirty = 0;
+
+    list_for_each_entry_t(cheat, &ctx->active_cheats, cheat_t, list) {
+        if (!cheat->enabled)
+            continue;
+
+        /* a cheat starts without preconditions */
+        conditions_start = ctx->program_size;
+
+        list_for_each_entry_t(code, &cheat->cheat_codes, cheat_code_t, list) {
+            code_start = ctx->program_size;
+
+            if (!compile_cheat_code(ctx, code))
+            {
+                DebugMessage(M64MSG_ERROR, "Failed to allocate memory for the compiled cheats");
+                ctx->program_size = 0;
+                return;
+            }
+
+            if ((code->address & 0xF0000000) != 0xD0000000)
+            {
+                /* when a precondition is false, skip past the
+                 * ops of this non-test code
+                 */
+                for (i = conditions_start; i < code_start; i++) {
+                    ctx->program[i].skip = (uint32_t)(ctx->program_size - i);
+                }
+                conditions_start = ctx->program_size;
+            }
+        }
+
+        /* preconditions at the end of a cheat don't guard anything */
+        for (i = conditions_start; i < ctx->program_size; i++) {
+            ctx->program[i].skip = (uint32_t)(ctx->program_size - i);
+        }
+    }
+}
+
+static void write_cheat_8bit(struct r4300_core* r4300, uint8_t* dram, const struct cheat_op* op)
+{
+    uint8_t* ptr = dram + op->offset;
+
+    /* if pointer to old value is valid and uninitialized, write current value to it */
+    if (op->old_value && (*op->old_value == CHEAT_CODE_MAGIC_VALUE)) {
+        *op->old_value = *ptr;
+    }
+
+    /* only invalidate cached code when the memory actually changes */
+    if (*ptr != (uint8_t)op->value) {
+        *ptr = (uint8_t)op->value;
+        invalidate_r4300_cached_code(r4300, op->address, 1);
+    }
+}
+
+static void write_cheat_16bit(struct r4300_core* r4300, uint8_t* dram, const struct cheat_op* op)
+{
+    uint16_t* ptr = (uint16_t*)(dram + op->offset);
+
+    /* if pointer to old value is valid and uninitialized, write current value to it */
+    if (op->old_value && (*op->old_value == CHEAT_CODE_MAGIC_VALUE)) {
+        *op->old_value = *ptr;
+    }
+
+    /* only invalidate cached code when the memory actually changes */
+    if (*ptr != op->value) {
+        *ptr = op->value;
+        invalidate_r4300_cached_code(r4300, op->address, 2);
+    }
+}
+
+static void run_cheat_program(struct cheat_ctx* ctx, struct r4300_core* r4300)
+{
+    uint8_t* dram = (uint8_t*)r4300->rdram->dram;
+    const struct cheat_op* op = ctx->program;
+    const struct cheat_op* end = ctx->program + ctx->program_size;
+    int gameshark = event_gameshark_active();
+    int passed;
+
+    while (op < end)
+    {
+        switch (op->type)
+        {
+        case CHEAT_OP_WRITE_8BIT:
+            if (!op->gameshark || gameshark) {
+                write_cheat_8bit(r4300, dram, op);
+            }
+            op++;
+            continue;
+        case CHEAT_OP_WRITE_16BIT:
+            if (!op->gameshark || gameshark) {
+                write_cheat_16bit(r4300, dram, op);
+            }
+            op++;
+            continue;
+        case CHEAT_OP_EQUAL_8BIT:
+            passed = dram[op->offset] == (uint8_t)op->value;
+            break;
+        case CHEAT_OP_EQUAL_16BIT:
+            passed = *(uint16_t*)(dram + op->offset) == op->value;
+            break;
+        case CHEAT_OP_NOT_EQUAL_8BIT:
+            passed = dram[op->offset] != (uint8_t)op->value;
+            break;
+        case CHEAT_OP_NOT_EQUAL_16BIT:
+            passed = *(uint16_t*)(dram + op->offset) != op->value;
+            break;
+        default:
+            passed = 1;
+            break;
+        }
+
+        /* if code needs GS button pressed and it's not, the condition is false */
+        if (passed && (!op->gameshark || gameshark)) {
+            op++;
+        } else {
+            op += op->skip;
+        }
+    }
+}
+
 
 /* public functions */
 void cheat_init(struct cheat_ctx* ctx)
 {
     ctx->mutex = SDL_CreateMutex();
     INIT_LIST_HEAD(&ctx->active_cheats);
+    ctx->program = NULL;
+    ctx->program_size = 0;
+    ctx->program_capacity = 0;
+    ctx->program_dirty = 0;
 }
 
 void cheat_uninit(struct cheat_ctx* ctx)
@@ -208,13 +451,17 @@ void cheat_uninit(struct cheat_ctx* ctx)
         SDL_DestroyMutex(ctx->mutex);
     }
     ctx->mutex = NULL;
+
+    free(ctx->program);
+    ctx->program = NULL;
+    ctx->program_size = 0;
+    ctx->program_capacity = 0;
 }
 
 void cheat_apply_cheats(struct cheat_ctx* ctx, struct r4300_core* r4300, int entry)
 {
     cheat_t *cheat;
     cheat_code_t *code;
-    int cond_failed;
 
     if (list_empty(&ctx->active_cheats))
         return;
@@ -227,97 +474,54 @@ void cheat_apply_cheats(struct cheat_ctx* ctx, struct r4300_core* r4300, int ent
 
     SDL_LockMutex(ctx->mutex);
 
-    list_for_each_entry_t(cheat, &ctx->active_cheats, cheat_t, list) {
-        if (cheat->enabled)
-        {
-            cheat->was_enabled = 1;
-            switch(entry)
+    if (ctx->program_dirty)
+    {
+        list_for_each_entry_t(cheat, &ctx->active_cheats, cheat_t, list) {
+            if (cheat->enabled)
             {
-            case ENTRY_BOOT:
-                list_for_each_entry_t(code, &cheat->cheat_codes, cheat_code_t, list) {
-                    /* code should only be written once at boot time */
-                    if ((code->address & 0xF0000000) == 0xF0000000) {
-                        execute_cheat(r4300, code->address, code->value, &code->old_value);
-                    }
-                }
-                break;
-            case ENTRY_VI:
-                /* a cheat starts without failed preconditions */
-                cond_failed = 0;
-
-                list_for_each_entry_t(code, &cheat->cheat_codes, cheat_code_t, list) {
-                    /* conditional cheat codes */
-                    if ((code->address & 0xF0000000) == 0xD0000000)
-                    {
-                        /* if code needs GS button pressed and it's not, skip it */
-                        if (((code->address & 0xFF000000) == 0xD8000000 ||
-                                    (code->address & 0xFF000000) == 0xD9000000 ||
-                                    (code->address & 0xFF000000) == 0xDA000000 ||
-                                    (code->address & 0xFF000000) == 0xDB000000) &&
-                                !event_gameshark_active()) {
-                            /* if condition false, skip next code non-test code */
-                            cond_failed = 1;
-                        }
-
-                        /* if condition false, skip next code non-test code */
-                        if (!execute_cheat(r4300, code->address, code->value, NULL)) {
-                            cond_failed = 1;
-                        }
-                    }
-                    else {
-                        /* preconditions were false for this non-test code
-                         * reset the condition state and skip the cheat
-                         */
-                        if (cond_failed) {
-                            cond_failed = 0;
-                            continue;
-                        }
-
-                        switch (code->address & 0xFF000000) {
-                        /* GS button triggers cheat code */
-                        case 0x88000000:
-                        case 0x89000000:
-                        case 0xA8000000:
-                        case 0xA9000000:
-                            if (event_gameshark_active()) {
-                                execute_cheat(r4300, code->address, code->value, NULL);
-                            }
-                            break;
-                            /* normal cheat code */
-                        default:
-                            /* exclude boot-time cheat codes */
-                            if ((code->address & 0xF0000000) != 0xF0000000) {
-                                execute_cheat(r4300, code->address, code->value, &code->old_value);
-                            }
-                            break;
+                cheat->was_enabled = 1;
+            }
+            /* if cheat was enabled, but is now disabled, restore old memory values */
+            else if (cheat->was_enabled)
+            {
+                cheat->was_enabled = 0;
+                if (entry == ENTRY_VI)
+                {
+                    list_for_each_entry_t(code, &cheat->cheat_codes, cheat_code_t, list) {
+                        /* set memory back to old value and clear saved copy of old value */
+                        if(code->old_value != CHEAT_CODE_MAGIC_VALUE)
+                        {
+                            execute_cheat(r4300, code->address, code->old_value, NULL);
+                            code->old_value = CHEAT_CODE_MAGIC_VALUE;
                         }
                     }
                 }
-                break;
-            default:
-                break;
             }
         }
-        /* if cheat was enabled, but is now disabled, restore old memory values */
-        else if (cheat->was_enabled)
-        {
-            cheat->was_enabled = 0;
-            switch(entry)
-            {
-            case ENTRY_VI:
-                list_for_each_entry_t(code, &cheat->cheat_codes, cheat_code_t, list) {
-                    /* set memory back to old value and clear saved copy of old value */
-                    if(code->old_value != CHEAT_CODE_MAGIC_VALUE)
-                    {
-                        execute_cheat(r4300, code->address, code->old_value, NULL);
-                        code->old_value = CHEAT_CODE_MAGIC_VALUE;
-                    }
+
+        compile_cheats(ctx);
+    }
+
+    switch(entry)
+    {
+    case ENTRY_BOOT:
+        list_for_each_entry_t(cheat, &ctx->active_cheats, cheat_t, list) {
+            if (!cheat->enabled)
+                continue;
+
+            list_for_each_entry_t(code, &cheat->cheat_codes, cheat_code_t, list) {
+                /* code should only be written once at boot time */
+                if ((code->address & 0xF0000000) == 0xF0000000) {
+                    execute_cheat(r4300, code->address, code->value, &code->old_value);
                 }
-                break;
-            default:
-                break;
             }
         }
+        break;
+    case ENTRY_VI:
+        run_cheat_program(ctx, r4300);
+        break;
+    default:
+        break;
     }
 
     SDL_UnlockMutex(ctx->mutex);
@@ -351,6 +555,8 @@ void cheat_delete_all(struct cheat_ctx* ctx)
         free(cheat);
     }
 
+    ctx->program_dirty = 1;
+
     SDL_UnlockMutex(ctx->mutex);
 }
 
@@ -373,6 +579,7 @@ int cheat_set_enabled(struct cheat_ctx* ctx, const char* name, int enabled)
         if (strcmp(name, cheat->name) == 0)
         {
             cheat->enabled = enabled;
+            ctx->program_dirty = 1;
             SDL_UnlockMutex(ctx->mutex);
             return 1;
         }
@@ -439,6 +646,8 @@ int cheat_add_new(struct cheat_ctx* ctx, const char* name, m64p_cheat_code* code
         }
     }
 
+    ctx->program_dirty = 1;
+
     SDL_UnlockMutex(ctx->mutex);
     return 1;
 }
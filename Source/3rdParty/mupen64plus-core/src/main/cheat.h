@@ -26,6 +26,7 @@
 
 #include "list.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define ENTRY_BOOT 0
@@ -33,6 +34,7 @@
 
 struct SDL_mutex;
 struct r4300_core;
+struct cheat_op;
 
 struct cheat_ctx
 {
@@ -42,6 +44,11 @@ struct cheat_ctx
     struct SDL_mutex* mutex;
 #endif
     struct list_head active_cheats;
+    /* enabled cheats compiled for ENTRY_VI, rebuilt when the cheats change */
+    struct cheat_op* program;
+    size_t program_size;
+    size_t program_capacity;
+    int program_dirty;
 };
 
 void cheat_apply_cheats(struct cheat_ctx* ctx, struct r4300_core* r4300, int entry);
@@ -78,6 +78,7 @@
 #include "profile.h"
 #endif
 #include "rom.h"
+#include "rewind.h"
 #include "savestates.h"
 #include "screenshot.h"
 #include "util.h"
@@ -87,6 +88,9 @@
 #include "debugger/dbg_debugger.h"
 #endif
 
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
 #ifdef WITH_LIRC
 #include "lirc.h"
 #endif //WITH_LIRC
@@ -127,6 +131,8 @@ static int   l_TakeScreenshot = 0;       // Tell OSD Rendering callback to take
 static int   l_SpeedFactor = 100;        // percentage of nominal game speed at which emulator is running
 static int   l_FrameAdvance = 0;         // variable to check if we pause on next frame
 static int   l_MainSpeedLimit = 1;       // insert delay during vi_interrupt to keep speed at real-time
+static int   l_PacingError = 0;          // difference between the target and actual time of the last VI in microseconds
+static int   l_HostRefreshRate = 0;      // refresh rate of the host display in millihertz, 0 when unknown
 static int   l_CurrentVI = 0;
 static int   l_LastVITime = -1;
 
@@ -449,6 +455,7 @@ int main_set_core_defaults(void)
     ConfigSetDefaultInt(g_CoreConfig, "CountPerOpDenomPot", 0, "Reduce number of cycles per update by power of two when set greater than 0 (overclock)");
     ConfigSetDefaultBool(g_CoreConfig, "AutoStateSlotIncrement", 0, "Increment the save state slot after each save operation");
     ConfigSetDefaultInt(g_CoreConfig, "CurrentStateSlot", 0, "Save state slot (0-9) to use when saving/loading the emulator state");
+    ConfigSetDefaultInt(g_CoreConfig, "WorkqueueThreads", 2, "Number of threads used for background work such as compressing save states and writing screenshots");
     ConfigSetDefaultBool(g_CoreConfig, "EnableDebugger", 0, "Activate the R4300 debugger when ROM execution begins, if core was built with Debugger support");
     ConfigSetDefaultString(g_CoreConfig, "ScreenshotPath", "", "Path to directory where screenshots are saved. If this is blank, the default value of ${UserDataPath}/screenshot will be used");
     ConfigSetDefaultString(g_CoreConfig, "SaveStatePath", "", "Path to directory where emulator save states (snapshots) are saved. If this is blank, the default value of ${UserDataPath}/save will be used");
@@ -695,7 +702,7 @@ void main_state_save(int format, const char *filename)
         return;
 
     if (filename == NULL) // Save to slot
-        savestates_set_job(savestates_job_save, savestates_type_m64p, NULL);
+        savestates_set_job(savestates_job_save, (format == savestates_type_m64p_fast) ? savestates_type_m64p_fast : savestates_type_m64p, NULL);
     else // Save to file
         savestates_set_job(savestates_job_save, (savestates_type)format, filename);
 }
@@ -750,6 +757,14 @@ m64p_error main_core_state_query(m64p_core_param param, int *rval)
         case M64CORE_INPUT_GAMESHARK:
             *rval = event_gameshark_active();
             break;
+        case M64CORE_PACING_ERROR:
+            if (!g_EmulatorRunning)
+                return M64ERR_INVALID_STATE;
+            *rval = l_PacingError;
+            break;
+        case M64CORE_HOST_REFRESH_RATE:
+            *rval = l_HostRefreshRate;
+            break;
         // these are only used for callbacks; they cannot be queried or set
         case M64CORE_SCREENSHOT_CAPTURED:
         case M64CORE_STATE_LOADCOMPLETE:
@@ -847,6 +862,11 @@ m64p_error main_core_state_set(m64p_core_param param, int val)
                 return M64ERR_INVALID_STATE;
             event_set_gameshark(val);
             return M64ERR_SUCCESS;
+        case M64CORE_HOST_REFRESH_RATE:
+            if (val < 0)
+                return M64ERR_INPUT_INVALID;
+            l_HostRefreshRate = val;
+            return M64ERR_SUCCESS;
         // these are only used for callbacks; they cannot be queried or set
         case M64CORE_STATE_LOADCOMPLETE:
         case M64CORE_STATE_SAVECOMPLETE:
@@ -869,6 +889,12 @@ m64p_error main_read_screen(void *pixels, int bFront)
     return M64ERR_SUCCESS;
 }
 
+m64p_error main_get_rdram_hash(uint64_t *hash)
+{
+    *hash = XXH3_64bits(g_dev.rdram.dram, g_dev.rdram.dram_size);
+    return M64ERR_SUCCESS;
+}
+
 m64p_error main_volume_up(void)
 {
     int level = 0;
@@ -983,34 +1009,102 @@ void new_frame(void)
     }
 }
 
+/* returns a monotonic time in nanoseconds */
+static uint64_t get_time_ns(void)
+{
+#ifdef USE_SDL3
+    return SDL_GetTicksNS();
+#else
+    static uint64_t frequency = 0;
+    uint64_t counter = SDL_GetPerformanceCounter();
+
+    if (frequency == 0)
+        frequency = SDL_GetPerformanceFrequency();
+
+    return (counter / frequency) * 1000000000 + (counter % frequency) * 1000000000 / frequency;
+#endif
+}
+
+/* sleeps until the given time, the OS sleep usually overshoots
+ * so it stops early by the measured overshoot and spins for the rest */
+static void sleep_until(uint64_t target)
+{
+    static uint64_t overshoot = 1000000;
+    uint64_t now = get_time_ns();
+    uint64_t requested, slept;
+
+    while (target > now + overshoot)
+    {
+        requested = target - now - overshoot;
+#ifdef USE_SDL3
+        SDL_DelayNS(requested);
+#else
+        if (requested < 1000000)
+            break;
+        requested -= requested % 1000000;
+        SDL_Delay((Uint32)(requested / 1000000));
+#endif
+        slept = get_time_ns() - now;
+        now += slept;
+
+        /* keep a moving average of the overshoot, bounded
+         * so a single long stall doesn't make us spin */
+        if (slept > requested)
+            overshoot = (overshoot * 7 + (slept - requested)) / 8;
+        else
+            overshoot = (overshoot * 7) / 8;
+        if (overshoot < 100000)
+            overshoot = 100000;
+        else if (overshoot > 4000000)
+            overshoot = 4000000;
+    }
+
+    while (now < target)
+        now = get_time_ns();
+}
+
+/* returns the duration of a VI in nanoseconds */
+static uint64_t get_vi_period(void)
+{
+    uint64_t period = (uint64_t)1000000000 * 100 / ((uint64_t)g_dev.vi.expected_refresh_rate * l_SpeedFactor);
+    uint64_t host_period;
+
+    /* when the host display refreshes at nearly the same rate, pace
+     * to it so every VI lines up with a refresh of the display */
+    if (l_HostRefreshRate > 0 && l_SpeedFactor == 100)
+    {
+        host_period = (uint64_t)1000000000 * 1000 / l_HostRefreshRate;
+        if (host_period * 100 > period * 98 && host_period * 100 < period * 102)
+            period = host_period;
+    }
+
+    return period;
+}
+
 static void apply_speed_limiter(void)
 {
-    static unsigned long totalVIs = 0;
-    static int resetOnce = 0;
-    static int lastSpeedFactor = 100;
-    static uint64_t StartFPSTime = 0;
-    static const double defaultSpeedFactor = 100.0;
-    uint64_t CurrentFPSTime = SDL_GetTicks();
+    static uint64_t totalVIs = 0;
+    static uint64_t StartTime = 0;
+    static uint64_t VIPeriod = 0;
+    uint64_t CurrentTime = get_time_ns();
+    uint64_t TargetTime;
+    int64_t sleepTime;
 
-    // calculate frame duration based upon ROM setting (50/60hz) and mupen64plus speed adjustment
-    const double VILimitMilliseconds = 1000.0 / g_dev.vi.expected_refresh_rate;
-    const double SpeedFactorMultiple = defaultSpeedFactor/l_SpeedFactor;
-    const double AdjustedLimit = VILimitMilliseconds * SpeedFactorMultiple;
+    const uint64_t period = get_vi_period();
+    const int64_t maxDrift = (int64_t)50000000 * 100 / l_SpeedFactor;
 
-    //if this is the first time or we are resuming from pause
-    if(StartFPSTime == 0 || !resetOnce || lastSpeedFactor != l_SpeedFactor)
+    //if this is the first time or the VI period has changed
+    if (StartTime == 0 || period != VIPeriod)
     {
-       StartFPSTime = CurrentFPSTime;
-       totalVIs = 0;
-       resetOnce = 1;
+        StartTime = CurrentTime;
+        VIPeriod = period;
+        totalVIs = 0;
     }
     else
     {
         ++totalVIs;
     }
 
-    lastSpeedFactor = l_SpeedFactor;
-
 #if defined(PROFILE)
     timed_section_start(TIMED_SECTION_IDLE);
 #endif
@@ -1019,33 +1113,33 @@ static void apply_speed_limiter(void)
     if(g_DebuggerActive) DebuggerCallback(DEBUG_UI_VI, 0);
 #endif
 
-    double totalElapsedGameTime = AdjustedLimit*totalVIs;
-    double elapsedRealTime = CurrentFPSTime - StartFPSTime;
-    double sleepTime = totalElapsedGameTime - elapsedRealTime;
+    /* the target is computed from the start of pacing,
+     * so rounding errors don't accumulate over time */
+    TargetTime = StartTime + totalVIs * VIPeriod;
+    sleepTime = (int64_t)(TargetTime - CurrentTime);
 
-    //Reset if the sleep needed is an unreasonable value
-    static const double minSleepNeeded = -50;
-    static const double maxSleepNeeded = 50;
-    if(sleepTime < minSleepNeeded || sleepTime > (maxSleepNeeded*SpeedFactorMultiple))
+    //restart pacing from this VI if we are too far behind or ahead, i.e after pausing
+    if (sleepTime < -50000000 || sleepTime > maxDrift)
     {
-       resetOnce = 0;
+        StartTime = TargetTime = CurrentTime;
+        totalVIs = 0;
+        sleepTime = 0;
     }
 
-    if (sleepTime < minSleepNeeded) {
-        totalVIs += (unsigned long)(minSleepNeeded/AdjustedLimit);
-    }
-
-    if(l_MainSpeedLimit && sleepTime > 0 && sleepTime < maxSleepNeeded*SpeedFactorMultiple)
+    if (l_MainSpeedLimit)
     {
-        while(sleepTime >= 0) {
-            SDL_Delay((unsigned int) sleepTime);
-
-            CurrentFPSTime = SDL_GetTicks();
-            elapsedRealTime = CurrentFPSTime - StartFPSTime;
-            sleepTime = totalElapsedGameTime - elapsedRealTime;
+        if (sleepTime > 0)
+        {
+            sleep_until(TargetTime);
+            CurrentTime = get_time_ns();
         }
-    }
 
+        l_PacingError = (int)((int64_t)(CurrentTime - TargetTime) / 1000);
+    }
+    else
+    {
+        l_PacingError = 0;
+    }
 
 #if defined(PROFILE)
     timed_section_end(TIMED_SECTION_IDLE);
@@ -1073,6 +1167,8 @@ static void pause_loop(void)
 {
     if(g_rom_pause)
     {
+        /* write pending saves while nothing else happens */
+        file_storage_request_flush();
         osd_render();  // draw Paused message in case gfx.updateScreen didn't do it
         VidExt_GL_SwapBuffers();
         while(g_rom_pause)
@@ -1104,6 +1200,8 @@ void new_vi(void)
 
     gs_apply_cheats(&g_cheat_ctx);
 
+    rewind_new_vi();
+
     apply_speed_limiter();
     main_check_inputs();
 
@@ -1403,7 +1501,7 @@ static int load_dd_disk(struct dd_disk* dd_disk, const struct storage_backend_in
     dd_disk->storage = fstorage;
     dd_disk->istorage = &g_ifile_storage_ro;
     dd_disk->save_storage = fstorage_save;
-    dd_disk->isave_storage = (save_format >= 0) ? &g_ifile_storage : NULL;
+    dd_disk->isave_storage = (save_format >= 0) ? &g_ifile_storage_wt : NULL;
     dd_disk->format = format;
     dd_disk->development = development;
     dd_disk->region = DDREGION_UNKNOWN;
@@ -1772,7 +1870,7 @@ m64p_error main_run(void)
     memset(&l_gb_carts_data, 0, GAME_CONTROLLERS_COUNT*sizeof(*l_gb_carts_data));
     memset(cin_compats, 0, GAME_CONTROLLERS_COUNT*sizeof(*cin_compats));
 
-    netplay_read_registration(cin_compats);
+    netplay_read_registration();
 
     for (i = 0; i < GAME_CONTROLLERS_COUNT; ++i) {
 
@@ -1795,8 +1893,6 @@ m64p_error main_run(void)
             cin_compats[i].cont = &g_dev.controllers[i];
             cin_compats[i].last_pak_type = Controls[i].Plugin;
             cin_compats[i].last_input = 0;
-            cin_compats[i].netplay_count = 0;
-            cin_compats[i].event_first = NULL;
 
             Controls[i].Plugin = PLUGIN_NONE;
 
@@ -1823,8 +1919,6 @@ m64p_error main_run(void)
             cin_compats[i].tpk = &g_dev.transferpaks[i];
             cin_compats[i].last_pak_type = Controls[i].Plugin;
             cin_compats[i].last_input = 0;
-            cin_compats[i].netplay_count = 0;
-            cin_compats[i].event_first = NULL;
 
             l_gb_carts_data[i].control_id = (int)i;
 
@@ -2001,13 +2095,25 @@ m64p_error main_run(void)
     /* Startup message on the OSD */
     osd_new_message(OSD_MIDDLE_CENTER, "Mupen64Plus Started...");
 
+    /* snapshots of a previous run can't be restored */
+    rewind_reset();
+
+    savestates_set_emulation_thread(1);
     g_EmulatorRunning = 1;
     StateChanged(M64CORE_EMU_STATE, M64EMU_RUNNING);
 
+#if defined(PROFILE)
+    timed_sections_reset();
+#endif
+
     poweron_device(&g_dev);
     pif_bootrom_hle_execute(&g_dev.r4300);
     run_device(&g_dev);
 
+#if defined(PROFILE)
+    timed_sections_report();
+#endif
+
     /* now begin to shut down */
 #ifdef WITH_LIRC
     lircStop();
@@ -2050,6 +2156,7 @@ m64p_error main_run(void)
 
     // clean up
     g_EmulatorRunning = 0;
+    savestates_set_emulation_thread(0);
     StateChanged(M64CORE_EMU_STATE, M64EMU_STOPPED);
 
     return M64ERR_SUCCESS;
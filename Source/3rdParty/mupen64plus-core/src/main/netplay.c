@@ -24,11 +24,14 @@
 #define M64P_CORE_PROTOTYPES 1
 #include "api/callbacks.h"
 #include "main.h"
+#include "savestates.h"
 #include "util.h"
 #include "plugin/plugin.h"
+#include "backends/api/storage_backend.h"
 #include "backends/plugins_compat/plugins_compat.h"
 #include "netplay.h"
 #include "osal/preproc.h"
+#include "osd/osd.h"
 
 #ifdef USE_SDL3NET
 #include <SDL3_net/SDL_net.h>
@@ -42,6 +45,12 @@
 
 #include <stdlib.h>
 
+#ifdef USE_SDL3
+#include <SDL3/SDL_thread.h>
+#else
+#include <SDL_thread.h>
+#endif
+
 /* small helper structures to wrap SDL2_net/SDL3_net */
 
 #ifdef USE_SDL3NET
@@ -57,6 +66,62 @@ typedef struct
 typedef UDPpacket netplay_udp_packet;
 #endif
 
+/* received input events of a player, kept in a ring indexed by the event count,
+ * only events within NETPLAY_EVENT_RING_SIZE of the current count are stored */
+
+#define NETPLAY_EVENT_RING_SIZE 256 /* must be a power of two */
+#define NETPLAY_EVENT_RING_MASK (NETPLAY_EVENT_RING_SIZE - 1)
+
+struct netplay_event
+{
+    uint32_t buttons;
+    uint8_t plugin;
+    uint8_t valid;
+};
+
+struct netplay_event_ring
+{
+    struct netplay_event events[NETPLAY_EVENT_RING_SIZE]; /* received events */
+    struct netplay_event inputs[NETPLAY_EVENT_RING_SIZE]; /* executed inputs */
+    struct netplay_event local[NETPLAY_EVENT_RING_SIZE];  /* sent local inputs, only used by rollback */
+    uint32_t count;     /* count of the next event to execute */
+    uint32_t confirmed; /* events before this count were executed with the received input */
+    uint32_t sent;      /* count of the next local input to send, only used by rollback */
+    uint16_t size;      /* amount of valid events */
+};
+
+/* In rollback mode missing input is predicted instead of waited for.
+ * A snapshot of the device is taken on every VI, when a received event
+ * differs from the predicted input the newest snapshot taken before the
+ * mispredicted input is restored and the VIs are simulated again
+ * without the speed limiter.
+ *
+ * The server decides at which count the local input is executed,
+ * so it is predicted as well until the server sends it back. */
+
+#define NETPLAY_MAX_ROLLBACK_FRAMES 15
+
+/* The save memory isn't part of the device state, so its contents are kept
+ * in the snapshots as well, otherwise a save written during a mispredicted
+ * VI would survive the rollback and be flushed to disk. */
+
+#define NETPLAY_MAX_SAVE_STORAGES (3 + 2 * GAME_CONTROLLERS_COUNT)
+
+struct netplay_save_storage
+{
+    void* storage;
+    const struct storage_backend_interface* istorage;
+    size_t size;
+};
+
+struct netplay_snapshot
+{
+    uint8_t* state;
+    uint8_t* saves;
+    uint32_t counts[4];
+    uint32_t vi_counter;
+};
+
 /* local variables */
 
 #ifdef USE_SDL3NET
@@ -78,11 +143,35 @@ static int l_netplay_is_init = 0;
 static uint32_t l_vi_counter;
 static uint8_t l_status;
 static uint32_t l_reg_id;
-static struct controller_input_compat *l_cin_compats;
 static uint8_t l_plugin[4];
 static uint8_t l_buffer_target;
 static uint8_t l_player_lag[4];
 
+//The network thread receives the input events and signals l_event_cond,
+//the rings, the player lag and l_status are protected by l_event_lock
+static struct netplay_event_ring l_event_rings[4];
+static SDL_Thread *l_network_thread;
+static int l_network_thread_quit;
+#ifdef USE_SDL3
+static SDL_Mutex *l_event_lock;
+static SDL_Condition *l_event_cond;
+#else
+static SDL_mutex *l_event_lock;
+static SDL_cond *l_event_cond;
+#endif
+#ifndef USE_SDL3NET
+static SDLNet_SocketSet l_socket_set;
+#endif
+
+//The statistics are read by the frontend at any time, so they have their own lock
+//which exists as long as the core, it is taken after l_event_lock when both are needed
+static m64p_netplay_stats l_stats;
+#ifdef USE_SDL3
+static SDL_Mutex *l_stats_lock;
+#else
+static SDL_mutex *l_stats_lock;
+#endif
+
 //UDP packets
 static netplay_udp_packet *l_request_input_packet;
 static netplay_udp_packet *l_send_input_packet;
@@ -91,6 +180,26 @@ static netplay_udp_packet *l_check_sync_packet;
 
 static const int32_t l_check_sync_packet_size = (CP0_REGS_COUNT * 4) + 5;
 
+//Rollback
+static unsigned int l_rollback_frames;
+static netplay_rollback_job l_rollback_job;
+static struct netplay_snapshot l_snapshots[NETPLAY_MAX_ROLLBACK_FRAMES + 1];
+static unsigned int l_first_snapshot;
+static unsigned int l_snapshot_count;
+static uint8_t* l_rollback_state;
+static size_t l_rollback_state_size;
+static struct netplay_save_storage l_save_storages[NETPLAY_MAX_SAVE_STORAGES];
+static unsigned int l_save_storage_count;
+static size_t l_saves_size;
+static int l_saves_init;
+static unsigned int l_resimulate_vis;
+static int l_mispredicted[4];
+static uint32_t l_mispredicted_count[4];
+//in rollback mode the sync data is sent once the input of its VI is confirmed
+static int l_sync_pending;
+static uint32_t l_sync_vi;
+static uint32_t l_sync_counts[4];
+
 //UDP packet formats
 #define UDP_SEND_KEY_INFO 0
 #define UDP_RECEIVE_KEY_INFO 1
@@ -233,8 +342,252 @@ static osal_inline uint32_t netplay_read32(void *p)
 #endif
 }
 
+/* input event rings and the network thread */
+
+static void netplay_insert_event(uint8_t player, uint32_t count, uint32_t keys, uint8_t plugin)
+{
+    //must be called with l_event_lock held
+    //it skips events that we have already recorded, events that have already happened
+    //and events too far ahead to fit in the ring, the server sends those again when we request them
+    struct netplay_event_ring* ring = &l_event_rings[player];
+    struct netplay_event* event;
+
+    if ((count - ring->confirmed) >= NETPLAY_EVENT_RING_SIZE)
+        return;
+
+    event = &ring->events[count & NETPLAY_EVENT_RING_MASK];
+    if (event->valid)
+        return;
+
+    event->buttons = keys;
+    event->plugin = plugin;
+    event->valid = 1;
+    ++ring->size;
+}
+
+static void netplay_process()
+{
+    //In this function we process data we have received from the server, it runs inside the network thread
+    uint32_t curr, count, keys, vis;
+    uint8_t plugin, player, current_status, changed_status;
+    while (netplay_recv_udp_packet(l_udpSocket, l_process_packet) == 1)
+    {
+        switch (l_process_packet->data[0])
+        {
+            case UDP_RECEIVE_KEY_INFO:
+            case UDP_RECEIVE_KEY_INFO_GRATUITOUS:
+                player = l_process_packet->data[1];
+                if (player >= 4)
+                    break;
+                //current_status is a status update from the server
+                //it will let us know if another player has disconnected, or the games have desynced
+                current_status = l_process_packet->data[2];
+                SDL_LockMutex(l_event_lock);
+                //l_status is shared with the other threads, so it is only changed with l_event_lock held
+                changed_status = current_status ^ l_status;
+                l_status = current_status;
+                SDL_LockMutex(l_stats_lock);
+                if ((changed_status & 0x1) && (current_status & 0x1))
+                    ++l_stats.desyncs;
+                vis = l_stats.vis;
+                SDL_UnlockMutex(l_stats_lock);
+                SDL_UnlockMutex(l_event_lock);
+                if (changed_status & 0x1)
+                    DebugMessage(M64MSG_ERROR, "Netplay: players have de-synced at VI %u", vis);
+                for (int dis = 1; dis < 5; ++dis)
+                {
+                    if (changed_status & (0x1 << dis))
+                        DebugMessage(M64MSG_ERROR, "Netplay: player %u has disconnected", dis);
+                }
+                SDL_LockMutex(l_event_lock);
+                if (l_process_packet->data[0] == UDP_RECEIVE_KEY_INFO)
+                    l_player_lag[player] = l_process_packet->data[3];
+                curr = 5;
+                //this loop processes input data from the server, inserting new events into the ring of each player
+                for (uint8_t i = 0; i < l_process_packet->data[4] && (curr + 9) <= (uint32_t)l_process_packet->len; ++i)
+                {
+                    count = netplay_read32(&l_process_packet->data[curr]);
+                    curr += 4;
+                    keys = netplay_read32(&l_process_packet->data[curr]);
+                    curr += 4;
+                    plugin = l_process_packet->data[curr];
+                    curr += 1;
+
+                    netplay_insert_event(player, count, keys, plugin);
+                }
+#ifdef USE_SDL3
+                SDL_SignalCondition(l_event_cond);
+#else
+                SDL_CondSignal(l_event_cond);
+#endif
+                SDL_UnlockMutex(l_event_lock);
+                break;
+            default:
+                DebugMessage(M64MSG_ERROR, "Netplay: received unknown message from server");
+                break;
+        }
+    }
+}
+
+static int netplay_network_thread(void* opaque)
+{
+    //This function runs inside a thread while the game is running.
+    //It sleeps until the server sends us data, the timeout only bounds how long stopping the thread takes.
+    SDL_LockMutex(l_event_lock);
+    while (!l_network_thread_quit)
+    {
+        SDL_UnlockMutex(l_event_lock);
+#ifdef USE_SDL3NET
+        if (NET_WaitUntilInputAvailable((void**)&l_udpSocket, 1, 100) > 0)
+#else
+        if (SDLNet_CheckSockets(l_socket_set, 100) > 0)
+#endif
+            netplay_process();
+        SDL_LockMutex(l_event_lock);
+    }
+    SDL_UnlockMutex(l_event_lock);
+    return 0;
+}
+
+static void netplay_destroy_network_objects()
+{
+#ifndef USE_SDL3NET
+    if (l_socket_set != NULL)
+        SDLNet_FreeSocketSet(l_socket_set);
+    l_socket_set = NULL;
+#endif
+    if (l_event_cond != NULL)
+    {
+#ifdef USE_SDL3
+        SDL_DestroyCondition(l_event_cond);
+#else
+        SDL_DestroyCond(l_event_cond);
+#endif
+    }
+    if (l_event_lock != NULL)
+        SDL_DestroyMutex(l_event_lock);
+    l_event_cond = NULL;
+    l_event_lock = NULL;
+}
+
+static void netplay_stop_network_thread()
+{
+    if (l_network_thread == NULL)
+        return;
+
+    SDL_LockMutex(l_event_lock);
+    l_network_thread_quit = 1;
+    SDL_UnlockMutex(l_event_lock);
+
+    SDL_WaitThread(l_network_thread, NULL);
+    l_network_thread = NULL;
+
+    netplay_destroy_network_objects();
+}
+
+static int netplay_start_network_thread()
+{
+    netplay_stop_network_thread();
+
+    memset(l_event_rings, 0, sizeof(l_event_rings));
+    SDL_LockMutex(l_stats_lock);
+    memset(&l_stats, 0, sizeof(l_stats));
+    SDL_UnlockMutex(l_stats_lock);
+    l_network_thread_quit = 0;
+
+    l_event_lock = SDL_CreateMutex();
+#ifdef USE_SDL3
+    l_event_cond = SDL_CreateCondition();
+#else
+    l_event_cond = SDL_CreateCond();
+#endif
+#ifndef USE_SDL3NET
+    l_socket_set = SDLNet_AllocSocketSet(1);
+    if (l_socket_set == NULL || SDLNet_UDP_AddSocket(l_socket_set, l_udpSocket) < 0)
+    {
+        netplay_destroy_network_objects();
+        return 0;
+    }
+#endif
+    if (l_event_lock == NULL || l_event_cond == NULL)
+    {
+        netplay_destroy_network_objects();
+        return 0;
+    }
+
+    l_network_thread = SDL_CreateThread(netplay_network_thread, "m64pnetplay", NULL);
+    if (l_network_thread == NULL)
+    {
+        netplay_destroy_network_objects();
+        return 0;
+    }
+
+    return 1;
+}
+
+static void netplay_rollback_deinit()
+{
+    for (int i = 0; i <= NETPLAY_MAX_ROLLBACK_FRAMES; ++i)
+    {
+        free(l_snapshots[i].state);
+        free(l_snapshots[i].saves);
+        l_snapshots[i].state = NULL;
+        l_snapshots[i].saves = NULL;
+    }
+
+    free(l_rollback_state);
+    l_rollback_state = NULL;
+    l_rollback_state_size = 0;
+    l_save_storage_count = 0;
+    l_saves_size = 0;
+    l_saves_init = 0;
+    l_first_snapshot = 0;
+    l_snapshot_count = 0;
+    l_resimulate_vis = 0;
+    l_rollback_job = netplay_rollback_job_nothing;
+    l_sync_pending = 0;
+    memset(l_mispredicted, 0, sizeof(l_mispredicted));
+}
+
+static int netplay_rollback_init()
+{
+    netplay_rollback_deinit();
+
+    //the snapshots have to be zeroed before they're used the first time
+    l_rollback_state_size = savestates_get_m64p_size();
+    l_rollback_state = malloc(l_rollback_state_size);
+    if (l_rollback_state == NULL)
+        return 0;
+
+    for (unsigned int i = 0; i <= l_rollback_frames; ++i)
+    {
+        l_snapshots[i].state = calloc(1, l_rollback_state_size);
+        if (l_snapshots[i].state == NULL)
+        {
+            netplay_rollback_deinit();
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
 /* public exposed functions */
 
+void netplay_init()
+{
+    l_stats_lock = SDL_CreateMutex();
+    if (l_stats_lock == NULL)
+        DebugMessage(M64MSG_ERROR, "Netplay: could not create statistics lock");
+}
+
+void netplay_deinit()
+{
+    if (l_stats_lock != NULL)
+        SDL_DestroyMutex(l_stats_lock);
+    l_stats_lock = NULL;
+}
+
 m64p_error netplay_start(const char* host, int port)
 {
 #ifdef USE_SDL3NET
@@ -387,6 +740,10 @@ m64p_error netplay_start(const char* host, int port)
     l_vi_counter = 0;
     l_status = 0;
     l_reg_id = 0;
+    l_rollback_frames = 0;
+    SDL_LockMutex(l_stats_lock);
+    memset(&l_stats, 0, sizeof(l_stats));
+    SDL_UnlockMutex(l_stats_lock);
 
     return M64ERR_SUCCESS;
 }
@@ -397,20 +754,9 @@ m64p_error netplay_stop()
         return M64ERR_INVALID_STATE;
     else
     {
-        if (l_cin_compats != NULL)
-        {
-            for (int i = 0; i < 4; ++i)
-            {
-                struct netplay_event* current = l_cin_compats[i].event_first;
-                struct netplay_event* next;
-                while (current != NULL)
-                {
-                    next = current->next;
-                    free(current);
-                    current = next;
-                }
-            }
-        }
+        netplay_stop_network_thread();
+        netplay_rollback_deinit();
+        l_rollback_frames = 0;
 
         char output_data[5];
         output_data[0] = TCP_DISCONNECT_NOTICE;
@@ -457,201 +803,212 @@ int netplay_is_init()
     return l_netplay_is_init;
 }
 
-static uint8_t buffer_size(uint8_t control_id)
-{
-    //This function returns the size of the local input buffer
-    uint8_t counter = 0;
-    struct netplay_event* current = l_cin_compats[control_id].event_first;
-    while (current != NULL)
-    {
-        current = current->next;
-        ++counter;
-    }
-    return counter;
-}
-
 static void netplay_request_input(uint8_t control_id)
 {
+    //must be called with l_event_lock held
     l_request_input_packet->data[0] = UDP_REQUEST_KEY_INFO;
     l_request_input_packet->data[1] = control_id; //The player we need input for
     netplay_write32(l_reg_id, &l_request_input_packet->data[2]); //our registration ID
-    netplay_write32(l_cin_compats[control_id].netplay_count, &l_request_input_packet->data[6]); //the current event count
+    netplay_write32(l_event_rings[control_id].confirmed, &l_request_input_packet->data[6]); //the first event count we need
     l_request_input_packet->data[10] = l_spectator; //whether we are a spectator
-    l_request_input_packet->data[11] = buffer_size(control_id); //our local buffer size
+    l_request_input_packet->data[11] = (l_event_rings[control_id].size > 255) ? 255 : (uint8_t)l_event_rings[control_id].size; //our local buffer size
     l_request_input_packet->len = 12;
     netplay_send_udp_packet(l_udpSocket, l_request_input_packet);
 }
 
-static int check_valid(uint8_t control_id, uint32_t count)
+static osal_inline int netplay_event_valid(uint8_t control_id)
 {
-    //Check if we already have this event recorded locally, returns 1 if we do
-    struct netplay_event* current = l_cin_compats[control_id].event_first;
-    while (current != NULL)
-    {
-        if (current->count == count) //event already recorded
-            return 1;
-        current = current->next;
-    }
-    return 0;
+    //Check if we have the current event recorded locally, returns 1 if we do
+    //must be called with l_event_lock held
+    struct netplay_event_ring* ring = &l_event_rings[control_id];
+    return ring->events[ring->count & NETPLAY_EVENT_RING_MASK].valid;
 }
 
-static int netplay_require_response(void* opaque)
+static int netplay_ensure_valid(uint8_t control_id)
 {
-    //This function runs inside a thread.
-    //It runs if our local buffer size is 0 (we need to execute a key event, but we don't have the data we need).
-    //We basically beg the server for input data.
+    //This function makes sure we have data for the current event, it must be called with l_event_lock held
+    //If we don't have the data, we beg the server for input data and sleep until the network thread receives it
     //After 10 seconds a timeout occurs, we assume we have lost connection to the server.
-    uint8_t control_id = *(uint8_t*)opaque;
-    uint64_t timeout = SDL_GetTicks() + 10000;
-    while (!check_valid(control_id, l_cin_compats[control_id].netplay_count))
+    uint64_t start, now, timeout, next_request;
+
+    if (netplay_event_valid(control_id))
+        return 1;
+
+    if (l_udpChannel == -1)
+        return 0;
+
+    start = now = SDL_GetTicks();
+    timeout = now + 10000;
+    next_request = now;
+    while (!netplay_event_valid(control_id))
     {
-        if (SDL_GetTicks() > timeout)
+        now = SDL_GetTicks();
+        if (now > timeout)
         {
             l_udpChannel = -1;
             return 0;
         }
-        netplay_request_input(control_id);
-        SDL_Delay(5);
+        if (now >= next_request)
+        {
+            netplay_request_input(control_id);
+            next_request = now + 5;
+        }
+#ifdef USE_SDL3
+        SDL_WaitConditionTimeout(l_event_cond, l_event_lock, 5);
+#else
+        SDL_CondWaitTimeout(l_event_cond, l_event_lock, 5);
+#endif
     }
+
+    SDL_LockMutex(l_stats_lock);
+    ++l_stats.stalls;
+    l_stats.stall_time += (unsigned int)(SDL_GetTicks() - start);
+    SDL_UnlockMutex(l_stats_lock);
     return 1;
 }
 
-static void netplay_process()
+static void netplay_update_speed_limiter()
 {
-    //In this function we process data we have received from the server
-    uint32_t curr, count, keys;
-    uint8_t plugin, player, current_status;
-    while (netplay_recv_udp_packet(l_udpSocket, l_process_packet) == 1)
-    {
-        switch (l_process_packet->data[0])
-        {
-            case UDP_RECEIVE_KEY_INFO:
-            case UDP_RECEIVE_KEY_INFO_GRATUITOUS:
-                player = l_process_packet->data[1];
-                //current_status is a status update from the server
-                //it will let us know if another player has disconnected, or the games have desynced
-                current_status = l_process_packet->data[2];
-                if (l_process_packet->data[0] == UDP_RECEIVE_KEY_INFO)
-                    l_player_lag[player] = l_process_packet->data[3];
-                if (current_status != l_status)
-                {
-                    if (((current_status & 0x1) ^ (l_status & 0x1)) != 0)
-                        DebugMessage(M64MSG_ERROR, "Netplay: players have de-synced at VI %u", l_vi_counter);
-                    for (int dis = 1; dis < 5; ++dis)
-                    {
-                        if (((current_status & (0x1 << dis)) ^ (l_status & (0x1 << dis))) != 0)
-                            DebugMessage(M64MSG_ERROR, "Netplay: player %u has disconnected", dis);
-                    }
-                    l_status = current_status;
-                }
-                curr = 5;
-                //this loop processes input data from the server, inserting new events into the linked list for each player
-                //it skips events that we have already recorded, or if we receive data for an event that has already happened
-                for (uint8_t i = 0; i < l_process_packet->data[4]; ++i)
-                {
-                    count = netplay_read32(&l_process_packet->data[curr]);
-                    curr += 4;
+    //fast forward when we are behind or when simulating VIs again after a rollback
+    main_core_state_set(M64CORE_SPEED_LIMITER, !(l_canFF || l_resimulate_vis != 0));
+}
 
-                    if (((count - l_cin_compats[player].netplay_count) > (UINT32_MAX / 2)) || (check_valid(player, count))) //event doesn't need to be recorded
-                    {
-                        curr += 5;
-                        continue;
-                    }
+static void netplay_lost_connection()
+{
+    DebugMessage(M64MSG_ERROR, "Netplay: lost connection to server");
+    main_core_state_set(M64CORE_EMU_STATE, M64EMU_STOPPED);
+}
 
-                    keys = netplay_read32(&l_process_packet->data[curr]);
-                    curr += 4;
-                    plugin = l_process_packet->data[curr];
-                    curr += 1;
+static int netplay_rollback_confirm()
+{
+    //This function moves the received events of the executed counts into the executed inputs,
+    //it records the first count of every player which was executed with a wrong prediction
+    //must be called with l_event_lock held, returns 1 if a rollback is needed
+    struct netplay_event_ring* ring;
+    struct netplay_event* event;
+    struct netplay_event* input;
+    int mispredicted = 0;
 
-                    //insert new event at beginning of linked list
-                    struct netplay_event* new_event = (struct netplay_event*)malloc(sizeof(struct netplay_event));
-                    new_event->count = count;
-                    new_event->buttons = keys;
-                    new_event->plugin = plugin;
-                    new_event->next = l_cin_compats[player].event_first;
-                    l_cin_compats[player].event_first = new_event;
-                }
-                break;
-            default:
-                DebugMessage(M64MSG_ERROR, "Netplay: received unknown message from server");
+    for (int i = 0; i < 4; ++i)
+    {
+        ring = &l_event_rings[i];
+        while ((int32_t)(ring->count - ring->confirmed) > 0)
+        {
+            event = &ring->events[ring->confirmed & NETPLAY_EVENT_RING_MASK];
+            if (!event->valid)
                 break;
-        }
-    }
-}
 
-static int netplay_ensure_valid(uint8_t control_id)
-{
-    //This function makes sure we have data for a certain event
-    //If we don't have the data, it will create a new thread that will request the data
-    if (check_valid(control_id, l_cin_compats[control_id].netplay_count))
-        return 1;
+            input = &ring->inputs[ring->confirmed & NETPLAY_EVENT_RING_MASK];
+            if (!l_mispredicted[i] && (input->buttons != event->buttons || input->plugin != event->plugin))
+            {
+                l_mispredicted[i] = 1;
+                l_mispredicted_count[i] = ring->confirmed;
+            }
 
-    if (l_udpChannel == -1)
-        return 0;
+            *input = *event;
+            event->valid = 0;
+            --ring->size;
+            ++ring->confirmed;
+        }
 
-    SDL_Thread* thread = SDL_CreateThread(netplay_require_response, "Netplay key request", &control_id);
+        mispredicted |= l_mispredicted[i];
+    }
 
-    while (!check_valid(control_id, l_cin_compats[control_id].netplay_count) && l_udpChannel != -1)
-        netplay_process();
-    int success;
-    SDL_WaitThread(thread, &success);
-    return success;
+    return mispredicted;
 }
 
-static void netplay_delete_event(struct netplay_event* current, uint8_t control_id)
+static int netplay_rollback_get_input(uint8_t control_id, uint32_t* keys)
 {
-    //This function deletes an event from the linked list
-    struct netplay_event* find = l_cin_compats[control_id].event_first;
-    while (find != NULL)
+    //This function returns the input for the current count when it is known already
+    //or when it can be predicted, must be called with l_event_lock held
+    //It returns 0 when the received event has to be used
+    struct netplay_event_ring* ring = &l_event_rings[control_id];
+    struct netplay_event* input = &ring->inputs[ring->count & NETPLAY_EVENT_RING_MASK];
+    struct netplay_event* previous;
+    uint32_t delayed = ring->count - l_buffer_target;
+
+    if ((int32_t)(ring->count - ring->confirmed) < 0)
+    {
+        //confirmed input which is executed again after a rollback
+    }
+    else if (ring->events[ring->count & NETPLAY_EVENT_RING_MASK].valid)
     {
-        if (find->next == current)
+        return 0;
+    }
+    else if (l_snapshot_count != 0 && (ring->count - ring->confirmed) < (NETPLAY_EVENT_RING_SIZE / 2))
+    {
+        if (l_netplay_control[control_id] != -1 && ring->count >= l_buffer_target &&
+            (int32_t)(ring->sent - delayed) > 0 && (ring->sent - delayed) <= NETPLAY_EVENT_RING_SIZE)
         {
-            find->next = current->next;
-            break;
+            //the server executes our own input after the input delay it told us upon registration
+            *input = ring->local[delayed & NETPLAY_EVENT_RING_MASK];
+        }
+        else
+        {
+            //we predict that the player keeps holding the same buttons
+            previous = &ring->inputs[(ring->count - 1) & NETPLAY_EVENT_RING_MASK];
+            input->buttons = (ring->count != 0) ? previous->buttons : 0;
+            input->plugin = (ring->count != 0) ? previous->plugin : Controls[control_id].Plugin;
+            input->valid = 1;
         }
-        find = find->next;
     }
-    if (current == l_cin_compats[control_id].event_first)
-        l_cin_compats[control_id].event_first = l_cin_compats[control_id].event_first->next;
-    free(current);
+    else
+    {
+        //there's no snapshot to roll back to, so we have to wait for the event
+        return 0;
+    }
+
+    *keys = input->buttons;
+    Controls[control_id].Plugin = input->plugin;
+    ++ring->count;
+    return 1;
 }
 
 static uint32_t netplay_get_input(uint8_t control_id)
 {
+    struct netplay_event_ring* ring = &l_event_rings[control_id];
+    struct netplay_event* event;
+    struct netplay_event* input;
     uint32_t keys;
-    netplay_process();
+
+    SDL_LockMutex(l_event_lock);
     netplay_request_input(control_id);
 
     //l_buffer_target is set by the server upon registration
     //l_player_lag is how far behind we are from the lead player
-    //buffer_size is the local buffer size
-    if (l_player_lag[control_id] > 0 && buffer_size(control_id) > l_buffer_target)
-    {
-        l_canFF = 1;
-        main_core_state_set(M64CORE_SPEED_LIMITER, 0);
-    }
-    else
+    //ring->size is the local buffer size
+    l_canFF = l_player_lag[control_id] > 0 && ring->size > l_buffer_target;
+    netplay_update_speed_limiter();
+
+    if (l_rollback_frames != 0 && netplay_rollback_get_input(control_id, &keys))
     {
-        main_core_state_set(M64CORE_SPEED_LIMITER, 1);
-        l_canFF = 0;
+        SDL_UnlockMutex(l_event_lock);
+        return keys;
     }
 
     if (netplay_ensure_valid(control_id))
     {
-        //We grab the event from the linked list, the delete it once it has been used
+        //We grab the event from the ring and keep it as the executed input,
+        //then release its slot once every event before it has been used
         //Finally we increment the event counter
-        struct netplay_event* current = l_cin_compats[control_id].event_first;
-        while (current->count != l_cin_compats[control_id].netplay_count)
-            current = current->next;
-        keys = current->buttons;
-        Controls[control_id].Plugin = current->plugin;
-        netplay_delete_event(current, control_id);
-        ++l_cin_compats[control_id].netplay_count;
+        event = &ring->events[ring->count & NETPLAY_EVENT_RING_MASK];
+        input = &ring->inputs[ring->count & NETPLAY_EVENT_RING_MASK];
+        *input = *event;
+        if (ring->count == ring->confirmed)
+        {
+            event->valid = 0;
+            --ring->size;
+            ++ring->confirmed;
+        }
+        ++ring->count;
+        keys = input->buttons;
+        Controls[control_id].Plugin = input->plugin;
+        SDL_UnlockMutex(l_event_lock);
     }
     else
     {
-        DebugMessage(M64MSG_ERROR, "Netplay: lost connection to server");
-        main_core_state_set(M64CORE_EMU_STATE, M64EMU_STOPPED);
+        SDL_UnlockMutex(l_event_lock);
+        netplay_lost_connection();
         keys = 0;
     }
 
@@ -660,9 +1017,26 @@ static uint32_t netplay_get_input(uint8_t control_id)
 
 static void netplay_send_input(uint8_t control_id, uint32_t keys)
 {
+    struct netplay_event_ring* ring = &l_event_rings[control_id];
+    struct netplay_event* input;
+
+    if (l_rollback_frames != 0)
+    {
+        //input which is executed again after a rollback has been sent already,
+        //otherwise we keep it to predict the event the server makes of it
+        if ((int32_t)(ring->count - ring->sent) < 0)
+            return;
+
+        input = &ring->local[ring->count & NETPLAY_EVENT_RING_MASK];
+        input->buttons = keys;
+        input->plugin = l_plugin[control_id];
+        input->valid = 1;
+        ring->sent = ring->count + 1;
+    }
+
     l_send_input_packet->data[0] = UDP_SEND_KEY_INFO;
     l_send_input_packet->data[1] = control_id; //player number
-    netplay_write32(l_cin_compats[control_id].netplay_count, &l_send_input_packet->data[2]); // current event count
+    netplay_write32(ring->count, &l_send_input_packet->data[2]); // current event count
     netplay_write32(keys, &l_send_input_packet->data[6]); //key data
     l_send_input_packet->data[10] = l_plugin[control_id]; //current plugin
     l_send_input_packet->len = 11;
@@ -710,6 +1084,12 @@ int netplay_get_controller(uint8_t player)
     return l_netplay_control[player];
 }
 
+uint32_t netplay_get_event_count(uint8_t player)
+{
+    //the count of the next event of the player, it goes back when a rollback restores a snapshot
+    return l_event_rings[player].count;
+}
+
 file_status_t netplay_read_storage(const char *filename, void *data, size_t size)
 {
     //This function syncs save games.
@@ -808,6 +1188,39 @@ void netplay_sync_settings(uint32_t *count_per_op, uint32_t *count_per_op_denom_
     }
 }
 
+static void netplay_rollback_send_sync()
+{
+    //This function sends the pending sync data once the input of its VI is confirmed
+    //must be called with l_event_lock held
+    if (!l_sync_pending)
+        return;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        if ((int32_t)(l_event_rings[i].confirmed - l_sync_counts[i]) < 0)
+            return;
+    }
+
+    netplay_send_udp_packet(l_udpSocket, l_check_sync_packet);
+    l_sync_pending = 0;
+}
+
+static void netplay_rollback_new_vi()
+{
+    int mispredicted;
+
+    if (l_resimulate_vis != 0 && --l_resimulate_vis == 0)
+        netplay_update_speed_limiter();
+
+    SDL_LockMutex(l_event_lock);
+    mispredicted = netplay_rollback_confirm();
+    if (!mispredicted)
+        netplay_rollback_send_sync();
+    SDL_UnlockMutex(l_event_lock);
+
+    l_rollback_job = mispredicted ? netplay_rollback_job_restore : netplay_rollback_job_snapshot;
+}
+
 void netplay_check_sync(struct cp0* cp0)
 {
     //This function is used to check if games have desynced
@@ -827,21 +1240,318 @@ void netplay_check_sync(struct cp0* cp0)
             netplay_write32(cp0_regs[i], &l_check_sync_packet->data[(i * 4) + 5]);
         }
         l_check_sync_packet->len = l_check_sync_packet_size;
-        netplay_send_udp_packet(l_udpSocket, l_check_sync_packet);
+
+        if (l_rollback_frames == 0)
+        {
+            netplay_send_udp_packet(l_udpSocket, l_check_sync_packet);
+        }
+        else
+        {
+            //the registers could be the result of predicted input
+            l_sync_pending = 1;
+            l_sync_vi = l_vi_counter;
+            for (int i = 0; i < 4; ++i)
+                l_sync_counts[i] = l_event_rings[i].count;
+        }
+    }
+
+    SDL_LockMutex(l_stats_lock);
+    if (l_resimulate_vis == 0)
+    {
+        ++l_stats.vis;
+        if (l_canFF)
+            ++l_stats.fast_forward_vis;
     }
+    SDL_UnlockMutex(l_stats_lock);
 
     ++l_vi_counter;
+
+    if (l_rollback_frames != 0)
+        netplay_rollback_new_vi();
+}
+
+netplay_rollback_job netplay_rollback_get_job()
+{
+    return l_rollback_job;
+}
+
+static int netplay_rollback_make_room()
+{
+    //This function makes sure the oldest snapshot can be dropped, which is only
+    //possible when the input executed after the snapshot after it is confirmed.
+    //Otherwise we wait for the events, so the emulation never runs further ahead
+    //than l_rollback_frames. Returns 0 when a rollback is needed first.
+    const struct netplay_snapshot* next = &l_snapshots[(l_first_snapshot + 1) % (l_rollback_frames + 1)];
+    uint64_t start, now, timeout, next_request;
+    int confirmed, stalled = 0;
+
+    start = now = SDL_GetTicks();
+    timeout = now + 10000;
+    next_request = now;
+
+    SDL_LockMutex(l_event_lock);
+    for (;;)
+    {
+        if (netplay_rollback_confirm())
+        {
+            SDL_UnlockMutex(l_event_lock);
+            l_rollback_job = netplay_rollback_job_restore;
+            return 0;
+        }
+
+        confirmed = 1;
+        for (int i = 0; i < 4; ++i)
+        {
+            if ((int32_t)(next->counts[i] - l_event_rings[i].confirmed) > 0)
+                confirmed = 0;
+        }
+
+        if (confirmed)
+            break;
+
+        now = SDL_GetTicks();
+        if (l_udpChannel == -1 || now > timeout)
+        {
+            l_udpChannel = -1;
+            SDL_UnlockMutex(l_event_lock);
+            netplay_lost_connection();
+            return 0;
+        }
+        if (now >= next_request)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                if ((int32_t)(next->counts[i] - l_event_rings[i].confirmed) > 0)
+                    netplay_request_input(i);
+            }
+            next_request = now + 5;
+        }
+
+        stalled = 1;
+#ifdef USE_SDL3
+        SDL_WaitConditionTimeout(l_event_cond, l_event_lock, 5);
+#else
+        SDL_CondWaitTimeout(l_event_cond, l_event_lock, 5);
+#endif
+    }
+
+    if (stalled)
+    {
+        SDL_LockMutex(l_stats_lock);
+        ++l_stats.stalls;
+        l_stats.stall_time += (unsigned int)(SDL_GetTicks() - start);
+        SDL_UnlockMutex(l_stats_lock);
+    }
+    SDL_UnlockMutex(l_event_lock);
+
+    return 1;
 }
 
-void netplay_read_registration(struct controller_input_compat* cin_compats)
+static void netplay_add_save_storage(void* storage, const struct storage_backend_interface* istorage)
+{
+    struct netplay_save_storage* save;
+
+    if (storage == NULL || istorage == NULL || istorage->size(storage) == 0)
+        return;
+
+    save = &l_save_storages[l_save_storage_count++];
+    save->storage = storage;
+    save->istorage = istorage;
+    save->size = istorage->size(storage);
+    l_saves_size += save->size;
+}
+
+static int netplay_rollback_init_saves()
+{
+    //the save storages are created with the device after the rollback buffers,
+    //so they're gathered when the first snapshot is taken
+    l_saves_init = 1;
+
+    netplay_add_save_storage(g_dev.cart.eeprom.storage, g_dev.cart.eeprom.istorage);
+    netplay_add_save_storage(g_dev.cart.flashram.storage, g_dev.cart.flashram.istorage);
+    netplay_add_save_storage(g_dev.cart.sram.storage, g_dev.cart.sram.istorage);
+    for (int i = 0; i < GAME_CONTROLLERS_COUNT; ++i)
+    {
+        netplay_add_save_storage(g_dev.mempaks[i].storage, g_dev.mempaks[i].istorage);
+        netplay_add_save_storage(g_dev.gb_carts[i].ram_storage, g_dev.gb_carts[i].iram_storage);
+    }
+
+    if (l_saves_size == 0)
+        return 1;
+
+    for (unsigned int i = 0; i <= l_rollback_frames; ++i)
+    {
+        l_snapshots[i].saves = malloc(l_saves_size);
+        if (l_snapshots[i].saves == NULL)
+        {
+            for (unsigned int j = 0; j < i; ++j)
+            {
+                free(l_snapshots[j].saves);
+                l_snapshots[j].saves = NULL;
+            }
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void netplay_rollback_save_saves(uint8_t* saves)
+{
+    const struct netplay_save_storage* save;
+
+    for (unsigned int i = 0; i < l_save_storage_count; ++i)
+    {
+        save = &l_save_storages[i];
+        memcpy(saves, save->istorage->data(save->storage), save->size);
+        saves += save->size;
+    }
+}
+
+static void netplay_rollback_restore_saves(const uint8_t* saves)
+{
+    //only the changed range is restored and passed to the storage backend,
+    //so the restored contents replace the mispredicted ones on disk as well
+    const struct netplay_save_storage* save;
+    uint8_t* data;
+    size_t start, end;
+
+    for (unsigned int i = 0; i < l_save_storage_count; ++i)
+    {
+        save = &l_save_storages[i];
+        data = save->istorage->data(save->storage);
+
+        for (start = 0; start < save->size && data[start] == saves[start]; ++start);
+        if (start != save->size)
+        {
+            for (end = save->size; data[end - 1] == saves[end - 1]; --end);
+            memcpy(data + start, saves + start, end - start);
+            save->istorage->save(save->storage, start, end - start);
+        }
+
+        saves += save->size;
+    }
+}
+
+void netplay_rollback_snapshot()
+{
+    struct netplay_snapshot* snapshot;
+
+    l_rollback_job = netplay_rollback_job_nothing;
+
+    if (!l_saves_init && !netplay_rollback_init_saves())
+    {
+        main_message(M64MSG_ERROR, OSD_BOTTOM_LEFT, "Netplay: failed to allocate the rollback save memory, stopping emulation");
+        main_stop();
+        return;
+    }
+
+    if (l_snapshot_count == l_rollback_frames + 1)
+    {
+        if (!netplay_rollback_make_room())
+            return;
+
+        l_first_snapshot = (l_first_snapshot + 1) % (l_rollback_frames + 1);
+        --l_snapshot_count;
+    }
+
+    snapshot = &l_snapshots[(l_first_snapshot + l_snapshot_count) % (l_rollback_frames + 1)];
+    ++l_snapshot_count;
+
+    savestates_serialize_m64p(&g_dev, snapshot->state);
+    if (snapshot->saves != NULL)
+        netplay_rollback_save_saves(snapshot->saves);
+    for (int i = 0; i < 4; ++i)
+        snapshot->counts[i] = l_event_rings[i].count;
+    snapshot->vi_counter = l_vi_counter;
+}
+
+int netplay_rollback_restore()
+{
+    struct netplay_snapshot* snapshot = NULL;
+    struct netplay_snapshot* candidate;
+    unsigned int depth;
+    int valid;
+
+    l_rollback_job = netplay_rollback_job_nothing;
+
+    //find the newest snapshot taken before every mispredicted input,
+    //the snapshots after it contain the result of a misprediction
+    while (l_snapshot_count != 0)
+    {
+        candidate = &l_snapshots[(l_first_snapshot + l_snapshot_count - 1) % (l_rollback_frames + 1)];
+
+        valid = 1;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (l_mispredicted[i] && (int32_t)(candidate->counts[i] - l_mispredicted_count[i]) > 0)
+                valid = 0;
+        }
+
+        if (valid)
+        {
+            snapshot = candidate;
+            break;
+        }
+
+        --l_snapshot_count;
+    }
+
+    memset(l_mispredicted, 0, sizeof(l_mispredicted));
+
+    //without a valid snapshot this client can no longer match the other players,
+    //so continuing would only hide a desync, stop emulation instead
+    if (snapshot == NULL)
+    {
+        main_message(M64MSG_ERROR, OSD_BOTTOM_LEFT, "Netplay: no snapshot to roll back to at VI %u, stopping emulation", l_vi_counter);
+        main_stop();
+        return 0;
+    }
+
+    //the state is converted in place, so load it from a copy
+    memcpy(l_rollback_state, snapshot->state, l_rollback_state_size);
+    if (!savestates_deserialize_m64p(&g_dev, l_rollback_state))
+    {
+        main_message(M64MSG_ERROR, OSD_BOTTOM_LEFT, "Netplay: failed to restore rollback snapshot, stopping emulation");
+        l_snapshot_count = 0;
+        main_stop();
+        return 0;
+    }
+
+    if (snapshot->saves != NULL)
+        netplay_rollback_restore_saves(snapshot->saves);
+
+    depth = l_vi_counter - snapshot->vi_counter;
+
+    SDL_LockMutex(l_event_lock);
+    for (int i = 0; i < 4; ++i)
+        l_event_rings[i].count = snapshot->counts[i];
+    SDL_UnlockMutex(l_event_lock);
+
+    SDL_LockMutex(l_stats_lock);
+    ++l_stats.rollbacks;
+    l_stats.resimulated_vis += depth;
+    l_stats.last_depth = depth;
+    if (depth > l_stats.max_depth)
+        l_stats.max_depth = depth;
+    SDL_UnlockMutex(l_stats_lock);
+
+    l_vi_counter = snapshot->vi_counter;
+    if (l_sync_pending && (int32_t)(l_sync_vi - l_vi_counter) >= 0)
+        l_sync_pending = 0;
+
+    l_resimulate_vis = depth;
+    netplay_update_speed_limiter();
+    return 1;
+}
+
+void netplay_read_registration()
 {
     //This function runs right before the game starts
     //The server shares the registration details about each player
     if (!netplay_is_init())
         return;
 
-    l_cin_compats = cin_compats;
-
     uint32_t reg_id;
     char output_data = TCP_GET_REGISTRATION;
     char input_data[24];
@@ -879,6 +1589,18 @@ void netplay_read_registration(struct controller_input_compat* cin_compats)
             ++curr;
         }
     }
+
+    if (!netplay_start_network_thread())
+    {
+        DebugMessage(M64MSG_ERROR, "Netplay: could not start network thread");
+        l_udpChannel = -1;
+    }
+
+    if (l_rollback_frames != 0 && !netplay_rollback_init())
+    {
+        DebugMessage(M64MSG_WARNING, "Netplay: could not allocate rollback snapshots, using delay based netplay");
+        l_rollback_frames = 0;
+    }
 }
 
 static void netplay_send_raw_input(struct pif* pif)
@@ -974,3 +1696,28 @@ m64p_error netplay_receive_config(char* data, int size)
     else
         return M64ERR_INVALID_STATE;
 }
+
+m64p_error netplay_set_rollback(int frames)
+{
+    if (!netplay_is_init())
+        return M64ERR_NOT_INIT;
+
+    if (frames < 0 || frames > NETPLAY_MAX_ROLLBACK_FRAMES)
+        return M64ERR_INPUT_INVALID;
+
+    l_rollback_frames = frames;
+    return M64ERR_SUCCESS;
+}
+
+m64p_error netplay_get_stats(m64p_netplay_stats* stats)
+{
+    //this is called by the frontend while netplay may be stopped by the emulation thread,
+    //the statistics are zeroed until the network thread starts with the emulation
+    if (!netplay_is_init())
+        return M64ERR_NOT_INIT;
+
+    SDL_LockMutex(l_stats_lock);
+    *stats = l_stats;
+    SDL_UnlockMutex(l_stats_lock);
+    return M64ERR_SUCCESS;
+}
@@ -28,17 +28,17 @@
 
 #define NETPLAY_CORE_VERSION 1
 
-struct netplay_event {
-    uint32_t buttons;
-    uint8_t plugin;
-    uint32_t count;
-    struct netplay_event* next;
-};
-
-struct controller_input_compat;
+typedef enum _netplay_rollback_job
+{
+    netplay_rollback_job_nothing,
+    netplay_rollback_job_snapshot,
+    netplay_rollback_job_restore
+} netplay_rollback_job;
 
 #ifdef M64P_NETPLAY
 
+void netplay_init();
+void netplay_deinit();
 m64p_error netplay_start(const char* host, int port);
 m64p_error netplay_stop();
 uint8_t netplay_register_player(uint8_t player, uint8_t plugin, uint8_t rawdata, uint32_t reg_id);
@@ -46,17 +46,31 @@ int netplay_lag();
 void netplay_set_controller(uint8_t player);
 int netplay_is_init();
 int netplay_get_controller(uint8_t player);
+uint32_t netplay_get_event_count(uint8_t player);
 file_status_t netplay_read_storage(const char *filename, void *data, size_t size);
 void netplay_sync_settings(uint32_t *count_per_op, uint32_t *count_per_op_denom_pot, uint32_t *disable_extra_mem, int32_t *si_dma_duration, uint32_t *emumode, int32_t *no_compiled_jump);
 void netplay_check_sync(struct cp0* cp0);
 int netplay_next_controller();
-void netplay_read_registration(struct controller_input_compat* cin_compats);
+void netplay_read_registration();
 void netplay_update_input(struct pif* pif);
 m64p_error netplay_send_config(char* data, int size);
 m64p_error netplay_receive_config(char* data, int size);
+m64p_error netplay_set_rollback(int frames);
+m64p_error netplay_get_stats(m64p_netplay_stats* stats);
+netplay_rollback_job netplay_rollback_get_job();
+void netplay_rollback_snapshot();
+int netplay_rollback_restore();
 
 #else
 
+static osal_inline void netplay_init()
+{
+}
+
+static osal_inline void netplay_deinit()
+{
+}
+
 static osal_inline m64p_error netplay_start(const char* host, int port)
 {
     return M64ERR_INCOMPATIBLE;
@@ -91,6 +105,11 @@ static osal_inline int netplay_get_controller(uint8_t player)
     return 0;
 }
 
+static osal_inline uint32_t netplay_get_event_count(uint8_t player)
+{
+    return 0;
+}
+
 static osal_inline file_status_t netplay_read_storage(const char *filename, void *data, size_t size)
 {
     return 0;
@@ -109,7 +128,7 @@ static osal_inline int netplay_next_controller()
     return 0;
 }
 
-static osal_inline void netplay_read_registration(struct controller_input_compat* cin_compats)
+static osal_inline void netplay_read_registration()
 {
 }
 
@@ -131,6 +150,30 @@ static osal_inline m64p_error netplay_receive_config(char* data, int size)
     return M64ERR_INCOMPATIBLE;
 }
 
+static osal_inline m64p_error netplay_set_rollback(int frames)
+{
+    return M64ERR_INCOMPATIBLE;
+}
+
+static osal_inline m64p_error netplay_get_stats(m64p_netplay_stats* stats)
+{
+    return M64ERR_INCOMPATIBLE;
+}
+
+static osal_inline netplay_rollback_job netplay_rollback_get_job()
+{
+    return netplay_rollback_job_nothing;
+}
+
+static osal_inline void netplay_rollback_snapshot()
+{
+}
+
+static osal_inline int netplay_rollback_restore()
+{
+    return 0;
+}
+
 #endif
 
 #endif
@@ -28,6 +28,12 @@
 
 static long long int time_in_section[NUM_TIMED_SECTIONS];
 static long long int last_start[NUM_TIMED_SECTIONS];
+static long long int counters[NUM_TIMED_COUNTERS];
+
+/* totals since timed_sections_reset() */
+static long long int total_start;
+static long long int total_in_section[NUM_TIMED_SECTIONS];
+static long long int total_counters[NUM_TIMED_COUNTERS];
 
 #if defined(WIN32) && !defined(__MINGW32__)
   // timing
@@ -72,6 +78,41 @@ void timed_section_end(enum timed_section section)
 {
    long long int end = get_time();
    time_in_section[section] += end - last_start[section];
+   total_in_section[section] += end - last_start[section];
+}
+
+void timed_counter_add(enum timed_counter counter, int value)
+{
+   counters[counter] += value;
+   total_counters[counter] += value;
+}
+
+void timed_sections_reset(void)
+{
+   int i;
+
+   for (i = 0; i < NUM_TIMED_SECTIONS; i++)
+      total_in_section[i] = 0;
+   for (i = 0; i < NUM_TIMED_COUNTERS; i++)
+      total_counters[i] = 0;
+
+   total_start = get_time();
+}
+
+void timed_sections_report(void)
+{
+   total_in_section[TIMED_SECTION_ALL] = get_time() - total_start;
+
+   DebugMessage(M64MSG_INFO, "profile: total=%llins - gfx=%llins - audio=%llins - compiler=%llins - idle=%llins",
+      time_to_nsec(total_in_section[TIMED_SECTION_ALL]),
+      time_to_nsec(total_in_section[TIMED_SECTION_GFX]),
+      time_to_nsec(total_in_section[TIMED_SECTION_AUDIO]),
+      time_to_nsec(total_in_section[TIMED_SECTION_COMPILER]),
+      time_to_nsec(total_in_section[TIMED_SECTION_IDLE]));
+   DebugMessage(M64MSG_INFO, "profile: code cache=%llins - hits=%lli - misses=%lli",
+      time_to_nsec(total_in_section[TIMED_SECTION_CODE_CACHE]),
+      total_counters[TIMED_COUNTER_CODE_CACHE_HITS],
+      total_counters[TIMED_COUNTER_CODE_CACHE_MISSES]);
 }
 
 void timed_sections_refresh()
@@ -90,10 +131,17 @@ void timed_sections_refresh()
          time_to_nsec(time_in_section[TIMED_SECTION_AUDIO]),
          time_to_nsec(time_in_section[TIMED_SECTION_COMPILER]),
          time_to_nsec(time_in_section[TIMED_SECTION_IDLE]));
+      DebugMessage(M64MSG_INFO, "code cache=%llins - hits=%lli - misses=%lli",
+         time_to_nsec(time_in_section[TIMED_SECTION_CODE_CACHE]),
+         counters[TIMED_COUNTER_CODE_CACHE_HITS],
+         counters[TIMED_COUNTER_CODE_CACHE_MISSES]);
       time_in_section[TIMED_SECTION_GFX] = 0;
       time_in_section[TIMED_SECTION_AUDIO] = 0;
       time_in_section[TIMED_SECTION_COMPILER] = 0;
       time_in_section[TIMED_SECTION_IDLE] = 0;
+      time_in_section[TIMED_SECTION_CODE_CACHE] = 0;
+      counters[TIMED_COUNTER_CODE_CACHE_HITS] = 0;
+      counters[TIMED_COUNTER_CODE_CACHE_MISSES] = 0;
       last_start[TIMED_SECTION_ALL] = curr_time;
    }
 }
@@ -31,11 +31,25 @@ enum timed_section
     TIMED_SECTION_AUDIO,
     TIMED_SECTION_COMPILER,
     TIMED_SECTION_IDLE,
+    TIMED_SECTION_CODE_CACHE,
     NUM_TIMED_SECTIONS
 };
 
+enum timed_counter
+{
+    TIMED_COUNTER_CODE_CACHE_HITS,
+    TIMED_COUNTER_CODE_CACHE_MISSES,
+    NUM_TIMED_COUNTERS
+};
+
 void timed_section_start(enum timed_section section);
 void timed_section_end(enum timed_section section);
 void timed_sections_refresh(void);
 
+/* the totals are reported when emulation stops */
+void timed_sections_reset(void);
+void timed_sections_report(void);
+
+void timed_counter_add(enum timed_counter counter, int value);
+
 #endif
@@ -0,0 +1,401 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rewind.c                                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2025 Rosalie Wanders                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* The rewind buffer keeps the latest snapshot of the device state in full,
+ * older snapshots are stored in a ring buffer as a list of deltas.
+ *
+ * Every delta record contains the pages which differ between a snapshot and
+ * the snapshot before it, each page is stored as the XOR of both pages where
+ * runs of zero words are skipped. Because XOR is symmetric, applying the
+ * newest record to the latest snapshot results in the previous snapshot.
+ *
+ * When the ring buffer is full, the oldest records are dropped. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef USE_SDL3
+#include <SDL3/SDL.h>
+#else
+#include <SDL.h>
+#endif
+
+#include "api/callbacks.h"
+#include "api/m64p_types.h"
+#include "main.h"
+#include "rewind.h"
+#include "savestates.h"
+
+#define REWIND_PAGE_SIZE   4096
+#define REWIND_PAGE_WORDS  (REWIND_PAGE_SIZE / sizeof(uint64_t))
+#define REWIND_MAX_RECORDS 4096
+
+/* worst case size of an encoded page:
+ * page index and size, one token and all words as literals */
+#define REWIND_MAX_PAGE_SIZE (4 + 4 + 4 + REWIND_PAGE_SIZE)
+
+#ifdef USE_SDL3
+#define rewind_atomic_t SDL_AtomicInt
+#define rewind_atomic_get SDL_GetAtomicInt
+#define rewind_atomic_set SDL_SetAtomicInt
+#else
+#define rewind_atomic_t SDL_atomic_t
+#define rewind_atomic_get SDL_AtomicGet
+#define rewind_atomic_set SDL_AtomicSet
+#endif
+
+struct rewind_record
+{
+    size_t offset;
+    size_t size;
+};
+
+static int l_RewindInit = 0;
+static unsigned int l_Interval = 0;
+static unsigned int l_VICount = 0;
+static int l_SnapshotPending = 0;
+/* the step back is requested by the frontend thread */
+static rewind_atomic_t l_StepBackPending;
+
+/* serialized device state */
+static uint8_t* l_State = NULL;
+static size_t l_StateSize = 0;
+
+/* latest snapshot */
+static uint8_t* l_Snapshot = NULL;
+static int l_HasSnapshot = 0;
+
+/* scratch buffer for encoding records */
+static uint8_t* l_Delta = NULL;
+
+/* ring buffer of delta records */
+static uint8_t* l_Buffer = NULL;
+static size_t l_BufferSize = 0;
+static struct rewind_record l_Records[REWIND_MAX_RECORDS];
+static unsigned int l_FirstRecord = 0;
+static unsigned int l_RecordCount = 0;
+/* copy of l_RecordCount for the frontend thread,
+ * l_RecordCount itself is only used by the emulation thread */
+static rewind_atomic_t l_PublishedCount;
+
+static size_t rewind_encode_page(uint8_t* out, const uint64_t* state, const uint64_t* snapshot)
+{
+    uint8_t* curr = out;
+    uint64_t value;
+    uint16_t zeros, literals;
+    size_t i = 0, j;
+
+    while (i < REWIND_PAGE_WORDS)
+    {
+        zeros = 0;
+        literals = 0;
+
+        while (i < REWIND_PAGE_WORDS && state[i] == snapshot[i]) {
+            zeros++;
+            i++;
+        }
+
+        j = i;
+        while (i < REWIND_PAGE_WORDS && state[i] != snapshot[i]) {
+            literals++;
+            i++;
+        }
+
+        if (literals == 0)
+            break;
+
+        memcpy(curr, &zeros, sizeof(zeros));
+        memcpy(curr + 2, &literals, sizeof(literals));
+        curr += 4;
+
+        for (; j < i; j++) {
+            value = state[j] ^ snapshot[j];
+            memcpy(curr, &value, sizeof(value));
+            curr += sizeof(value);
+        }
+    }
+
+    return (size_t)(curr - out);
+}
+
+static void rewind_decode_page(uint64_t* snapshot, const uint8_t* data, size_t size)
+{
+    const uint8_t* end = data + size;
+    uint64_t value;
+    uint16_t zeros, literals;
+    size_t i = 0;
+
+    while (data < end)
+    {
+        memcpy(&zeros, data, sizeof(zeros));
+        memcpy(&literals, data + 2, sizeof(literals));
+        data += 4;
+
+        i += zeros;
+        for (; literals > 0; literals--, i++) {
+            memcpy(&value, data, sizeof(value));
+            data += sizeof(value);
+            snapshot[i] ^= value;
+        }
+    }
+}
+
+static void rewind_publish_count(void)
+{
+    rewind_atomic_set(&l_PublishedCount, (int)l_RecordCount);
+}
+
+static void rewind_drop_oldest_record(void)
+{
+    l_FirstRecord = (l_FirstRecord + 1) % REWIND_MAX_RECORDS;
+    l_RecordCount--;
+}
+
+static void rewind_push_record(const uint8_t* data, size_t size)
+{
+    struct rewind_record* record;
+    size_t offset = 0, tail = 0;
+    int wrapped = 0;
+
+    /* when the record doesn't fit, the older
+     * records can't be reached anymore */
+    if (size > l_BufferSize) {
+        l_RecordCount = 0;
+        rewind_publish_count();
+        return;
+    }
+
+    if (l_RecordCount == REWIND_MAX_RECORDS)
+        rewind_drop_oldest_record();
+
+    if (l_RecordCount > 0) {
+        record = &l_Records[(l_FirstRecord + l_RecordCount - 1) % REWIND_MAX_RECORDS];
+        tail = record->offset + record->size;
+    }
+
+    offset = tail;
+    if (offset + size > l_BufferSize) {
+        offset = 0;
+        wrapped = 1;
+    }
+
+    /* the records after the tail are the oldest ones,
+     * drop them until the new record doesn't overlap */
+    while (l_RecordCount > 0)
+    {
+        record = &l_Records[l_FirstRecord];
+        if ((wrapped && record->offset >= tail) ||
+            (record->offset < offset + size && offset < record->offset + record->size)) {
+            rewind_drop_oldest_record();
+        }
+        else {
+            break;
+        }
+    }
+
+    memcpy(l_Buffer + offset, data, size);
+
+    record = &l_Records[(l_FirstRecord + l_RecordCount) % REWIND_MAX_RECORDS];
+    record->offset = offset;
+    record->size = size;
+    l_RecordCount++;
+    rewind_publish_count();
+}
+
+m64p_error rewind_init(size_t size, unsigned int interval)
+{
+    size_t pages;
+
+    if (size == 0 || interval == 0)
+        return M64ERR_INPUT_INVALID;
+
+    rewind_deinit();
+
+    /* round up to whole pages, the padding stays zero */
+    l_StateSize = (savestates_get_m64p_size() + REWIND_PAGE_SIZE - 1) & ~(size_t)(REWIND_PAGE_SIZE - 1);
+    pages = l_StateSize / REWIND_PAGE_SIZE;
+
+    l_State = calloc(1, l_StateSize);
+    l_Snapshot = calloc(1, l_StateSize);
+    l_Delta = malloc(pages * REWIND_MAX_PAGE_SIZE);
+    l_Buffer = malloc(size);
+    if (l_State == NULL || l_Snapshot == NULL || l_Delta == NULL || l_Buffer == NULL) {
+        rewind_deinit();
+        return M64ERR_NO_MEMORY;
+    }
+
+    l_BufferSize = size;
+    l_Interval = interval;
+    l_RewindInit = 1;
+
+    rewind_reset();
+    return M64ERR_SUCCESS;
+}
+
+void rewind_deinit(void)
+{
+    free(l_State);
+    free(l_Snapshot);
+    free(l_Delta);
+    free(l_Buffer);
+
+    l_State = NULL;
+    l_Snapshot = NULL;
+    l_Delta = NULL;
+    l_Buffer = NULL;
+    l_StateSize = 0;
+    l_BufferSize = 0;
+    l_RewindInit = 0;
+
+    rewind_reset();
+}
+
+void rewind_reset(void)
+{
+    l_VICount = 0;
+    l_SnapshotPending = 0;
+    rewind_atomic_set(&l_StepBackPending, 0);
+    l_HasSnapshot = 0;
+    l_FirstRecord = 0;
+    l_RecordCount = 0;
+    rewind_publish_count();
+}
+
+int rewind_is_init(void)
+{
+    return l_RewindInit;
+}
+
+unsigned int rewind_get_count(void)
+{
+    return (unsigned int)rewind_atomic_get(&l_PublishedCount);
+}
+
+rewind_job rewind_get_job(void)
+{
+    if (rewind_atomic_get(&l_StepBackPending))
+        return rewind_job_step_back;
+    if (l_SnapshotPending)
+        return rewind_job_snapshot;
+    return rewind_job_nothing;
+}
+
+m64p_error rewind_request_step_back(void)
+{
+    if (!l_RewindInit || rewind_atomic_get(&l_PublishedCount) == 0)
+        return M64ERR_INVALID_STATE;
+
+    rewind_atomic_set(&l_StepBackPending, 1);
+    return M64ERR_SUCCESS;
+}
+
+void rewind_new_vi(void)
+{
+    if (!l_RewindInit)
+        return;
+
+    if (++l_VICount >= l_Interval)
+        l_SnapshotPending = 1;
+}
+
+int rewind_snapshot(void)
+{
+    size_t offset;
+    uint32_t page, size;
+    uint8_t* curr = l_Delta;
+
+    l_SnapshotPending = 0;
+    l_VICount = 0;
+
+    savestates_serialize_m64p(&g_dev, l_State);
+
+    if (!l_HasSnapshot) {
+        memcpy(l_Snapshot, l_State, l_StateSize);
+        l_HasSnapshot = 1;
+        return 1;
+    }
+
+    /* encode the pages which differ from the latest
+     * snapshot and update the latest snapshot */
+    for (offset = 0, page = 0; offset < l_StateSize; offset += REWIND_PAGE_SIZE, page++)
+    {
+        if (memcmp(l_State + offset, l_Snapshot + offset, REWIND_PAGE_SIZE) == 0)
+            continue;
+
+        size = (uint32_t)rewind_encode_page(curr + 8,
+                                            (const uint64_t*)(l_State + offset),
+                                            (const uint64_t*)(l_Snapshot + offset));
+        memcpy(curr, &page, sizeof(page));
+        memcpy(curr + 4, &size, sizeof(size));
+        curr += 8 + size;
+
+        memcpy(l_Snapshot + offset, l_State + offset, REWIND_PAGE_SIZE);
+    }
+
+    if (curr != l_Delta)
+        rewind_push_record(l_Delta, (size_t)(curr - l_Delta));
+
+    return 1;
+}
+
+int rewind_step_back(void)
+{
+    const struct rewind_record* record;
+    const uint8_t* curr;
+    const uint8_t* end;
+    uint32_t page, size;
+
+    rewind_atomic_set(&l_StepBackPending, 0);
+    l_SnapshotPending = 0;
+    l_VICount = 0;
+
+    if (l_RecordCount == 0)
+        return 0;
+
+    /* restore the previous snapshot from the newest record */
+    record = &l_Records[(l_FirstRecord + l_RecordCount - 1) % REWIND_MAX_RECORDS];
+    curr = l_Buffer + record->offset;
+    end = curr + record->size;
+
+    while (curr < end)
+    {
+        memcpy(&page, curr, sizeof(page));
+        memcpy(&size, curr + 4, sizeof(size));
+        curr += 8;
+
+        rewind_decode_page((uint64_t*)(l_Snapshot + (size_t)page * REWIND_PAGE_SIZE), curr, size);
+        curr += size;
+    }
+
+    l_RecordCount--;
+    rewind_publish_count();
+
+    /* the state is converted in place, so load it from a copy */
+    memcpy(l_State, l_Snapshot, l_StateSize);
+    if (!savestates_deserialize_m64p(&g_dev, l_State)) {
+        DebugMessage(M64MSG_ERROR, "Failed to restore rewind snapshot");
+        rewind_reset();
+        return 0;
+    }
+
+    return 1;
+}
@@ -0,0 +1,62 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - rewind.h                                                *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2025 Rosalie Wanders                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_REWIND_H
+#define M64P_MAIN_REWIND_H
+
+#include "api/m64p_types.h"
+
+#include <stddef.h>
+
+typedef enum _rewind_job
+{
+    rewind_job_nothing,
+    rewind_job_snapshot,
+    rewind_job_step_back
+} rewind_job;
+
+/* allocates the rewind buffers, size is the size of the
+ * delta ring buffer in bytes and interval the amount of
+ * VIs between snapshots */
+m64p_error rewind_init(size_t size, unsigned int interval);
+void rewind_deinit(void);
+
+/* drops all snapshots */
+void rewind_reset(void);
+
+int rewind_is_init(void);
+
+/* returns the amount of snapshots which can be restored */
+unsigned int rewind_get_count(void);
+
+rewind_job rewind_get_job(void);
+m64p_error rewind_request_step_back(void);
+
+/* called on every VI, schedules a snapshot
+ * once the interval has passed */
+void rewind_new_vi(void);
+
+/* performs the pending job, must be called when
+ * the device state is safe to save or load */
+int rewind_snapshot(void);
+int rewind_step_back(void);
+
+#endif /* M64P_MAIN_REWIND_H */
@@ -138,6 +138,85 @@ static void swap_copy_rom(void* dst, const void* src, size_t len, unsigned char*
     }
 }
 
+/* Fills in the ROM settings for the given big-endian ROM header and MD5 digest
+ * from the rom database, this doesn't modify the currently loaded ROM. Returns
+ * the rom database entry when it was found by MD5 or CRC, NULL otherwise. */
+romdatabase_entry* rom_lookup_settings(m64p_rom_settings* settings, const m64p_rom_header* header, const md5_byte_t* digest)
+{
+    romdatabase_entry* entry;
+    romdatabase_entry* found_entry = NULL;
+    char headername[21];
+
+    memcpy(headername, header->Name, 20);
+    headername[20] = '\0';
+    trim(headername); /* Remove trailing whitespace from ROM name. */
+
+    /* Look up this ROM in the .ini file and fill in goodname, etc */
+    if ((entry=ini_search_by_md5((md5_byte_t*)digest)) != NULL ||
+        (entry=ini_search_by_crc(tohl(header->CRC1),tohl(header->CRC2))) != NULL)
+    {
+        found_entry = entry;
+        strncpy(settings->goodname, entry->goodname, 255);
+        settings->goodname[255] = '\0';
+        settings->savetype = entry->savetype;
+        settings->status = entry->status;
+        settings->players = entry->players;
+        settings->rumble = entry->rumble;
+        settings->transferpak = entry->transferpak;
+        settings->mempak = entry->mempak;
+        settings->biopak = entry->biopak;
+        settings->countperop = entry->countperop;
+        settings->disableextramem = entry->disableextramem;
+        settings->sidmaduration = entry->sidmaduration;
+        settings->aidmamodifier = entry->aidmamodifier;
+    }
+    else if ((entry=ini_search_by_internal_name_and_country(headername, header->Country_code)) != NULL)
+    {
+        strcpy(settings->goodname, headername);
+        strcat(settings->goodname, " (unknown rom)");
+        settings->savetype = entry->savetype;
+        settings->status = entry->status;
+        settings->players = entry->players;
+        settings->rumble = entry->rumble;
+        settings->transferpak = entry->transferpak;
+        settings->mempak = entry->mempak;
+        settings->biopak = entry->biopak;
+        settings->countperop = entry->countperop;
+        settings->disableextramem = entry->disableextramem;
+        settings->sidmaduration = entry->sidmaduration;
+        settings->aidmamodifier = entry->aidmamodifier;
+    }
+    else
+    {
+        strcpy(settings->goodname, headername);
+        strcat(settings->goodname, " (unknown rom)");
+        settings->status = 0;
+        settings->players = 4;
+        settings->rumble = 1;
+        settings->transferpak = 0;
+        settings->mempak = 1;
+        settings->biopak = 0;
+        settings->countperop = DEFAULT_COUNT_PER_OP;
+        settings->disableextramem = DEFAULT_DISABLE_EXTRA_MEM;
+        settings->sidmaduration = DEFAULT_SI_DMA_DURATION;
+        settings->aidmamodifier = DEFAULT_AI_DMA_MODIFIER;
+
+        /* check if ROM has the Advanced Homebrew ROM Header (see https://n64brew.dev/wiki/ROM_Header) */
+        if (header->Cartridge_ID == 0x4445)
+        {
+            /* When current ROM has the Advanced Homebrew ROM Header, use the save type */
+            settings->savetype = rom_homebrew_savetype_to_savetype(header->Version >> 4);
+        }
+        else
+        {
+            /* There's no way to guess the save type, but 4K EEPROM is better than nothing */
+            settings->savetype = SAVETYPE_EEPROM_4K;
+        }
+    }
+
+    return found_entry;
+}
+
 m64p_error open_rom(const unsigned char* romimage, unsigned int size)
 {
     md5_state_t state;
@@ -178,76 +257,14 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
 
     /* add some useful properties to ROM_PARAMS */
     ROM_PARAMS.systemtype = rom_country_code_to_system_type(ROM_HEADER.Country_code);
-    ROM_PARAMS.cheats = NULL;
 
     memcpy(ROM_PARAMS.headername, ROM_HEADER.Name, 20);
     ROM_PARAMS.headername[20] = '\0';
     trim(ROM_PARAMS.headername); /* Remove trailing whitespace from ROM name. */
 
     /* Look up this ROM in the .ini file and fill in goodname, etc */
-    if ((entry=ini_search_by_md5(digest)) != NULL ||
-        (entry=ini_search_by_crc(tohl(ROM_HEADER.CRC1),tohl(ROM_HEADER.CRC2))) != NULL)
-    {
-        strncpy(ROM_SETTINGS.goodname, entry->goodname, 255);
-        ROM_SETTINGS.goodname[255] = '\0';
-        ROM_SETTINGS.savetype = entry->savetype;
-        ROM_SETTINGS.status = entry->status;
-        ROM_SETTINGS.players = entry->players;
-        ROM_SETTINGS.rumble = entry->rumble;
-        ROM_SETTINGS.transferpak = entry->transferpak;
-        ROM_SETTINGS.mempak = entry->mempak;
-        ROM_SETTINGS.biopak = entry->biopak;
-        ROM_SETTINGS.countperop = entry->countperop;
-        ROM_SETTINGS.disableextramem = entry->disableextramem;
-        ROM_SETTINGS.sidmaduration = entry->sidmaduration;
-        ROM_SETTINGS.aidmamodifier = entry->aidmamodifier;
-        ROM_PARAMS.cheats = entry->cheats;
-    }
-    else if ((entry=ini_search_by_internal_name_and_country(ROM_PARAMS.headername, ROM_HEADER.Country_code)) != NULL)
-    {
-        strcpy(ROM_SETTINGS.goodname, ROM_PARAMS.headername);
-        strcat(ROM_SETTINGS.goodname, " (unknown rom)");
-        ROM_SETTINGS.savetype = entry->savetype;
-        ROM_SETTINGS.status = entry->status;
-        ROM_SETTINGS.players = entry->players;
-        ROM_SETTINGS.rumble = entry->rumble;
-        ROM_SETTINGS.transferpak = entry->transferpak;
-        ROM_SETTINGS.mempak = entry->mempak;
-        ROM_SETTINGS.biopak = entry->biopak;
-        ROM_SETTINGS.countperop = entry->countperop;
-        ROM_SETTINGS.disableextramem = entry->disableextramem;
-        ROM_SETTINGS.sidmaduration = entry->sidmaduration;
-        ROM_SETTINGS.aidmamodifier = entry->aidmamodifier;
-        ROM_PARAMS.cheats = NULL;
-    }
-    else
-    {
-        strcpy(ROM_SETTINGS.goodname, ROM_PARAMS.headername);
-        strcat(ROM_SETTINGS.goodname, " (unknown rom)");
-        ROM_SETTINGS.status = 0;
-        ROM_SETTINGS.players = 4;
-        ROM_SETTINGS.rumble = 1;
-        ROM_SETTINGS.transferpak = 0;
-        ROM_SETTINGS.mempak = 1;
-        ROM_SETTINGS.biopak = 0;
-        ROM_SETTINGS.countperop = DEFAULT_COUNT_PER_OP;
-        ROM_SETTINGS.disableextramem = DEFAULT_DISABLE_EXTRA_MEM;
-        ROM_SETTINGS.sidmaduration = DEFAULT_SI_DMA_DURATION;
-        ROM_SETTINGS.aidmamodifier = DEFAULT_AI_DMA_MODIFIER;
-        ROM_PARAMS.cheats = NULL;
-
-        /* check if ROM has the Advanced Homebrew ROM Header (see https://n64brew.dev/wiki/ROM_Header) */
-        if (ROM_HEADER.Cartridge_ID == 0x4445)
-        {
-            /* When current ROM has the Advanced Homebrew ROM Header, use the save type */
-            ROM_SETTINGS.savetype = rom_homebrew_savetype_to_savetype(ROM_HEADER.Version >> 4);
-        }
-        else
-        {
-            /* There's no way to guess the save type, but 4K EEPROM is better than nothing */
-            ROM_SETTINGS.savetype = SAVETYPE_EEPROM_4K;
-        }
-    }
+    entry = rom_lookup_settings(&ROM_SETTINGS, &ROM_HEADER, digest);
+    ROM_PARAMS.cheats = (entry != NULL) ? entry->cheats : NULL;
 
     /* print out a bunch of info about the ROM */
     DebugMessage(M64MSG_INFO, "Goodname: %s", ROM_SETTINGS.goodname);
@@ -164,5 +164,7 @@ void romdatabase_close(void);
  */
 romdatabase_entry* ini_search_by_crc(unsigned int crc1, unsigned int crc2);
 
+romdatabase_entry* rom_lookup_settings(m64p_rom_settings* settings, const m64p_rom_header* header, const md5_byte_t* digest);
+
 #endif /* __ROM_H__ */
 
@@ -64,6 +64,9 @@ enum { DD_DISK_ID_OFFSET = 0x43670 };
 
 static const char* savestate_magic = "M64+SAVE";
 static const int savestate_latest_version = 0x00020000;  /* 2.0 */
+/* container for savestates which are compressed with a fast codec */
+static const char* savestate_fast_magic = "M64+FAST";
+enum { savestate_codec_zero_run = 1 };
 static const unsigned char pj64_magic[4] = { 0xC8, 0xA6, 0xD8, 0x23 };
 
 static savestates_job job = savestates_job_nothing;
@@ -79,6 +82,26 @@ static SDL_Mutex *savestates_lock;
 static SDL_mutex *savestates_lock;
 #endif
 
+/* state of a save or load from memory, the job is
+ * performed by the emulation thread while the
+ * requesting thread waits for it to complete */
+enum { memory_job_pending, memory_job_running, memory_job_done };
+
+static savestates_job memory_job = savestates_job_nothing;
+static int memory_job_state = memory_job_done;
+static int memory_job_result = 0;
+static void *memory_job_buffer = NULL;
+#ifdef USE_SDL3
+static SDL_Mutex *memory_job_lock;
+static SDL_Condition *memory_job_cond;
+static SDL_ThreadID memory_job_emulation_thread;
+#else
+static SDL_mutex *memory_job_lock;
+static SDL_cond *memory_job_cond;
+static SDL_threadID memory_job_emulation_thread;
+#endif
+static int memory_job_emulation_thread_set = 0;
+
 struct savestate_work {
     char *filepath;
     char *data;
@@ -86,6 +109,9 @@ struct savestate_work {
     struct work_struct work;
 };
 
+/* signaled once all queued savestate writes have finished */
+static struct work_completion *savestates_write_completion = NULL;
+
 /* Returns the malloc'd full path of the currently selected savestate. */
 static char *savestates_generate_path(savestates_type type)
 {
@@ -101,6 +127,7 @@ static char *savestates_generate_path(savestates_type type)
         switch (type)
         {
             case savestates_type_m64p:
+            case savestates_type_m64p_fast:
                 /* check if old file path exists, if it does then use that */
                 filepath = formatstr("%s%s.st%d", get_savestatepath(), ROM_SETTINGS.goodname, slot);
                 if (get_file_size(filepath, &size) != file_ok || size == 0)
@@ -194,126 +221,172 @@ static void savestates_clear_job(void)
 #define PUTDATA(buff, type, value) \
     do { type x = value; PUTARRAY(&x, buff, type, 1); } while(0)
 
-static int savestates_load_m64p(struct device* dev, char *filepath)
+static int savestates_check_m64p_header(const unsigned char *curr, unsigned int *version, const char *filepath)
 {
-    unsigned char header[44];
-    gzFile f;
-    unsigned int version;
-    int i;
-    uint32_t FCR31;
-
-    size_t savestateSize;
-    unsigned char *savestateData, *curr;
-    char queue[1024];
-    unsigned char using_tlb_data[4];
-    unsigned char data_0001_0200[4096]; // 4k for extra state from v1.2
-
-    uint32_t* cp0_regs = r4300_cp0_regs(&dev->r4300.cp0);
-
-    SDL_LockMutex(savestates_lock);
-
-    f = osal_gzopen(filepath, "rb");
-    if(f==NULL)
+    if(strncmp((const char *)curr, savestate_magic, 8)!=0)
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", filepath);
-        SDL_UnlockMutex(savestates_lock);
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State file: %s is not a valid Mupen64plus savestate.", filepath);
         return 0;
     }
+    curr += 8;
 
-    /* Read and check Mupen64Plus magic number. */
-    if (gzread(f, header, 44) != 44)
+    *version = *curr++;
+    *version = (*version << 8) | *curr++;
+    *version = (*version << 8) | *curr++;
+    *version = (*version << 8) | *curr++;
+    if((*version >> 16) != (savestate_latest_version >> 16))
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read header from state file %s", filepath);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State version (%08x) isn't compatible. Please update Mupen64Plus.", *version);
         return 0;
     }
-    curr = header;
 
-    if(strncmp((char *)curr, savestate_magic, 8)!=0)
+    if(memcmp((const char *)curr, ROM_SETTINGS.MD5, 32))
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State file: %s is not a valid Mupen64plus savestate.", filepath);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State ROM MD5 does not match current ROM.");
         return 0;
     }
-    curr += 8;
 
-    version = *curr++;
-    version = (version << 8) | *curr++;
-    version = (version << 8) | *curr++;
-    version = (version << 8) | *curr++;
-    if((version >> 16) != (savestate_latest_version >> 16))
+    return 1;
+}
+
+/* The zero run codec stores the state as 64-bit words, runs of zero words
+ * are skipped. Every token contains the amount of zero words followed by the
+ * amount of literal words and the literal words themselves, the remaining
+ * bytes are stored as is. It's a lot faster than zlib, most of the state
+ * (the TLB lookup tables and unused RDRAM) is zero. */
+static size_t savestates_zero_run_bound(size_t size)
+{
+    return size + (size / 16 + 2) * 8;
+}
+
+static int savestates_is_zero_word(const unsigned char *data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value == 0;
+}
+
+static size_t savestates_zero_run_encode(const unsigned char *src, size_t size, unsigned char *dst)
+{
+    unsigned char *curr = dst;
+    size_t words = size / 8;
+    size_t i = 0, j;
+    uint32_t zeros, literals;
+
+    while (i < words)
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State version (%08x) isn't compatible. Please update Mupen64Plus.", version);
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
+        zeros = 0;
+        while (i < words && savestates_is_zero_word(src + i * 8))
+        {
+            zeros++;
+            i++;
+        }
+
+        j = i;
+        literals = 0;
+        while (i < words && !savestates_is_zero_word(src + i * 8))
+        {
+            literals++;
+            i++;
+        }
+
+        PUTDATA(curr, uint32_t, zeros);
+        PUTDATA(curr, uint32_t, literals);
+        PUTARRAY(src + j * 8, curr, unsigned char, literals * 8);
     }
 
-    if(memcmp((char *)curr, ROM_SETTINGS.MD5, 32))
+    PUTARRAY(src + words * 8, curr, unsigned char, size % 8);
+    return (size_t)(curr - dst);
+}
+
+static int savestates_zero_run_decode(unsigned char *src, size_t src_size, unsigned char *dst, size_t size)
+{
+    unsigned char *end = src + src_size;
+    size_t words = size / 8;
+    size_t i = 0;
+    uint32_t zeros, literals;
+
+    while (i < words)
     {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State ROM MD5 does not match current ROM.");
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
-        return 0;
+        if ((size_t)(end - src) < 8)
+            return 0;
+
+        zeros = GETDATA(src, uint32_t);
+        literals = GETDATA(src, uint32_t);
+        if ((zeros == 0 && literals == 0) ||
+            zeros > words - i ||
+            literals > words - i - zeros ||
+            (size_t)(end - src) < (size_t)literals * 8)
+            return 0;
+
+        memset(dst + i * 8, 0, (size_t)zeros * 8);
+        i += zeros;
+        memcpy(dst + i * 8, src, (size_t)literals * 8);
+        src += (size_t)literals * 8;
+        i += literals;
     }
-    curr += 32;
 
-    /* Read the rest of the savestate */
-    savestateSize = 16788244;
-    savestateData = curr = (unsigned char *)malloc(savestateSize);
-    if (savestateData == NULL)
-    {
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to load state.");
-        gzclose(f);
-        SDL_UnlockMutex(savestates_lock);
+    if ((size_t)(end - src) != size % 8)
         return 0;
+
+    memcpy(dst + words * 8, src, size % 8);
+    return 1;
+}
+
+/* Returns the malloc'd state image stored in a fast savestate container,
+ * the container magic has already been read. */
+static unsigned char *savestates_read_m64p_fast(gzFile f, const char *filepath)
+{
+    unsigned char header[8], *curr = header;
+    unsigned char *data, *image;
+    uint32_t codec, size;
+    int data_size;
+
+    if (gzread(f, header, sizeof(header)) != sizeof(header))
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read header from state file %s", filepath);
+        return NULL;
     }
-    if (version == 0x00010000) /* original savestate version */
+
+    codec = GETDATA(curr, uint32_t);
+    size = GETDATA(curr, uint32_t);
+    if (codec != savestate_codec_zero_run || size != savestates_get_m64p_size())
     {
-        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
-            (gzread(f, queue, sizeof(queue)) % 4) != 0)
-        {
-            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.0 data from %s", filepath);
-            free(savestateData);
-            gzclose(f);
-            SDL_UnlockMutex(savestates_lock);
-            return 0;
-        }
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State file: %s uses an unsupported codec.", filepath);
+        return NULL;
     }
-    else if (version == 0x00010100) // saves entire eventqueue plus 4-byte using_tlb flags
+
+    data = malloc(savestates_zero_run_bound(size));
+    image = malloc(size);
+    if (data == NULL || image == NULL)
     {
-        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
-            gzread(f, queue, sizeof(queue)) != sizeof(queue) ||
-            gzread(f, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data))
-        {
-            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.1 data from %s", filepath);
-            free(savestateData);
-            gzclose(f);
-            SDL_UnlockMutex(savestates_lock);
-            return 0;
-        }
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to load state.");
+        free(data);
+        free(image);
+        return NULL;
     }
-    else // version >= 0x00010200  saves entire eventqueue, 4-byte using_tlb flags and extra state
+
+    data_size = gzread(f, data, (unsigned int)savestates_zero_run_bound(size));
+    if (data_size < 0 || !savestates_zero_run_decode(data, (size_t)data_size, image, size))
     {
-        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
-            gzread(f, queue, sizeof(queue)) != sizeof(queue) ||
-            gzread(f, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data) ||
-            gzread(f, data_0001_0200, sizeof(data_0001_0200)) != sizeof(data_0001_0200))
-        {
-            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.2+ data from %s", filepath);
-            free(savestateData);
-            gzclose(f);
-            SDL_UnlockMutex(savestates_lock);
-            return 0;
-        }
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate data from %s", filepath);
+        free(data);
+        free(image);
+        return NULL;
     }
 
-    gzclose(f);
-    SDL_UnlockMutex(savestates_lock);
+    free(data);
+    return image;
+}
+
+static void savestates_parse_m64p(struct device* dev, unsigned int version, unsigned char *curr,
+                                  char *queue, unsigned char *using_tlb_data, unsigned char *data_0001_0200)
+{
+    int i;
+    uint32_t FCR31;
+
+    uint32_t* cp0_regs = r4300_cp0_regs(&dev->r4300.cp0);
 
-    // Parse savestate
     dev->rdram.regs[0][RDRAM_CONFIG_REG]       = GETDATA(curr, uint32_t);
     dev->rdram.regs[0][RDRAM_DEVICE_ID_REG]    = GETDATA(curr, uint32_t);
     dev->rdram.regs[0][RDRAM_DELAY_REG]        = GETDATA(curr, uint32_t);
@@ -969,6 +1042,141 @@ static int savestates_load_m64p(struct device* dev, char *filepath)
     dev->r4300.cp0.interrupt_unsafe_state = 0;
 
     *r4300_cp0_last_addr(&dev->r4300.cp0) = *r4300_pc(&dev->r4300);
+}
+
+/* parses a complete state image, excluding the header */
+static void savestates_parse_m64p_image(struct device* dev, unsigned int version, unsigned char *curr)
+{
+    savestates_parse_m64p(dev, version, curr,
+                          (char *)(curr + 16788244),
+                          curr + 16788244 + 1024,
+                          curr + 16788244 + 1024 + 4);
+}
+
+static int savestates_load_m64p(struct device* dev, char *filepath)
+{
+    unsigned char header[44];
+    gzFile f;
+    unsigned int version;
+
+    size_t savestateSize;
+    unsigned char *savestateData;
+    char queue[1024];
+    unsigned char using_tlb_data[4];
+    unsigned char data_0001_0200[4096]; // 4k for extra state from v1.2
+
+    SDL_LockMutex(savestates_lock);
+
+    f = osal_gzopen(filepath, "rb");
+    if(f==NULL)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", filepath);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+
+    /* Read and check Mupen64Plus magic number. */
+    if (gzread(f, header, 8) != 8)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read header from state file %s", filepath);
+        gzclose(f);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+
+    /* gzread() reads files which aren't compressed with zlib as is,
+     * so states which use a fast codec are read through it too */
+    if (strncmp((char *)header, savestate_fast_magic, 8) == 0)
+    {
+        savestateData = savestates_read_m64p_fast(f, filepath);
+        gzclose(f);
+        SDL_UnlockMutex(savestates_lock);
+
+        if (savestateData == NULL)
+            return 0;
+
+        if (!savestates_check_m64p_header(savestateData, &version, filepath))
+        {
+            free(savestateData);
+            return 0;
+        }
+
+        savestates_parse_m64p_image(dev, version, savestateData + 44);
+
+        free(savestateData);
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State loaded from: %s", namefrompath(filepath));
+        return 1;
+    }
+
+    if (gzread(f, header + 8, 36) != 36)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read header from state file %s", filepath);
+        gzclose(f);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+
+    if (!savestates_check_m64p_header(header, &version, filepath))
+    {
+        gzclose(f);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+
+    /* Read the rest of the savestate */
+    savestateSize = 16788244;
+    savestateData = (unsigned char *)malloc(savestateSize);
+    if (savestateData == NULL)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to load state.");
+        gzclose(f);
+        SDL_UnlockMutex(savestates_lock);
+        return 0;
+    }
+    if (version == 0x00010000) /* original savestate version */
+    {
+        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
+            (gzread(f, queue, sizeof(queue)) % 4) != 0)
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.0 data from %s", filepath);
+            free(savestateData);
+            gzclose(f);
+            SDL_UnlockMutex(savestates_lock);
+            return 0;
+        }
+    }
+    else if (version == 0x00010100) // saves entire eventqueue plus 4-byte using_tlb flags
+    {
+        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
+            gzread(f, queue, sizeof(queue)) != sizeof(queue) ||
+            gzread(f, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data))
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.1 data from %s", filepath);
+            free(savestateData);
+            gzclose(f);
+            SDL_UnlockMutex(savestates_lock);
+            return 0;
+        }
+    }
+    else // version >= 0x00010200  saves entire eventqueue, 4-byte using_tlb flags and extra state
+    {
+        if (gzread(f, savestateData, savestateSize) != (int)savestateSize ||
+            gzread(f, queue, sizeof(queue)) != sizeof(queue) ||
+            gzread(f, using_tlb_data, sizeof(using_tlb_data)) != sizeof(using_tlb_data) ||
+            gzread(f, data_0001_0200, sizeof(data_0001_0200)) != sizeof(data_0001_0200))
+        {
+            main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not read Mupen64Plus savestate 1.2+ data from %s", filepath);
+            free(savestateData);
+            gzclose(f);
+            SDL_UnlockMutex(savestates_lock);
+            return 0;
+        }
+    }
+
+    gzclose(f);
+    SDL_UnlockMutex(savestates_lock);
+
+    savestates_parse_m64p(dev, version, savestateData, queue, using_tlb_data, data_0001_0200);
 
     free(savestateData);
     main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State loaded from: %s", namefrompath(filepath));
@@ -1402,6 +1610,8 @@ static savestates_type savestates_detect_type(char *filepath)
 
     if (magic[0] == 0x1f && magic[1] == 0x8b) // GZIP header
         return savestates_type_m64p;
+    else if (memcmp(magic, "M64+", 4) == 0) // Mupen64Plus fast codec header
+        return savestates_type_m64p_fast;
     else if (memcmp(magic, "PK\x03\x04", 4) == 0) // ZIP header
         return savestates_type_pj64_zip;
     else if (memcmp(magic, pj64_magic, 4) == 0) // PJ64 header
@@ -1419,6 +1629,9 @@ int savestates_load(void)
     char *filepath = NULL;
     int ret = 0;
 
+    /* the state might still be written by the workqueue */
+    wait_for_completion(savestates_write_completion);
+
     if (fname == NULL) // For slots, autodetect the savestate type
     {
         // try M64P type first
@@ -1476,7 +1689,8 @@ int savestates_load(void)
 
         switch (type)
         {
-            case savestates_type_m64p: ret = savestates_load_m64p(dev, filepath); break;
+            case savestates_type_m64p:
+            case savestates_type_m64p_fast: ret = savestates_load_m64p(dev, filepath); break;
             case savestates_type_pj64_zip: ret = savestates_load_pj64_zip(dev, filepath); break;
             case savestates_type_pj64_unc: ret = savestates_load_pj64_unc(dev, filepath); break;
             default: ret = 0; break;
@@ -1532,48 +1746,76 @@ static void savestates_save_m64p_work(struct work_struct *work)
     StateChanged(M64CORE_STATE_SAVECOMPLETE, 1);
 }
 
-static int savestates_save_m64p(const struct device* dev, char *filepath)
+static void savestates_save_m64p_fast_work(struct work_struct *work)
 {
-    unsigned char outbuf[4];
-    int i;
-
-    char queue[1024];
-
-    struct savestate_work *save;
-    char *curr;
+    FILE *f;
+    unsigned char header[16], *curr = header;
+    unsigned char *data;
+    size_t size;
+    int ret = 0;
+    struct savestate_work *save = container_of(work, struct savestate_work, work);
 
-    /* OK to cast away const qualifier */
-    const uint32_t* cp0_regs = r4300_cp0_regs((struct cp0*)&dev->r4300.cp0);
+    SDL_LockMutex(savestates_lock);
 
-    save = malloc(sizeof(*save));
-    if (!save) {
+    data = malloc(savestates_zero_run_bound(save->size));
+    if (data == NULL)
+    {
         main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
-        return 0;
+        goto cleanup;
     }
 
-    save->filepath = strdup(filepath);
+    size = savestates_zero_run_encode((unsigned char *)save->data, save->size, data);
 
-    if(autoinc_save_slot)
-        savestates_inc_slot();
+    PUTARRAY(savestate_fast_magic, curr, unsigned char, 8);
+    PUTDATA(curr, uint32_t, savestate_codec_zero_run);
+    PUTDATA(curr, uint32_t, (uint32_t)save->size);
 
-    save_eventqueue_infos(&dev->r4300.cp0, queue);
+    f = osal_file_open(save->filepath, "wb");
+    if (f == NULL)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not open state file: %s", save->filepath);
+        goto cleanup;
+    }
 
-    // Allocate memory for the save state data
-    save->size = 16788288 + sizeof(queue) + 4 + 4096;
-    save->data = curr = malloc(save->size);
-    if (save->data == NULL)
+    if (fwrite(header, 1, sizeof(header), f) != sizeof(header) ||
+        fwrite(data, 1, size, f) != size)
     {
-        free(save->filepath);
-        free(save);
-        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
-        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
-        return 0;
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not write data to state file: %s", save->filepath);
+        fclose(f);
+        goto cleanup;
     }
 
-    memset(save->data, 0, save->size);
+    if (fclose(f) != 0)
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Could not write data to state file: %s", save->filepath);
+        goto cleanup;
+    }
+
+    main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Saved state to: %s", namefrompath(save->filepath));
+    ret = 1;
+
+cleanup:
+    free(data);
+    free(save->data);
+    free(save->filepath);
+    free(save);
+
+    SDL_UnlockMutex(savestates_lock);
+    StateChanged(M64CORE_STATE_SAVECOMPLETE, ret);
+}
+
+static void savestates_write_m64p(const struct device* dev, char *curr)
+{
+    unsigned char outbuf[4];
+    int i;
+
+    char queue[1024];
+
+    /* OK to cast away const qualifier */
+    const uint32_t* cp0_regs = r4300_cp0_regs((struct cp0*)&dev->r4300.cp0);
+
+    save_eventqueue_infos(&dev->r4300.cp0, queue);
 
-    // Write the save state data to memory
     PUTARRAY(savestate_magic, curr, unsigned char, 8);
 
     outbuf[0] = (savestate_latest_version >> 24) & 0xff;
@@ -1934,8 +2176,46 @@ static int savestates_save_m64p(const struct device* dev, char *filepath)
     PUTDATA(curr, uint32_t, dev->sp.rsp_status);
     PUTDATA(curr, uint32_t, dev->sp.first_run);
     PUTDATA(curr, uint32_t, dev->sp.rsp_wait);
+}
+
+static int savestates_save_m64p(const struct device* dev, char *filepath, savestates_type type)
+{
+    struct savestate_work *save;
+
+    save = malloc(sizeof(*save));
+    if (!save) {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
+        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
+        return 0;
+    }
+
+    save->filepath = strdup(filepath);
 
-    init_work(&save->work, savestates_save_m64p_work);
+    if(autoinc_save_slot)
+        savestates_inc_slot();
+
+    // Allocate memory for the save state data
+    save->size = savestates_get_m64p_size();
+    save->data = calloc(1, save->size);
+    if (save->data == NULL)
+    {
+        free(save->filepath);
+        free(save);
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Insufficient memory to save state.");
+        StateChanged(M64CORE_STATE_SAVECOMPLETE, 0);
+        return 0;
+    }
+
+    // Write the save state data to memory
+    savestates_write_m64p(dev, save->data);
+
+    if (type == savestates_type_m64p_fast)
+        init_work(&save->work, savestates_save_m64p_fast_work);
+    else
+        init_work(&save->work, savestates_save_m64p_work);
+    /* compressing the state is slow, don't hold up other work */
+    set_work_priority(&save->work, WORK_PRIORITY_LOW);
+    set_work_completion(&save->work, savestates_write_completion);
     queue_work(&save->work);
 
     return 1;
@@ -2195,7 +2475,7 @@ int savestates_save(void)
 
     if (fname != NULL && type == savestates_type_unknown)
         type = savestates_type_m64p;
-    else if (fname == NULL) // Always save slots in M64P format
+    else if (fname == NULL && type != savestates_type_m64p_fast) // Always save slots in M64P format
         type = savestates_type_m64p;
 
     filepath = savestates_generate_path(type);
@@ -2203,7 +2483,8 @@ int savestates_save(void)
     {
         switch (type)
         {
-            case savestates_type_m64p: ret = savestates_save_m64p(dev, filepath); break;
+            case savestates_type_m64p:
+            case savestates_type_m64p_fast: ret = savestates_save_m64p(dev, filepath, type); break;
             case savestates_type_pj64_zip: ret = savestates_save_pj64_zip(dev, filepath); break;
             case savestates_type_pj64_unc: ret = savestates_save_pj64_unc(dev, filepath); break;
             default: ret = 0; StateChanged(M64CORE_STATE_SAVECOMPLETE, ret); break;
@@ -2219,6 +2500,168 @@ int savestates_save(void)
     return ret;
 }
 
+size_t savestates_get_m64p_size(void)
+{
+    return 16788288 + 1024 + 4 + 4096;
+}
+
+void savestates_serialize_m64p(const struct device* dev, void *buffer)
+{
+    savestates_write_m64p(dev, (char *)buffer);
+}
+
+int savestates_deserialize_m64p(struct device* dev, void *buffer)
+{
+    unsigned char *curr = (unsigned char *)buffer;
+    unsigned int version;
+
+    if (strncmp((char *)curr, savestate_magic, 8) != 0)
+        return 0;
+    curr += 8;
+
+    version = *curr++;
+    version = (version << 8) | *curr++;
+    version = (version << 8) | *curr++;
+    version = (version << 8) | *curr++;
+    if (version != savestate_latest_version)
+        return 0;
+
+    if (memcmp((char *)curr, ROM_SETTINGS.MD5, 32))
+        return 0;
+    curr += 32;
+
+    savestates_parse_m64p_image(dev, version, curr);
+    return 1;
+}
+
+static m64p_error savestates_run_memory_job(savestates_job j, void *buffer, size_t size)
+{
+    int result;
+
+    if (buffer == NULL || size < savestates_get_m64p_size())
+        return M64ERR_INPUT_INVALID;
+
+    SDL_LockMutex(memory_job_lock);
+
+    /* the emulation thread would wait on itself,
+     * and it isn't at a safe point to do the job inline */
+#ifdef USE_SDL3
+    if (memory_job_emulation_thread_set && memory_job_emulation_thread == SDL_GetCurrentThreadID())
+#else
+    if (memory_job_emulation_thread_set && memory_job_emulation_thread == SDL_ThreadID())
+#endif
+    {
+        SDL_UnlockMutex(memory_job_lock);
+        DebugMessage(M64MSG_ERROR, "savestates: can't save or load a state in memory from the emulation thread");
+        return M64ERR_INVALID_STATE;
+    }
+
+    /* only one job can be performed at a time */
+    if (memory_job != savestates_job_nothing)
+    {
+        SDL_UnlockMutex(memory_job_lock);
+        return M64ERR_INVALID_STATE;
+    }
+
+    memory_job = j;
+    memory_job_buffer = buffer;
+    memory_job_state = memory_job_pending;
+
+    while (memory_job_state != memory_job_done)
+    {
+#ifdef USE_SDL3
+        SDL_WaitConditionTimeout(memory_job_cond, memory_job_lock, 10);
+#else
+        SDL_CondWaitTimeout(memory_job_cond, memory_job_lock, 10);
+#endif
+
+        /* the emulation thread won't perform the
+         * job when emulation is paused or stopped */
+        if (memory_job_state == memory_job_pending &&
+            (g_rom_pause || !g_EmulatorRunning))
+        {
+            memory_job = savestates_job_nothing;
+            memory_job_buffer = NULL;
+            memory_job_state = memory_job_done;
+            SDL_UnlockMutex(memory_job_lock);
+            return M64ERR_INVALID_STATE;
+        }
+    }
+
+    result = memory_job_result;
+    memory_job = savestates_job_nothing;
+    memory_job_buffer = NULL;
+
+    SDL_UnlockMutex(memory_job_lock);
+
+    return result ? M64ERR_SUCCESS : M64ERR_INPUT_INVALID;
+}
+
+m64p_error savestates_save_memory(void *buffer, size_t size)
+{
+    return savestates_run_memory_job(savestates_job_save, buffer, size);
+}
+
+m64p_error savestates_load_memory(void *buffer, size_t size)
+{
+    return savestates_run_memory_job(savestates_job_load, buffer, size);
+}
+
+void savestates_set_emulation_thread(int running)
+{
+    SDL_LockMutex(memory_job_lock);
+#ifdef USE_SDL3
+    memory_job_emulation_thread = SDL_GetCurrentThreadID();
+#else
+    memory_job_emulation_thread = SDL_ThreadID();
+#endif
+    memory_job_emulation_thread_set = running;
+    SDL_UnlockMutex(memory_job_lock);
+}
+
+savestates_job savestates_get_memory_job(void)
+{
+    return memory_job;
+}
+
+void savestates_do_memory_job(void)
+{
+    savestates_job j;
+    void *buffer;
+    int result = 0;
+
+    SDL_LockMutex(memory_job_lock);
+    if (memory_job_state != memory_job_pending)
+    {
+        SDL_UnlockMutex(memory_job_lock);
+        return;
+    }
+    memory_job_state = memory_job_running;
+    j = memory_job;
+    buffer = memory_job_buffer;
+    SDL_UnlockMutex(memory_job_lock);
+
+    if (j == savestates_job_save)
+    {
+        savestates_serialize_m64p(&g_dev, buffer);
+        result = 1;
+    }
+    else if (j == savestates_job_load)
+    {
+        result = savestates_deserialize_m64p(&g_dev, buffer);
+    }
+
+    SDL_LockMutex(memory_job_lock);
+    memory_job_result = result;
+    memory_job_state = memory_job_done;
+#ifdef USE_SDL3
+    SDL_BroadcastCondition(memory_job_cond);
+#else
+    SDL_CondBroadcast(memory_job_cond);
+#endif
+    SDL_UnlockMutex(memory_job_lock);
+}
+
 void savestates_init(void)
 {
     savestates_lock = SDL_CreateMutex();
@@ -2226,10 +2669,31 @@ void savestates_init(void)
         DebugMessage(M64MSG_ERROR, "Could not create savestates list lock");
         return;
     }
+
+    memory_job_lock = SDL_CreateMutex();
+#ifdef USE_SDL3
+    memory_job_cond = SDL_CreateCondition();
+#else
+    memory_job_cond = SDL_CreateCond();
+#endif
+    if (!memory_job_lock || !memory_job_cond) {
+        DebugMessage(M64MSG_ERROR, "Could not create savestates memory job lock");
+        return;
+    }
+
+    savestates_write_completion = create_completion();
 }
 
 void savestates_deinit(void)
 {
     SDL_DestroyMutex(savestates_lock);
+    SDL_DestroyMutex(memory_job_lock);
+#ifdef USE_SDL3
+    SDL_DestroyCondition(memory_job_cond);
+#else
+    SDL_DestroyCond(memory_job_cond);
+#endif
+    destroy_completion(savestates_write_completion);
+    savestates_write_completion = NULL;
     savestates_clear_job();
 }
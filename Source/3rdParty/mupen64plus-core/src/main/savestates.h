@@ -25,6 +25,12 @@
 #ifndef __SAVESTAVES_H__
 #define __SAVESTAVES_H__
 
+#include <stddef.h>
+
+#include "api/m64p_types.h"
+
+struct device;
+
 typedef enum _savestates_job
 {
     savestates_job_nothing,
@@ -37,7 +43,8 @@ typedef enum _savestates_type
     savestates_type_unknown,
     savestates_type_m64p,
     savestates_type_pj64_zip,
-    savestates_type_pj64_unc
+    savestates_type_pj64_unc,
+    savestates_type_m64p_fast
 } savestates_type;
 
 savestates_job savestates_get_job(void);
@@ -53,5 +60,33 @@ unsigned int savestates_get_slot(void);
 void savestates_set_autoinc_slot(int b);
 void savestates_inc_slot(void);
 
+/* returns the size of a mupen64plus savestate in memory */
+size_t savestates_get_m64p_size(void);
+
+/* writes the state of the device to the given buffer,
+ * the buffer must be savestates_get_m64p_size() bytes large
+ * and zeroed before the first call */
+void savestates_serialize_m64p(const struct device* dev, void *buffer);
+
+/* restores the state of the device from a buffer written by
+ * savestates_serialize_m64p(), the buffer is converted in place.
+ * Returns 0 when the buffer isn't a valid state for the current ROM */
+int savestates_deserialize_m64p(struct device* dev, void *buffer);
+
+/* saves or loads the state using the given buffer, the emulation
+ * thread performs the job at the next safe point while the calling
+ * thread waits for it. When called from the emulation thread itself
+ * (i.e from a frame callback), M64ERR_INVALID_STATE is returned.
+ * The buffer must be at least savestates_get_m64p_size() bytes
+ * large and zeroed before it's used for the first time. */
+m64p_error savestates_save_memory(void *buffer, size_t size);
+m64p_error savestates_load_memory(void *buffer, size_t size);
+
+/* marks the calling thread as the emulation thread while running is set */
+void savestates_set_emulation_thread(int running);
+
+savestates_job savestates_get_memory_job(void);
+void savestates_do_memory_job(void);
+
 #endif /* __SAVESTAVES_H__ */
 
@@ -39,6 +39,7 @@
 #include "main/main.h"
 #include "main/rom.h"
 #include "main/util.h"
+#include "main/workqueue.h"
 #include "osal/files.h"
 #include "osal/preproc.h"
 #include "osd/osd.h"
@@ -225,9 +226,42 @@ void ScreenshotRomOpen(void)
     CurrentShotIndex = 0;
 }
 
+struct screenshot_work {
+    char *filename;
+    unsigned char *frame;
+    int width;
+    int height;
+    int frame_number;
+    struct work_struct work;
+};
+
+static void screenshot_save_work(struct work_struct *work)
+{
+    struct screenshot_work *screenshot = container_of(work, struct screenshot_work, work);
+
+    // write the image to a PNG
+    int rval = SaveRGBBufferToFile(screenshot->filename, screenshot->frame, screenshot->width, screenshot->height, screenshot->width * 3);
+    // print message -- this allows developers to capture frames and use them in the regression test
+    if (rval != 0)
+    {
+        StateChanged(M64CORE_SCREENSHOT_CAPTURED, 0);
+    }
+    else
+    {
+        main_message(M64MSG_INFO, OSD_BOTTOM_LEFT, "Captured screenshot for frame %i.", screenshot->frame_number);
+        StateChanged(M64CORE_SCREENSHOT_CAPTURED, 1);
+    }
+
+    // free the memory
+    free(screenshot->frame);
+    free(screenshot->filename);
+    free(screenshot);
+}
+
 void TakeScreenshot(int iFrameNumber)
 {
     char *filename;
+    struct screenshot_work *screenshot;
 
     // look for an unused screenshot filename
     filename = GetNextScreenshotPath();
@@ -243,10 +277,13 @@ void TakeScreenshot(int iFrameNumber)
     gfx.readScreen(NULL, &width, &height, 0);
 
     // allocate memory for the image
+    screenshot = (struct screenshot_work *) malloc(sizeof(*screenshot));
     unsigned char *pucFrame = (unsigned char *) malloc(width * height * 3);
-    if (pucFrame == NULL)
+    if (screenshot == NULL || pucFrame == NULL)
     {
         StateChanged(M64CORE_SCREENSHOT_CAPTURED, 0);
+        free(screenshot);
+        free(pucFrame);
         free(filename);
         return;
     }
@@ -254,20 +291,13 @@ void TakeScreenshot(int iFrameNumber)
     // grab the back image from OpenGL by calling the video plugin
     gfx.readScreen(pucFrame, &width, &height, 0);
 
-    // write the image to a PNG
-    int rval = SaveRGBBufferToFile(filename, pucFrame, width, height, width * 3);
-    // free the memory
-    free(pucFrame);
-    free(filename);
-    // print message -- this allows developers to capture frames and use them in the regression test
-    if (rval != 0)
-    {
-        StateChanged(M64CORE_SCREENSHOT_CAPTURED, 0);
-    }
-    else
-    {
-        main_message(M64MSG_INFO, OSD_BOTTOM_LEFT, "Captured screenshot for frame %i.", iFrameNumber);
-        StateChanged(M64CORE_SCREENSHOT_CAPTURED, 1);
-    }
+    // encode the PNG on the workqueue
+    screenshot->filename = filename;
+    screenshot->frame = pucFrame;
+    screenshot->width = width;
+    screenshot->height = height;
+    screenshot->frame_number = iFrameNumber;
+    init_work(&screenshot->work, screenshot_save_work);
+    set_work_priority(&screenshot->work, WORK_PRIORITY_HIGH);
+    queue_work(&screenshot->work);
 }
-
@@ -38,6 +38,12 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "osal/files.h"
 #include "osal/preproc.h"
 #include "rom.h"
@@ -116,6 +122,47 @@ file_status_t write_chunk_to_file(const char *filename, const void *data, size_t
 }
 
 
+file_status_t replace_file(const char *filename, const void *data, size_t size)
+{
+    FILE *f;
+    char *tmpfilename;
+    int err;
+
+    tmpfilename = formatstr("%s.tmp", filename);
+    if (tmpfilename == NULL)
+    {
+        return file_open_error;
+    }
+
+    f = osal_file_open(tmpfilename, "wb");
+    if (f == NULL)
+    {
+        free(tmpfilename);
+        return file_open_error;
+    }
+
+    /* make sure the content has reached the disk before the rename,
+     * otherwise a crash could leave an empty file behind */
+    err = (fwrite(data, 1, size, f) != size) || (fflush(f) != 0);
+#ifdef _WIN32
+    err = err || (_commit(_fileno(f)) != 0);
+#else
+    err = err || (fsync(fileno(f)) != 0);
+#endif
+    err = (fclose(f) != 0) || err;
+
+    if (err || osal_file_rename(tmpfilename, filename) != 0)
+    {
+        remove(tmpfilename);
+        free(tmpfilename);
+        return file_write_error;
+    }
+
+    free(tmpfilename);
+    return file_ok;
+}
+
+
 file_status_t load_file(const char* filename, void** buffer, size_t* size)
 {
     FILE* fd;
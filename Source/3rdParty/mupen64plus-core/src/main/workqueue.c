@@ -36,131 +36,195 @@
 #include "api/m64p_types.h"
 #include "main/list.h"
 
-#define WORKQUEUE_THREADS 1
+#define WORKQUEUE_MAX_THREADS 16
+
+#ifdef USE_SDL3
+#define workqueue_atomic_t SDL_AtomicInt
+#define workqueue_atomic_get SDL_GetAtomicInt
+#define workqueue_atomic_get_ptr SDL_GetAtomicPointer
+#define workqueue_atomic_set_ptr SDL_SetAtomicPointer
+#define workqueue_atomic_cas_ptr SDL_CompareAndSwapAtomicPointer
+#define workqueue_sem_post SDL_SignalSemaphore
+#define workqueue_sem_wait SDL_WaitSemaphore
+#else
+#define workqueue_atomic_t SDL_atomic_t
+#define workqueue_atomic_get SDL_AtomicGet
+#define workqueue_atomic_get_ptr SDL_AtomicGetPtr
+#define workqueue_atomic_set_ptr SDL_AtomicSetPtr
+#define workqueue_atomic_cas_ptr SDL_AtomicCASPtr
+#define workqueue_sem_post SDL_SemPost
+#define workqueue_sem_wait SDL_SemWait
+#endif
+
+struct work_completion {
+    workqueue_atomic_t pending;
+};
 
 struct workqueue_mgmt_globals {
-    struct list_head work_queue;
-    struct list_head thread_queue;
+    /* works are pushed onto the submitted stack without taking
+     * the lock, the threads move them into the priority queues */
+    void *submitted;
+    struct list_head work_queue[WORK_PRIORITY_COUNT];
     struct list_head thread_list;
+    size_t thread_count;
+    int low_priority_running;
+    int stop;
 #ifdef USE_SDL3
     SDL_Mutex *lock;
+    SDL_Condition *work_done;
+    SDL_Semaphore *work_avail;
 #else
     SDL_mutex *lock;
+    SDL_cond *work_done;
+    SDL_sem *work_avail;
 #endif
 };
 
 struct workqueue_thread {
     SDL_Thread *thread;
-#ifdef USE_SDL3
-    SDL_Condition *work_avail;
-#else
-    SDL_cond *work_avail;
-#endif
-    struct list_head list;
     struct list_head list_mgmt;
 };
 
 static struct workqueue_mgmt_globals workqueue_mgmt;
 
-static void workqueue_dismiss(struct work_struct *work)
+/* must be called with the lock held */
+static void workqueue_collect_work(void)
 {
+    struct work_struct *work, *next, *head = NULL;
+
+    work = workqueue_atomic_set_ptr(&workqueue_mgmt.submitted, NULL);
+
+    /* the stack is in reverse order of submission */
+    while (work != NULL) {
+        next = work->next;
+        work->next = head;
+        head = work;
+        work = next;
+    }
+
+    for (work = head; work != NULL; work = next) {
+        next = work->next;
+        work->next = NULL;
+        list_add_tail(&work->list, &workqueue_mgmt.work_queue[work->priority]);
+    }
 }
 
-static struct work_struct *workqueue_get_work(struct workqueue_thread *thread)
+/* must be called with the lock held */
+static struct work_struct *workqueue_get_work(void)
 {
-    int found = 0;
+    int priority;
     struct work_struct *work;
 
-    for (;;) {
-        SDL_LockMutex(workqueue_mgmt.lock);
-        list_del_init(&thread->list);
-        if (!list_empty(&workqueue_mgmt.work_queue)) {
-            found = 1;
-            work = list_first_entry(&workqueue_mgmt.work_queue, struct work_struct, list);
-            list_del_init(&work->list);
-        } else {
-            list_add(&thread->list, &workqueue_mgmt.thread_queue);
-#ifdef USE_SDL3
-            SDL_WaitCondition(thread->work_avail, workqueue_mgmt.lock);
-#else
-	        SDL_CondWait(thread->work_avail, workqueue_mgmt.lock);
-#endif
+    for (priority = 0; priority < WORK_PRIORITY_COUNT; priority++) {
+        if (list_empty(&workqueue_mgmt.work_queue[priority]))
+            continue;
+
+        if (priority == WORK_PRIORITY_LOW) {
+            if (workqueue_mgmt.low_priority_running)
+                break;
+            workqueue_mgmt.low_priority_running = 1;
         }
-        SDL_UnlockMutex(workqueue_mgmt.lock);
 
-        if (found)
-            break;
+        work = list_first_entry(&workqueue_mgmt.work_queue[priority], struct work_struct, list);
+        list_del_init(&work->list);
+        return work;
     }
 
-    return work;
+    return NULL;
 }
 
 static int workqueue_thread_handler(void *data)
 {
-    struct workqueue_thread *thread = data;
+    int stop;
+    enum work_priority priority;
+    struct work_completion *completion;
     struct work_struct *work;
 
     for (;;) {
-        work = workqueue_get_work(thread);
-        if (work->func == workqueue_dismiss) {
-            free(work);
-            break;
+        workqueue_sem_wait(workqueue_mgmt.work_avail);
+
+        for (;;) {
+            SDL_LockMutex(workqueue_mgmt.lock);
+            workqueue_collect_work();
+            work = workqueue_get_work();
+            stop = workqueue_mgmt.stop;
+            SDL_UnlockMutex(workqueue_mgmt.lock);
+
+            if (work == NULL)
+                break;
+
+            /* the work may be freed by its function */
+            priority = work->priority;
+            completion = work->completion;
+
+            work->func(work);
+
+            SDL_LockMutex(workqueue_mgmt.lock);
+            if (priority == WORK_PRIORITY_LOW)
+                workqueue_mgmt.low_priority_running = 0;
+            if (completion != NULL && SDL_AtomicDecRef(&completion->pending)) {
+#ifdef USE_SDL3
+                SDL_BroadcastCondition(workqueue_mgmt.work_done);
+#else
+                SDL_CondBroadcast(workqueue_mgmt.work_done);
+#endif
+            }
+            SDL_UnlockMutex(workqueue_mgmt.lock);
         }
 
-        work->func(work);
+        if (stop)
+            break;
     }
 
     return 0;
 }
 
-int workqueue_init(void)
+int workqueue_init(int threads)
 {
     size_t i;
     struct workqueue_thread *thread;
 
     memset(&workqueue_mgmt, 0, sizeof(workqueue_mgmt));
-    INIT_LIST_HEAD(&workqueue_mgmt.work_queue);
-    INIT_LIST_HEAD(&workqueue_mgmt.thread_queue);
+    for (i = 0; i < WORK_PRIORITY_COUNT; i++)
+        INIT_LIST_HEAD(&workqueue_mgmt.work_queue[i]);
     INIT_LIST_HEAD(&workqueue_mgmt.thread_list);
 
+    if (threads < 1)
+        threads = 1;
+    else if (threads > WORKQUEUE_MAX_THREADS)
+        threads = WORKQUEUE_MAX_THREADS;
+
     workqueue_mgmt.lock = SDL_CreateMutex();
-    if (!workqueue_mgmt.lock) {
+#ifdef USE_SDL3
+    workqueue_mgmt.work_done = SDL_CreateCondition();
+#else
+    workqueue_mgmt.work_done = SDL_CreateCond();
+#endif
+    workqueue_mgmt.work_avail = SDL_CreateSemaphore(0);
+    if (!workqueue_mgmt.lock || !workqueue_mgmt.work_done || !workqueue_mgmt.work_avail) {
         DebugMessage(M64MSG_ERROR, "Could not create workqueue management");
         return -1;
     }
 
-    SDL_LockMutex(workqueue_mgmt.lock);
-    for (i = 0; i < WORKQUEUE_THREADS; i++) {
+    for (i = 0; i < (size_t)threads; i++) {
         thread = malloc(sizeof(*thread));
         if (!thread) {
             DebugMessage(M64MSG_ERROR, "Could not create workqueue thread management data");
-            SDL_UnlockMutex(workqueue_mgmt.lock);
             return -1;
         }
 
         memset(thread, 0, sizeof(*thread));
-        list_add(&thread->list_mgmt, &workqueue_mgmt.thread_list);
-        INIT_LIST_HEAD(&thread->list);
-#ifdef USE_SDL3
-        thread->work_avail = SDL_CreateCondition();
-#else
-        thread->work_avail = SDL_CreateCond();
-#endif
-        if (!thread->work_avail) {
-            DebugMessage(M64MSG_ERROR, "Could not create workqueue thread work_avail condition");
-            SDL_UnlockMutex(workqueue_mgmt.lock);
-            return -1;
-        }
-
         thread->thread = SDL_CreateThread(workqueue_thread_handler, "m64pwq", thread);
 
         if (!thread->thread) {
             DebugMessage(M64MSG_ERROR, "Could not create workqueue thread handler");
-            SDL_UnlockMutex(workqueue_mgmt.lock);
+            free(thread);
             return -1;
         }
+
+        list_add(&thread->list_mgmt, &workqueue_mgmt.thread_list);
+        workqueue_mgmt.thread_count++;
     }
-    SDL_UnlockMutex(workqueue_mgmt.lock);
 
     return 0;
 }
@@ -169,48 +233,79 @@ void workqueue_shutdown(void)
 {
     size_t i;
     int status;
-    struct work_struct *work;
     struct workqueue_thread *thread, *safe;
 
-    for (i = 0; i < WORKQUEUE_THREADS; i++) {
-        work = malloc(sizeof(*work));
-        init_work(work, workqueue_dismiss);
-        queue_work(work);
-    }
+    /* the threads finish the pending work before they stop */
+    SDL_LockMutex(workqueue_mgmt.lock);
+    workqueue_mgmt.stop = 1;
+    SDL_UnlockMutex(workqueue_mgmt.lock);
+
+    for (i = 0; i < workqueue_mgmt.thread_count; i++)
+        workqueue_sem_post(workqueue_mgmt.work_avail);
 
     list_for_each_entry_safe_t(thread, safe, &workqueue_mgmt.thread_list, struct workqueue_thread, list_mgmt) {
         list_del(&thread->list_mgmt);
         SDL_WaitThread(thread->thread, &status);
-#ifdef USE_SDL3
-        SDL_DestroyCondition(thread->work_avail);
-#else
-        SDL_DestroyCond(thread->work_avail);
-#endif
         free(thread);
     }
 
-    if (!list_empty(&workqueue_mgmt.work_queue))
+    if (workqueue_atomic_get_ptr(&workqueue_mgmt.submitted) != NULL)
         DebugMessage(M64MSG_WARNING, "Stopped workqueue with work still pending");
 
+    SDL_DestroySemaphore(workqueue_mgmt.work_avail);
+#ifdef USE_SDL3
+    SDL_DestroyCondition(workqueue_mgmt.work_done);
+#else
+    SDL_DestroyCond(workqueue_mgmt.work_done);
+#endif
     SDL_DestroyMutex(workqueue_mgmt.lock);
 }
 
 int queue_work(struct work_struct *work)
 {
-    struct workqueue_thread *thread;
+    struct work_struct *head;
+
+    if (work->completion != NULL)
+        SDL_AtomicIncRef(&work->completion->pending);
+
+    do {
+        head = workqueue_atomic_get_ptr(&workqueue_mgmt.submitted);
+        work->next = head;
+    } while (!workqueue_atomic_cas_ptr(&workqueue_mgmt.submitted, head, work));
+
+    workqueue_sem_post(workqueue_mgmt.work_avail);
+
+    return 0;
+}
+
+struct work_completion *create_completion(void)
+{
+    struct work_completion *completion;
+
+    completion = malloc(sizeof(*completion));
+    if (completion != NULL)
+        memset(completion, 0, sizeof(*completion));
+
+    return completion;
+}
+
+void destroy_completion(struct work_completion *completion)
+{
+    free(completion);
+}
+
+void wait_for_completion(struct work_completion *completion)
+{
+    if (completion == NULL)
+        return;
 
     SDL_LockMutex(workqueue_mgmt.lock);
-    list_add_tail(&work->list, &workqueue_mgmt.work_queue);
-    if (!list_empty(&workqueue_mgmt.thread_queue)) {
-        thread = list_first_entry(&workqueue_mgmt.thread_queue, struct workqueue_thread, list);
-        list_del_init(&thread->list);
+    while (workqueue_atomic_get(&completion->pending) > 0) {
 #ifdef USE_SDL3
-        SDL_SignalCondition(thread->work_avail);
+        SDL_WaitCondition(workqueue_mgmt.work_done, workqueue_mgmt.lock);
 #else
-        SDL_CondSignal(thread->work_avail);
+        SDL_CondWait(workqueue_mgmt.work_done, workqueue_mgmt.lock);
 #endif
     }
     SDL_UnlockMutex(workqueue_mgmt.lock);
-
-    return 0;
 }
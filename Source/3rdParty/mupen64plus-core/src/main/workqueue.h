@@ -26,28 +26,61 @@
 #include "osal/preproc.h"
 
 struct work_struct;
+struct work_completion;
+
+/* works with a lower priority only run when no work with a
+ * higher priority is queued, low priority works run one at a
+ * time so they never occupy all threads */
+enum work_priority {
+    WORK_PRIORITY_HIGH,
+    WORK_PRIORITY_NORMAL,
+    WORK_PRIORITY_LOW,
+    WORK_PRIORITY_COUNT
+};
 
 typedef void (*work_func_t)(struct work_struct *work);
 struct work_struct {
     work_func_t func;
     struct list_head list;
+    struct work_struct *next;
+    struct work_completion *completion;
+    enum work_priority priority;
 };
 
 static osal_inline void init_work(struct work_struct *work, work_func_t func)
 {
     INIT_LIST_HEAD(&work->list);
     work->func = func;
+    work->next = NULL;
+    work->completion = NULL;
+    work->priority = WORK_PRIORITY_NORMAL;
+}
+
+static osal_inline void set_work_priority(struct work_struct *work, enum work_priority priority)
+{
+    work->priority = priority;
+}
+
+/* the completion is signaled once all works
+ * queued with it have finished */
+static osal_inline void set_work_completion(struct work_struct *work, struct work_completion *completion)
+{
+    work->completion = completion;
 }
 
 #ifdef M64P_PARALLEL
 
-int workqueue_init(void);
+int workqueue_init(int threads);
 void workqueue_shutdown(void);
 int queue_work(struct work_struct *work);
 
+struct work_completion *create_completion(void);
+void destroy_completion(struct work_completion *completion);
+void wait_for_completion(struct work_completion *completion);
+
 #else
 
-static osal_inline int workqueue_init(void)
+static osal_inline int workqueue_init(int threads)
 {
     return 0;
 }
@@ -62,6 +95,19 @@ static osal_inline int queue_work(struct work_struct *work)
     return 0;
 }
 
+static osal_inline struct work_completion *create_completion(void)
+{
+    return NULL;
+}
+
+static osal_inline void destroy_completion(struct work_completion *completion)
+{
+}
+
+static osal_inline void wait_for_completion(struct work_completion *completion)
+{
+}
+
 #endif
 
 #endif
@@ -65,6 +65,10 @@ extern const char * osal_get_user_datapath(void);
 extern const char * osal_get_user_cachepath(void);
 
 extern FILE * osal_file_open (const char *filename, const char *mode);
+/* Renames a file, replacing the destination file when it exists.
+ * Returns zero on success, nonzero on failure.
+ */
+extern int osal_file_rename(const char *oldfilename, const char *newfilename);
 extern gzFile osal_gzopen(const char *filename, const char *mode);
 
 #endif /* OSAL_FILES_H */
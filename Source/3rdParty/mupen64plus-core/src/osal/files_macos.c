@@ -228,6 +228,11 @@ FILE * osal_file_open ( const char * filename, const char * mode )
     return fopen (filename, mode);
 }
 
+int osal_file_rename(const char *oldfilename, const char *newfilename)
+{
+    return rename(oldfilename, newfilename);
+}
+
 gzFile osal_gzopen(const char *filename, const char *mode)
 {
     return gzopen(filename, mode);
@@ -214,6 +214,15 @@ FILE * osal_file_open ( const char * filename, const char * mode )
     return _wfopen (wstr_filename, wstr_mode);
 }
 
+int osal_file_rename(const char *oldfilename, const char *newfilename)
+{
+    wchar_t wstr_oldfilename[PATH_MAX];
+    wchar_t wstr_newfilename[PATH_MAX];
+    MultiByteToWideChar(CP_UTF8, 0, oldfilename, -1, wstr_oldfilename, PATH_MAX);
+    MultiByteToWideChar(CP_UTF8, 0, newfilename, -1, wstr_newfilename, PATH_MAX);
+    return MoveFileExW(wstr_oldfilename, wstr_newfilename, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) ? 0 : 1;
+}
+
 gzFile osal_gzopen(const char *filename, const char *mode)
 {
     wchar_t wstr_filename[PATH_MAX];
@@ -0,0 +1,392 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - interrupt_queue_bench.c                                 *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *   Copyright (C) 2025 Rosalie Wanders                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Microbenchmark for the r4300 interrupt event queue.
+ *
+ * The interrupt queue of the core is compared against the linked list
+ * which was used before, both queues are fed the same workload and the
+ * order of the events is verified to be identical after every operation.
+ *
+ * Build from the tools directory with:
+ *   gcc -O2 -I../src -o interrupt_queue_bench interrupt_queue_bench.c ../src/device/r4300/interrupt.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "device/r4300/cp0.h"
+#include "device/r4300/interrupt.h"
+
+#define BENCH_OPERATIONS 20000000
+
+/***************************************************************************
+ * Stubs for the parts of the core which the interrupt queue doesn't use
+ **************************************************************************/
+
+unsigned int g_gs_vi_counter;
+
+void DebugMessage(int level, const char *message, ...) { }
+void dyna_stop(void* r4300) { }
+void exception_general(struct r4300_core* r4300) { }
+void generic_jump_to(void* r4300, uint32_t address) { }
+void invalidate_r4300_cached_code(void* r4300, uint32_t start, uint32_t size) { }
+void pif_bootrom_hle_execute(void* r4300) { }
+void poweron_device(void* dev) { }
+void poweron_rsp(void* sp) { }
+void reset_pif(void* pif, unsigned int reset_type) { }
+void* r4300_pc(void* r4300) { return NULL; }
+void* r4300_pc_struct(void* r4300) { return NULL; }
+void* r4300_stop(void* r4300) { return NULL; }
+int rewind_get_job(void) { return 0; }
+int rewind_snapshot(void) { return 0; }
+int rewind_step_back(void) { return 0; }
+int savestates_do_memory_job(void) { return 0; }
+int savestates_get_job(void) { return 0; }
+int savestates_get_memory_job(void) { return 0; }
+int savestates_load(void) { return 0; }
+int savestates_save(void) { return 0; }
+
+uint32_t* r4300_cp0_regs(struct cp0* cp0)
+{
+    return cp0->regs;
+}
+
+unsigned int* r4300_cp0_next_interrupt(struct cp0* cp0)
+{
+    return &cp0->next_interrupt;
+}
+
+int* r4300_cp0_cycle_count(struct cp0* cp0)
+{
+    return &cp0->cycle_count;
+}
+
+/***************************************************************************
+ * Linked list interrupt queue, as used before
+ **************************************************************************/
+
+struct list_node
+{
+    struct interrupt_event data;
+    struct list_node* next;
+};
+
+struct list_queue
+{
+    struct cp0 cp0;
+    struct list_node nodes[INTERRUPT_EVENTS_CAPACITY];
+    struct list_node* stack[INTERRUPT_EVENTS_CAPACITY];
+    size_t index;
+    struct list_node* first;
+};
+
+static void list_clear(struct list_queue* q)
+{
+    size_t i;
+
+    for (i = 0; i < INTERRUPT_EVENTS_CAPACITY; ++i) {
+        q->stack[i] = &q->nodes[i];
+    }
+
+    q->index = 0;
+    q->first = NULL;
+}
+
+static int list_before_event(struct cp0* cp0, unsigned int evt1, unsigned int evt2)
+{
+    uint32_t count = cp0->regs[CP0_COUNT_REG];
+
+    if (cp0->cycle_count > 0)
+        count -= cp0->cycle_count;
+
+    return (evt1 - count) < (evt2 - count);
+}
+
+static unsigned int* list_get_event(struct list_queue* q, int type)
+{
+    struct list_node* e;
+
+    for (e = q->first; e != NULL; e = e->next)
+    {
+        if (e->data.type == type) {
+            return &e->data.count;
+        }
+    }
+
+    return NULL;
+}
+
+static void list_add_event(struct list_queue* q, int type, unsigned int count)
+{
+    struct list_node* event;
+    struct list_node* e;
+
+    if (q->index >= INTERRUPT_EVENTS_CAPACITY) {
+        return;
+    }
+
+    event = q->stack[q->index++];
+    event->data.count = count;
+    event->data.type = type;
+
+    if (q->first == NULL || list_before_event(&q->cp0, count, q->first->data.count))
+    {
+        event->next = q->first;
+        q->first = event;
+    }
+    else
+    {
+        for (e = q->first;
+            e->next != NULL && !list_before_event(&q->cp0, count, e->next->data.count);
+            e = e->next);
+
+        event->next = e->next;
+        e->next = event;
+    }
+
+    q->cp0.next_interrupt = q->first->data.count;
+    q->cp0.cycle_count = q->cp0.regs[CP0_COUNT_REG] - q->first->data.count;
+}
+
+static void list_remove_first(struct list_queue* q)
+{
+    struct list_node* e = q->first;
+
+    q->first = e->next;
+    q->stack[--q->index] = e;
+
+    q->cp0.next_interrupt = (q->first != NULL) ? q->first->data.count : 0;
+    q->cp0.cycle_count = (q->first != NULL) ? (q->cp0.regs[CP0_COUNT_REG] - q->first->data.count) : 0;
+}
+
+static void list_remove_event(struct list_queue* q, int type)
+{
+    struct list_node** e;
+    struct list_node* to_del;
+
+    for (e = &q->first; *e != NULL; e = &(*e)->next)
+    {
+        if ((*e)->data.type == type)
+        {
+            to_del = *e;
+            *e = to_del->next;
+            q->stack[--q->index] = to_del;
+            return;
+        }
+    }
+}
+
+/***************************************************************************
+ * Workload
+ **************************************************************************/
+
+struct bench_queue
+{
+    unsigned int* (*get)(int type);
+    void (*add)(int type, unsigned int delay);
+    void (*remove)(int type);
+    /* fires the next event, returns 0 if it is a special event */
+    int (*fire)(void);
+};
+
+static const int bench_types[] =
+{
+    VI_INT, SI_INT, PI_INT, AI_INT, SP_INT, DP_INT, RSP_DMA_EVT, RSP_TSK_EVT
+};
+enum { BENCH_TYPES_COUNT = sizeof(bench_types) / sizeof(bench_types[0]) };
+
+static struct cp0 g_cp0;
+static struct list_queue g_list;
+
+static unsigned int* queue_get(int type)
+{
+    return get_event(&g_cp0.q, type);
+}
+
+static void queue_add(int type, unsigned int delay)
+{
+    add_interrupt_event(&g_cp0, type, delay);
+}
+
+static void queue_remove(int type)
+{
+    remove_event(&g_cp0.q, type);
+}
+
+static int queue_fire(void)
+{
+    if (get_next_event_type(&g_cp0.q) <= SPECIAL_INT)
+        return 0;
+
+    g_cp0.regs[CP0_COUNT_REG] = g_cp0.next_interrupt;
+    remove_interrupt_event(&g_cp0);
+    return 1;
+}
+
+static unsigned int* list_get(int type)
+{
+    return list_get_event(&g_list, type);
+}
+
+static void list_add(int type, unsigned int delay)
+{
+    list_add_event(&g_list, type, g_list.cp0.regs[CP0_COUNT_REG] + delay);
+}
+
+static void list_remove(int type)
+{
+    list_remove_event(&g_list, type);
+}
+
+static int list_fire(void)
+{
+    if (g_list.first == NULL || g_list.first->data.type <= SPECIAL_INT)
+        return 0;
+
+    g_list.cp0.regs[CP0_COUNT_REG] = g_list.cp0.next_interrupt;
+    list_remove_first(&g_list);
+    return 1;
+}
+
+static const struct bench_queue g_queue_ops = { queue_get, queue_add, queue_remove, queue_fire };
+static const struct bench_queue g_list_ops = { list_get, list_add, list_remove, list_fire };
+
+static void reset(void)
+{
+    memset(&g_cp0, 0, sizeof(g_cp0));
+    init_interrupt(&g_cp0);
+
+    memset(&g_list, 0, sizeof(g_list));
+    list_clear(&g_list);
+    list_add_event(&g_list, SPECIAL_INT, 0x80000000);
+    list_add_event(&g_list, COMPARE_INT, 0);
+}
+
+static uint32_t bench_random(uint32_t* state)
+{
+    *state = *state * UINT32_C(1664525) + UINT32_C(1013904223);
+    return *state >> 8;
+}
+
+/* performs one operation of a mix of event lookups, insertions and
+ * removals resembling the AI, VI, SI, PI and SP activity of a game */
+static unsigned int bench_step(const struct bench_queue* q, uint32_t value)
+{
+    int type = bench_types[value % BENCH_TYPES_COUNT];
+
+    switch ((value >> 4) % 8)
+    {
+        case 0: case 1: case 2: case 3:
+            return q->get(type) != NULL;
+        case 4: case 5:
+            if (q->get(type) == NULL)
+                q->add(type, (value >> 8) & 0xffff);
+            return 0;
+        case 6:
+            q->remove(type);
+            return 0;
+        default:
+            return q->fire();
+    }
+}
+
+static double bench_run(const struct bench_queue* q, unsigned int* checksum)
+{
+    struct timespec start, end;
+    uint32_t state = 1;
+    int i;
+
+    reset();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < BENCH_OPERATIONS; ++i)
+    {
+        *checksum += bench_step(q, bench_random(&state));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* runs both queues in lockstep and compares the saved event queues */
+static int bench_verify(void)
+{
+    char queue_buf[INTERRUPT_EVENTS_CAPACITY * 8 + 4];
+    char list_buf[INTERRUPT_EVENTS_CAPACITY * 8 + 4];
+    const unsigned int terminator = 0xFFFFFFFF;
+    struct list_node* e;
+    uint32_t state = 1, value;
+    int i, queue_len, list_len;
+
+    reset();
+    for (i = 0; i < BENCH_OPERATIONS / 20; ++i)
+    {
+        value = bench_random(&state);
+        bench_step(&g_queue_ops, value);
+        bench_step(&g_list_ops, value);
+
+        queue_len = save_eventqueue_infos(&g_cp0, queue_buf);
+
+        list_len = 0;
+        for (e = g_list.first; e != NULL; e = e->next)
+        {
+            memcpy(list_buf + list_len    , &e->data.type , 4);
+            memcpy(list_buf + list_len + 4, &e->data.count, 4);
+            list_len += 8;
+        }
+        memcpy(list_buf + list_len, &terminator, 4);
+        list_len += 4;
+
+        if (queue_len != list_len || memcmp(queue_buf, list_buf, queue_len) != 0)
+        {
+            fprintf(stderr, "event order differs from the linked list after %d operations\n", i + 1);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int main(void)
+{
+    double queue_time, list_time;
+    unsigned int queue_checksum = 0, list_checksum = 0;
+
+    if (!bench_verify())
+        return EXIT_FAILURE;
+
+    list_time = bench_run(&g_list_ops, &list_checksum);
+    queue_time = bench_run(&g_queue_ops, &queue_checksum);
+
+    if (queue_checksum != list_checksum)
+    {
+        fprintf(stderr, "checksum differs from the linked list\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("operations:  %d\n", BENCH_OPERATIONS);
+    printf("linked list: %.2f ns/op\n", list_time * 1e9 / BENCH_OPERATIONS);
+    printf("queue:       %.2f ns/op\n", queue_time * 1e9 / BENCH_OPERATIONS);
+    printf("speedup:     %.2fx\n", list_time / queue_time);
+
+    return EXIT_SUCCESS;
+}
@@ -80,6 +80,7 @@ void MainDialog::on_buttonBox_clicked(QAbstractButton* button)
 
     if (pushButton == okButton)
     {
+        CoreSettingsBeginTransaction();
         CoreSettingsSetValue(SettingsID::Audio_Volume, this->volumeSlider->value());
         CoreSettingsSetValue(SettingsID::Audio_Muted, this->muteCheckBox->isChecked());
     
@@ -87,6 +88,7 @@ void MainDialog::on_buttonBox_clicked(QAbstractButton* button)
         CoreSettingsSetValue(SettingsID::Audio_Resampler, this->resamplerComboBox->currentText().toStdString());
         CoreSettingsSetValue(SettingsID::Audio_SwapChannels, this->swapChannelsCheckBox->isChecked());
         CoreSettingsSave();
+        CoreSettingsCommitTransaction();
     }
     else if (pushButton == defaultButton)
     {
@@ -175,12 +175,18 @@ EXPORT m64p_error CALL PluginConfig(void* parent)
         return M64ERR_NOT_INIT;
     }
 
+    uint32_t changeCounter = CoreSettingsGetChangeCounter();
+
     UserInterface::MainDialog dialog((QWidget*)parent);
     dialog.exec();
 
-    // apply volume settings
-    load_volume_settings();
-    apply_volume_settings();
+    // apply volume settings when they've changed
+    if (CoreSettingsHasChanged(SettingsID::Audio_Volume, changeCounter) ||
+        CoreSettingsHasChanged(SettingsID::Audio_Muted, changeCounter))
+    {
+        load_volume_settings();
+        apply_volume_settings();
+    }
 
     return M64ERR_SUCCESS;
 }
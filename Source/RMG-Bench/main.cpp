@@ -0,0 +1,577 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <RMG-Core/SpeedLimiter.hpp>
+#include <RMG-Core/Directories.hpp>
+#include <RMG-Core/Emulation.hpp>
+#include <RMG-Core/Benchmark.hpp>
+#include <RMG-Core/SaveState.hpp>
+#include <RMG-Core/Callback.hpp>
+#include <RMG-Core/Settings.hpp>
+#include <RMG-Core/Netplay.hpp>
+#include <RMG-Core/Plugins.hpp>
+#include <RMG-Core/Error.hpp>
+#include <RMG-Core/File.hpp>
+#include <RMG-Core/Core.hpp>
+
+#include <filesystem>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif // _WIN32
+
+//
+// Local Structs
+//
+
+struct l_BenchOptions
+{
+    std::filesystem::path Rom;
+    std::filesystem::path SaveState;
+    std::filesystem::path Input;
+    unsigned int VICount = 3600;
+    int CpuEmulator = -1;
+    std::string RspPlugin;
+    std::string GfxPlugin   = "(None)";
+    std::string AudioPlugin = "(None)";
+    std::string InputPlugin = "(None)";
+    std::string NetplayAddress;
+    int NetplayPort     = 45000;
+    int NetplayPlayer   = 1;
+    int NetplayRollback = 0;
+    bool DebugMessages = false;
+};
+
+//
+// Local Variables
+//
+
+static l_BenchOptions l_Options;
+static std::vector<uint32_t> l_Inputs;
+
+// only accessed on the emulation thread
+static bool         l_Counting         = false;
+static bool         l_SaveStateLoading = false;
+static unsigned int l_SaveStateTries   = 0;
+static unsigned int l_CountedVIs       = 0;
+static std::chrono::steady_clock::time_point l_StartTime;
+
+// read after emulation has finished
+static std::atomic<bool> l_Finished = false;
+static std::atomic<bool> l_Failed   = false;
+static double            l_Seconds  = 0;
+static uint64_t          l_RDRAMHash = 0;
+static CoreNetplayStats  l_NetplayStats;
+static std::vector<std::string> l_ProfileMessages;
+
+//
+// Local Functions
+//
+
+static void print_usage(const char* program)
+{
+    std::cout << "Usage: " << program << " [options] ROM" << std::endl
+              << std::endl
+              << "Runs ROM without speed limiter for the given amount of VIs and reports" << std::endl
+              << "the VI/s, the profile of the core (when built with CORE_PROFILING)" << std::endl
+              << "and a hash of RDRAM after the last VI" << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "  -h, --help                  Displays this help" << std::endl
+              << "  -d, --debug-messages        Prints debug callback messages to stdout" << std::endl
+              << "  --vis <count>               Amount of VIs to run (default: 3600)" << std::endl
+              << "  --state <file>              Save state to load before counting VIs" << std::endl
+              << "  --input <file>              Input to replay, a .m64 file or a raw" << std::endl
+              << "                              list of 32-bit button values" << std::endl
+              << "  --cpu-emulator <0|1|2>      Pure interpreter, cached interpreter or dynamic recompiler" << std::endl
+              << "  --rsp <plugin>              RSP plugin (default: RSP plugin from the settings)" << std::endl
+              << "  --gfx <plugin>              GFX plugin (default: (None))" << std::endl
+              << "  --audio <plugin>            Audio plugin (default: (None))" << std::endl
+              << "  --input-plugin <plugin>     Input plugin (default: (None))" << std::endl
+              << "  --netplay <address>         Runs as a netplay client of the server at address," << std::endl
+              << "                              with the speed limiter, and reports the netplay" << std::endl
+              << "                              statistics per 10000 VIs" << std::endl
+              << "  --port <port>               Port of the netplay server (default: 45000)" << std::endl
+              << "  --player <1-4>              Netplay player to control (default: 1)" << std::endl
+              << "  --rollback <frames>         Netplay rollback frames, 0 disables rollback (default: 0)" << std::endl
+#ifndef PORTABLE_INSTALL
+              << "  --lib-path <path>           Changes the path where the libraries are stored" << std::endl
+              << "  --core-path <path>          Changes the path where the core library is stored" << std::endl
+              << "  --plugin-path <path>        Changes the path where the plugins are stored" << std::endl
+              << "  --shared-data-path <path>   Changes the path where the shared data is stored" << std::endl
+#endif // PORTABLE_INSTALL
+              ;
+}
+
+static bool parse_arguments(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        std::string value;
+
+        if (arg == "-h" || arg == "--help")
+        {
+            print_usage(argv[0]);
+            std::exit(0);
+        }
+        else if (arg == "-d" || arg == "--debug-messages")
+        {
+            l_Options.DebugMessages = true;
+            continue;
+        }
+        else if (!arg.starts_with("-"))
+        {
+            if (!l_Options.Rom.empty())
+            {
+                std::cerr << "Error: only one ROM can be specified" << std::endl;
+                return false;
+            }
+            l_Options.Rom = std::filesystem::absolute(arg);
+            continue;
+        }
+
+        // all other options require a value
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Error: missing value for " << arg << std::endl;
+            return false;
+        }
+        value = argv[++i];
+
+        if (arg == "--vis")
+        {
+            l_Options.VICount = static_cast<unsigned int>(std::strtoul(value.c_str(), nullptr, 10));
+            if (l_Options.VICount == 0)
+            {
+                std::cerr << "Error: invalid amount of VIs: " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--state")
+        {
+            l_Options.SaveState = std::filesystem::absolute(value);
+        }
+        else if (arg == "--input")
+        {
+            l_Options.Input = std::filesystem::absolute(value);
+        }
+        else if (arg == "--cpu-emulator")
+        {
+            l_Options.CpuEmulator = std::atoi(value.c_str());
+            if (l_Options.CpuEmulator < 0 || l_Options.CpuEmulator > 2)
+            {
+                std::cerr << "Error: invalid CPU emulator: " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--rsp")
+        {
+            l_Options.RspPlugin = value;
+        }
+        else if (arg == "--gfx")
+        {
+            l_Options.GfxPlugin = value;
+        }
+        else if (arg == "--audio")
+        {
+            l_Options.AudioPlugin = value;
+        }
+        else if (arg == "--input-plugin")
+        {
+            l_Options.InputPlugin = value;
+        }
+        else if (arg == "--netplay")
+        {
+            l_Options.NetplayAddress = value;
+        }
+        else if (arg == "--port")
+        {
+            l_Options.NetplayPort = std::atoi(value.c_str());
+            if (l_Options.NetplayPort < 1 || l_Options.NetplayPort > 65535)
+            {
+                std::cerr << "Error: invalid port: " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--player")
+        {
+            l_Options.NetplayPlayer = std::atoi(value.c_str());
+            if (l_Options.NetplayPlayer < 1 || l_Options.NetplayPlayer > 4)
+            {
+                std::cerr << "Error: invalid player: " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--rollback")
+        {
+            l_Options.NetplayRollback = std::atoi(value.c_str());
+            if (l_Options.NetplayRollback < 0 || l_Options.NetplayRollback > 15)
+            {
+                std::cerr << "Error: invalid amount of rollback frames: " << value << std::endl;
+                return false;
+            }
+        }
+#ifndef PORTABLE_INSTALL
+        else if (arg == "--lib-path")
+        {
+            CoreSetLibraryPathOverride(value);
+        }
+        else if (arg == "--core-path")
+        {
+            CoreSetCorePathOverride(value);
+        }
+        else if (arg == "--plugin-path")
+        {
+            CoreSetPluginPathOverride(value);
+        }
+        else if (arg == "--shared-data-path")
+        {
+            CoreSetSharedDataPathOverride(value);
+        }
+#endif // PORTABLE_INSTALL
+        else
+        {
+            std::cerr << "Error: unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (l_Options.Rom.empty())
+    {
+        print_usage(argv[0]);
+        return false;
+    }
+
+    // save states can't be loaded during netplay
+    if (!l_Options.NetplayAddress.empty() && !l_Options.SaveState.empty())
+    {
+        std::cerr << "Error: --state can't be used with --netplay" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+#ifdef PORTABLE_INSTALL
+static std::filesystem::path get_exe_directory(void)
+{
+#ifdef _WIN32
+    wchar_t buffer[MAX_PATH + 1] = {0};
+    GetModuleFileNameW(nullptr, buffer, MAX_PATH);
+    return std::filesystem::path(buffer).parent_path();
+#else
+    return std::filesystem::canonical("/proc/self/exe").parent_path();
+#endif // _WIN32
+}
+#endif // PORTABLE_INSTALL
+
+static bool read_input_file(const std::filesystem::path& file)
+{
+    std::vector<char> buffer;
+    size_t offset = 0;
+
+    if (!CoreReadFile(file, buffer))
+    {
+        return false;
+    }
+
+    // .m64 files start with a header, version 3
+    // has the input after 0x400 bytes, older
+    // versions have it after 0x200 bytes
+    if (buffer.size() >= 8 && std::memcmp(buffer.data(), "M64\x1A", 4) == 0)
+    {
+        uint32_t version = 0;
+        std::memcpy(&version, buffer.data() + 4, sizeof(version));
+        offset = (version >= 3) ? 0x400 : 0x200;
+    }
+
+    if (offset > buffer.size())
+    {
+        offset = buffer.size();
+    }
+
+    l_Inputs.resize((buffer.size() - offset) / sizeof(uint32_t));
+    if (!l_Inputs.empty())
+    {
+        std::memcpy(l_Inputs.data(), buffer.data() + offset, l_Inputs.size() * sizeof(uint32_t));
+    }
+
+    return true;
+}
+
+static void start_counting(void)
+{
+    if (!l_Inputs.empty())
+    {
+        CoreSetInputPlayback(l_Inputs);
+    }
+
+    l_Counting   = true;
+    l_CountedVIs = 0;
+    l_StartTime  = std::chrono::steady_clock::now();
+}
+
+static void stop_emulation(bool failed)
+{
+    l_Failed   = failed;
+    l_Finished = true;
+    CoreStopEmulation();
+}
+
+static void frame_callback(unsigned int)
+{
+    if (l_Finished)
+    {
+        return;
+    }
+
+    if (!l_Counting)
+    {
+        // the save state is loaded on the first VI,
+        // it's retried when the core isn't ready yet
+        if (!l_SaveStateLoading)
+        {
+            if (l_SaveStateTries++ >= 5 || !CoreLoadSaveState(l_Options.SaveState))
+            {
+                std::cerr << "Error: failed to load save state: " << CoreGetError() << std::endl;
+                stop_emulation(true);
+                return;
+            }
+            l_SaveStateLoading = true;
+        }
+        return;
+    }
+
+    if (!l_Options.NetplayAddress.empty())
+    {
+        // VIs which are emulated again after
+        // a rollback aren't counted
+        if (!CoreGetNetplayStats(l_NetplayStats))
+        {
+            std::cerr << "Error: failed to retrieve netplay statistics: " << CoreGetError() << std::endl;
+            stop_emulation(true);
+            return;
+        }
+
+        l_CountedVIs = l_NetplayStats.VIs;
+        if (l_CountedVIs < l_Options.VICount)
+        {
+            return;
+        }
+    }
+    else if (++l_CountedVIs < l_Options.VICount)
+    {
+        return;
+    }
+
+    l_Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - l_StartTime).count();
+
+    if (!CoreGetRDRAMHash(l_RDRAMHash))
+    {
+        std::cerr << "Error: failed to retrieve RDRAM hash: " << CoreGetError() << std::endl;
+        stop_emulation(true);
+        return;
+    }
+
+    stop_emulation(false);
+}
+
+static void debug_callback(CoreDebugMessageType type, std::string context, std::string message)
+{
+    if (context.starts_with("[CORE]") && message.starts_with("profile: "))
+    {
+        l_ProfileMessages.push_back(message.substr(9));
+    }
+    else if (type == CoreDebugMessageType::Error && !l_Options.DebugMessages)
+    {
+        std::cerr << context << message << std::endl;
+    }
+}
+
+static void state_callback(CoreStateCallbackType type, int value)
+{
+    switch (type)
+    {
+        default:
+            break;
+        case CoreStateCallbackType::EmulationState:
+        {
+            if (value == static_cast<int>(CoreEmulationState::Running))
+            {
+                // netplay controls the speed limiter
+                if (l_Options.NetplayAddress.empty())
+                {
+                    CoreSetSpeedLimiterState(false);
+                }
+                if (l_Options.SaveState.empty() && !l_Counting)
+                {
+                    start_counting();
+                }
+            }
+        } break;
+        case CoreStateCallbackType::SaveStateLoaded:
+        {
+            if (!l_SaveStateLoading)
+            {
+                break;
+            }
+
+            l_SaveStateLoading = false;
+            if (value != 0)
+            {
+                start_counting();
+            }
+        } break;
+    }
+}
+
+static bool apply_settings(void)
+{
+    if (l_Options.RspPlugin.empty())
+    {
+        l_Options.RspPlugin = CoreSettingsGetStringValue(SettingsID::Core_RSP_Plugin);
+    }
+
+    // the settings aren't saved, so
+    // they don't affect RMG
+    CoreSettingsSetValue(SettingsID::Core_RSP_Plugin, l_Options.RspPlugin);
+    CoreSettingsSetValue(SettingsID::Core_GFX_Plugin, l_Options.GfxPlugin);
+    CoreSettingsSetValue(SettingsID::Core_AUDIO_Plugin, l_Options.AudioPlugin);
+    CoreSettingsSetValue(SettingsID::Core_INPUT_Plugin, l_Options.InputPlugin);
+    CoreSettingsSetValue(SettingsID::Core_EXECUTION_Plugin, std::string("(None)"));
+
+    // results must be reproducible
+    CoreSettingsSetValue(SettingsID::CoreOverlay_RandomizeInterrupt, false);
+    CoreSettingsSetValue(SettingsID::Core_Rewind_Enabled, false);
+    if (l_Options.CpuEmulator != -1)
+    {
+        CoreSettingsSetValue(SettingsID::CoreOverlay_CPU_Emulator, l_Options.CpuEmulator);
+    }
+    CoreSettingsSetValue(SettingsID::Netplay_RollbackFrames, l_Options.NetplayRollback);
+
+    return CoreApplyPluginSettings();
+}
+
+//
+// Exported Functions
+//
+
+int main(int argc, char** argv)
+{
+    if (!parse_arguments(argc, argv))
+    {
+        return 1;
+    }
+
+#ifdef PORTABLE_INSTALL
+    // only change current directory
+    // when we're in portable directory mode
+    if (CoreGetPortableDirectoryMode())
+    {
+        std::filesystem::current_path(get_exe_directory());
+    }
+#endif // PORTABLE_INSTALL
+
+    CoreSetPrintDebugCallback(l_Options.DebugMessages);
+    CoreSetupCallbacks(debug_callback, state_callback);
+
+    if (!CoreInit())
+    {
+        std::cerr << "Error: failed to initialize core: " << CoreGetError() << std::endl;
+        return 1;
+    }
+
+    if (!l_Options.Input.empty() && !read_input_file(l_Options.Input))
+    {
+        std::cerr << "Error: failed to read input file: " << CoreGetError() << std::endl;
+        CoreShutdown();
+        return 1;
+    }
+
+    if (!apply_settings())
+    {
+        std::cerr << "Error: failed to apply plugin settings: " << CoreGetError() << std::endl;
+        CoreShutdown();
+        return 1;
+    }
+
+    CoreSetFrameCallback(frame_callback);
+
+    bool ret;
+    if (l_Options.NetplayAddress.empty())
+    {
+        ret = CoreStartEmulation(l_Options.Rom, "");
+    }
+    else
+    {
+        ret = CoreStartEmulation(l_Options.Rom, "", l_Options.NetplayAddress,
+                                 l_Options.NetplayPort, l_Options.NetplayPlayer);
+    }
+
+    CoreSetFrameCallback(nullptr);
+    CoreClearInputPlayback();
+
+    if (!l_Finished)
+    {
+        std::cerr << "Error: emulation stopped before " << l_Options.VICount << " VIs";
+        if (!ret)
+        {
+            std::cerr << ": " << CoreGetError();
+        }
+        std::cerr << std::endl;
+        l_Failed = true;
+    }
+
+    if (!l_Failed)
+    {
+        char hash[17];
+        std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(l_RDRAMHash));
+
+        std::cout << "ROM:        " << l_Options.Rom.filename().string() << std::endl
+                  << "VIs:        " << l_CountedVIs << std::endl
+                  << "Time:       " << l_Seconds << " s" << std::endl
+                  << "VI/s:       " << (l_Seconds > 0 ? l_CountedVIs / l_Seconds : 0) << std::endl
+                  << "RDRAM hash: " << hash << std::endl;
+
+        if (!l_Options.NetplayAddress.empty())
+        {
+            // the statistics are scaled to 10000 VIs,
+            // so runs of a different length can be compared
+            const double scale = l_CountedVIs > 0 ? 10000.0 / l_CountedVIs : 0;
+
+            std::cout << "Netplay:    player " << l_Options.NetplayPlayer
+                      << ", rollback frames " << l_Options.NetplayRollback << std::endl
+                      << "Stalls:     " << l_NetplayStats.Stalls * scale << " per 10k VIs, "
+                      << l_NetplayStats.StallTime * scale << " ms per 10k VIs" << std::endl
+                      << "Catch-up:   " << l_NetplayStats.FastForwardVIs * scale << " fast-forwarded VIs per 10k VIs" << std::endl
+                      << "Rollbacks:  " << l_NetplayStats.Rollbacks * scale << " per 10k VIs, "
+                      << l_NetplayStats.ResimulatedVIs * scale << " resimulated VIs per 10k VIs, "
+                      << "max depth " << l_NetplayStats.MaxDepth << std::endl
+                      << "Desyncs:    " << l_NetplayStats.Desyncs * scale << " per 10k VIs" << std::endl;
+        }
+
+        for (const std::string& message : l_ProfileMessages)
+        {
+            std::cout << "Profile:    " << message << std::endl;
+        }
+    }
+
+    CoreShutdown();
+    return l_Failed ? 1 : 0;
+}
@@ -12,11 +12,15 @@
 
 #include "Directories.hpp"
 #include "Library.hpp"
+#include "File.hpp"
 #include "String.hpp"
 #include "Error.hpp"
 
 #include <cstring>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <list>
 
 // lzma includes
 #include <3rdParty/lzma/7zVersion.h>
@@ -41,6 +45,36 @@
 //
 
 #define UNZIP_READ_SIZE 67108860 /* 64 MiB */
+#define SEVENZIP_BLOCK_CACHE_MAX_SIZE 268435456 /* 256 MiB */
+#define ARCHIVE_ROM_MAX_SIZE 264241152 /* 252 MiB, size of the cartridge domain */
+
+//
+// Local Structures
+//
+
+struct l_7zipBlockCacheEntry
+{
+    std::filesystem::path file;
+    CoreFileTime fileTime;
+    uint32_t     blockIndex;
+
+    std::shared_ptr<std::vector<char>> block;
+};
+
+//
+// Local Variables
+//
+
+static std::once_flag l_CrcTableInitialized;
+
+// decompressed 7zip blocks, ordered from
+// most to least recently used, this allows
+// the ROM browser workers to share the decompressed
+// data of solid blocks during a search, they're
+// released by CoreClearArchiveCache()
+static std::list<l_7zipBlockCacheEntry> l_7zipBlockCache;
+static uint64_t                         l_7zipBlockCacheSize = 0;
+static std::mutex                       l_7zipBlockCacheMutex;
 
 //
 // Local Functions
@@ -105,6 +139,62 @@ static int zlib_filefunc_close(voidpf, voidpf stream)
     return fileStream->fail() ? -1 : 0;
 }
 
+static std::shared_ptr<std::vector<char>> get_cached_7zip_block(const std::filesystem::path& file, CoreFileTime fileTime, uint32_t blockIndex)
+{
+    const std::lock_guard<std::mutex> guard(l_7zipBlockCacheMutex);
+
+    for (auto iter = l_7zipBlockCache.begin(); iter != l_7zipBlockCache.end(); iter++)
+    {
+        if ((*iter).fileTime == fileTime &&
+            (*iter).blockIndex == blockIndex &&
+            (*iter).file == file)
+        {
+            // move entry to the front
+            l_7zipBlockCache.splice(l_7zipBlockCache.begin(), l_7zipBlockCache, iter);
+            return l_7zipBlockCache.front().block;
+        }
+    }
+
+    return nullptr;
+}
+
+// adds the block to the cache, when another thread
+// has cached the same block in the meantime,
+// the block in the cache is returned instead
+static std::shared_ptr<std::vector<char>> add_cached_7zip_block(const std::filesystem::path& file, CoreFileTime fileTime, uint32_t blockIndex, std::shared_ptr<std::vector<char>> block)
+{
+    const std::lock_guard<std::mutex> guard(l_7zipBlockCacheMutex);
+
+    for (auto iter = l_7zipBlockCache.begin(); iter != l_7zipBlockCache.end(); iter++)
+    {
+        if ((*iter).fileTime == fileTime &&
+            (*iter).blockIndex == blockIndex &&
+            (*iter).file == file)
+        {
+            l_7zipBlockCache.splice(l_7zipBlockCache.begin(), l_7zipBlockCache, iter);
+            return l_7zipBlockCache.front().block;
+        }
+    }
+
+    if (block->size() > SEVENZIP_BLOCK_CACHE_MAX_SIZE)
+    {
+        return block;
+    }
+
+    // remove least recently used entries
+    // until the block fits in the cache
+    while (!l_7zipBlockCache.empty() &&
+           (l_7zipBlockCacheSize + block->size()) > SEVENZIP_BLOCK_CACHE_MAX_SIZE)
+    {
+        l_7zipBlockCacheSize -= l_7zipBlockCache.back().block->size();
+        l_7zipBlockCache.pop_back();
+    }
+
+    l_7zipBlockCache.push_front({ file, fileTime, blockIndex, block });
+    l_7zipBlockCacheSize += block->size();
+    return block;
+}
+
 static int zlib_filefunc_testerror(voidpf, voidpf)
 {
     return errno;
@@ -114,10 +204,11 @@ static int zlib_filefunc_testerror(voidpf, voidpf)
 // Exported Functions
 //
 
-CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer)
+CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer, bool headerOnly)
 {
     std::string  error;
     std::ifstream fileStream;
+    bool          skippedLargeFile = false;
 
     unzFile           zipFile;
     unz_global_info64 zipInfo;
@@ -154,6 +245,7 @@ CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::pa
 
     if (unzGetGlobalInfo64(zipFile, &zipInfo) != UNZ_OK)
     {
+        unzClose(zipFile);
         error = "CoreReadZipFile: unzGetGlobalInfo Failed!";
         CoreSetError(error);
         return false;
@@ -161,12 +253,12 @@ CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::pa
 
     for (uint64_t i = 0; i < zipInfo.number_entry; i++)
     {
-        unz_file_info fileInfo;
-        char          fileName[CORE_DIR_MAX_LEN];
+        unz_file_info64 fileInfo;
+        char            fileName[CORE_DIR_MAX_LEN];
 
         // if we can't retrieve file info,
         // skip the file
-        if (unzGetCurrentFileInfo(zipFile, &fileInfo, fileName, CORE_DIR_MAX_LEN, nullptr, 0, nullptr, 0) != UNZ_OK)
+        if (unzGetCurrentFileInfo64(zipFile, &fileInfo, fileName, CORE_DIR_MAX_LEN, nullptr, 0, nullptr, 0) != UNZ_OK)
         {
             continue;
         }
@@ -187,46 +279,83 @@ CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::pa
         }
         std::string fileExtension = fileNamePath.has_extension() ? fileNamePath.extension().string() : "";
         fileExtension = CoreLowerString(fileExtension);
-        if (fileExtension == ".z64" ||
-            fileExtension == ".v64" ||
-            fileExtension == ".n64" ||
-            fileExtension == ".ndd" ||
-            fileExtension == ".d64")
+        bool isRomFile = (fileExtension == ".z64" ||
+                          fileExtension == ".v64" ||
+                          fileExtension == ".n64" ||
+                          fileExtension == ".ndd" ||
+                          fileExtension == ".d64");
+
+        // the uncompressed size comes from the central directory,
+        // so skip files which claim to be larger than any ROM can be
+        if (isRomFile && fileInfo.uncompressed_size > ARCHIVE_ROM_MAX_SIZE)
         {
-            std::vector<char> buffer(UNZIP_READ_SIZE);
-            int bytes_read = 0;
+            isRomFile        = false;
+            skippedLargeFile = true;
+        }
 
-            outBuffer.reserve(UNZIP_READ_SIZE);
+        if (isRomFile)
+        {
+            uint64_t readSize  = fileInfo.uncompressed_size;
+            uint64_t bytesRead = 0;
+            int      ret       = 0;
+
+            // only read the start of the file
+            // when we only need the header
+            if (headerOnly)
+            {
+                readSize = std::min(readSize, static_cast<uint64_t>(ARCHIVE_HEADER_READ_SIZE));
+            }
 
             if (unzOpenCurrentFile(zipFile) != UNZ_OK)
             {
+                unzClose(zipFile);
                 error = "CoreReadZipFile Failed: unzOpenCurrentFile Failed!";
                 CoreSetError(error);
                 return false;
             }
 
-            do
+            // allocate the buffer using the uncompressed size
+            // from the central directory and decompress
+            // directly into it
+            outBuffer.resize(readSize);
+
+            while (bytesRead < readSize)
             {
-                bytes_read = unzReadCurrentFile(zipFile, buffer.data(), UNZIP_READ_SIZE);
-                if (bytes_read < 0)
+                ret = unzReadCurrentFile(zipFile, outBuffer.data() + bytesRead, 
+                                         static_cast<unsigned int>(std::min(readSize - bytesRead, static_cast<uint64_t>(UNZIP_READ_SIZE))));
+                if (ret < 0)
                 {
                     unzCloseCurrentFile(zipFile);
                     unzClose(zipFile);
                     error = "CoreReadZipFile Failed: unzReadCurrentFile Failed: ";
-                    error += std::to_string(bytes_read);
+                    error += std::to_string(ret);
                     CoreSetError(error);
                     return false;
                 }
-                else if (bytes_read > 0)
-                {
-                    outBuffer.insert(outBuffer.end(), buffer.begin(), std::next(buffer.begin(), bytes_read));
+                else if (ret == 0)
+                { // end of file was reached earlier than expected
+                    break;
                 }
-            } while (bytes_read > 0);
+
+                bytesRead += ret;
+            }
+
+            outBuffer.resize(bytesRead);
+
+            // the CRC is only verified when
+            // the whole file has been read
+            ret = unzCloseCurrentFile(zipFile);
+            unzClose(zipFile);
+            if (ret != UNZ_OK)
+            {
+                error = "CoreReadZipFile Failed: unzCloseCurrentFile Failed: ";
+                error += std::to_string(ret);
+                CoreSetError(error);
+                return false;
+            }
 
             extractedFileName = fileNamePath;
             isDisk            = (fileExtension == ".ndd" || fileExtension == ".d64");
-            unzCloseCurrentFile(zipFile);
-            unzClose(zipFile);
             return true;
         }
 
@@ -247,12 +376,18 @@ CORE_EXPORT bool CoreReadZipFile(std::filesystem::path file, std::filesystem::pa
     }
 
     error = "CoreReadZipFile Failed: no valid ROMs found in zip!";
+    if (skippedLargeFile)
+    {
+        error += " (skipped files larger than ";
+        error += std::to_string(ARCHIVE_ROM_MAX_SIZE);
+        error += " bytes)";
+    }
     CoreSetError(error);
     unzClose(zipFile);
     return false;
 }
 
-CORE_EXPORT bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer)
+CORE_EXPORT bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer, bool headerOnly)
 {
     std::string  error;
 
@@ -267,6 +402,8 @@ CORE_EXPORT bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::p
     CSzArEx db;
     SRes res;
 
+    CoreFileTime fileTime = CoreGetFileTime(file);
+
     // initialize allocator 
     allocImp     = alloc;
     allocTempImp = alloc;
@@ -305,8 +442,9 @@ CORE_EXPORT bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::p
     lookStream.realStream = &archiveStream.vt;
     LookToRead2_INIT(&lookStream);
 
-    // initialize CRC table
-    CrcGenerateTable();
+    // initialize CRC table once,
+    // archives can be read from multiple threads
+    std::call_once(l_CrcTableInitialized, CrcGenerateTable);
 
     // initialize archive
     SzArEx_Init(&db);
@@ -363,37 +501,92 @@ CORE_EXPORT bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::p
             fileExtension == ".ndd" ||
             fileExtension == ".d64")
         {
-            uint32_t blockIndex = 0xFFFFFFFF;
-            uint8_t* readBuffer = nullptr;
-            size_t   readBufferSize = 0;
-            size_t   offset = 0;
-            size_t   outSizeProcessed = 0;
-
-            res = SzArEx_Extract(&db, &lookStream.vt, i,
-                                    &blockIndex, &readBuffer, &readBufferSize,
-                                    &offset, &outSizeProcessed,
-                                    &allocImp, &allocTempImp);
+            const uint32_t folderIndex = db.FileToFolder[i];
+            const uint64_t fileSize    = SzArEx_GetFileSize(&db, i);
+            uint64_t blockSize   = 0;
+            uint64_t blockOffset = 0;
+            std::shared_ptr<std::vector<char>> block;
+
+            res = SZ_OK;
+
+            if (folderIndex == 0xFFFFFFFF)
+            { // empty files don't have a block
+                outBuffer.clear();
+            }
+            else
+            {
+                blockSize   = SzAr_GetFolderUnpackSize(&db.db, folderIndex);
+                blockOffset = db.UnpackPositions[i] - db.UnpackPositions[db.FolderToFile[folderIndex]];
+                block       = get_cached_7zip_block(file, fileTime, folderIndex);
+            }
+
+            if (block == nullptr && folderIndex != 0xFFFFFFFF &&
+                blockSize == fileSize && blockSize > SEVENZIP_BLOCK_CACHE_MAX_SIZE)
+            { // when the file is the only file in a block which is too large
+              // to cache, decompress it directly into the output buffer
+                outBuffer.resize(fileSize);
+                res = SzAr_DecodeFolder(&db.db, folderIndex, &lookStream.vt, db.dataPos,
+                                        reinterpret_cast<Byte*>(outBuffer.data()), outBuffer.size(),
+                                        &allocTempImp);
+            }
+            else if (folderIndex != 0xFFFFFFFF)
+            {
+                // decompress the whole block when it isn't cached
+                if (block == nullptr)
+                {
+                    block = std::make_shared<std::vector<char>>(blockSize);
+                    res = SzAr_DecodeFolder(&db.db, folderIndex, &lookStream.vt, db.dataPos,
+                                            reinterpret_cast<Byte*>(block->data()), block->size(),
+                                            &allocTempImp);
+                    if (res == SZ_OK)
+                    {
+                        block = add_cached_7zip_block(file, fileTime, folderIndex, block);
+                    }
+                }
+
+                // copy the file from the block
+                if (res == SZ_OK)
+                {
+                    const uint64_t copySize = headerOnly ? std::min(fileSize, static_cast<uint64_t>(ARCHIVE_HEADER_READ_SIZE)) : fileSize;
+                    outBuffer.assign(block->begin() + blockOffset, block->begin() + blockOffset + copySize);
+                }
+            }
+
+            // verify the CRC when we've read the whole file
+            if (res == SZ_OK && outBuffer.size() == fileSize &&
+                SzBitWithVals_Check(&db.CRCs, i) &&
+                CrcCalc(outBuffer.data(), outBuffer.size()) != db.CRCs.Vals[i])
+            {
+                res = SZ_ERROR_CRC;
+            }
+
             if (res != SZ_OK)
             {
-                error = "CoreRead7zipFile Failed: SzArEx_Extract Failed: ";
+                error = "CoreRead7zipFile Failed: SzAr_DecodeFolder Failed: ";
                 error += std::to_string(res);
                 CoreSetError(error);
 
                 SzArEx_Free(&db, &allocImp);
                 ISzAlloc_Free(&allocImp, lookStream.buf);
                 File_Close(&archiveStream.file);
-                ISzAlloc_Free(&allocImp, readBuffer);
                 return false;
             }
 
-            outBuffer.insert(outBuffer.begin(), readBuffer, readBuffer + outSizeProcessed);
+            // 7zip blocks can't be partially decompressed,
+            // so only keep the header when requested
+            // for blocks we've decompressed directly
+            if (headerOnly && outBuffer.size() > ARCHIVE_HEADER_READ_SIZE)
+            {
+                outBuffer.resize(ARCHIVE_HEADER_READ_SIZE);
+                outBuffer.shrink_to_fit();
+            }
+
             extractedFileName = fileNamePath;
             isDisk            = (fileExtension == ".ndd" || fileExtension == ".d64");
 
             SzArEx_Free(&db, &allocImp);
             ISzAlloc_Free(&allocImp, lookStream.buf);
             File_Close(&archiveStream.file);
-            ISzAlloc_Free(&allocImp, readBuffer);
             return true;
         }
     }
@@ -408,7 +601,7 @@ CORE_EXPORT bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::p
     return false;
 }
 
-CORE_EXPORT bool CoreReadArchiveFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer)
+CORE_EXPORT bool CoreReadArchiveFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer, bool headerOnly)
 {
 	std::string file_extension;
 
@@ -422,14 +615,14 @@ CORE_EXPORT bool CoreReadArchiveFile(std::filesystem::path file, std::filesystem
 
     if (file_extension == ".zip")
     {
-    	if (!CoreReadZipFile(file, extractedFileName, isDisk, outBuffer))
+    	if (!CoreReadZipFile(file, extractedFileName, isDisk, outBuffer, headerOnly))
         {
             return false;
         }
     }
     else
     {
-        if (!CoreRead7zipFile(file, extractedFileName, isDisk, outBuffer))
+        if (!CoreRead7zipFile(file, extractedFileName, isDisk, outBuffer, headerOnly))
         {
             return false;
         }
@@ -438,6 +631,13 @@ CORE_EXPORT bool CoreReadArchiveFile(std::filesystem::path file, std::filesystem
     return true;
 }
 
+CORE_EXPORT void CoreClearArchiveCache(void)
+{
+    const std::lock_guard<std::mutex> guard(l_7zipBlockCacheMutex);
+    l_7zipBlockCache.clear();
+    l_7zipBlockCacheSize = 0;
+}
+
 CORE_EXPORT bool CoreUnzip(std::filesystem::path file, std::filesystem::path path)
 {
     std::string error;
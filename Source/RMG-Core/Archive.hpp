@@ -13,14 +13,24 @@
 #include <filesystem>
 #include <vector>
 
-// attempts to read the ROM/disk in a zip file into outBuffer
-bool CoreReadZipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer);
+// amount of bytes read when only the header is requested
+#define ARCHIVE_HEADER_READ_SIZE 4096 /* 4 KiB */
 
-// attempts to read the ROM/disk in a 7zip file into outBuffer
-bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer);
+// attempts to read the ROM/disk in a zip file into outBuffer,
+// when headerOnly is true, only the first ARCHIVE_HEADER_READ_SIZE bytes are read
+bool CoreReadZipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer, bool headerOnly = false);
 
-// attempts to read the ROM/disk in a supported archive file into outBuffer
-bool CoreReadArchiveFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer);
+// attempts to read the ROM/disk in a 7zip file into outBuffer,
+// when headerOnly is true, only the first ARCHIVE_HEADER_READ_SIZE bytes are kept
+bool CoreRead7zipFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer, bool headerOnly = false);
+
+// attempts to read the ROM/disk in a supported archive file into outBuffer,
+// when headerOnly is true, only the first ARCHIVE_HEADER_READ_SIZE bytes are returned
+bool CoreReadArchiveFile(std::filesystem::path file, std::filesystem::path& extractedFileName, bool& isDisk, std::vector<char>& outBuffer, bool headerOnly = false);
+
+// releases the decompressed 7zip blocks which
+// have been cached by CoreRead7zipFile()
+void CoreClearArchiveCache(void);
 
 // attempts to unzip the file to path
 bool CoreUnzip(std::filesystem::path file, std::filesystem::path path);
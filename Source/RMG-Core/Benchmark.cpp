@@ -0,0 +1,130 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define CORE_INTERNAL
+#include "Benchmark.hpp"
+#include "Library.hpp"
+#include "Error.hpp"
+
+#include "m64p/Api.hpp"
+
+#include <string>
+
+//
+// Local Variables
+//
+
+static std::function<void(unsigned int)> l_FrameCallbackFunc;
+
+//
+// Local Functions
+//
+
+static void frame_callback(unsigned int frameIndex)
+{
+    if (l_FrameCallbackFunc)
+    {
+        l_FrameCallbackFunc(frameIndex);
+    }
+}
+
+//
+// Exported Functions
+//
+
+CORE_EXPORT bool CoreSetFrameCallback(std::function<void(unsigned int)> callbackFunc)
+{
+    std::string error;
+    m64p_error ret;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    l_FrameCallbackFunc = callbackFunc;
+
+    ret = m64p::Core.DoCommand(M64CMD_SET_FRAME_CALLBACK, 0, callbackFunc ? (void*)frame_callback : nullptr);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreSetFrameCallback: m64p::Core.DoCommand(M64CMD_SET_FRAME_CALLBACK) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
+
+CORE_EXPORT bool CoreSetInputPlayback(const std::vector<uint32_t>& inputs)
+{
+    std::string error;
+    m64p_error ret;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    if (inputs.empty())
+    {
+        return CoreClearInputPlayback();
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_INPUT_PLAYBACK, static_cast<int>(inputs.size()), (void*)inputs.data());
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreSetInputPlayback: m64p::Core.DoCommand(M64CMD_INPUT_PLAYBACK) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
+
+CORE_EXPORT bool CoreClearInputPlayback(void)
+{
+    std::string error;
+    m64p_error ret;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_INPUT_PLAYBACK, 0, nullptr);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreClearInputPlayback: m64p::Core.DoCommand(M64CMD_INPUT_PLAYBACK) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
+
+CORE_EXPORT bool CoreGetRDRAMHash(uint64_t& hash)
+{
+    std::string error;
+    m64p_error ret;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_RDRAM_GET_HASH, 0, &hash);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreGetRDRAMHash: m64p::Core.DoCommand(M64CMD_RDRAM_GET_HASH) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
@@ -0,0 +1,34 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_BENCHMARK_HPP
+#define CORE_BENCHMARK_HPP
+
+#include <functional>
+#include <cstdint>
+#include <vector>
+
+// sets the function which is called on every VI,
+// it's called on the emulation thread,
+// passing nullptr removes the function
+bool CoreSetFrameCallback(std::function<void(unsigned int)> callbackFunc);
+
+// replaces the input of the plugged controllers with the
+// given button values, every controller poll uses the next value,
+// during netplay only the input of the local player is replaced
+bool CoreSetInputPlayback(const std::vector<uint32_t>& inputs);
+
+// stops the input playback
+bool CoreClearInputPlayback(void);
+
+// retrieves a hash of RDRAM, it must
+// be called on the emulation thread
+bool CoreGetRDRAMHash(uint64_t& hash);
+
+#endif // CORE_BENCHMARK_HPP
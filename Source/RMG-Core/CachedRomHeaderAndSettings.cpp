@@ -9,32 +9,40 @@
  */
 #define CORE_INTERNAL
 #include "CachedRomHeaderAndSettings.hpp"
+#include "RomHeaderAndSettings.hpp"
 #include "Directories.hpp"
 #include "RomSettings.hpp"
 #include "RomHeader.hpp"
 #include "Library.hpp"
 #include "File.hpp"
 
+#include <unordered_map>
 #include <algorithm>
 #include <cstring>
 #include <fstream>
+#include <mutex>
 #include <vector>
+#include <list>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
 
 //
 // Local Defines
 //
 
-#define ROMHEADER_NAME_LEN 256
-#define GOODNAME_LEN 256
-#define MD5_LEN 33
-#define GAMEID_LEN 5
-#define REGION_LEN 18
-
 #ifdef _WIN32
-#define CACHE_FILE_MAGIC "RMGCoreHeaderAndSettingsCacheWindows_09"
+#define CACHE_FILE_MAGIC "RMGCoreHeaderAndSettingsCacheWindows"
 #else // Linux
-#define CACHE_FILE_MAGIC "RMGCoreHeaderAndSettingsCacheLinux_09"
+#define CACHE_FILE_MAGIC "RMGCoreHeaderAndSettingsCacheLinux"
 #endif // _WIN32
+#define CACHE_FILE_VERSION   10
 #define CACHE_FILE_ITEMS_MAX 250000
 
 //
@@ -54,12 +62,88 @@ struct l_CacheEntry
     CoreRomSettings defaultSettings;
 };
 
+struct l_CachePathHash
+{
+    std::size_t operator()(const std::filesystem::path& path) const noexcept
+    {
+        return std::filesystem::hash_value(path);
+    }
+};
+
+// on-disk layout, the file consists of a header,
+// followed by a table of fixed size entries
+// and a string table which the entries refer to,
+// this allows us to map the file and read
+// the entries without parsing them field by field
+
+struct l_CacheFileString
+{
+    uint32_t Offset;
+    uint32_t Size;
+};
+
+struct l_CacheFileSettings
+{
+    int32_t  CountPerOp;
+    int32_t  SiDMADuration;
+    uint16_t SaveType;
+    uint8_t  DisableExtraMem;
+    uint8_t  TransferPak;
+};
+
+struct l_CacheFileHeader
+{
+    char     Magic[64];
+    uint32_t Version;
+    uint32_t EntryCount;
+    uint64_t StringTableOffset;
+    uint64_t StringTableSize;
+};
+
+struct l_CacheFileEntry
+{
+    uint64_t FileTime;
+    l_CacheFileString FileName;
+
+    uint8_t Valid;
+    uint8_t Type;
+    uint8_t SystemType;
+    uint8_t Reserved;
+
+    uint32_t CRC1;
+    uint32_t CRC2;
+    uint32_t CountryCode;
+    l_CacheFileString Name;
+    l_CacheFileString GameID;
+    l_CacheFileString Region;
+
+    l_CacheFileString GoodName;
+    l_CacheFileString MD5;
+    l_CacheFileSettings DefaultSettings;
+    l_CacheFileSettings Settings;
+};
+
+struct l_MappedFile
+{
+    const char* Data = nullptr;
+    uint64_t    Size = 0;
+#ifdef _WIN32
+    HANDLE FileHandle    = INVALID_HANDLE_VALUE;
+    HANDLE MappingHandle = nullptr;
+#endif // _WIN32
+};
+
 //
 // Local Variables
 //
 
-static bool                      l_CacheEntriesChanged = false;
-static std::vector<l_CacheEntry> l_CacheEntries;
+// cache entries are kept in insertion order,
+// when we go over the item limit, the oldest
+// entry at the front will be removed
+static bool                    l_CacheEntriesChanged = false;
+static std::list<l_CacheEntry> l_CacheEntries;
+static std::unordered_map<std::filesystem::path, std::list<l_CacheEntry>::iterator, l_CachePathHash> l_CacheEntriesIndex;
+static std::mutex              l_CacheMutex;
 
 //
 // Internal Functions
@@ -76,71 +160,214 @@ static std::filesystem::path get_cache_file_name(void)
     return file;
 }
 
-static std::vector<l_CacheEntry>::iterator get_cache_entry_iter(const std::filesystem::path& file, bool checkFileTime = true)
+static bool map_file(const std::filesystem::path& file, l_MappedFile& mappedFile)
 {
-    CoreFileTime fileTime = (checkFileTime ? CoreGetFileTime(file) : 0);
+#ifdef _WIN32
+    LARGE_INTEGER fileSize;
+
+    mappedFile.FileHandle = CreateFileW(file.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (mappedFile.FileHandle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
 
-    auto predicate = [file, fileTime, checkFileTime](const auto& entry)
+    if (!GetFileSizeEx(mappedFile.FileHandle, &fileSize) || fileSize.QuadPart == 0)
     {
-        return entry.fileName == file &&
-                (!checkFileTime || entry.fileTime == fileTime);
-    };
+        CloseHandle(mappedFile.FileHandle);
+        return false;
+    }
 
-    return std::find_if(l_CacheEntries.begin(), l_CacheEntries.end(), predicate);
+    mappedFile.MappingHandle = CreateFileMappingW(mappedFile.FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappedFile.MappingHandle == nullptr)
+    {
+        CloseHandle(mappedFile.FileHandle);
+        return false;
+    }
+
+    mappedFile.Data = (const char*)MapViewOfFile(mappedFile.MappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (mappedFile.Data == nullptr)
+    {
+        CloseHandle(mappedFile.MappingHandle);
+        CloseHandle(mappedFile.FileHandle);
+        return false;
+    }
+
+    mappedFile.Size = fileSize.QuadPart;
+    return true;
+#else // Linux
+    int fd;
+    struct stat fileStat;
+    void* data;
+
+    fd = open(file.string().c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after closing
+    // the file descriptor
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    mappedFile.Data = (const char*)data;
+    mappedFile.Size = fileStat.st_size;
+    return true;
+#endif // _WIN32
 }
 
-static void add_cache_entry(const std::filesystem::path& file, CoreRomType type, 
-                            const CoreRomHeader& header, const CoreRomSettings& defaultSettings,
-                            const CoreRomSettings& settings)
+static void unmap_file(l_MappedFile& mappedFile)
 {
-    l_CacheEntry cacheEntry;
+#ifdef _WIN32
+    UnmapViewOfFile(mappedFile.Data);
+    CloseHandle(mappedFile.MappingHandle);
+    CloseHandle(mappedFile.FileHandle);
+#else // Linux
+    munmap((void*)mappedFile.Data, mappedFile.Size);
+#endif // _WIN32
+    mappedFile = {};
+}
 
+static std::list<l_CacheEntry>::iterator get_cache_entry_iter(const std::filesystem::path& file)
+{
+    auto indexIter = l_CacheEntriesIndex.find(file);
+    if (indexIter == l_CacheEntriesIndex.end())
+    {
+        return l_CacheEntries.end();
+    }
+
+    return indexIter->second;
+}
+
+static std::list<l_CacheEntry>::iterator get_cache_entry_iter(const std::filesystem::path& file, CoreFileTime fileTime)
+{
+    auto iter = get_cache_entry_iter(file);
+    if (iter != l_CacheEntries.end() && (*iter).fileTime != fileTime)
+    {
+        return l_CacheEntries.end();
+    }
+
+    return iter;
+}
+
+static void insert_cache_entry(l_CacheEntry&& cacheEntry)
+{
     // try to find existing entry with same filename,
     // when found, remove it from the cache
-    auto iter = get_cache_entry_iter(file, false);
-    if (iter != l_CacheEntries.end())
+    auto indexIter = l_CacheEntriesIndex.find(cacheEntry.fileName);
+    if (indexIter != l_CacheEntriesIndex.end())
     {
-        l_CacheEntries.erase(iter);
+        l_CacheEntries.erase(indexIter->second);
+        l_CacheEntriesIndex.erase(indexIter);
     }
     else if (l_CacheEntries.size() >= CACHE_FILE_ITEMS_MAX)
     { // delete first item when we're over the item limit
-        l_CacheEntries.erase(l_CacheEntries.begin());
+        l_CacheEntriesIndex.erase(l_CacheEntries.front().fileName);
+        l_CacheEntries.pop_front();
     }
 
+    l_CacheEntries.push_back(std::move(cacheEntry));
+    l_CacheEntriesIndex[l_CacheEntries.back().fileName] = std::prev(l_CacheEntries.end());
+}
+
+static void add_cache_entry(const std::filesystem::path& file, CoreFileTime fileTime, CoreRomType type, 
+                            const CoreRomHeader& header, const CoreRomSettings& defaultSettings,
+                            const CoreRomSettings& settings)
+{
+    l_CacheEntry cacheEntry;
+
     cacheEntry.fileName = file;
-    cacheEntry.fileTime = CoreGetFileTime(file);
+    cacheEntry.fileTime = fileTime;
     cacheEntry.type     = type;
     cacheEntry.header   = header;
     cacheEntry.settings = settings;
     cacheEntry.defaultSettings = defaultSettings;
     cacheEntry.valid    = true;
 
-    l_CacheEntries.push_back(cacheEntry);
+    insert_cache_entry(std::move(cacheEntry));
     l_CacheEntriesChanged = true;
 }
 
-static void add_invalid_cache_entry(const std::filesystem::path& file)
+static void add_invalid_cache_entry(const std::filesystem::path& file, CoreFileTime fileTime)
 {
-    l_CacheEntry cacheEntry;
+    l_CacheEntry cacheEntry = {};
 
-    // try to find existing entry with same filename,
-    // when found, remove it from the cache
-    auto iter = get_cache_entry_iter(file, false);
-    if (iter != l_CacheEntries.end())
+    cacheEntry.fileName = file;
+    cacheEntry.fileTime = fileTime;
+    cacheEntry.valid    = false;
+
+    insert_cache_entry(std::move(cacheEntry));
+    l_CacheEntriesChanged = true;
+}
+
+static void copy_cache_entry(const l_CacheEntry& cacheEntry, CoreRomType* type, CoreRomHeader* header, CoreRomSettings* defaultSettings, CoreRomSettings* settings)
+{
+    if (type != nullptr)
     {
-        l_CacheEntries.erase(iter);
+        *type = cacheEntry.type;
     }
-    else if (l_CacheEntries.size() >= CACHE_FILE_ITEMS_MAX)
-    { // delete first item when we're over the item limit
-        l_CacheEntries.erase(l_CacheEntries.begin());
+    if (header != nullptr)
+    {
+        *header = cacheEntry.header;
+    }
+    if (settings != nullptr)
+    {
+        *settings = cacheEntry.settings;
+    }
+    if (defaultSettings != nullptr)
+    {
+        *defaultSettings = cacheEntry.defaultSettings;
     }
+}
 
-    cacheEntry.fileName = file;
-    cacheEntry.fileTime = CoreGetFileTime(file);
-    cacheEntry.valid    = false;
+static bool read_cache_string(const l_MappedFile& mappedFile, const l_CacheFileHeader* header, const l_CacheFileString& string, std::string& outString)
+{
+    if ((uint64_t)string.Offset + string.Size > header->StringTableSize)
+    {
+        return false;
+    }
 
-    l_CacheEntries.push_back(cacheEntry);
-    l_CacheEntriesChanged = true;
+    outString.assign(mappedFile.Data + header->StringTableOffset + string.Offset, string.Size);
+    return true;
+}
+
+static l_CacheFileString write_cache_string(std::vector<char>& stringTable, const std::string& string)
+{
+    l_CacheFileString cacheString;
+
+    cacheString.Offset = stringTable.size();
+    cacheString.Size   = string.size();
+
+    stringTable.insert(stringTable.end(), string.begin(), string.end());
+    return cacheString;
+}
+
+static void read_cache_settings(const l_CacheFileSettings& cacheSettings, CoreRomSettings& settings)
+{
+    settings.SaveType        = cacheSettings.SaveType;
+    settings.DisableExtraMem = cacheSettings.DisableExtraMem;
+    settings.TransferPak     = cacheSettings.TransferPak;
+    settings.CountPerOp      = cacheSettings.CountPerOp;
+    settings.SiDMADuration   = cacheSettings.SiDMADuration;
+}
+
+static void write_cache_settings(l_CacheFileSettings& cacheSettings, const CoreRomSettings& settings)
+{
+    cacheSettings.SaveType        = settings.SaveType;
+    cacheSettings.DisableExtraMem = settings.DisableExtraMem;
+    cacheSettings.TransferPak     = settings.TransferPak;
+    cacheSettings.CountPerOp      = settings.CountPerOp;
+    cacheSettings.SiDMADuration   = settings.SiDMADuration;
 }
 
 //
@@ -149,126 +376,122 @@ static void add_invalid_cache_entry(const std::filesystem::path& file)
 
 CORE_EXPORT void CoreReadRomHeaderAndSettingsCache(void)
 {
-    std::ifstream inputStream;
-    char magicBuf[sizeof(CACHE_FILE_MAGIC)];
-    wchar_t fileNameBuf[CORE_DIR_MAX_LEN];
-    char headerNameBuf[ROMHEADER_NAME_LEN];
-    char gameIDBuf[GAMEID_LEN];
-    char regionBuf[REGION_LEN];
-    char goodNameBuf[GOODNAME_LEN];
-    char md5Buf[MD5_LEN];
-    uint32_t size;
+    l_MappedFile mappedFile;
+    const l_CacheFileHeader* fileHeader;
+    const l_CacheFileEntry* fileEntries;
+    std::string fileName;
+    std::string goodName;
+    std::string md5;
     l_CacheEntry cacheEntry;
+    bool ret = true;
+
+    const std::lock_guard<std::mutex> guard(l_CacheMutex);
 
-    inputStream.open(get_cache_file_name(), std::ios::binary);
-    if (!inputStream.good())
+    if (!map_file(get_cache_file_name(), mappedFile))
     {
         return;
     }
 
-    // when magic doesn't match, don't read cache file
-    inputStream.read((char*)magicBuf, sizeof(CACHE_FILE_MAGIC));
-    if (std::string(magicBuf) != std::string(CACHE_FILE_MAGIC))
+    // ensure the file at least contains the header
+    if (mappedFile.Size < sizeof(l_CacheFileHeader))
     {
-        inputStream.close();
+        unmap_file(mappedFile);
         return;
     }
 
-    // read entry count
-    size = l_CacheEntries.size();
-    inputStream.read((char*)&size, sizeof(size));
+    fileHeader  = (const l_CacheFileHeader*)mappedFile.Data;
+    fileEntries = (const l_CacheFileEntry*)(mappedFile.Data + sizeof(l_CacheFileHeader));
+
+    // when magic or version doesn't match,
+    // or when the tables don't fit in the file,
+    // don't read cache file
+    if (memcmp(fileHeader->Magic, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC)) != 0 ||
+        fileHeader->Version != CACHE_FILE_VERSION ||
+        fileHeader->EntryCount > CACHE_FILE_ITEMS_MAX ||
+        fileHeader->StringTableOffset != (sizeof(l_CacheFileHeader) + (fileHeader->EntryCount * sizeof(l_CacheFileEntry))) ||
+        fileHeader->StringTableOffset > mappedFile.Size ||
+        fileHeader->StringTableSize > (mappedFile.Size - fileHeader->StringTableOffset))
+    {
+        unmap_file(mappedFile);
+        return;
+    }
 
     // reserve items
-    l_CacheEntries.reserve(size);
+    l_CacheEntriesIndex.reserve(fileHeader->EntryCount);
 
     // read all file entries
-#define FREAD(x) inputStream.read((char*)&x, sizeof(x))
-#define FREAD_STR(x, y) inputStream.read((char*)x, y)
-    while (!inputStream.eof())
+    for (uint32_t i = 0; i < fileHeader->EntryCount && ret; i++)
     {
+        const l_CacheFileEntry& fileEntry = fileEntries[i];
+
         // reset state
-        size = 0;
         cacheEntry = {};
-        memset(fileNameBuf, 0, sizeof(fileNameBuf));
-        memset(headerNameBuf, 0, sizeof(headerNameBuf));
-        memset(gameIDBuf, 0, sizeof(gameIDBuf));
-        memset(regionBuf, 0, sizeof(regionBuf));
-        memset(goodNameBuf, 0, sizeof(goodNameBuf));
-        memset(md5Buf, 0, sizeof(md5Buf));
 
         // file info
-        FREAD(size);
-        FREAD_STR(fileNameBuf, size);
-        cacheEntry.fileName = std::filesystem::path(fileNameBuf);
-        FREAD(cacheEntry.fileTime);
+        ret = read_cache_string(mappedFile, fileHeader, fileEntry.FileName, fileName);
+        cacheEntry.fileName = std::filesystem::path(std::u8string(fileName.begin(), fileName.end()));
+        cacheEntry.fileTime = fileEntry.FileTime;
         // validity
-        FREAD(cacheEntry.valid);
+        cacheEntry.valid = fileEntry.Valid;
         // invalid entries have less data
         // so we don't need to read further
         if (!cacheEntry.valid)
         {
-            l_CacheEntries.push_back(cacheEntry);
+            insert_cache_entry(std::move(cacheEntry));
             continue;
         }
         // type
-        FREAD(cacheEntry.type);
+        cacheEntry.type = (CoreRomType)fileEntry.Type;
         // header
-        FREAD(size);
-        FREAD_STR(headerNameBuf, size);
-        FREAD(size);
-        FREAD_STR(gameIDBuf, size);
-        FREAD(size);
-        FREAD_STR(regionBuf, size);
-        cacheEntry.header.Name = std::string(headerNameBuf);
-        cacheEntry.header.GameID = std::string(gameIDBuf);
-        cacheEntry.header.Region = std::string(regionBuf);
-        FREAD(cacheEntry.header.CRC1);
-        FREAD(cacheEntry.header.CRC2);
-        FREAD(cacheEntry.header.CountryCode);
-        FREAD(cacheEntry.header.SystemType);
+        ret = ret && read_cache_string(mappedFile, fileHeader, fileEntry.Name, cacheEntry.header.Name) &&
+                read_cache_string(mappedFile, fileHeader, fileEntry.GameID, cacheEntry.header.GameID) &&
+                read_cache_string(mappedFile, fileHeader, fileEntry.Region, cacheEntry.header.Region);
+        cacheEntry.header.CRC1 = fileEntry.CRC1;
+        cacheEntry.header.CRC2 = fileEntry.CRC2;
+        cacheEntry.header.CountryCode = fileEntry.CountryCode;
+        cacheEntry.header.SystemType  = (CoreSystemType)fileEntry.SystemType;
         // shared settings
-        FREAD(size);
-        FREAD_STR(goodNameBuf, size);
-        FREAD(size);
-        FREAD_STR(md5Buf, size);
-        cacheEntry.defaultSettings.GoodName = std::string(goodNameBuf);
-        cacheEntry.defaultSettings.MD5 = std::string(md5Buf);
-        cacheEntry.settings.GoodName = std::string(goodNameBuf);
-        cacheEntry.settings.InternalName = std::string(headerNameBuf);
-        cacheEntry.settings.MD5 = std::string(md5Buf);
+        ret = ret && read_cache_string(mappedFile, fileHeader, fileEntry.GoodName, goodName) &&
+                read_cache_string(mappedFile, fileHeader, fileEntry.MD5, md5);
+        cacheEntry.defaultSettings.GoodName = goodName;
+        cacheEntry.defaultSettings.MD5 = md5;
+        cacheEntry.settings.GoodName = goodName;
+        cacheEntry.settings.InternalName = cacheEntry.header.Name;
+        cacheEntry.settings.MD5 = md5;
         // default settings
-        FREAD(cacheEntry.defaultSettings.SaveType);
-        FREAD(cacheEntry.defaultSettings.DisableExtraMem);
-        FREAD(cacheEntry.defaultSettings.TransferPak);
-        FREAD(cacheEntry.defaultSettings.CountPerOp);
-        FREAD(cacheEntry.defaultSettings.SiDMADuration);
+        read_cache_settings(fileEntry.DefaultSettings, cacheEntry.defaultSettings);
         // current settings
-        FREAD(cacheEntry.settings.SaveType);
-        FREAD(cacheEntry.settings.DisableExtraMem);
-        FREAD(cacheEntry.settings.TransferPak);
-        FREAD(cacheEntry.settings.CountPerOp);
-        FREAD(cacheEntry.settings.SiDMADuration);
+        read_cache_settings(fileEntry.Settings, cacheEntry.settings);
 
         // add to cached entries
-        l_CacheEntries.push_back(cacheEntry);
+        if (ret)
+        {
+            insert_cache_entry(std::move(cacheEntry));
+        }
+    }
+
+    // don't use a partially read cache file
+    if (!ret)
+    {
+        l_CacheEntries.clear();
+        l_CacheEntriesIndex.clear();
     }
-#undef FREAD
-#undef FREAD_STR
 
-    inputStream.close();
+    unmap_file(mappedFile);
 }
 
 CORE_EXPORT bool CoreSaveRomHeaderAndSettingsCache(void)
 {
+    std::filesystem::path fileName;
+    std::filesystem::path tempFileName;
     std::ofstream outputStream;
-    wchar_t fileNameBuf[CORE_DIR_MAX_LEN];
-    char headerNameBuf[ROMHEADER_NAME_LEN];
-    char gameIDBuf[GAMEID_LEN];
-    char regionBuf[REGION_LEN];
-    char goodNameBuf[GOODNAME_LEN];
-    char md5Buf[MD5_LEN];
-    uint32_t size;
-    l_CacheEntry cacheEntry;
+    std::error_code errorCode;
+    l_CacheFileHeader fileHeader = {};
+    std::vector<l_CacheFileEntry> fileEntries;
+    std::vector<char> stringTable;
+    std::u8string u8FileName;
+
+    const std::lock_guard<std::mutex> guard(l_CacheMutex);
 
     // only save cache when the entries have changed
     if (!l_CacheEntriesChanged)
@@ -276,198 +499,219 @@ CORE_EXPORT bool CoreSaveRomHeaderAndSettingsCache(void)
         return true;
     }
 
-    outputStream.open(get_cache_file_name(), std::ios::binary);
-    if (!outputStream.good())
-    {
-        return false;
-    }
-
-    // write magic header
-    outputStream.write((char*)CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
-
-    // write entry count
-    size = l_CacheEntries.size();
-    outputStream.write((char*)&size, sizeof(size));
+    fileEntries.reserve(l_CacheEntries.size());
 
-    // write each entry in the file
-#define FWRITE(x) outputStream.write((char*)&x, sizeof(x))
-#define FWRITE_STR(x, y) outputStream.write((char*)x, y)
-    for (auto iter = l_CacheEntries.cbegin(); iter != l_CacheEntries.end(); iter++)
+    // convert each entry to its on-disk representation
+    for (const l_CacheEntry& cacheEntry : l_CacheEntries)
     {
-        cacheEntry = (*iter);
-
-        // reset buffers
-        size = 0;
-        memset(fileNameBuf, 0, sizeof(fileNameBuf));
-        memset(headerNameBuf, 0, sizeof(headerNameBuf));
-        memset(gameIDBuf, 0, sizeof(gameIDBuf));
-        memset(regionBuf, 0, sizeof(regionBuf));
-        memset(goodNameBuf, 0, sizeof(goodNameBuf));
-        memset(md5Buf, 0, sizeof(md5Buf));
-
-        // copy strings into buffers
-        wcsncpy(fileNameBuf, cacheEntry.fileName.wstring().c_str(), CORE_DIR_MAX_LEN);
-        strncpy(headerNameBuf, cacheEntry.header.Name.c_str(), sizeof(headerNameBuf));
-        strncpy(gameIDBuf, cacheEntry.header.GameID.c_str(), sizeof(gameIDBuf));
-        strncpy(regionBuf, cacheEntry.header.Region.c_str(), sizeof(regionBuf));
-        strncpy(goodNameBuf, cacheEntry.settings.GoodName.c_str(), sizeof(goodNameBuf));
-        strncpy(md5Buf, cacheEntry.settings.MD5.c_str(), sizeof(md5Buf));
+        l_CacheFileEntry fileEntry = {};
 
         // file info
-        size = cacheEntry.fileName.wstring().size() * sizeof(wchar_t);
-        FWRITE(size);
-        FWRITE_STR(fileNameBuf, size);
-        FWRITE(cacheEntry.fileTime);
+        u8FileName = cacheEntry.fileName.u8string();
+        fileEntry.FileName = write_cache_string(stringTable, std::string(u8FileName.begin(), u8FileName.end()));
+        fileEntry.FileTime = cacheEntry.fileTime;
         // validity
-        FWRITE(cacheEntry.valid);
+        fileEntry.Valid = cacheEntry.valid;
         // skip writing more data
         // when the entry is invalid
         if (!cacheEntry.valid)
         {
+            fileEntries.push_back(fileEntry);
             continue;
         }
         // type
-        FWRITE(cacheEntry.type);
+        fileEntry.Type = (uint8_t)cacheEntry.type;
         // header
-        size = cacheEntry.header.Name.size();
-        FWRITE(size);
-        FWRITE_STR(headerNameBuf, size);
-        size = cacheEntry.header.GameID.size();
-        FWRITE(size);
-        FWRITE_STR(gameIDBuf, size);
-        size = cacheEntry.header.Region.size();
-        FWRITE(size);
-        FWRITE_STR(regionBuf, size);
-        FWRITE(cacheEntry.header.CRC1);
-        FWRITE(cacheEntry.header.CRC2);
-        FWRITE(cacheEntry.header.CountryCode);
-        FWRITE(cacheEntry.header.SystemType);
+        fileEntry.Name   = write_cache_string(stringTable, cacheEntry.header.Name);
+        fileEntry.GameID = write_cache_string(stringTable, cacheEntry.header.GameID);
+        fileEntry.Region = write_cache_string(stringTable, cacheEntry.header.Region);
+        fileEntry.CRC1   = cacheEntry.header.CRC1;
+        fileEntry.CRC2   = cacheEntry.header.CRC2;
+        fileEntry.CountryCode = cacheEntry.header.CountryCode;
+        fileEntry.SystemType  = (uint8_t)cacheEntry.header.SystemType;
         // shared settings
-        size = cacheEntry.settings.GoodName.size();
-        FWRITE(size);
-        FWRITE_STR(goodNameBuf, size);
-        size = cacheEntry.settings.MD5.size();
-        FWRITE(size);
-        FWRITE_STR(md5Buf, size);
+        fileEntry.GoodName = write_cache_string(stringTable, cacheEntry.settings.GoodName);
+        fileEntry.MD5      = write_cache_string(stringTable, cacheEntry.settings.MD5);
         // default settings
-        FWRITE(cacheEntry.defaultSettings.SaveType);
-        FWRITE(cacheEntry.defaultSettings.DisableExtraMem);
-        FWRITE(cacheEntry.defaultSettings.TransferPak);
-        FWRITE(cacheEntry.defaultSettings.CountPerOp);
-        FWRITE(cacheEntry.defaultSettings.SiDMADuration);
+        write_cache_settings(fileEntry.DefaultSettings, cacheEntry.defaultSettings);
         // current settings
-        FWRITE(cacheEntry.settings.SaveType);
-        FWRITE(cacheEntry.settings.DisableExtraMem);
-        FWRITE(cacheEntry.settings.TransferPak);
-        FWRITE(cacheEntry.settings.CountPerOp);
-        FWRITE(cacheEntry.settings.SiDMADuration);
+        write_cache_settings(fileEntry.Settings, cacheEntry.settings);
+
+        fileEntries.push_back(fileEntry);
     }
-#undef FWRITE
-#undef FWRITE_STR
 
+    // header
+    memcpy(fileHeader.Magic, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+    fileHeader.Version    = CACHE_FILE_VERSION;
+    fileHeader.EntryCount = fileEntries.size();
+    fileHeader.StringTableOffset = sizeof(l_CacheFileHeader) + (fileEntries.size() * sizeof(l_CacheFileEntry));
+    fileHeader.StringTableSize   = stringTable.size();
+
+    // write to a temporary file first
+    // so we never leave a partially
+    // written cache file behind
+    fileName     = get_cache_file_name();
+    tempFileName = fileName;
+    tempFileName += ".tmp";
+
+    outputStream.open(tempFileName, std::ios::binary);
+    if (!outputStream.good())
+    {
+        return false;
+    }
+
+    outputStream.write((char*)&fileHeader, sizeof(fileHeader));
+    outputStream.write((char*)fileEntries.data(), fileEntries.size() * sizeof(l_CacheFileEntry));
+    outputStream.write(stringTable.data(), stringTable.size());
     outputStream.close();
+    if (outputStream.fail())
+    {
+        std::filesystem::remove(tempFileName, errorCode);
+        return false;
+    }
+
+    std::filesystem::rename(tempFileName, fileName, errorCode);
+    if (errorCode)
+    {
+        std::filesystem::remove(tempFileName, errorCode);
+        return false;
+    }
+
+    l_CacheEntriesChanged = false;
     return true;
 }
 
-CORE_EXPORT bool CoreGetCachedRomHeaderAndSettings(std::filesystem::path file, CoreRomType* type, CoreRomHeader* header, CoreRomSettings* defaultSettings, CoreRomSettings* settings)
+CORE_EXPORT bool CoreHasCachedRomHeaderAndSettings(std::filesystem::path file, bool& valid, CoreRomType* type, CoreRomHeader* header, CoreRomSettings* defaultSettings, CoreRomSettings* settings)
 {
-    bool ret = false;
-    auto iter = get_cache_entry_iter(file);
+    // retrieve the file time before locking,
+    // this allows multiple threads to query
+    // the file system at the same time
+    CoreFileTime fileTime = CoreGetFileTime(file);
+
+    const std::lock_guard<std::mutex> guard(l_CacheMutex);
+
+    auto iter = get_cache_entry_iter(file, fileTime);
     if (iter == l_CacheEntries.end())
     {
-        CoreRomType romType;
-        CoreRomHeader romHeader;
-        CoreRomSettings romSettings;
-        CoreRomSettings romDefaultSettings;
-
-        // when we haven't found a cached entry,
-        // we're gonna attempt to retrieve the
-        // rom header and settings and add it
-        // to the cache
-        ret = CoreOpenRom(file) &&
-                CoreGetRomType(romType) &&
-                CoreGetCurrentRomHeader(romHeader) &&
-                CoreGetCurrentRomSettings(romSettings) &&
-                CoreGetCurrentDefaultRomSettings(romDefaultSettings);
-        // always close ROM
-        if (CoreHasRomOpen() && !CoreCloseRom())
+        return false;
+    }
+
+    valid = (*iter).valid;
+    if (valid)
+    {
+        copy_cache_entry((*iter), type, header, defaultSettings, settings);
+    }
+    return true;
+}
+
+CORE_EXPORT bool CoreGetCachedRomHeaderAndSettingsInDirectory(std::filesystem::path directory, bool recursive, std::vector<CoreCachedRomHeaderAndSettings>& entries)
+{
+    // remove trailing separator
+    if (!directory.has_filename())
+    {
+        directory = directory.parent_path();
+    }
+
+    const std::lock_guard<std::mutex> guard(l_CacheMutex);
+
+    entries.clear();
+
+    for (const l_CacheEntry& cacheEntry : l_CacheEntries)
+    {
+        if (!cacheEntry.valid)
         {
-            ret = false;
+            continue;
         }
-        // add file to cache
-        if (ret)
+
+        if (recursive)
         {
-            if (type != nullptr)
+            auto iters = std::mismatch(directory.begin(), directory.end(),
+                                       cacheEntry.fileName.begin(), cacheEntry.fileName.end());
+            if (iters.first != directory.end() ||
+                iters.second == cacheEntry.fileName.end())
             {
-                *type = romType;
+                continue;
             }
-            if (header != nullptr)
-            {
-                *header = romHeader;
-            }
-            if (settings != nullptr)
-            {
-                *settings = romSettings;
-            }
-            if (defaultSettings != nullptr)
-            {
-                *defaultSettings = romDefaultSettings;
-            }
-
-            add_cache_entry(file, romType, romHeader, romSettings, romDefaultSettings);
-            return true;
         }
-        else
+        else if (cacheEntry.fileName.parent_path() != directory)
         {
-            add_invalid_cache_entry(file);
-            return false;
+            continue;
         }
-    }
 
-    if (!(*iter).valid)
-    {
-        return false;
+        entries.push_back(
+        {
+            cacheEntry.fileName,
+            cacheEntry.type,
+            cacheEntry.header,
+            cacheEntry.defaultSettings,
+            cacheEntry.settings
+        });
     }
 
-    if (type != nullptr)
+    return true;
+}
+
+CORE_EXPORT bool CoreAddCachedRomHeaderAndSettings(std::filesystem::path file, bool valid, CoreRomType type, CoreRomHeader header, CoreRomSettings defaultSettings, CoreRomSettings settings)
+{
+    CoreFileTime fileTime = CoreGetFileTime(file);
+
+    const std::lock_guard<std::mutex> guard(l_CacheMutex);
+
+    if (valid)
     {
-        *type = (*iter).type;
+        add_cache_entry(file, fileTime, type, header, defaultSettings, settings);
     }
-    if (header != nullptr)
+    else
     {
-        *header = (*iter).header;
+        add_invalid_cache_entry(file, fileTime);
     }
-    if (settings != nullptr)
+    return true;
+}
+
+CORE_EXPORT bool CoreGetCachedRomHeaderAndSettings(std::filesystem::path file, CoreRomType* type, CoreRomHeader* header, CoreRomSettings* defaultSettings, CoreRomSettings* settings)
+{
+    l_CacheEntry romEntry = {};
+    bool valid;
+
+    if (CoreHasCachedRomHeaderAndSettings(file, valid, type, header, defaultSettings, settings))
     {
-        *settings = (*iter).settings;
+        return valid;
     }
-    if (defaultSettings != nullptr)
+
+    // when we haven't found a cached entry,
+    // we're gonna attempt to retrieve the
+    // rom header and settings and add it
+    // to the cache
+    valid = CoreGetRomHeaderAndSettings(file, &romEntry.type, &romEntry.header, &romEntry.defaultSettings, &romEntry.settings);
+    CoreAddCachedRomHeaderAndSettings(file, valid, romEntry.type, romEntry.header, romEntry.defaultSettings, romEntry.settings);
+
+    if (valid)
     {
-        *defaultSettings = (*iter).defaultSettings;
+        copy_cache_entry(romEntry, type, header, defaultSettings, settings);
     }
-    return true;
+
+    return valid;
 }
 
 CORE_EXPORT bool CoreUpdateCachedRomHeaderAndSettings(std::filesystem::path file, CoreRomType type, CoreRomHeader header, CoreRomSettings defaultSettings, CoreRomSettings settings)
 {
-    l_CacheEntry cachedEntry;
+    const std::lock_guard<std::mutex> guard(l_CacheMutex);
 
     // try to find existing entry with same filename,
     // when not found, do nothing
-    auto iter = get_cache_entry_iter(file, false);
+    auto iter = get_cache_entry_iter(file);
     if (iter == l_CacheEntries.end())
     {
         return true;
     }
 
-    cachedEntry = (*iter);
-
     // check if the cached entry needs to be updated,
     // if it does, then update the entry
-    if (cachedEntry.type != type ||
-        cachedEntry.header != header ||
-        cachedEntry.defaultSettings != defaultSettings ||
-        cachedEntry.settings != settings)
+    if (!(*iter).valid ||
+        (*iter).type != type ||
+        (*iter).header != header ||
+        (*iter).defaultSettings != defaultSettings ||
+        (*iter).settings != settings)
     {
         (*iter).type            = type;
         (*iter).header          = header;
@@ -489,10 +733,12 @@ CORE_EXPORT bool CoreUpdateCachedRomHeaderAndSettings(std::filesystem::path file
 
     // try to find existing entry with same filename,
     // when not found, do nothing
-    auto iter = get_cache_entry_iter(file, false);
-    if (iter == l_CacheEntries.end())
     {
-        return true;
+        const std::lock_guard<std::mutex> guard(l_CacheMutex);
+        if (get_cache_entry_iter(file) == l_CacheEntries.end())
+        {
+            return true;
+        }
     }
 
     // attempt to retrieve required information
@@ -509,7 +755,10 @@ CORE_EXPORT bool CoreUpdateCachedRomHeaderAndSettings(std::filesystem::path file
 
 CORE_EXPORT bool CoreClearRomHeaderAndSettingsCache(void)
 {
+    const std::lock_guard<std::mutex> guard(l_CacheMutex);
+
     l_CacheEntries.clear();
+    l_CacheEntriesIndex.clear();
     l_CacheEntriesChanged = true;
     return true;
 }
@@ -11,11 +11,21 @@
 #define CORE_CACHEDROMHEADERANDSETTINGS_HPP
 
 #include <filesystem>
+#include <vector>
 
 #include "Rom.hpp"
 #include "RomHeader.hpp"
 #include "RomSettings.hpp"
 
+struct CoreCachedRomHeaderAndSettings
+{
+    std::filesystem::path File;
+    CoreRomType     Type;
+    CoreRomHeader   Header;
+    CoreRomSettings DefaultSettings;
+    CoreRomSettings Settings;
+};
+
 #ifdef CORE_INTERNAL
 // attempts to read rom header & settings cache
 void CoreReadRomHeaderAndSettingsCache(void);
@@ -25,6 +35,18 @@ void CoreReadRomHeaderAndSettingsCache(void);
 bool CoreSaveRomHeaderAndSettingsCache(void);
 #endif // CORE_INTERNAL
 
+// returns whether a cached entry for given filename exists,
+// valid is set to whether the cached entry is a valid ROM
+bool CoreHasCachedRomHeaderAndSettings(std::filesystem::path file, bool& valid, CoreRomType* type, CoreRomHeader* header, CoreRomSettings* defaultSettings, CoreRomSettings* settings);
+
+// retrieves all valid cached entries for files in given directory,
+// it doesn't check whether the files still exist or have been changed
+bool CoreGetCachedRomHeaderAndSettingsInDirectory(std::filesystem::path directory, bool recursive, std::vector<CoreCachedRomHeaderAndSettings>& entries);
+
+// returns whether adding the rom header & settings for given filename
+// to the cache succeeds, when valid is false, an invalid entry is added
+bool CoreAddCachedRomHeaderAndSettings(std::filesystem::path file, bool valid, CoreRomType type, CoreRomHeader header, CoreRomSettings defaultSettings, CoreRomSettings settings);
+
 // returns whether retrieving the rom header & settings
 // for given filename succeeds, it also attempts to add
 // an entry if there's no cached entry found
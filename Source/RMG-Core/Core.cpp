@@ -178,5 +178,7 @@ CORE_EXPORT void CoreShutdown(void)
     m64p::Core.Unhook();
     m64p::Config.Unhook();
 
+    CoreSettingsClearCache();
+
     CoreCloseLibrary(l_CoreLibHandle);
 }
@@ -16,6 +16,7 @@
 #include "Library.hpp"
 #include "Netplay.hpp"
 #include "Plugins.hpp"
+#include "Rewind.hpp"
 #include "Cheats.hpp"
 #include "Error.hpp"
 #include "File.hpp"
@@ -231,11 +232,25 @@ CORE_EXPORT bool CoreStartEmulation(std::filesystem::path n64rom, std::filesyste
     // apply pif rom settings
     apply_pif_rom_settings();
 
+    // initialize rewind buffer when enabled,
+    // rewinding isn't supported with netplay
+    if (!netplay && CoreSettingsGetBoolValue(SettingsID::Core_Rewind_Enabled))
+    {
+        CoreRewindInit(CoreSettingsGetIntValue(SettingsID::Core_Rewind_BufferSize),
+                       CoreSettingsGetIntValue(SettingsID::Core_Rewind_Interval));
+    }
+
 #ifdef NETPLAY
     if (netplay)
     {
         netplay_ret = CoreInitNetplay(address, port, player);
-        if (!netplay_ret)
+        if (netplay_ret)
+        {
+            // rollback is optional, so a failure
+            // falls back to the delay based netplay
+            CoreSetNetplayRollback(CoreSettingsGetIntValue(SettingsID::Netplay_RollbackFrames));
+        }
+        else
         {
             m64p_ret = M64ERR_SYSTEM_FAIL;
         }
@@ -261,6 +276,11 @@ CORE_EXPORT bool CoreStartEmulation(std::filesystem::path n64rom, std::filesyste
     }
 #endif // NETPLAY
 
+    if (CoreRewindIsInitialized())
+    {
+        CoreRewindShutdown();
+    }
+
     CoreClearCheats();
     CoreDetachPlugins();
     CoreCloseRom();
@@ -11,11 +11,14 @@
 
 #include "Library.hpp"
 
+#include <mutex>
+
 //
 // Local Variables
 //
 
 static std::string l_ErrorMessage;
+static std::mutex  l_ErrorMutex;
 
 //
 // Exported Functions
@@ -23,10 +26,12 @@ static std::string l_ErrorMessage;
 
 void CoreSetError(std::string error)
 {
+    const std::lock_guard<std::mutex> guard(l_ErrorMutex);
     l_ErrorMessage = error;
 }
 
 CORE_EXPORT std::string CoreGetError(void)
 {
+    const std::lock_guard<std::mutex> guard(l_ErrorMutex);
     return l_ErrorMessage;
 }
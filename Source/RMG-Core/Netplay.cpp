@@ -113,4 +113,56 @@ CORE_EXPORT bool CoreShutdownNetplay(void)
 #else
     return false;
 #endif // NETPLAY
-}
\ No newline at end of file
+}
+
+CORE_EXPORT bool CoreSetNetplayRollback(int frames)
+{
+#ifdef NETPLAY
+    std::string error;
+    m64p_error ret;
+
+    ret = m64p::Core.DoCommand(M64CMD_NETPLAY_SET_ROLLBACK, frames, nullptr);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreSetNetplayRollback m64p::Core.DoCommand(M64CMD_NETPLAY_SET_ROLLBACK) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif // NETPLAY
+}
+
+CORE_EXPORT bool CoreGetNetplayStats(CoreNetplayStats& stats)
+{
+#ifdef NETPLAY
+    std::string error;
+    m64p_error ret;
+    m64p_netplay_stats m64p_stats;
+
+    ret = m64p::Core.DoCommand(M64CMD_NETPLAY_GET_STATS, 0, &m64p_stats);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreGetNetplayStats m64p::Core.DoCommand(M64CMD_NETPLAY_GET_STATS) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+        return false;
+    }
+
+    stats.Rollbacks      = m64p_stats.rollbacks;
+    stats.ResimulatedVIs = m64p_stats.resimulated_vis;
+    stats.LastDepth      = m64p_stats.last_depth;
+    stats.MaxDepth       = m64p_stats.max_depth;
+    stats.Stalls         = m64p_stats.stalls;
+    stats.StallTime      = m64p_stats.stall_time;
+    stats.VIs            = m64p_stats.vis;
+    stats.FastForwardVIs = m64p_stats.fast_forward_vis;
+    stats.Desyncs        = m64p_stats.desyncs;
+    return true;
+#else
+    return false;
+#endif // NETPLAY
+}
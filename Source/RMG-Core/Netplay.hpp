@@ -12,6 +12,19 @@
 
 #include <string>
 
+struct CoreNetplayStats
+{
+    unsigned int Rollbacks       = 0;
+    unsigned int ResimulatedVIs  = 0;
+    unsigned int LastDepth       = 0;
+    unsigned int MaxDepth        = 0;
+    unsigned int Stalls          = 0;
+    unsigned int StallTime       = 0; // in milliseconds
+    unsigned int VIs             = 0;
+    unsigned int FastForwardVIs  = 0;
+    unsigned int Desyncs         = 0;
+};
+
 // attempts to initialize netplay
 bool CoreInitNetplay(std::string address, int port, int player);
 
@@ -21,4 +34,12 @@ bool CoreHasInitNetplay(void);
 // attempts to shutdown netplay
 bool CoreShutdownNetplay(void);
 
+// sets the amount of frames netplay may predict
+// the input of other players for, 0 disables rollback,
+// it must be called before the emulation starts
+bool CoreSetNetplayRollback(int frames);
+
+// retrieves the netplay statistics
+bool CoreGetNetplayStats(CoreNetplayStats& stats);
+
 #endif // CORE_NETPLAY_HPP
\ No newline at end of file
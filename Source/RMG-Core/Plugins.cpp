@@ -509,6 +509,15 @@ CORE_EXPORT bool CoreArePluginsReady(void)
             continue;
         }
 
+        // the core uses its dummy plugin when
+        // no plugin is used, which the RSP
+        // can't do without
+        if ((CorePluginType)(i + 1) != CorePluginType::Rsp &&
+            l_PluginFiles[i] == "(None)")
+        {
+            continue;
+        }
+
         if (!l_Plugins[i].IsHooked())
         {
             error = "CoreArePluginsReady Failed: ";
@@ -0,0 +1,98 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define CORE_INTERNAL
+#include "Rewind.hpp"
+#include "Library.hpp"
+#include "Error.hpp"
+
+#include "m64p/Api.hpp"
+
+#include <string>
+
+//
+// Local Variables
+//
+
+static bool l_RewindInitialized = false;
+
+//
+// Exported Functions
+//
+
+CORE_EXPORT bool CoreRewindInit(int size, int interval)
+{
+    std::string error;
+    m64p_error ret;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_REWIND_INIT, size, &interval);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreRewindInit: m64p::Core.DoCommand(M64CMD_REWIND_INIT) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    l_RewindInitialized = (ret == M64ERR_SUCCESS);
+    return l_RewindInitialized;
+}
+
+CORE_EXPORT bool CoreRewindIsInitialized(void)
+{
+    return l_RewindInitialized;
+}
+
+CORE_EXPORT bool CoreRewindStepBack(void)
+{
+    std::string error;
+    m64p_error ret;
+
+    if (!m64p::Core.IsHooked() || !l_RewindInitialized)
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_REWIND_STEP_BACK, 0, nullptr);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreRewindStepBack: m64p::Core.DoCommand(M64CMD_REWIND_STEP_BACK) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
+
+CORE_EXPORT bool CoreRewindShutdown(void)
+{
+    std::string error;
+    m64p_error ret;
+
+    if (!m64p::Core.IsHooked() || !l_RewindInitialized)
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_REWIND_CLOSE, 0, nullptr);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreRewindShutdown: m64p::Core.DoCommand(M64CMD_REWIND_CLOSE) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+        return false;
+    }
+
+    l_RewindInitialized = false;
+    return true;
+}
@@ -0,0 +1,30 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_REWIND_HPP
+#define CORE_REWIND_HPP
+
+// attempts to initialize the rewind buffer,
+// size is the size of the buffer in MiB and
+// interval the amount of VIs between snapshots,
+// it can only be initialized when emulation
+// isn't running
+bool CoreRewindInit(int size, int interval);
+
+// returns whether the rewind buffer has been initialized
+bool CoreRewindIsInitialized(void);
+
+// attempts to step back to the previous snapshot,
+// the snapshot is restored on the emulation thread
+bool CoreRewindStepBack(void);
+
+// frees the rewind buffer
+bool CoreRewindShutdown(void);
+
+#endif // CORE_REWIND_HPP
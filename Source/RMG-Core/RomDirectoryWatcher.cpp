@@ -0,0 +1,340 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define CORE_INTERNAL
+#include "RomDirectoryWatcher.hpp"
+#include "Library.hpp"
+#include "String.hpp"
+#include "Error.hpp"
+
+#ifndef _WIN32
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <poll.h>
+#endif // _WIN32
+
+//
+// Local Defines
+//
+
+#define INOTIFY_READ_SIZE 65536
+#define INOTIFY_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | \
+                            IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+//
+// Local Variables
+//
+
+static bool                  l_WatcherStarted = false;
+static std::filesystem::path l_WatcherDirectory;
+static bool                  l_WatcherRecursive = false;
+
+#ifndef _WIN32
+static int l_InotifyFd = -1;
+static std::unordered_map<int, std::filesystem::path> l_WatchDescriptors;
+#endif // _WIN32
+
+//
+// Internal Functions
+//
+
+#ifndef _WIN32
+static bool is_rom_file(const std::filesystem::path& file)
+{
+    std::string fileExtension;
+
+    fileExtension = file.has_extension() ? file.extension().string() : "";
+    fileExtension = CoreLowerString(fileExtension);
+
+    return fileExtension == ".n64" ||
+           fileExtension == ".z64" ||
+           fileExtension == ".v64" ||
+           fileExtension == ".ndd" ||
+           fileExtension == ".d64" ||
+           fileExtension == ".zip" ||
+           fileExtension == ".7z";
+}
+
+static bool is_sub_path(const std::filesystem::path& directory, const std::filesystem::path& path)
+{
+    auto iters = std::mismatch(directory.begin(), directory.end(), path.begin(), path.end());
+    return iters.first == directory.end();
+}
+
+static bool add_watch(const std::filesystem::path& directory)
+{
+    int wd = inotify_add_watch(l_InotifyFd, directory.c_str(), INOTIFY_WATCH_MASK);
+    if (wd == -1)
+    {
+        return false;
+    }
+
+    l_WatchDescriptors[wd] = directory;
+    return true;
+}
+
+static void remove_watches(const std::filesystem::path& directory)
+{
+    for (auto iter = l_WatchDescriptors.begin(); iter != l_WatchDescriptors.end();)
+    {
+        if (is_sub_path(directory, iter->second))
+        {
+            inotify_rm_watch(l_InotifyFd, iter->first);
+            iter = l_WatchDescriptors.erase(iter);
+        }
+        else
+        {
+            iter++;
+        }
+    }
+}
+
+static void add_watches_recursive(const std::filesystem::path& directory, std::vector<CoreRomDirectoryEvent>* events)
+{
+    std::error_code errorCode;
+
+    if (!add_watch(directory))
+    {
+        return;
+    }
+
+    // add watches for all sub directories,
+    // when events is set, all ROM files
+    // inside of the directories are added
+    // as events, because they could've been
+    // created before the watch was added
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory,
+            std::filesystem::directory_options::skip_permission_denied, errorCode))
+    {
+        if (entry.is_directory(errorCode))
+        {
+            add_watch(entry.path());
+        }
+        else if (events != nullptr && is_rom_file(entry.path()))
+        {
+            events->push_back({ CoreRomDirectoryEventType::FileChanged, entry.path() });
+        }
+    }
+}
+
+static void handle_inotify_event(const struct inotify_event* event, std::vector<CoreRomDirectoryEvent>& events)
+{
+    if (event->mask & IN_Q_OVERFLOW)
+    {
+        events.push_back({ CoreRomDirectoryEventType::Rescan, l_WatcherDirectory });
+        return;
+    }
+
+    auto iter = l_WatchDescriptors.find(event->wd);
+    if (iter == l_WatchDescriptors.end())
+    {
+        return;
+    }
+
+    // the kernel has removed the watch
+    if (event->mask & IN_IGNORED)
+    {
+        l_WatchDescriptors.erase(iter);
+        return;
+    }
+
+    // when the watched directory itself is removed or moved,
+    // we can't keep track of it anymore
+    if ((event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) &&
+        iter->second == l_WatcherDirectory)
+    {
+        events.push_back({ CoreRomDirectoryEventType::Rescan, l_WatcherDirectory });
+        return;
+    }
+
+    if (event->len == 0)
+    {
+        return;
+    }
+
+    std::filesystem::path path = iter->second / event->name;
+
+    if (event->mask & IN_ISDIR)
+    {
+        if (!l_WatcherRecursive)
+        {
+            return;
+        }
+
+        if (event->mask & (IN_CREATE | IN_MOVED_TO))
+        {
+            add_watches_recursive(path, &events);
+        }
+        else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+        {
+            remove_watches(path);
+            events.push_back({ CoreRomDirectoryEventType::DirectoryRemoved, path });
+        }
+        return;
+    }
+
+    if (!is_rom_file(path))
+    {
+        return;
+    }
+
+    // we only report files when they've been closed
+    // after writing, so we don't read partial files
+    if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+    {
+        events.push_back({ CoreRomDirectoryEventType::FileChanged, path });
+    }
+    else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+    {
+        events.push_back({ CoreRomDirectoryEventType::FileRemoved, path });
+    }
+}
+#endif // _WIN32
+
+//
+// Exported Functions
+//
+
+CORE_EXPORT bool CoreStartRomDirectoryWatcher(std::filesystem::path directory, bool recursive)
+{
+    std::string error;
+
+    if (l_WatcherStarted)
+    {
+        CoreStopRomDirectoryWatcher();
+    }
+
+#ifdef _WIN32
+    error = "CoreStartRomDirectoryWatcher Failed: watching directories isn't supported on this platform!";
+    CoreSetError(error);
+    return false;
+#else // Unix
+    l_InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (l_InotifyFd == -1)
+    {
+        error = "CoreStartRomDirectoryWatcher Failed: inotify_init1 Failed: ";
+        error += strerror(errno);
+        CoreSetError(error);
+        return false;
+    }
+
+    l_WatcherDirectory = directory;
+    l_WatcherRecursive = recursive;
+
+    if (recursive)
+    {
+        add_watches_recursive(directory, nullptr);
+    }
+    else
+    {
+        add_watch(directory);
+    }
+
+    if (l_WatchDescriptors.empty())
+    {
+        error = "CoreStartRomDirectoryWatcher Failed: failed to watch directory: ";
+        error += strerror(errno);
+        CoreSetError(error);
+        close(l_InotifyFd);
+        l_InotifyFd = -1;
+        return false;
+    }
+
+    l_WatcherStarted = true;
+    return true;
+#endif // _WIN32
+}
+
+CORE_EXPORT bool CoreIsRomDirectoryWatcherStarted(void)
+{
+    return l_WatcherStarted;
+}
+
+CORE_EXPORT bool CoreWaitForRomDirectoryEvents(std::vector<CoreRomDirectoryEvent>& events, int timeout)
+{
+    std::string error;
+
+    events.clear();
+
+    if (!l_WatcherStarted)
+    {
+        error = "CoreWaitForRomDirectoryEvents Failed: watcher hasn't been started!";
+        CoreSetError(error);
+        return false;
+    }
+
+#ifdef _WIN32
+    return false;
+#else // Unix
+    struct pollfd pollFd = { l_InotifyFd, POLLIN, 0 };
+    int ret = poll(&pollFd, 1, timeout);
+    if (ret == -1 && errno != EINTR)
+    {
+        error = "CoreWaitForRomDirectoryEvents Failed: poll Failed: ";
+        error += strerror(errno);
+        CoreSetError(error);
+        return false;
+    }
+    else if (ret <= 0)
+    { // timeout
+        return true;
+    }
+
+    alignas(struct inotify_event) char buffer[INOTIFY_READ_SIZE];
+
+    while (true)
+    {
+        ssize_t size = read(l_InotifyFd, buffer, sizeof(buffer));
+        if (size == -1)
+        {
+            if (errno == EAGAIN)
+            {
+                break;
+            }
+
+            error = "CoreWaitForRomDirectoryEvents Failed: read Failed: ";
+            error += strerror(errno);
+            CoreSetError(error);
+            return false;
+        }
+
+        for (char* ptr = buffer; ptr < (buffer + size);)
+        {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+            handle_inotify_event(event, events);
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    return true;
+#endif // _WIN32
+}
+
+CORE_EXPORT bool CoreStopRomDirectoryWatcher(void)
+{
+    if (!l_WatcherStarted)
+    {
+        return true;
+    }
+
+#ifndef _WIN32
+    close(l_InotifyFd);
+    l_InotifyFd = -1;
+    l_WatchDescriptors.clear();
+#endif // _WIN32
+
+    l_WatcherDirectory.clear();
+    l_WatcherStarted = false;
+    return true;
+}
@@ -0,0 +1,52 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_ROMDIRECTORYWATCHER_HPP
+#define CORE_ROMDIRECTORYWATCHER_HPP
+
+#include <filesystem>
+#include <vector>
+
+enum class CoreRomDirectoryEventType
+{
+    // ROM file was added or has been changed
+    FileChanged = 0,
+    // ROM file was removed
+    FileRemoved,
+    // directory was removed, including all
+    // the ROM files in the directory
+    DirectoryRemoved,
+    // events were lost, the whole
+    // directory needs to be searched again
+    Rescan
+};
+
+struct CoreRomDirectoryEvent
+{
+    CoreRomDirectoryEventType Type;
+    std::filesystem::path     Path;
+};
+
+// attempts to start watching the given directory for
+// changes to ROM files, it can only watch one directory
+// at a time and shouldn't be used by multiple threads
+bool CoreStartRomDirectoryWatcher(std::filesystem::path directory, bool recursive);
+
+// returns whether the ROM directory watcher has been started
+bool CoreIsRomDirectoryWatcherStarted(void);
+
+// waits at most timeout milliseconds for changes in the
+// watched directory, returns false when the watcher
+// has failed or hasn't been started
+bool CoreWaitForRomDirectoryEvents(std::vector<CoreRomDirectoryEvent>& events, int timeout);
+
+// stops watching the ROM directory
+bool CoreStopRomDirectoryWatcher(void);
+
+#endif // CORE_ROMDIRECTORYWATCHER_HPP
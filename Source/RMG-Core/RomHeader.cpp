@@ -20,11 +20,13 @@
 #include "Library.hpp"
 #include "Error.hpp"
 
+#include <cstring>
+
 //
 // Local Functions
 //
 
-static std::string get_name_from_headername(uint8_t name[20])
+static std::string get_name_from_headername(const uint8_t name[20])
 {
     std::string safeName;
     size_t count = 0;
@@ -40,11 +42,11 @@ static std::string get_name_from_headername(uint8_t name[20])
         }
     }
 
-    safeName = std::string(reinterpret_cast<char*>(name), count);
+    safeName = std::string(reinterpret_cast<const char*>(name), count);
     return CoreConvertStringEncoding(safeName, CoreStringEncoding::Shift_JIS);
 }
 
-static std::string get_gameid_from_header(m64p_rom_header header)
+static std::string get_gameid_from_header(const m64p_rom_header& header)
 {
     std::string gameID;
 
@@ -164,10 +166,30 @@ static CoreSystemType get_systemtype_from_countrycode(uint8_t countryCode)
     return systemType;
 }
 
+static void convert_m64p_header(const m64p_rom_header& m64p_header, CoreRomHeader& header)
+{
+    header.CRC1        = ntohl(m64p_header.CRC1);
+    header.CRC2        = ntohl(m64p_header.CRC2);
+    header.CountryCode = m64p_header.Country_code;
+    header.Name        = get_name_from_headername(m64p_header.Name);
+    header.GameID      = get_gameid_from_header(m64p_header);
+    header.Region      = get_region_from_countrycode(static_cast<char>(header.CountryCode));
+    header.SystemType  = get_systemtype_from_countrycode(header.CountryCode);
+}
+
 //
 // Exported Functions
 //
 
+void CoreConvertRomHeader(const uint8_t* data, CoreRomHeader& header)
+{
+    m64p_rom_header m64p_header;
+
+    memcpy(&m64p_header, data, sizeof(m64p_header));
+
+    convert_m64p_header(m64p_header, header);
+}
+
 CORE_EXPORT bool CoreGetCurrentRomHeader(CoreRomHeader& header)
 {
     std::string error;
@@ -188,13 +210,6 @@ CORE_EXPORT bool CoreGetCurrentRomHeader(CoreRomHeader& header)
         return false;
     }
 
-    header.CRC1        = ntohl(m64p_header.CRC1);
-    header.CRC2        = ntohl(m64p_header.CRC2);
-    header.CountryCode = m64p_header.Country_code;
-    header.Name        = get_name_from_headername(m64p_header.Name);
-    header.GameID      = get_gameid_from_header(m64p_header);
-    header.Region      = get_region_from_countrycode(static_cast<char>(header.CountryCode));
-    header.SystemType  = get_systemtype_from_countrycode(header.CountryCode);
-
+    convert_m64p_header(m64p_header, header);
     return true;
 }
@@ -45,4 +45,10 @@ struct CoreRomHeader
 // retrieves the currently opened ROM header
 bool CoreGetCurrentRomHeader(CoreRomHeader& header);
 
+#ifdef CORE_INTERNAL
+// converts the given 64 byte big-endian (.z64)
+// ROM header data to a CoreRomHeader
+void CoreConvertRomHeader(const uint8_t* data, CoreRomHeader& header);
+#endif // CORE_INTERNAL
+
 #endif // CORE_ROMHEADER_HPP
\ No newline at end of file
@@ -0,0 +1,372 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define CORE_INTERNAL
+#include "ConvertStringEncoding.hpp"
+#include "RomHeaderAndSettings.hpp"
+#include "m64p/Api.hpp"
+#include "Archive.hpp"
+#include "Library.hpp"
+#include "String.hpp"
+#include "Error.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#include <md5.h>
+
+//
+// Local Defines
+//
+
+#define ROM_HEADER_SIZE 64
+#define ROM_READ_SIZE   1048576 /* 1 MiB */
+
+//
+// Local Enums
+//
+
+enum class l_RomByteOrder
+{
+    BigEndian,    // .z64
+    ByteSwapped,  // .v64
+    LittleEndian  // .n64
+};
+
+//
+// Local Variables
+//
+
+static const uint8_t l_Z64Signature[4] = { 0x80, 0x37, 0x12, 0x40 };
+static const uint8_t l_V64Signature[4] = { 0x37, 0x80, 0x40, 0x12 };
+static const uint8_t l_N64Signature[4] = { 0x40, 0x12, 0x37, 0x80 };
+
+// disks still have to be opened by the core,
+// which can only have one ROM open at a time
+static std::mutex l_CoreRomMutex;
+
+//
+// Local Functions
+//
+
+static bool get_rom_byte_order(const uint8_t* data, uint64_t size, l_RomByteOrder& byteOrder)
+{
+    if (size < ROM_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    // matches is_valid_rom() in mupen64plus-core
+    if (memcmp(data, l_Z64Signature, sizeof(l_Z64Signature)) == 0)
+    {
+        byteOrder = l_RomByteOrder::BigEndian;
+        return true;
+    }
+    else if (memcmp(data, l_V64Signature, sizeof(l_V64Signature)) == 0 && (size % 2) == 0)
+    {
+        byteOrder = l_RomByteOrder::ByteSwapped;
+        return true;
+    }
+    else if (memcmp(data, l_N64Signature, sizeof(l_N64Signature)) == 0 && (size % 4) == 0)
+    {
+        byteOrder = l_RomByteOrder::LittleEndian;
+        return true;
+    }
+
+    return false;
+}
+
+static bool is_valid_rom_header(const std::vector<char>& buffer)
+{
+    std::string    error;
+    l_RomByteOrder byteOrder;
+
+    // the size of the file isn't known here,
+    // so only check the signature
+    if (buffer.size() < ROM_HEADER_SIZE ||
+        !get_rom_byte_order(reinterpret_cast<const uint8_t*>(buffer.data()), ROM_HEADER_SIZE, byteOrder))
+    {
+        error = "CoreGetRomHeaderAndSettings Failed: ";
+        error += "not a valid ROM image!";
+        CoreSetError(error);
+        return false;
+    }
+
+    return true;
+}
+
+static void swap_rom_data(uint8_t* data, size_t size, l_RomByteOrder byteOrder)
+{
+    if (byteOrder == l_RomByteOrder::ByteSwapped)
+    {
+        for (size_t i = 0; (i + 1) < size; i += 2)
+        {
+            std::swap(data[i], data[i + 1]);
+        }
+    }
+    else if (byteOrder == l_RomByteOrder::LittleEndian)
+    {
+        for (size_t i = 0; (i + 3) < size; i += 4)
+        {
+            std::swap(data[i], data[i + 3]);
+            std::swap(data[i + 1], data[i + 2]);
+        }
+    }
+}
+
+static bool lookup_rom_settings(const uint8_t* headerData, const md5_byte_t* digest, CoreRomHeader& header, CoreRomSettings& defaultSettings, CoreRomSettings& settings)
+{
+    std::string       error;
+    m64p_error        ret;
+    m64p_rom_settings m64p_settings;
+    m64p_rom_header   m64p_header;
+
+    memcpy(&m64p_header, headerData, sizeof(m64p_header));
+
+    ret = m64p::Core.LookupRomSettings(&m64p_settings, sizeof(m64p_settings), &m64p_header, digest);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreGetRomHeaderAndSettings m64p::Core.LookupRomSettings() Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+        return false;
+    }
+
+    CoreConvertRomHeader(headerData, header);
+
+    defaultSettings.GoodName = CoreConvertStringEncoding(m64p_settings.goodname, CoreStringEncoding::Shift_JIS);
+    defaultSettings.InternalName = header.Name;
+    defaultSettings.MD5 = std::string(m64p_settings.MD5);
+    defaultSettings.SaveType = m64p_settings.savetype;
+    defaultSettings.DisableExtraMem = m64p_settings.disableextramem;
+    defaultSettings.TransferPak = m64p_settings.transferpak;
+    defaultSettings.CountPerOp = m64p_settings.countperop;
+    defaultSettings.SiDMADuration = m64p_settings.sidmaduration;
+
+    // apply the settings overlay like
+    // CoreOpenRom() does, the settings
+    // API serializes the config access
+    if (!CoreGetRomSettingsOverlay(defaultSettings, settings))
+    {
+        settings = defaultSettings;
+    }
+    return true;
+}
+
+static bool get_header_and_settings_from_buffer(std::vector<char>& buffer, CoreRomHeader& header, CoreRomSettings& defaultSettings, CoreRomSettings& settings)
+{
+    std::string    error;
+    l_RomByteOrder byteOrder;
+    md5_state_t    md5State;
+    md5_byte_t     digest[16];
+    uint8_t*       data = reinterpret_cast<uint8_t*>(buffer.data());
+
+    if (!get_rom_byte_order(data, buffer.size(), byteOrder))
+    {
+        error = "CoreGetRomHeaderAndSettings Failed: ";
+        error += "not a valid ROM image!";
+        CoreSetError(error);
+        return false;
+    }
+
+    swap_rom_data(data, buffer.size(), byteOrder);
+
+    md5_init(&md5State);
+    md5_append(&md5State, data, buffer.size());
+    md5_finish(&md5State, digest);
+
+    return lookup_rom_settings(data, digest, header, defaultSettings, settings);
+}
+
+static bool get_header_and_settings_from_file(const std::filesystem::path& file, CoreRomHeader& header, CoreRomSettings& defaultSettings, CoreRomSettings& settings)
+{
+    std::string       error;
+    std::ifstream     fileStream;
+    std::error_code   errorCode;
+    std::vector<char> buffer(ROM_READ_SIZE);
+    uint8_t           headerData[ROM_HEADER_SIZE];
+    l_RomByteOrder    byteOrder;
+    md5_state_t       md5State;
+    md5_byte_t        digest[16];
+    uint64_t          fileSize;
+    uint64_t          bytesLeft;
+    uint8_t*          data = reinterpret_cast<uint8_t*>(buffer.data());
+
+    fileSize = std::filesystem::file_size(file, errorCode);
+    if (errorCode)
+    {
+        error = "CoreGetRomHeaderAndSettings Failed: ";
+        error += "failed to retrieve file size: ";
+        error += errorCode.message();
+        CoreSetError(error);
+        return false;
+    }
+
+    fileStream.open(file, std::ios::binary);
+    if (!fileStream.is_open())
+    {
+        error = "CoreGetRomHeaderAndSettings Failed: ";
+        error += "failed to open file: ";
+        error += strerror(errno);
+        error += " (";
+        error += std::to_string(errno);
+        error += ")";
+        CoreSetError(error);
+        return false;
+    }
+
+    // read the header first, so we can
+    // bail out early on invalid files
+    fileStream.read(reinterpret_cast<char*>(headerData), sizeof(headerData));
+    if (fileStream.gcount() != sizeof(headerData) ||
+        !get_rom_byte_order(headerData, fileSize, byteOrder))
+    {
+        error = "CoreGetRomHeaderAndSettings Failed: ";
+        error += "not a valid ROM image!";
+        CoreSetError(error);
+        return false;
+    }
+
+    swap_rom_data(headerData, sizeof(headerData), byteOrder);
+
+    md5_init(&md5State);
+    md5_append(&md5State, headerData, sizeof(headerData));
+
+    // stream the rest of the file through the MD5 hash,
+    // the read size is a multiple of 4 so the byte order
+    // can be swapped for each chunk separately
+    bytesLeft = fileSize - sizeof(headerData);
+    while (bytesLeft > 0)
+    {
+        size_t readSize = std::min(bytesLeft, static_cast<uint64_t>(ROM_READ_SIZE));
+
+        fileStream.read(buffer.data(), readSize);
+        if (fileStream.gcount() != static_cast<std::streamsize>(readSize))
+        {
+            error = "CoreGetRomHeaderAndSettings Failed: ";
+            error += "failed to read file!";
+            CoreSetError(error);
+            return false;
+        }
+
+        swap_rom_data(data, readSize, byteOrder);
+        md5_append(&md5State, data, readSize);
+        bytesLeft -= readSize;
+    }
+
+    md5_finish(&md5State, digest);
+
+    return lookup_rom_settings(headerData, digest, header, defaultSettings, settings);
+}
+
+static bool get_header_and_settings_from_core(const std::filesystem::path& file, CoreRomHeader& header, CoreRomSettings& defaultSettings, CoreRomSettings& settings)
+{
+    const std::lock_guard<std::mutex> guard(l_CoreRomMutex);
+
+    bool ret;
+
+    ret = CoreOpenRom(file) &&
+            CoreGetCurrentRomHeader(header) &&
+            CoreGetCurrentRomSettings(settings) &&
+            CoreGetCurrentDefaultRomSettings(defaultSettings);
+    // always close ROM
+    if (CoreHasRomOpen() && !CoreCloseRom())
+    {
+        ret = false;
+    }
+
+    return ret;
+}
+
+//
+// Exported Functions
+//
+
+CORE_EXPORT bool CoreGetRomHeaderAndSettings(std::filesystem::path file, CoreRomType* type, CoreRomHeader* header, CoreRomSettings* defaultSettings, CoreRomSettings* settings)
+{
+    std::string           fileExtension;
+    std::vector<char>     buffer;
+    std::filesystem::path extractedFile;
+    bool                  isDisk = false;
+    CoreRomHeader         romHeader;
+    CoreRomSettings       romDefaultSettings;
+    CoreRomSettings       romSettings;
+    bool                  ret;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    fileExtension = file.has_extension() ? file.extension().string() : "";
+    fileExtension = CoreLowerString(fileExtension);
+
+    if (fileExtension == ".zip" ||
+        fileExtension == ".7z")
+    {
+        // check the header before decompressing the whole file,
+        // zip files can be partially decompressed and 7zip
+        // blocks are kept in the block cache for the second read
+        if (!CoreReadArchiveFile(file, extractedFile, isDisk, buffer, true))
+        {
+            return false;
+        }
+
+        if (!isDisk && !is_valid_rom_header(buffer))
+        {
+            return false;
+        }
+
+        // disks are handled by the core
+        if (isDisk)
+        {
+            ret = get_header_and_settings_from_core(file, romHeader, romDefaultSettings, romSettings);
+        }
+        else
+        {
+            ret = CoreReadArchiveFile(file, extractedFile, isDisk, buffer) &&
+                    get_header_and_settings_from_buffer(buffer, romHeader, romDefaultSettings, romSettings);
+        }
+    }
+    else if (fileExtension == ".d64" ||
+             fileExtension == ".ndd")
+    {
+        isDisk = true;
+        ret = get_header_and_settings_from_core(file, romHeader, romDefaultSettings, romSettings);
+    }
+    else
+    {
+        ret = get_header_and_settings_from_file(file, romHeader, romDefaultSettings, romSettings);
+    }
+
+    if (!ret)
+    {
+        return false;
+    }
+
+    if (type != nullptr)
+    {
+        *type = isDisk ? CoreRomType::Disk : CoreRomType::Cartridge;
+    }
+    if (header != nullptr)
+    {
+        *header = romHeader;
+    }
+    if (defaultSettings != nullptr)
+    {
+        *defaultSettings = romDefaultSettings;
+    }
+    if (settings != nullptr)
+    {
+        *settings = romSettings;
+    }
+    return true;
+}
@@ -0,0 +1,24 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_ROMHEADERANDSETTINGS_HPP
+#define CORE_ROMHEADERANDSETTINGS_HPP
+
+#include <filesystem>
+
+#include "Rom.hpp"
+#include "RomHeader.hpp"
+#include "RomSettings.hpp"
+
+// returns whether retrieving the rom header & settings
+// for given filename succeeds without opening the ROM,
+// this function is thread-safe and doesn't use the cache
+bool CoreGetRomHeaderAndSettings(std::filesystem::path file, CoreRomType* type, CoreRomHeader* header, CoreRomSettings* defaultSettings, CoreRomSettings* settings);
+
+#endif // CORE_ROMHEADERANDSETTINGS_HPP
@@ -155,14 +155,9 @@ CORE_EXPORT bool CoreApplyRomSettings(CoreRomSettings settings)
     return ret == M64ERR_SUCCESS;
 }
 
-CORE_EXPORT bool CoreApplyRomSettingsOverlay(void)
+bool CoreGetRomSettingsOverlay(const CoreRomSettings& defaultSettings, CoreRomSettings& settings)
 {
-    CoreRomSettings settings;
-
-    if (!CoreGetCurrentDefaultRomSettings(settings))
-    {
-        return false;
-    }
+    settings = defaultSettings;
 
     std::string section;
     int format = CoreSettingsGetIntValue(SettingsID::Core_SaveFileNameFormat);
@@ -189,6 +184,23 @@ CORE_EXPORT bool CoreApplyRomSettingsOverlay(void)
     settings.TransferPak = CoreSettingsGetBoolValue(SettingsID::Game_TransferPak, section);
     settings.CountPerOp = CoreSettingsGetIntValue(SettingsID::Game_CountPerOp, section);
     settings.SiDMADuration = CoreSettingsGetIntValue(SettingsID::Game_SiDmaDuration, section);
+    return true;
+}
+
+CORE_EXPORT bool CoreApplyRomSettingsOverlay(void)
+{
+    CoreRomSettings defaultSettings;
+    CoreRomSettings settings;
+
+    if (!CoreGetCurrentDefaultRomSettings(defaultSettings))
+    {
+        return false;
+    }
+
+    if (!CoreGetRomSettingsOverlay(defaultSettings, settings))
+    {
+        return false;
+    }
 
     return CoreApplyRomSettings(settings);
 }
@@ -62,4 +62,10 @@ bool CoreApplyRomSettings(CoreRomSettings settings);
 // applies the ROM settings settings if they exist
 bool CoreApplyRomSettingsOverlay(void);
 
+#ifdef CORE_INTERNAL
+// retrieves the ROM settings overlay for the given
+// default ROM settings, returns false when there's no overlay
+bool CoreGetRomSettingsOverlay(const CoreRomSettings& defaultSettings, CoreRomSettings& settings);
+#endif // CORE_INTERNAL
+
 #endif // CORE_ROMSETTINGS_HPP
\ No newline at end of file
@@ -221,13 +221,19 @@ CORE_EXPORT bool CoreSaveState(void)
 {
     std::string error;
     m64p_error ret;
+    int type = 0;
 
     if (!m64p::Core.IsHooked())
     {
         return false;
     }
 
-    ret = m64p::Core.DoCommand(M64CMD_STATE_SAVE, 0, nullptr);
+    if (CoreSettingsGetBoolValue(SettingsID::Core_FastSaveStates))
+    {
+        type = static_cast<int>(CoreSaveStateType::Mupen64PlusFast);
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_STATE_SAVE, type, nullptr);
     if (ret != M64ERR_SUCCESS)
     {
         error = "CoreSaveState: m64p::Core.DoCommand(M64CMD_STATE_SAVE) Failed: ";
@@ -300,3 +306,68 @@ CORE_EXPORT bool CoreLoadSaveState(std::filesystem::path file)
 
     return ret == M64ERR_SUCCESS;
 }
+
+CORE_EXPORT bool CoreSaveStateToMemory(std::vector<uint8_t>& buffer)
+{
+    std::string error;
+    m64p_error ret;
+    int size = 0;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_STATE_GET_MEMORY_SIZE, 0, &size);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreSaveStateToMemory: m64p::Core.DoCommand(M64CMD_STATE_GET_MEMORY_SIZE) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+        return false;
+    }
+
+    // the core requires a zeroed buffer the first time,
+    // so clear the whole buffer when its size changes,
+    // a buffer which already holds a state of the same
+    // size is re-used without clearing or allocating it
+    if (buffer.size() != static_cast<size_t>(size))
+    {
+        buffer.assign(size, 0);
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_STATE_SAVE_MEMORY, size, buffer.data());
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreSaveStateToMemory: m64p::Core.DoCommand(M64CMD_STATE_SAVE_MEMORY) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
+
+CORE_EXPORT bool CoreLoadStateFromMemory(const std::vector<uint8_t>& buffer)
+{
+    std::string error;
+    m64p_error ret;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    // the core converts the state in place,
+    // so pass it a copy to keep the buffer intact
+    std::vector<uint8_t> state = buffer;
+
+    ret = m64p::Core.DoCommand(M64CMD_STATE_LOAD_MEMORY, static_cast<int>(state.size()), state.data());
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreLoadStateFromMemory: m64p::Core.DoCommand(M64CMD_STATE_LOAD_MEMORY) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
@@ -14,11 +14,16 @@
 #include "RomSettings.hpp"
 
 #include <filesystem>
+#include <cstdint>
+#include <vector>
 
 enum class CoreSaveStateType
 {
-	Mupen64Plus = 1,
-	Project64   = 2
+	Mupen64Plus     = 1,
+	Project64       = 2,
+	// mupen64plus save state which uses
+	// a fast codec instead of gzip
+	Mupen64PlusFast = 4
 };
 
 // sets save state slot
@@ -44,7 +49,8 @@ bool CoreGetSaveStatePath(int slot, std::filesystem::path& path);
 bool CoreGetSaveStatePath(CoreRomHeader header, CoreRomSettings settings, int slot, std::filesystem::path& path);
 
 
-// saves state
+// saves state, uses the fast codec
+// when Core_FastSaveStates is enabled
 bool CoreSaveState(void);
 
 // saves state to file
@@ -56,4 +62,19 @@ bool CoreLoadSaveState(void);
 // loads saved state from file
 bool CoreLoadSaveState(std::filesystem::path file);
 
+// saves state to the given buffer, the buffer is resized
+// and cleared when its size doesn't match, so it can be
+// re-used without allocating when it holds a previous state,
+// it waits until the emulation thread has saved the state
+// and fails when emulation isn't running or is paused,
+// or when it's called from the emulation thread
+bool CoreSaveStateToMemory(std::vector<uint8_t>& buffer);
+
+// loads state from a copy of the given buffer, so the
+// buffer isn't modified and can be loaded again, it waits
+// until the emulation thread has loaded the state
+// and fails when emulation isn't running or is paused,
+// or when it's called from the emulation thread
+bool CoreLoadStateFromMemory(const std::vector<uint8_t>& buffer);
+
 #endif // CORE_SAVESTATE_HPP
\ No newline at end of file
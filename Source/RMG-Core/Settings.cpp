@@ -19,9 +19,14 @@
 #include "m64p/Api.hpp"
 #include "m64p/api/m64p_types.h"
 
+#include <unordered_map>
 #include <algorithm>
 #include <sstream>
 #include <variant>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <map>
 
 //
 // Local Defines
@@ -43,14 +48,66 @@ struct l_Setting
     bool ForceUseSetAlways  = false;
 };
 
+struct l_CachedSetting
+{
+    // the upper 32 bits contain the cache generation
+    // and the lower 32 bits contain the value
+    std::atomic<uint64_t> IntValue   = 0;
+    std::atomic<uint64_t> BoolValue  = 0;
+    std::atomic<uint64_t> FloatValue = 0;
+
+    std::mutex  StringMutex;
+    uint32_t    StringGeneration = 0;
+    std::string StringValue;
+};
+
+struct l_PendingSetting
+{
+    SettingsID  Id;
+    std::string Section;
+    std::string Key;
+    m64p_type   Type;
+    int         IntValue   = 0;
+    float       FloatValue = 0.0f;
+    std::string StringValue;
+};
+
 //
 // Local Variables
 //
 
 static m64p_handle              l_sectionHandle = nullptr;
 static std::vector<std::string> l_sectionList;
+static std::mutex               l_sectionListMutex;
 static std::vector<std::string> l_keyList;
 
+// serializes every call into the config API,
+// neither the core nor l_sectionHandle and l_keyList
+// are thread-safe, l_sectionListMutex and l_transactionMutex
+// must be locked before this mutex when both are needed
+static std::mutex               l_configMutex;
+
+// cached values of settings in their default section,
+// a cached value is only valid when its generation
+// matches the current cache generation
+static l_CachedSetting       l_cachedSettings[static_cast<int>(SettingsID::Invalid)];
+static std::atomic<uint32_t> l_cacheGeneration = 1;
+
+// the change counter of each setting is set to the
+// global change counter when the setting has changed
+static std::atomic<uint32_t> l_changeCounter = 0;
+static std::atomic<uint32_t> l_settingChangeCounters[static_cast<int>(SettingsID::Invalid)];
+static std::unordered_multimap<std::string, SettingsID> l_settingKeys;
+static std::once_flag                                   l_settingKeysOnce;
+
+// settings which have been set during a transaction,
+// they're applied when the transaction is committed
+static std::mutex                                             l_transactionMutex;
+static std::atomic<int>                                       l_transactionDepth = 0;
+static bool                                                   l_transactionSave  = false;
+static std::vector<l_PendingSetting>                          l_pendingSettings;
+static std::map<std::pair<std::string, std::string>, size_t> l_pendingSettingIndices;
+
 //
 // Local Functions
 //
@@ -176,6 +233,9 @@ static l_Setting get_setting(SettingsID settingId)
     case SettingsID::Netplay_SelectedServer:
         setting = {SETTING_SECTION_NETPLAY, "SelectedServer", std::string("")};
         break;
+    case SettingsID::Netplay_RollbackFrames:
+        setting = {SETTING_SECTION_NETPLAY, "RollbackFrames", 0};
+        break;
 
     case SettingsID::Core_GFX_Plugin:
         setting = {SETTING_SECTION_CORE, "GFX_Plugin", 
@@ -335,6 +395,24 @@ static l_Setting get_setting(SettingsID settingId)
         setting = {SETTING_SECTION_GB, "Gameboy_P4_Save", std::string("")};
         break;
 
+    case SettingsID::Core_Rewind_Enabled:
+        setting = {SETTING_SECTION_CORE, "Rewind_Enabled", false};
+        break;
+    case SettingsID::Core_Rewind_BufferSize:
+        setting = {SETTING_SECTION_CORE, "Rewind_BufferSize", 64};
+        break;
+    case SettingsID::Core_Rewind_Interval:
+        setting = {SETTING_SECTION_CORE, "Rewind_Interval", 10};
+        break;
+
+    case SettingsID::Core_FastSaveStates:
+        setting = {SETTING_SECTION_CORE, "FastSaveStates", false};
+        break;
+
+    case SettingsID::Core_PaceToHostRefreshRate:
+        setting = {SETTING_SECTION_CORE, "PaceToHostRefreshRate", false};
+        break;
+
     case SettingsID::Game_OverrideSettings:
         setting = {"", "OverrideSettings", false};
         break;
@@ -461,6 +539,9 @@ static l_Setting get_setting(SettingsID settingId)
     case SettingsID::KeyBinding_LoadState:
         setting = {SETTING_SECTION_KEYBIND, "LoadState", std::string("F7")};
         break;
+    case SettingsID::KeyBinding_Rewind:
+        setting = {SETTING_SECTION_KEYBIND, "Rewind", std::string("F8")};
+        break;
     case SettingsID::KeyBinding_Load:
         setting = {SETTING_SECTION_KEYBIND, "Load", std::string("Ctrl+L")};
         break;
@@ -1395,8 +1476,19 @@ static bool config_section_exists(const std::string& section)
         return false;
     }
 
+    std::lock_guard<std::mutex> lock(l_sectionListMutex);
+
+    // sections are only removed through us,
+    // so when we've seen the section before,
+    // it still exists
+    if (std::find(l_sectionList.begin(), l_sectionList.end(), section) != l_sectionList.end())
+    {
+        return true;
+    }
+
     l_sectionList.clear();
 
+    std::lock_guard<std::mutex> configLock(l_configMutex);
     ret = m64p::Config.ListSections(nullptr, &config_listsections_callback);
     if (ret != M64ERR_SUCCESS)
     {
@@ -1409,6 +1501,146 @@ static bool config_section_exists(const std::string& section)
     return std::find(l_sectionList.begin(), l_sectionList.end(), section) != l_sectionList.end();
 }
 
+static void config_section_list_clear(void)
+{
+    std::lock_guard<std::mutex> lock(l_sectionListMutex);
+    l_sectionList.clear();
+}
+
+static void config_cache_invalidate(void)
+{
+    uint32_t generation = ++l_cacheGeneration;
+    // generation 0 is used for values
+    // which have never been cached
+    if (generation == 0)
+    {
+        ++l_cacheGeneration;
+    }
+}
+
+static bool config_cache_get(SettingsID settingId, uint32_t generation, m64p_type type, void* value)
+{
+    int index = static_cast<int>(settingId);
+    std::atomic<uint64_t>* cachedValue;
+    uint64_t data;
+    uint32_t bits;
+
+    if (index < 0 || index >= static_cast<int>(SettingsID::Invalid))
+    {
+        return false;
+    }
+
+    l_CachedSetting& cachedSetting = l_cachedSettings[index];
+
+    switch (type)
+    {
+    default:
+        return false;
+    case M64TYPE_INT:
+        cachedValue = &cachedSetting.IntValue;
+        break;
+    case M64TYPE_BOOL:
+        cachedValue = &cachedSetting.BoolValue;
+        break;
+    case M64TYPE_FLOAT:
+        cachedValue = &cachedSetting.FloatValue;
+        break;
+    case M64TYPE_STRING:
+    {
+        std::lock_guard<std::mutex> lock(cachedSetting.StringMutex);
+        if (cachedSetting.StringGeneration != generation)
+        {
+            return false;
+        }
+        *static_cast<std::string*>(value) = cachedSetting.StringValue;
+        return true;
+    }
+    }
+
+    data = cachedValue->load(std::memory_order_acquire);
+    if (static_cast<uint32_t>(data >> 32) != generation)
+    {
+        return false;
+    }
+
+    bits = static_cast<uint32_t>(data);
+    std::memcpy(value, &bits, sizeof(bits));
+    return true;
+}
+
+static void config_cache_set(SettingsID settingId, uint32_t generation, m64p_type type, const void* value)
+{
+    int index = static_cast<int>(settingId);
+    std::atomic<uint64_t>* cachedValue;
+    uint32_t bits;
+
+    if (index < 0 || index >= static_cast<int>(SettingsID::Invalid))
+    {
+        return;
+    }
+
+    l_CachedSetting& cachedSetting = l_cachedSettings[index];
+
+    switch (type)
+    {
+    default:
+        return;
+    case M64TYPE_INT:
+        cachedValue = &cachedSetting.IntValue;
+        break;
+    case M64TYPE_BOOL:
+        cachedValue = &cachedSetting.BoolValue;
+        break;
+    case M64TYPE_FLOAT:
+        cachedValue = &cachedSetting.FloatValue;
+        break;
+    case M64TYPE_STRING:
+    {
+        std::lock_guard<std::mutex> lock(cachedSetting.StringMutex);
+        cachedSetting.StringGeneration = generation;
+        cachedSetting.StringValue      = *static_cast<const std::string*>(value);
+        return;
+    }
+    }
+
+    // the value and generation are stored at once, so when
+    // the cache has been invalidated while the value was
+    // retrieved, the stored value is never used
+    std::memcpy(&bits, value, sizeof(bits));
+    cachedValue->store((static_cast<uint64_t>(generation) << 32) | bits, std::memory_order_release);
+}
+
+static void config_change_mark(SettingsID settingId)
+{
+    int index = static_cast<int>(settingId);
+
+    if (index < 0 || index >= static_cast<int>(SettingsID::Invalid))
+    {
+        return;
+    }
+
+    l_settingChangeCounters[index].store(++l_changeCounter);
+}
+
+static void config_change_mark_key(const std::string& key)
+{
+    // we don't know which setting has been changed,
+    // so mark every setting with the same key
+    std::call_once(l_settingKeysOnce, []()
+    {
+        for (int i = 0; i < static_cast<int>(SettingsID::Invalid); i++)
+        {
+            l_settingKeys.insert({ get_setting(static_cast<SettingsID>(i)).Key, static_cast<SettingsID>(i) });
+        }
+    });
+
+    auto range = l_settingKeys.equal_range(key);
+    for (auto iter = range.first; iter != range.second; iter++)
+    {
+        config_change_mark(iter->second);
+    }
+}
+
 static bool config_section_open(const std::string& section)
 {
     std::string error;
@@ -1442,7 +1674,7 @@ static void config_listkeys_callback(void*, const char* key, m64p_type)
     l_keyList.push_back(std::string(key));
 }
 
-static bool config_key_exists(const std::string& section, const std::string& key)
+static bool config_section_keys(const std::string& section, std::vector<std::string>& keys)
 {
     std::string error;
     m64p_error ret;
@@ -1452,6 +1684,8 @@ static bool config_key_exists(const std::string& section, const std::string& key
         return false;
     }
 
+    std::lock_guard<std::mutex> lock(l_configMutex);
+
     if (!config_section_open(section))
     {
         return false;
@@ -1462,39 +1696,220 @@ static bool config_key_exists(const std::string& section, const std::string& key
     ret = m64p::Config.ListParameters(l_sectionHandle, nullptr, &config_listkeys_callback);
     if (ret != M64ERR_SUCCESS)
     {
-        error = "config_key_exists m64p::Config.ListParameters Failed: ";
+        error = "config_section_keys m64p::Config.ListParameters Failed: ";
         error += m64p::Core.ErrorMessage(ret);
         CoreSetError(error);
         return false;
     }
 
-    return std::find(l_keyList.begin(), l_keyList.end(), key) != l_keyList.end();
+    keys = l_keyList;
+    return true;
 }
 
-static bool config_option_set(const std::string& section, const std::string& key, m64p_type type, void *value)
+static bool config_key_exists(const std::string& section, const std::string& key)
 {
-    std::string error;
-    m64p_error ret;
+    std::vector<std::string> keys;
 
-    if (!m64p::Config.IsHooked())
+    if (!config_section_keys(section, keys))
     {
         return false;
     }
 
+    return std::find(keys.begin(), keys.end(), key) != keys.end();
+}
+
+static void config_change_mark_section(const std::string& section)
+{
+    std::vector<std::string> keys;
+
+    if (!config_section_exists(section) ||
+        !config_section_keys(section, keys))
+    {
+        return;
+    }
+
+    for (const std::string& key : keys)
+    {
+        config_change_mark_key(key);
+    }
+}
+
+static bool config_option_apply(SettingsID settingId, const std::string& section, const std::string& key, m64p_type type, void *value)
+{
+    std::string error;
+    m64p_error ret;
+    m64p_type currentType;
+
+    std::lock_guard<std::mutex> lock(l_configMutex);
+
     if (!config_section_open(section))
     {
         return false;
     }
 
+    // don't change anything when the
+    // value is the same as the current one
+    ret = m64p::Config.GetParameterType(l_sectionHandle, key.c_str(), &currentType);
+    if (ret == M64ERR_SUCCESS && currentType == type)
+    {
+        bool equal = false;
+
+        switch (type)
+        {
+        default:
+            break;
+        case M64TYPE_INT:
+        case M64TYPE_BOOL:
+        {
+            int currentValue = 0;
+            ret = m64p::Config.GetParameter(l_sectionHandle, key.c_str(), type, &currentValue, sizeof(currentValue));
+            equal = type == M64TYPE_INT ? 
+                        (currentValue == *static_cast<int*>(value)) :
+                        ((currentValue != 0) == (*static_cast<int*>(value) != 0));
+        } break;
+        case M64TYPE_FLOAT:
+        {
+            float currentValue = 0.0f;
+            ret = m64p::Config.GetParameter(l_sectionHandle, key.c_str(), type, &currentValue, sizeof(currentValue));
+            equal = currentValue == *static_cast<float*>(value);
+        } break;
+        case M64TYPE_STRING:
+        {
+            char currentValue[STR_SIZE] = {0};
+            ret = m64p::Config.GetParameter(l_sectionHandle, key.c_str(), type, currentValue, sizeof(currentValue));
+            equal = std::strcmp(currentValue, static_cast<char*>(value)) == 0;
+        } break;
+        }
+
+        if (ret == M64ERR_SUCCESS && equal)
+        {
+            return true;
+        }
+    }
+
     ret = m64p::Config.SetParameter(l_sectionHandle, key.c_str(), type, value);
+    config_cache_invalidate();
     if (ret != M64ERR_SUCCESS)
     {
         error = "config_option_set m64p::Config.SetParameter Failed: ";
         error += m64p::Core.ErrorMessage(ret);
         CoreSetError(error);
+        return false;
     }
 
-    return ret == M64ERR_SUCCESS;
+    if (settingId != SettingsID::Invalid)
+    {
+        config_change_mark(settingId);
+    }
+    else
+    {
+        config_change_mark_key(key);
+    }
+
+    return true;
+}
+
+// applies the pending settings,
+// l_transactionMutex must be locked
+static bool config_transaction_flush(void)
+{
+    bool ret = true;
+
+    for (l_PendingSetting& pendingSetting : l_pendingSettings)
+    {
+        void* value;
+
+        switch (pendingSetting.Type)
+        {
+        default:
+        case M64TYPE_INT:
+        case M64TYPE_BOOL:
+            value = &pendingSetting.IntValue;
+            break;
+        case M64TYPE_FLOAT:
+            value = &pendingSetting.FloatValue;
+            break;
+        case M64TYPE_STRING:
+            value = const_cast<char*>(pendingSetting.StringValue.c_str());
+            break;
+        }
+
+        if (!config_option_apply(pendingSetting.Id, pendingSetting.Section, pendingSetting.Key, pendingSetting.Type, value))
+        {
+            ret = false;
+        }
+    }
+
+    l_pendingSettings.clear();
+    l_pendingSettingIndices.clear();
+    return ret;
+}
+
+// applies the pending settings before an operation
+// which doesn't know about the pending settings
+static bool config_transaction_barrier(void)
+{
+    if (l_transactionDepth == 0)
+    {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(l_transactionMutex);
+    return config_transaction_flush();
+}
+
+static bool config_option_set(SettingsID settingId, const std::string& section, const std::string& key, m64p_type type, void *value)
+{
+    std::string error;
+
+    if (!m64p::Config.IsHooked())
+    {
+        return false;
+    }
+
+    if (section.empty())
+    {
+        error = "config_option_set Failed: cannot set value in empty section!";
+        CoreSetError(error);
+        return false;
+    }
+
+    if (l_transactionDepth > 0)
+    {
+        std::lock_guard<std::mutex> lock(l_transactionMutex);
+        if (l_transactionDepth > 0)
+        {
+            auto iter = l_pendingSettingIndices.find({ section, key });
+            if (iter == l_pendingSettingIndices.end())
+            {
+                iter = l_pendingSettingIndices.insert({ { section, key }, l_pendingSettings.size() }).first;
+                l_pendingSettings.push_back({ settingId, section, key, type });
+            }
+
+            l_PendingSetting& pendingSetting = l_pendingSettings[iter->second];
+            pendingSetting.Id   = settingId;
+            pendingSetting.Type = type;
+            switch (type)
+            {
+            default:
+            case M64TYPE_INT:
+            case M64TYPE_BOOL:
+                pendingSetting.IntValue = *static_cast<int*>(value);
+                break;
+            case M64TYPE_FLOAT:
+                pendingSetting.FloatValue = *static_cast<float*>(value);
+                break;
+            case M64TYPE_STRING:
+                pendingSetting.StringValue = static_cast<char*>(value);
+                break;
+            }
+
+            config_cache_invalidate();
+            return true;
+        }
+    }
+
+    return config_option_apply(settingId, section, key, type, value);
 }
 
 static bool config_option_get(const std::string& section, const std::string& key, m64p_type type, void *value, int size)
@@ -1507,6 +1922,40 @@ static bool config_option_get(const std::string& section, const std::string& key
         return false;
     }
 
+    // settings which have been set during
+    // the transaction take precedence
+    if (l_transactionDepth > 0)
+    {
+        std::lock_guard<std::mutex> lock(l_transactionMutex);
+        auto iter = l_pendingSettingIndices.find({ section, key });
+        if (iter != l_pendingSettingIndices.end())
+        {
+            const l_PendingSetting& pendingSetting = l_pendingSettings[iter->second];
+            if (pendingSetting.Type == type)
+            {
+                switch (type)
+                {
+                default:
+                case M64TYPE_INT:
+                case M64TYPE_BOOL:
+                    std::memcpy(value, &pendingSetting.IntValue, sizeof(int));
+                    break;
+                case M64TYPE_FLOAT:
+                    std::memcpy(value, &pendingSetting.FloatValue, sizeof(float));
+                    break;
+                case M64TYPE_STRING:
+                    std::strncpy(static_cast<char*>(value), pendingSetting.StringValue.c_str(), size - 1);
+                    static_cast<char*>(value)[size - 1] = '\0';
+                    break;
+                }
+                return true;
+            }
+
+            // let the core convert the value
+            config_transaction_flush();
+        }
+    }
+
     if (!config_section_exists(section))
     {
         error = "config_option_get Failed: cannot open non-existent section!";
@@ -1514,6 +1963,8 @@ static bool config_option_get(const std::string& section, const std::string& key
         return false;
     }
 
+    std::lock_guard<std::mutex> lock(l_configMutex);
+
     if (!config_section_open(section))
     {
         return false;
@@ -1535,6 +1986,8 @@ static bool config_option_default_set(const std::string& section, const std::str
     std::string error;
     m64p_error ret;
 
+    std::lock_guard<std::mutex> lock(l_configMutex);
+
     if (!config_section_open(section))
     {
         return false;
@@ -1573,6 +2026,8 @@ static bool config_option_default_set(const std::string& section, const std::str
         } break;
     }
 
+    config_cache_invalidate();
+
     if (ret != M64ERR_SUCCESS)
     {
         CoreSetError(error);
@@ -1683,7 +2138,21 @@ CORE_EXPORT bool CoreSettingsSave(void)
         return false;
     }
 
-    ret = m64p::Config.SaveFile();
+    // defer saving until the transaction is committed
+    if (l_transactionDepth > 0)
+    {
+        std::lock_guard<std::mutex> lock(l_transactionMutex);
+        if (l_transactionDepth > 0)
+        {
+            l_transactionSave = true;
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(l_configMutex);
+        ret = m64p::Config.SaveFile();
+    }
     if (ret != M64ERR_SUCCESS)
     {
         error = "CoreSettingsSave m64p::Config.SaveFile Failed: ";
@@ -1813,7 +2282,7 @@ CORE_EXPORT bool CoreSettingsSetupDefaults(void)
                 if (setting.ForceUseSetAlways ||
                     (setting.ForceUseSetOnce && !hasForceUsedSetOnce))
                 {
-                    ret = config_option_set(setting.Section, setting.Key, M64TYPE_STRING, const_cast<char*>(value.c_str()));
+                    ret = config_option_set(static_cast<SettingsID>(i), setting.Section, setting.Key, M64TYPE_STRING, const_cast<char*>(value.c_str()));
                 }
                 else if (!setting.ForceUseSetOnce && !setting.ForceUseSetAlways)
                 {
@@ -1840,8 +2309,67 @@ CORE_EXPORT bool CoreSettingsSetupDefaults(void)
     return true;
 }
 
+CORE_EXPORT bool CoreSettingsBeginTransaction(void)
+{
+    std::lock_guard<std::mutex> lock(l_transactionMutex);
+    l_transactionDepth++;
+    return true;
+}
+
+CORE_EXPORT bool CoreSettingsCommitTransaction(void)
+{
+    std::string error;
+    bool ret;
+
+    {
+        std::lock_guard<std::mutex> lock(l_transactionMutex);
+
+        if (l_transactionDepth == 0)
+        {
+            error = "CoreSettingsCommitTransaction Failed: no transaction has been started!";
+            CoreSetError(error);
+            return false;
+        }
+
+        // only the outer transaction applies the settings
+        if (--l_transactionDepth > 0)
+        {
+            return true;
+        }
+
+        ret = config_transaction_flush();
+
+        if (!l_transactionSave)
+        {
+            return ret;
+        }
+
+        l_transactionSave = false;
+    }
+
+    return CoreSettingsSave() && ret;
+}
+
+CORE_EXPORT uint32_t CoreSettingsGetChangeCounter(void)
+{
+    return l_changeCounter;
+}
+
+CORE_EXPORT bool CoreSettingsHasChanged(SettingsID settingId, uint32_t changeCounter)
+{
+    int index = static_cast<int>(settingId);
+
+    if (index < 0 || index >= static_cast<int>(SettingsID::Invalid))
+    {
+        return false;
+    }
+
+    return l_settingChangeCounters[index] > changeCounter;
+}
+
 CORE_EXPORT bool CoreSettingsSectionExists(std::string section)
 {
+    config_transaction_barrier();
     return config_section_exists(section);
 }
 
@@ -1855,7 +2383,15 @@ CORE_EXPORT bool CoreSettingsRevertSection(std::string section)
         return false;
     }
 
-    ret = m64p::Config.RevertChanges(section.c_str());
+    config_transaction_barrier();
+    config_change_mark_section(section);
+
+    {
+        std::lock_guard<std::mutex> lock(l_configMutex);
+        ret = m64p::Config.RevertChanges(section.c_str());
+    }
+    config_section_list_clear();
+    config_cache_invalidate();
     if (ret != M64ERR_SUCCESS)
     {
         error = "CoreSettingsRevertSection m64p::Config.RevertChanges() Failed: ";
@@ -1876,6 +2412,8 @@ CORE_EXPORT bool CoreSettingsDeleteSection(std::string section)
         return false;
     }
 
+    config_transaction_barrier();
+
     if (!config_section_exists(section))
     {
         error = "CoreSettingsDeleteSection Failed: cannot non-existent section!";
@@ -1883,7 +2421,14 @@ CORE_EXPORT bool CoreSettingsDeleteSection(std::string section)
         return false;
     }
 
-    ret = m64p::Config.DeleteSection(section.c_str());
+    config_change_mark_section(section);
+
+    {
+        std::lock_guard<std::mutex> lock(l_configMutex);
+        ret = m64p::Config.DeleteSection(section.c_str());
+    }
+    config_section_list_clear();
+    config_cache_invalidate();
     if (ret != M64ERR_SUCCESS)
     {
         error = "CoreSettingsDeleteSection m64p::Config.DeleteSection() Failed: ";
@@ -1896,32 +2441,39 @@ CORE_EXPORT bool CoreSettingsDeleteSection(std::string section)
 
 CORE_EXPORT bool CoreSettingsKeyExists(std::string section, std::string key)
 {
+    config_transaction_barrier();
     return config_key_exists(section, key);
 }
 
+CORE_EXPORT void CoreSettingsClearCache(void)
+{
+    config_section_list_clear();
+    config_cache_invalidate();
+}
+
 CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, int value)
 {
     l_Setting setting = get_setting(settingId);
-    return config_option_set(setting.Section, setting.Key, M64TYPE_INT, &value);
+    return config_option_set(settingId, setting.Section, setting.Key, M64TYPE_INT, &value);
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, bool value)
 {
     l_Setting setting = get_setting(settingId);
     int intValue = value ? 1 : 0;
-    return config_option_set(setting.Section, setting.Key, M64TYPE_BOOL, &intValue);
+    return config_option_set(settingId, setting.Section, setting.Key, M64TYPE_BOOL, &intValue);
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, float value)
 {
     l_Setting setting = get_setting(settingId);
-    return config_option_set(setting.Section, setting.Key, M64TYPE_FLOAT, &value);
+    return config_option_set(settingId, setting.Section, setting.Key, M64TYPE_FLOAT, &value);
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, std::string value)
 {
     l_Setting setting = get_setting(settingId);
-    return config_option_set(setting.Section, setting.Key, M64TYPE_STRING, const_cast<char*>(value.c_str()));
+    return config_option_set(settingId, setting.Section, setting.Key, M64TYPE_STRING, const_cast<char*>(value.c_str()));
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, std::vector<int> value)
@@ -1947,26 +2499,26 @@ CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, std::vector<std::str
 CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, std::string section, int value)
 {
     l_Setting setting = get_setting(settingId);
-    return config_option_set(section, setting.Key, M64TYPE_INT, &value);
+    return config_option_set(settingId, section, setting.Key, M64TYPE_INT, &value);
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, std::string section, bool value)
 {
     l_Setting setting = get_setting(settingId);
     int intValue = value ? 1 : 0;
-    return config_option_set(section, setting.Key, M64TYPE_BOOL, &intValue);
+    return config_option_set(settingId, section, setting.Key, M64TYPE_BOOL, &intValue);
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, std::string section, float value)
 {
     l_Setting setting = get_setting(settingId);
-    return config_option_set(section, setting.Key, M64TYPE_FLOAT, &value);
+    return config_option_set(settingId, section, setting.Key, M64TYPE_FLOAT, &value);
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, std::string section, std::string value)
 {
     l_Setting setting = get_setting(settingId);
-    return config_option_set(section, setting.Key, M64TYPE_STRING, const_cast<char*>(value.c_str()));
+    return config_option_set(settingId, section, setting.Key, M64TYPE_STRING, const_cast<char*>(value.c_str()));
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, std::string section, std::vector<int> value)
@@ -1991,23 +2543,23 @@ CORE_EXPORT bool CoreSettingsSetValue(SettingsID settingId, std::string section,
 
 CORE_EXPORT bool CoreSettingsSetValue(std::string section, std::string key, int value)
 {
-    return config_option_set(section, key, M64TYPE_INT, &value);
+    return config_option_set(SettingsID::Invalid, section, key, M64TYPE_INT, &value);
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(std::string section, std::string key, bool value)
 {
     int intValue = value ? 1 : 0;
-    return config_option_set(section, key, M64TYPE_BOOL, &intValue);
+    return config_option_set(SettingsID::Invalid, section, key, M64TYPE_BOOL, &intValue);
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(std::string section, std::string key, float value)
 {
-    return config_option_set(section, key, M64TYPE_FLOAT, &value);
+    return config_option_set(SettingsID::Invalid, section, key, M64TYPE_FLOAT, &value);
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(std::string section, std::string key, std::string value)
 {
-    return config_option_set(section, key, M64TYPE_STRING, const_cast<char*>(value.c_str()));
+    return config_option_set(SettingsID::Invalid, section, key, M64TYPE_STRING, const_cast<char*>(value.c_str()));
 }
 
 CORE_EXPORT bool CoreSettingsSetValue(std::string section, std::string key, std::vector<int> value)
@@ -2068,46 +2620,112 @@ CORE_EXPORT std::vector<int> CoreSettingsGetDefaultIntListValue(SettingsID setti
 
 CORE_EXPORT int CoreSettingsGetIntValue(SettingsID settingId)
 {
+    // the generation has to be retrieved before
+    // the value, so a value which has been changed
+    // in the meantime isn't cached
+    uint32_t generation = l_cacheGeneration.load(std::memory_order_acquire);
+    int value = 0;
+
+    if (config_cache_get(settingId, generation, M64TYPE_INT, &value))
+    {
+        return value;
+    }
+
     l_Setting setting = get_setting(settingId);
-    int value = setting.DefaultValue.index() == 0 ? 0 : std::get<int>(setting.DefaultValue);
-    config_option_get(setting.Section, setting.Key, M64TYPE_INT, &value, sizeof(value));
+    value = setting.DefaultValue.index() == 0 ? 0 : std::get<int>(setting.DefaultValue);
+    if (config_option_get(setting.Section, setting.Key, M64TYPE_INT, &value, sizeof(value)))
+    {
+        config_cache_set(settingId, generation, M64TYPE_INT, &value);
+    }
     return value;
 }
 
 CORE_EXPORT bool CoreSettingsGetBoolValue(SettingsID settingId)
 {
+    uint32_t generation = l_cacheGeneration.load(std::memory_order_acquire);
+    int value = 0;
+
+    if (config_cache_get(settingId, generation, M64TYPE_BOOL, &value))
+    {
+        return value > 0;
+    }
+
     l_Setting setting = get_setting(settingId);
-    int value = setting.DefaultValue.index() == 0 ? 0 : (std::get<bool>(setting.DefaultValue) ? 1 : 0);
-    config_option_get(setting.Section, setting.Key, M64TYPE_BOOL, &value, sizeof(value));
+    value = setting.DefaultValue.index() == 0 ? 0 : (std::get<bool>(setting.DefaultValue) ? 1 : 0);
+    if (config_option_get(setting.Section, setting.Key, M64TYPE_BOOL, &value, sizeof(value)))
+    {
+        config_cache_set(settingId, generation, M64TYPE_BOOL, &value);
+    }
     return value > 0;
 }
 
 CORE_EXPORT float CoreSettingsGetFloatValue(SettingsID settingId)
 {
+    uint32_t generation = l_cacheGeneration.load(std::memory_order_acquire);
+    float value = 0.0f;
+
+    if (config_cache_get(settingId, generation, M64TYPE_FLOAT, &value))
+    {
+        return value;
+    }
+
     l_Setting setting = get_setting(settingId);
-    float value = setting.DefaultValue.index() == 0 ? 0.0f : std::get<float>(setting.DefaultValue);
-    config_option_get(setting.Section, setting.Key, M64TYPE_FLOAT, &value, sizeof(value));
+    value = setting.DefaultValue.index() == 0 ? 0.0f : std::get<float>(setting.DefaultValue);
+    if (config_option_get(setting.Section, setting.Key, M64TYPE_FLOAT, &value, sizeof(value)))
+    {
+        config_cache_set(settingId, generation, M64TYPE_FLOAT, &value);
+    }
     return value;
 }
 
 CORE_EXPORT std::string CoreSettingsGetStringValue(SettingsID settingId)
 {
+    uint32_t generation = l_cacheGeneration.load(std::memory_order_acquire);
+    std::string cachedValue;
+
+    if (config_cache_get(settingId, generation, M64TYPE_STRING, &cachedValue))
+    {
+        return cachedValue;
+    }
+
     l_Setting setting = get_setting(settingId);
     char value[STR_SIZE] = {0};
-    config_option_get(setting.Section, setting.Key, M64TYPE_STRING, value, sizeof(value));
+    if (config_option_get(setting.Section, setting.Key, M64TYPE_STRING, value, sizeof(value)))
+    {
+        cachedValue = value;
+        config_cache_set(settingId, generation, M64TYPE_STRING, &cachedValue);
+    }
     return std::string(value);
 }
 
 CORE_EXPORT std::vector<int> CoreSettingsGetIntListValue(SettingsID settingId)
 {
-    l_Setting setting = get_setting(settingId);
-    return CoreSettingsGetIntListValue(settingId, setting.Section);
+    std::vector<int> value;
+
+    std::string value_str;
+    value_str = CoreSettingsGetStringValue(settingId);
+
+    if (!string_to_int_list(value_str, value))
+    {
+        return std::vector<int>();
+    }
+
+    return value;
 }
 
 CORE_EXPORT std::vector<std::string> CoreSettingsGetStringListValue(SettingsID settingId)
 {
-    l_Setting setting = get_setting(settingId);
-    return CoreSettingsGetStringListValue(settingId, setting.Section);
+    std::vector<std::string> value;
+
+    std::string value_str;
+    value_str = CoreSettingsGetStringValue(settingId);
+
+    if (!string_to_string_list(value_str, value))
+    {
+        return std::vector<std::string>();
+    }
+
+    return value;
 }
 
 CORE_EXPORT int CoreSettingsGetIntValue(SettingsID settingId, std::string section)
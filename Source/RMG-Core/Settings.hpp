@@ -10,6 +10,7 @@
 #ifndef CORE_SETTINGS_HPP
 #define CORE_SETTINGS_HPP
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -47,6 +48,7 @@ enum class SettingsID
     Netplay_ServerJsonUrl,
     Netplay_DispatcherUrl,
     Netplay_SelectedServer,
+    Netplay_RollbackFrames,
 
     // Core Plugin Settings
     Core_GFX_Plugin,
@@ -76,6 +78,17 @@ enum class SettingsID
     Core_Gameboy_P4_Rom,
     Core_Gameboy_P4_Save,
 
+    // Core Rewind Settings
+    Core_Rewind_Enabled,
+    Core_Rewind_BufferSize,
+    Core_Rewind_Interval,
+
+    // Core Save State Settings
+    Core_FastSaveStates,
+
+    // Core Speed Limiter Settings
+    Core_PaceToHostRefreshRate,
+
     // (mupen64plus) Core Settings
     Core_OverrideGameSpecificSettings,
     Core_RandomizeInterrupt,
@@ -152,6 +165,7 @@ enum class SettingsID
     KeyBinding_SaveState,
     KeyBinding_SaveAs,
     KeyBinding_LoadState,
+    KeyBinding_Rewind,
     KeyBinding_Load,
     KeyBinding_Cheats,
     KeyBinding_GSButton,
@@ -474,6 +488,25 @@ bool CoreSettingsSave(void);
 // upgrades existing settings to new version
 bool CoreSettingsUpgrade(void);
 
+// begins a settings transaction, settings which are set
+// during a transaction are kept in memory and saving the
+// settings is deferred until the transaction has been
+// committed, transactions can be nested
+bool CoreSettingsBeginTransaction(void);
+
+// commits the settings transaction, this applies
+// all settings which have been set during the
+// transaction and saves them once when requested
+bool CoreSettingsCommitTransaction(void);
+
+// returns the settings change counter, which
+// is incremented every time a setting changes
+uint32_t CoreSettingsGetChangeCounter(void);
+
+// returns whether the given setting has changed
+// since the given change counter was retrieved
+bool CoreSettingsHasChanged(SettingsID settingId, uint32_t changeCounter);
+
 // setup default settings
 bool CoreSettingsSetupDefaults(void);
 
@@ -489,6 +522,12 @@ bool CoreSettingsDeleteSection(std::string section);
 // returns whether a key in the given section exists
 bool CoreSettingsKeyExists(std::string section, std::string key);
 
+#ifdef CORE_INTERNAL
+// clears the cached settings, this needs to be
+// called when the settings have been reloaded
+void CoreSettingsClearCache(void);
+#endif // CORE_INTERNAL
+
 // sets setting as int value
 bool CoreSettingsSetValue(SettingsID settingId, int value);
 // sets setting as bool value
@@ -63,3 +63,47 @@ CORE_EXPORT bool CoreSetSpeedLimiterState(bool enabled)
 
     return ret == M64ERR_SUCCESS;
 }
+
+CORE_EXPORT int CoreGetSpeedLimiterPacingError(void)
+{
+    std::string error;
+    m64p_error ret;
+    int value = 0;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return 0;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_CORE_STATE_QUERY, M64CORE_PACING_ERROR, &value);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreGetSpeedLimiterPacingError: m64p::Core.DoCommand(M64CMD_CORE_STATE_QUERY) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return value;
+}
+
+CORE_EXPORT bool CoreSetSpeedLimiterHostRefreshRate(int refreshRate)
+{
+    std::string error;
+    m64p_error ret;
+    int value = refreshRate;
+
+    if (!m64p::Core.IsHooked())
+    {
+        return false;
+    }
+
+    ret = m64p::Core.DoCommand(M64CMD_CORE_STATE_SET, M64CORE_HOST_REFRESH_RATE, &value);
+    if (ret != M64ERR_SUCCESS)
+    {
+        error = "CoreSetSpeedLimiterHostRefreshRate: m64p::Core.DoCommand(M64CMD_CORE_STATE_SET) Failed: ";
+        error += m64p::Core.ErrorMessage(ret);
+        CoreSetError(error);
+    }
+
+    return ret == M64ERR_SUCCESS;
+}
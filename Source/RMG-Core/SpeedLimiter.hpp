@@ -16,4 +16,12 @@ bool CoreIsSpeedLimiterEnabled(void);
 // sets the speed limiter state
 bool CoreSetSpeedLimiterState(bool enabled);
 
+// returns how late the last VI was in microseconds
+int CoreGetSpeedLimiterPacingError(void);
+
+// sets the refresh rate of the host display in millihertz,
+// when it's close to the game's refresh rate the speed limiter
+// paces to it instead, 0 disables pacing to the host display
+bool CoreSetSpeedLimiterHostRefreshRate(int refreshRate);
+
 #endif // CORE_SPEEDLIMITER_HPP
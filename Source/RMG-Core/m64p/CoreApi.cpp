@@ -34,6 +34,7 @@ bool CoreApi::Hook(m64p_dynlib_handle handle)
     HOOK_FUNC(handle, Core, AddCheat);
     HOOK_FUNC(handle, Core, CheatEnabled);
     HOOK_FUNC(handle, Core, GetRomSettings);
+    HOOK_FUNC(handle, Core, LookupRomSettings);
     HOOK_FUNC(handle, Core, GetAPIVersions);
     HOOK_FUNC(handle, Core, ErrorMessage);
 
@@ -53,6 +54,7 @@ bool CoreApi::Unhook(void)
     UNHOOK_FUNC(Core, AddCheat);
     UNHOOK_FUNC(Core, CheatEnabled);
     UNHOOK_FUNC(Core, GetRomSettings);
+    UNHOOK_FUNC(Core, LookupRomSettings);
     UNHOOK_FUNC(Core, GetAPIVersions);
     UNHOOK_FUNC(Core, ErrorMessage);
 
@@ -41,6 +41,7 @@ class CoreApi
     ptr_CoreAddCheat AddCheat;
     ptr_CoreCheatEnabled CheatEnabled;
     ptr_CoreGetRomSettings GetRomSettings;
+    ptr_CoreLookupRomSettings LookupRomSettings;
     ptr_CoreGetAPIVersions GetAPIVersions;
     ptr_CoreErrorMessage ErrorMessage;
 
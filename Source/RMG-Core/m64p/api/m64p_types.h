@@ -140,7 +140,9 @@ typedef enum {
   M64CORE_STATE_LOADCOMPLETE,
   M64CORE_STATE_SAVECOMPLETE,
   M64CORE_SCREENSHOT_CAPTURED,
-  M64CORE_SPEED_UDPATE
+  M64CORE_SPEED_UDPATE,
+  M64CORE_PACING_ERROR,
+  M64CORE_HOST_REFRESH_RATE
 } m64p_core_param;
 
 typedef enum {
@@ -173,7 +175,17 @@ typedef enum {
   M64CMD_PIF_OPEN,
   M64CMD_ROM_SET_SETTINGS,
   M64CMD_DISK_OPEN,
-  M64CMD_DISK_CLOSE
+  M64CMD_DISK_CLOSE,
+  M64CMD_REWIND_INIT,
+  M64CMD_REWIND_CLOSE,
+  M64CMD_REWIND_STEP_BACK,
+  M64CMD_STATE_GET_MEMORY_SIZE,
+  M64CMD_STATE_SAVE_MEMORY,
+  M64CMD_STATE_LOAD_MEMORY,
+  M64CMD_INPUT_PLAYBACK,
+  M64CMD_RDRAM_GET_HASH,
+  M64CMD_NETPLAY_SET_ROLLBACK,
+  M64CMD_NETPLAY_GET_STATS
 } m64p_command;
 
 typedef struct {
@@ -181,6 +193,26 @@ typedef struct {
   int      value;
 } m64p_cheat_code;
 
+typedef struct {
+  /* Number of times the emulation was rolled back after a misprediction,
+   * and the amount of VIs which were emulated again because of it. */
+  unsigned int rollbacks;
+  unsigned int resimulated_vis;
+  /* Depth in VIs of the last and of the deepest rollback. */
+  unsigned int last_depth;
+  unsigned int max_depth;
+  /* Number of times the emulation waited for input of another player,
+   * and the total time it waited in milliseconds. */
+  unsigned int stalls;
+  unsigned int stall_time;
+  /* Number of VIs emulated, and how many of those were emulated without
+   * the speed limiter to catch up with the other players. */
+  unsigned int vis;
+  unsigned int fast_forward_vis;
+  /* Number of desyncs reported by the server. */
+  unsigned int desyncs;
+} m64p_netplay_stats;
+
 typedef struct {
   /* Frontend-defined callback data. */
   void* cb_data;
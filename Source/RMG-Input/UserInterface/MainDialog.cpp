@@ -395,6 +395,8 @@ void MainDialog::accept(void)
     Widget::ControllerWidget* controllerWidget;
     int currentIndex = this->tabWidget->currentIndex();
 
+    CoreSettingsBeginTransaction();
+
     for (int i = 0; i < this->controllerWidgets.count(); i++)
     {
         if (i != currentIndex)
@@ -410,11 +412,15 @@ void MainDialog::accept(void)
 
     CoreSettingsSave();
 
+    CoreSettingsCommitTransaction();
+
     QDialog::accept();
 }
 
 void MainDialog::reject(void)
 {
+    CoreSettingsBeginTransaction();
+
     for (auto& controllerWidget : this->controllerWidgets)
     {
         controllerWidget->RevertSettings();
@@ -422,5 +428,7 @@ void MainDialog::reject(void)
 
     CoreSettingsSave();
 
+    CoreSettingsCommitTransaction();
+
     QDialog::reject();
 }
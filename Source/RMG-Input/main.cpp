@@ -1223,6 +1223,8 @@ EXPORT m64p_error CALL PluginConfigWithRomConfig(void* parent, int romConfig, Co
 
     l_SDLThread->SetAction(SDLThreadAction::SDLPumpEvents);
 
+    uint32_t changeCounter = CoreSettingsGetChangeCounter();
+
     UserInterface::MainDialog dialog(static_cast<QWidget*>(parent), l_SDLThread, romConfig, *romHeader, *romSettings);
     dialog.exec();
 
@@ -1242,8 +1244,11 @@ EXPORT m64p_error CALL PluginConfigWithRomConfig(void* parent, int romConfig, Co
         QThread::msleep(5);
     }
 
-    // reload settings
-    load_settings();
+    // reload settings when they've changed
+    if (CoreSettingsGetChangeCounter() != changeCounter)
+    {
+        load_settings();
+    }
 
     // apply profiles when we're not in netplay
     if (!CoreHasInitNetplay())
@@ -0,0 +1,638 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "NetplayServer.hpp"
+
+#include <QCoreApplication>
+#include <QtEndian>
+#include <QTimer>
+
+#include <algorithm>
+#include <iostream>
+
+//
+// Local Defines
+//
+
+// protocol of main/netplay.c in the mupen64plus-core
+#define UDP_SEND_KEY_INFO               0
+#define UDP_RECEIVE_KEY_INFO            1
+#define UDP_REQUEST_KEY_INFO            2
+#define UDP_RECEIVE_KEY_INFO_GRATUITOUS 3
+#define UDP_SYNC_DATA                   4
+
+#define TCP_SEND_SAVE         1
+#define TCP_RECEIVE_SAVE      2
+#define TCP_SEND_SETTINGS     3
+#define TCP_RECEIVE_SETTINGS  4
+#define TCP_REGISTER_PLAYER   5
+#define TCP_GET_REGISTRATION  6
+#define TCP_DISCONNECT_NOTICE 7
+
+#define SETTINGS_SIZE 24
+
+// the core receives packets of up to 512 bytes,
+// every event takes 9 bytes after a 5 byte header
+#define MAX_EVENTS_PER_PACKET 50
+
+// amount of events which are kept before the lead
+#define MAX_EVENT_HISTORY 1024
+
+// amount of VIs after which unmatched sync data is dropped
+#define MAX_SYNC_HISTORY 6000
+
+//
+// Exported Functions
+//
+
+NetplayServer::NetplayServer(NetplayServerOptions options, QObject* parent) : QObject(parent)
+{
+    this->options = options;
+    this->random.seed(options.Seed);
+}
+
+NetplayServer::~NetplayServer(void)
+{
+}
+
+bool NetplayServer::Start(void)
+{
+    this->tcpServer = new QTcpServer(this);
+    this->udpSocket = new QUdpSocket(this);
+
+    if (!this->tcpServer->listen(QHostAddress::Any, this->options.Port))
+    {
+        std::cerr << "Error: failed to listen on TCP port " << this->options.Port << ": "
+                  << this->tcpServer->errorString().toStdString() << std::endl;
+        return false;
+    }
+
+    if (!this->udpSocket->bind(QHostAddress::Any, this->options.Port))
+    {
+        std::cerr << "Error: failed to bind to UDP port " << this->options.Port << ": "
+                  << this->udpSocket->errorString().toStdString() << std::endl;
+        return false;
+    }
+
+    connect(this->tcpServer, &QTcpServer::newConnection, this, &NetplayServer::on_tcpServer_newConnection);
+    connect(this->udpSocket, &QUdpSocket::readyRead, this, &NetplayServer::on_udpSocket_readyRead);
+
+    std::cout << "Listening on port " << this->options.Port << " for " << this->options.Players << " players"
+              << " (input delay: " << this->options.InputDelay
+              << ", latency: " << this->options.Latency << " ms"
+              << ", jitter: " << this->options.Jitter << " ms"
+              << ", loss: " << this->options.Loss << "%)" << std::endl;
+    return true;
+}
+
+//
+// Private Functions
+//
+
+int NetplayServer::registeredPlayers(void)
+{
+    int count = 0;
+
+    for (const NetplayPlayer& player : this->players)
+    {
+        if (player.RegId != 0)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+int NetplayServer::connectedPlayers(void)
+{
+    int count = 0;
+
+    for (const NetplayPlayer& player : this->players)
+    {
+        if (player.RegId != 0 && !player.Disconnected)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void NetplayServer::processTcpData(QTcpSocket* socket)
+{
+    NetplayClient& client = this->clients[socket];
+    client.Buffer.append(socket->readAll());
+
+    while (!client.Buffer.isEmpty())
+    {
+        const char* data = client.Buffer.constData();
+        qsizetype size = 0;
+
+        switch (static_cast<uint8_t>(data[0]))
+        {
+        case TCP_SEND_SAVE:
+        { // type, extension, size and the data
+            qsizetype end = client.Buffer.indexOf('\0', 1);
+            if (end == -1 || client.Buffer.size() < (end + 5))
+            {
+                break;
+            }
+
+            qsizetype saveSize = qFromBigEndian<quint32>(data + end + 1);
+            if (client.Buffer.size() < (end + 5 + saveSize))
+            {
+                break;
+            }
+
+            this->saves[QString::fromLatin1(data + 1)] = client.Buffer.mid(end + 5, saveSize);
+            size = end + 5 + saveSize;
+        } break;
+        case TCP_RECEIVE_SAVE:
+        { // type and extension
+            qsizetype end = client.Buffer.indexOf('\0', 1);
+            if (end == -1)
+            {
+                break;
+            }
+
+            client.PendingSaves.append(QString::fromLatin1(data + 1));
+            size = end + 1;
+        } break;
+        case TCP_SEND_SETTINGS:
+        { // type and settings
+            if (client.Buffer.size() < (SETTINGS_SIZE + 1))
+            {
+                break;
+            }
+
+            this->settings = client.Buffer.mid(1, SETTINGS_SIZE);
+            size = SETTINGS_SIZE + 1;
+        } break;
+        case TCP_RECEIVE_SETTINGS:
+        { // type
+            client.PendingSettings = true;
+            size = 1;
+        } break;
+        case TCP_REGISTER_PLAYER:
+        { // type, player, plugin, raw data and registration ID
+            if (client.Buffer.size() < 8)
+            {
+                break;
+            }
+
+            this->registerPlayer(socket, data[1], data[2], data[3], qFromBigEndian<quint32>(data + 4));
+            size = 8;
+        } break;
+        case TCP_GET_REGISTRATION:
+        { // type
+            client.PendingRegistration = true;
+            size = 1;
+        } break;
+        case TCP_DISCONNECT_NOTICE:
+        { // type and registration ID
+            if (client.Buffer.size() < 5)
+            {
+                break;
+            }
+
+            this->disconnectPlayer(qFromBigEndian<quint32>(data + 1));
+            size = 5;
+        } break;
+        default:
+        {
+            std::cerr << "Error: received unknown TCP message " << static_cast<int>(data[0]) << std::endl;
+            client.Buffer.clear();
+            socket->abort();
+            return;
+        }
+        }
+
+        // wait for the rest of the message
+        if (size == 0)
+        {
+            break;
+        }
+
+        client.Buffer.remove(0, size);
+    }
+
+    this->sendPendingTcpData();
+}
+
+void NetplayServer::sendPendingTcpData(void)
+{
+    for (auto& [socket, client] : this->clients)
+    {
+        // only player 1 sends the saves and settings,
+        // the other players wait until they've been received
+        for (auto iter = client.PendingSaves.begin(); iter != client.PendingSaves.end();)
+        {
+            auto save = this->saves.find(*iter);
+            if (save == this->saves.end())
+            {
+                iter++;
+                continue;
+            }
+
+            socket->write(save->second);
+            iter = client.PendingSaves.erase(iter);
+        }
+
+        if (client.PendingSettings && this->settings.size() == SETTINGS_SIZE)
+        {
+            socket->write(this->settings);
+            client.PendingSettings = false;
+        }
+
+        // the game starts once every player has registered
+        if (client.PendingRegistration && this->registeredPlayers() >= this->options.Players)
+        {
+            QByteArray registration(24, 0);
+            for (int i = 0; i < 4; i++)
+            {
+                qToBigEndian<quint32>(this->players[i].RegId, registration.data() + (i * 6));
+                registration[(i * 6) + 4] = this->players[i].Plugin;
+                registration[(i * 6) + 5] = this->players[i].RawData;
+            }
+
+            socket->write(registration);
+            client.PendingRegistration = false;
+        }
+    }
+}
+
+void NetplayServer::registerPlayer(QTcpSocket* socket, uint8_t player, uint8_t plugin, uint8_t rawData, uint32_t regId)
+{
+    QByteArray response(2, 0);
+    bool accepted = player < 4 && regId != 0 &&
+                    (this->players[player].RegId == 0 || this->players[player].RegId == regId);
+
+    if (accepted && this->players[player].RegId == 0)
+    {
+        NetplayPlayer& netplayPlayer = this->players[player];
+        netplayPlayer.RegId   = regId;
+        netplayPlayer.Plugin  = plugin;
+        netplayPlayer.RawData = rawData;
+
+        // the input delay is created by the events
+        // which are there before the player sends input
+        for (int i = 0; i < this->options.InputDelay; i++)
+        {
+            netplayPlayer.Inputs[i] = { 0, plugin };
+        }
+
+        this->clients[socket].RegId = regId;
+        std::cout << "Player " << (player + 1) << " registered" << std::endl;
+    }
+
+    response[0] = accepted ? 1 : 0;
+    response[1] = static_cast<char>(this->options.InputDelay);
+    socket->write(response);
+}
+
+void NetplayServer::disconnectPlayer(uint32_t regId)
+{
+    if (regId == 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        NetplayPlayer& player = this->players[i];
+        if (player.RegId != regId || player.Disconnected)
+        {
+            continue;
+        }
+
+        player.Disconnected = true;
+        this->status |= (1 << (i + 1));
+        std::cout << "Player " << (i + 1) << " disconnected" << std::endl;
+    }
+
+    // the server only hosts one session
+    if (this->registeredPlayers() >= this->options.Players && this->connectedPlayers() == 0)
+    {
+        std::cout << "Every player has disconnected, exiting" << std::endl;
+        QTimer::singleShot(0, QCoreApplication::instance(), &QCoreApplication::quit);
+    }
+}
+
+bool NetplayServer::dropPacket(void)
+{
+    if (this->options.Loss <= 0.0)
+    {
+        return false;
+    }
+
+    std::uniform_real_distribution<double> distribution(0.0, 100.0);
+    return distribution(this->random) < this->options.Loss;
+}
+
+int NetplayServer::packetDelay(void)
+{
+    if (this->options.Jitter <= 0)
+    {
+        return this->options.Latency;
+    }
+
+    std::uniform_int_distribution<int> distribution(0, this->options.Jitter);
+    return this->options.Latency + distribution(this->random);
+}
+
+void NetplayServer::processDatagram(const QNetworkDatagram& datagram)
+{
+    QByteArray data = datagram.data();
+
+    if (data.isEmpty())
+    {
+        return;
+    }
+
+    switch (static_cast<uint8_t>(data[0]))
+    {
+    case UDP_SEND_KEY_INFO:
+        this->receiveKeyInfo(data);
+        break;
+    case UDP_REQUEST_KEY_INFO:
+        this->requestKeyInfo(data, datagram.senderAddress(), datagram.senderPort());
+        break;
+    case UDP_SYNC_DATA:
+        this->receiveSyncData(data);
+        break;
+    default:
+        if (this->options.Verbose)
+        {
+            std::cerr << "Error: received unknown UDP message " << static_cast<int>(data[0]) << std::endl;
+        }
+        break;
+    }
+}
+
+void NetplayServer::sendDatagram(const QByteArray& data, const QHostAddress& address, quint16 port)
+{
+    if (this->dropPacket())
+    {
+        return;
+    }
+
+    int delay = this->packetDelay();
+    if (delay == 0)
+    {
+        this->udpSocket->writeDatagram(data, address, port);
+        return;
+    }
+
+    QTimer::singleShot(delay, Qt::PreciseTimer, this, [this, data, address, port]()
+    {
+        this->udpSocket->writeDatagram(data, address, port);
+    });
+}
+
+void NetplayServer::sendInputs(uint8_t type, uint8_t player, uint32_t count, uint8_t lag, const QHostAddress& address, quint16 port)
+{
+    const std::map<uint32_t, NetplayInput>& inputs = this->players[player].Inputs;
+    QByteArray data(5, 0);
+    char event[9];
+    uint8_t events = 0;
+
+    data[0] = type;
+    data[1] = player;
+    data[2] = this->status;
+    data[3] = lag;
+
+    // send the events which follow each other,
+    // starting at the requested event
+    for (auto iter = inputs.find(count); iter != inputs.end() && events < MAX_EVENTS_PER_PACKET; iter++)
+    {
+        if (iter->first != (count + events))
+        {
+            break;
+        }
+
+        qToBigEndian<quint32>(iter->first, event);
+        qToBigEndian<quint32>(iter->second.Keys, event + 4);
+        event[8] = iter->second.Plugin;
+        data.append(event, sizeof(event));
+        events++;
+    }
+
+    data[4] = events;
+    this->sendDatagram(data, address, port);
+}
+
+void NetplayServer::receiveKeyInfo(const QByteArray& data)
+{
+    if (data.size() < 11)
+    {
+        return;
+    }
+
+    const uint8_t playerNumber = data[1];
+    if (playerNumber >= 4)
+    {
+        return;
+    }
+
+    NetplayPlayer& player = this->players[playerNumber];
+    if (player.RegId == 0 || player.Disconnected)
+    {
+        return;
+    }
+
+    // the input is executed after the input delay,
+    // events which are sent again are ignored
+    uint32_t count = qFromBigEndian<quint32>(data.constData() + 2) + this->options.InputDelay;
+    if (player.Inputs.contains(count))
+    {
+        return;
+    }
+
+    player.Inputs[count] = { qFromBigEndian<quint32>(data.constData() + 6), static_cast<uint8_t>(data[10]) };
+
+    for (const NetplayEndpoint& endpoint : this->endpoints)
+    {
+        this->sendInputs(UDP_RECEIVE_KEY_INFO_GRATUITOUS, playerNumber, count, 0, endpoint.Address, endpoint.Port);
+    }
+}
+
+void NetplayServer::requestKeyInfo(const QByteArray& data, const QHostAddress& address, quint16 port)
+{
+    if (data.size() < 12)
+    {
+        return;
+    }
+
+    const uint8_t  playerNumber = data[1];
+    const uint32_t regId        = qFromBigEndian<quint32>(data.constData() + 2);
+    const uint32_t count        = qFromBigEndian<quint32>(data.constData() + 6);
+    const bool     spectator    = data[10] != 0;
+    uint8_t lag = 0;
+
+    if (playerNumber >= 4)
+    {
+        return;
+    }
+
+    // remember where to send the events to
+    auto endpoint = std::find_if(this->endpoints.begin(), this->endpoints.end(),
+                                 [regId](const NetplayEndpoint& e) { return e.RegId == regId; });
+    if (endpoint == this->endpoints.end())
+    {
+        this->endpoints.push_back({ regId, address, port });
+    }
+    else
+    {
+        endpoint->Address = address;
+        endpoint->Port    = port;
+    }
+
+    NetplayPlayer& player = this->players[playerNumber];
+
+    if (!spectator && count > player.LeadCount)
+    {
+        player.LeadCount = count;
+    }
+    else if (player.LeadCount > count)
+    {
+        lag = static_cast<uint8_t>(std::min<uint32_t>(player.LeadCount - count, 255));
+    }
+
+    // the controller of a player who has
+    // disconnected keeps the last input
+    if (player.Disconnected)
+    {
+        NetplayInput input = { 0, player.Plugin };
+        if (!player.Inputs.empty())
+        {
+            input = player.Inputs.rbegin()->second;
+        }
+
+        for (uint32_t i = count; i < (count + MAX_EVENTS_PER_PACKET); i++)
+        {
+            player.Inputs.emplace(i, input);
+        }
+    }
+
+    while (!player.Inputs.empty() && (player.Inputs.begin()->first + MAX_EVENT_HISTORY) < player.LeadCount)
+    {
+        player.Inputs.erase(player.Inputs.begin());
+    }
+
+    this->sendInputs(UDP_RECEIVE_KEY_INFO, playerNumber, count, lag, address, port);
+}
+
+void NetplayServer::receiveSyncData(const QByteArray& data)
+{
+    if (data.size() < 5)
+    {
+        return;
+    }
+
+    const uint32_t vi = qFromBigEndian<quint32>(data.constData() + 1);
+    QByteArray registers = data.mid(5);
+
+    auto iter = this->syncData.find(vi);
+    if (iter == this->syncData.end())
+    {
+        iter = this->syncData.insert({ vi, { registers, 0 } }).first;
+    }
+    else if (iter->second.Registers != registers)
+    {
+        if (!(this->status & 0x1))
+        {
+            std::cout << "Players have desynced at VI " << vi << std::endl;
+        }
+        this->status |= 0x1;
+    }
+
+    if (++iter->second.Reports >= this->connectedPlayers())
+    {
+        this->syncData.erase(iter);
+    }
+
+    // drop the data which a player never sent
+    while (!this->syncData.empty() && (this->syncData.begin()->first + MAX_SYNC_HISTORY) < vi)
+    {
+        this->syncData.erase(this->syncData.begin());
+    }
+}
+
+//
+// Slots
+//
+
+void NetplayServer::on_tcpServer_newConnection(void)
+{
+    while (this->tcpServer->hasPendingConnections())
+    {
+        QTcpSocket* socket = this->tcpServer->nextPendingConnection();
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        this->clients[socket] = {};
+
+        connect(socket, &QTcpSocket::readyRead, this, &NetplayServer::on_tcpSocket_readyRead);
+        connect(socket, &QTcpSocket::disconnected, this, &NetplayServer::on_tcpSocket_disconnected);
+    }
+}
+
+void NetplayServer::on_tcpSocket_readyRead(void)
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(this->sender());
+
+    if (socket == nullptr || !this->clients.contains(socket))
+    {
+        return;
+    }
+
+    this->processTcpData(socket);
+}
+
+void NetplayServer::on_tcpSocket_disconnected(void)
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(this->sender());
+
+    auto iter = this->clients.find(socket);
+    if (iter == this->clients.end())
+    {
+        return;
+    }
+
+    uint32_t regId = iter->second.RegId;
+    this->clients.erase(iter);
+    socket->deleteLater();
+
+    this->disconnectPlayer(regId);
+}
+
+void NetplayServer::on_udpSocket_readyRead(void)
+{
+    while (this->udpSocket->hasPendingDatagrams())
+    {
+        QNetworkDatagram datagram = this->udpSocket->receiveDatagram();
+
+        if (this->dropPacket())
+        {
+            continue;
+        }
+
+        int delay = this->packetDelay();
+        if (delay == 0)
+        {
+            this->processDatagram(datagram);
+            continue;
+        }
+
+        QTimer::singleShot(delay, Qt::PreciseTimer, this, [this, datagram]()
+        {
+            this->processDatagram(datagram);
+        });
+    }
+}
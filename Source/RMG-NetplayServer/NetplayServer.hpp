@@ -0,0 +1,128 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NETPLAYSERVER_HPP
+#define NETPLAYSERVER_HPP
+
+#include <QNetworkDatagram>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <array>
+#include <map>
+
+struct NetplayServerOptions
+{
+    quint16  Port       = 45000;
+    int      Players    = 2;
+    int      InputDelay = 2;
+    int      Latency    = 0;   // in milliseconds, added to every UDP packet in both directions
+    int      Jitter     = 0;   // in milliseconds, random extra latency
+    double   Loss       = 0.0; // in percent
+    uint32_t Seed       = 0;
+    bool     Verbose    = false;
+};
+
+class NetplayServer : public QObject
+{
+    Q_OBJECT
+
+  public:
+    NetplayServer(NetplayServerOptions options, QObject* parent = nullptr);
+    ~NetplayServer(void);
+
+    bool Start(void);
+
+  private:
+    struct NetplayInput
+    {
+        uint32_t Keys   = 0;
+        uint8_t  Plugin = 0;
+    };
+
+    struct NetplayPlayer
+    {
+        uint32_t RegId         = 0;
+        uint8_t  Plugin        = 0;
+        uint8_t  RawData       = 0;
+        bool     Disconnected  = false;
+        uint32_t LeadCount     = 0;
+        std::map<uint32_t, NetplayInput> Inputs;
+    };
+
+    struct NetplayClient
+    {
+        uint32_t   RegId = 0;
+        QByteArray Buffer;
+        QList<QString> PendingSaves;
+        bool PendingSettings     = false;
+        bool PendingRegistration = false;
+    };
+
+    struct NetplayEndpoint
+    {
+        uint32_t     RegId = 0;
+        QHostAddress Address;
+        quint16      Port  = 0;
+    };
+
+    struct NetplaySyncData
+    {
+        QByteArray Registers;
+        int        Reports = 0;
+    };
+
+    NetplayServerOptions options;
+
+    QTcpServer* tcpServer = nullptr;
+    QUdpSocket* udpSocket = nullptr;
+
+    std::map<QTcpSocket*, NetplayClient> clients;
+    std::array<NetplayPlayer, 4> players;
+    std::vector<NetplayEndpoint> endpoints;
+    std::map<QString, QByteArray> saves;
+    std::map<uint32_t, NetplaySyncData> syncData;
+    QByteArray settings;
+    uint8_t status = 0;
+
+    std::mt19937 random;
+
+    int registeredPlayers(void);
+    int connectedPlayers(void);
+
+    void processTcpData(QTcpSocket* socket);
+    void sendPendingTcpData(void);
+    void registerPlayer(QTcpSocket* socket, uint8_t player, uint8_t plugin, uint8_t rawData, uint32_t regId);
+    void disconnectPlayer(uint32_t regId);
+
+    bool dropPacket(void);
+    int packetDelay(void);
+    void processDatagram(const QNetworkDatagram& datagram);
+    void sendDatagram(const QByteArray& data, const QHostAddress& address, quint16 port);
+    void sendInputs(uint8_t type, uint8_t player, uint32_t count, uint8_t lag, const QHostAddress& address, quint16 port);
+    void receiveKeyInfo(const QByteArray& data);
+    void requestKeyInfo(const QByteArray& data, const QHostAddress& address, quint16 port);
+    void receiveSyncData(const QByteArray& data);
+
+  private slots:
+    void on_tcpServer_newConnection(void);
+    void on_tcpSocket_readyRead(void);
+    void on_tcpSocket_disconnected(void);
+    void on_udpSocket_readyRead(void);
+};
+
+#endif // NETPLAYSERVER_HPP
@@ -0,0 +1,94 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "NetplayServer.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+
+#include <iostream>
+
+//
+// Local Functions
+//
+
+static bool parse_int(const QString& value, int min, int max, int& result)
+{
+    bool ok = false;
+    result = value.toInt(&ok);
+    return ok && result >= min && result <= max;
+}
+
+//
+// Exported Functions
+//
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("RMG-NetplayServer");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local netplay server for testing, it hosts one session and\n"
+                                     "exits once every player has disconnected");
+    parser.addHelpOption();
+
+    QCommandLineOption portOption({"p", "port"}, "Port to listen on (default: 45000)", "port", "45000");
+    QCommandLineOption playersOption("players", "Amount of players to wait for (default: 2)", "count", "2");
+    QCommandLineOption inputDelayOption("input-delay", "Amount of VIs the input is delayed by (default: 2)", "VIs", "2");
+    QCommandLineOption latencyOption("latency", "Latency added to every UDP packet in both directions (default: 0)", "ms", "0");
+    QCommandLineOption jitterOption("jitter", "Random extra latency of every UDP packet (default: 0)", "ms", "0");
+    QCommandLineOption lossOption("loss", "Chance that a UDP packet is lost (default: 0)", "percent", "0");
+    QCommandLineOption seedOption("seed", "Seed of the jitter and loss (default: 0)", "seed", "0");
+    QCommandLineOption verboseOption({"v", "verbose"}, "Prints invalid packets");
+
+    parser.addOption(portOption);
+    parser.addOption(playersOption);
+    parser.addOption(inputDelayOption);
+    parser.addOption(latencyOption);
+    parser.addOption(jitterOption);
+    parser.addOption(lossOption);
+    parser.addOption(seedOption);
+    parser.addOption(verboseOption);
+
+    parser.process(app);
+
+    NetplayServerOptions options;
+    int port = 0;
+    bool lossOk = false;
+
+    if (!parse_int(parser.value(portOption), 1, 65535, port) ||
+        !parse_int(parser.value(playersOption), 1, 4, options.Players) ||
+        !parse_int(parser.value(inputDelayOption), 0, 255, options.InputDelay) ||
+        !parse_int(parser.value(latencyOption), 0, 10000, options.Latency) ||
+        !parse_int(parser.value(jitterOption), 0, 10000, options.Jitter))
+    {
+        std::cerr << "Error: invalid option value" << std::endl;
+        return 1;
+    }
+
+    options.Port    = static_cast<quint16>(port);
+    options.Loss    = parser.value(lossOption).toDouble(&lossOk);
+    options.Seed    = parser.value(seedOption).toUInt();
+    options.Verbose = parser.isSet(verboseOption);
+
+    if (!lossOk || options.Loss < 0.0 || options.Loss > 100.0)
+    {
+        std::cerr << "Error: invalid packet loss: " << parser.value(lossOption).toStdString() << std::endl;
+        return 1;
+    }
+
+    NetplayServer server(options);
+    if (!server.Start())
+    {
+        return 1;
+    }
+
+    return app.exec();
+}
@@ -10,12 +10,52 @@
 #include "RomSearcherThread.hpp"
 
 #include <RMG-Core/CachedRomHeaderAndSettings.hpp>
+#include <RMG-Core/RomHeaderAndSettings.hpp>
+#include <RMG-Core/RomDirectoryWatcher.hpp>
+#include <RMG-Core/Archive.hpp>
 
 #include <QElapsedTimer>
 #include <QDirIterator>
+#include <QThreadPool>
+#include <QFileInfo>
+#include <QDir>
+
+#include <vector>
 
 using namespace Thread;
 
+//
+// Local Structures
+//
+
+struct RomSearcherThreadResult
+{
+    bool cached    = false;
+    bool valid     = false;
+    bool unchanged = false;
+    CoreRomType     type = CoreRomType::Cartridge;
+    CoreRomHeader   header = {};
+    CoreRomSettings defaultSettings = {};
+    CoreRomSettings settings = {};
+};
+
+//
+// Local Functions
+//
+
+static QStringList get_rom_name_filters(void)
+{
+    QStringList filter;
+    filter << "*.N64";
+    filter << "*.Z64";
+    filter << "*.V64";
+    filter << "*.NDD";
+    filter << "*.D64";
+    filter << "*.ZIP";
+    filter << "*.7Z";
+    return filter;
+}
+
 RomSearcherThread::RomSearcherThread(QObject *parent) : QThread(parent)
 {
     qRegisterMetaType<CoreRomType>("CoreRomType");
@@ -53,64 +93,225 @@ void RomSearcherThread::Stop(void)
     }
 }
 
+bool RomSearcherThread::IsRefreshing(void)
+{
+    return this->isRunning() && this->refreshing;
+}
+
+bool RomSearcherThread::IsWatching(void)
+{
+    return this->isRunning() && !this->refreshing;
+}
+
 void RomSearcherThread::run(void)
 {
-    this->stop = false;
-    this->searchDirectory(this->directory);
+    this->stop       = false;
+    this->refreshing = true;
+    this->files.clear();
+
+    QString directory = QDir::cleanPath(this->directory);
+
+    // when we have cached entries for the directory,
+    // send those to the UI right away and finish the
+    // refresh, any changes made after the entries were
+    // cached will be sent to the UI afterwards
+    if (this->searchCachedDirectory(directory))
+    {
+        this->finishRefresh();
+    }
+
+    // start watching before searching the directory,
+    // so we won't miss any changes made during the search
+    bool watching = CoreStartRomDirectoryWatcher(directory.toStdU32String(), this->recursive);
+
+    this->searchDirectory(directory);
+
+    if (this->refreshing)
+    {
+        this->finishRefresh();
+    }
+
+    if (watching)
+    {
+        this->watchDirectory(directory);
+        CoreStopRomDirectoryWatcher();
+    }
 }
 
-void RomSearcherThread::searchDirectory(QString directory)
+bool RomSearcherThread::searchCachedDirectory(QString directory)
 {
-    QStringList filter;
-    filter << "*.N64";
-    filter << "*.Z64";
-    filter << "*.V64";
-    filter << "*.NDD";
-    filter << "*.D64";
-    filter << "*.ZIP";
-    filter << "*.7Z";
+    std::vector<CoreCachedRomHeaderAndSettings> entries;
+    QList<RomSearcherThreadData> data;
+    QStringList filter = get_rom_name_filters();
+
+    if (!CoreGetCachedRomHeaderAndSettingsInDirectory(directory.toStdU32String(), this->recursive, entries))
+    {
+        return false;
+    }
+
+    for (const CoreCachedRomHeaderAndSettings& entry : entries)
+    {
+        if (data.size() >= this->maxItems)
+        {
+            break;
+        }
 
+        QString file = QString::fromStdU32String(entry.File.u32string());
+        if (!QDir::match(filter, QFileInfo(file).fileName()))
+        {
+            continue;
+        }
+
+        data.push_back(
+        {
+            file,
+            entry.Type,
+            entry.Header,
+            entry.Settings
+        });
+        this->files.insert(file);
+    }
+
+    if (data.isEmpty())
+    {
+        return false;
+    }
+
+    emit this->RomsFound(data, data.size(), data.size());
+    return true;
+}
+
+void RomSearcherThread::searchDirectory(QString directory)
+{
     QDirIterator::IteratorFlag flag = this->recursive ? 
         QDirIterator::Subdirectories : 
         QDirIterator::NoIteratorFlags;
-    QDirIterator romDirIt(directory, filter, QDir::Files, flag);
-
-    CoreRomType     type;
-    CoreRomHeader   header;
-    CoreRomSettings defaultSettings;
-    CoreRomSettings settings;
-    bool            ret;
+    QDirIterator romDirIt(directory, get_rom_name_filters(), QDir::Files, flag);
 
     QList<QString> roms;
-    while (romDirIt.hasNext())
+    while (romDirIt.hasNext() && roms.size() < this->maxItems)
     {
         roms.push_back(romDirIt.next());
     }
 
-    const int romAmount = std::min(this->maxItems, (int)roms.size());
+    this->searchFiles(roms, this->refreshing);
+
+    if (this->stop)
+    {
+        return;
+    }
+
+    // remove the files which we've sent to the UI before
+    // but which weren't found anymore
+    QSet<QString> foundFiles(roms.begin(), roms.end());
+    QList<QString> removedFiles;
+    for (auto iter = this->files.begin(); iter != this->files.end();)
+    {
+        if (!foundFiles.contains(*iter))
+        {
+            removedFiles.push_back(*iter);
+            iter = this->files.erase(iter);
+        }
+        else
+        {
+            iter++;
+        }
+    }
+
+    if (!removedFiles.isEmpty())
+    {
+        emit this->RomsRemoved(removedFiles);
+    }
+}
+
+void RomSearcherThread::searchFiles(QList<QString> roms, bool refreshing)
+{
+    const int romAmount = roms.size();
 
     // our ROM data
     QList<RomSearcherThreadData> data;
+    QList<QString> removedFiles;
+
+    // retrieving the header and settings is done
+    // on a pool of worker threads in batches,
+    // merging the results into the cache and
+    // sending them to the UI is only done
+    // on this thread
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(QThread::idealThreadCount());
+    const int batchSize = threadPool.maxThreadCount() * 4;
+    std::vector<RomSearcherThreadResult> results(batchSize);
 
     // keep track of the time
     QElapsedTimer timer;
     timer.start();
 
-    for (int i = 0; i < romAmount; i++)
+    for (int i = 0; i < romAmount; i += batchSize)
     {
-        QString file = roms.at(i);
+        const int batchEnd = std::min(i + batchSize, romAmount);
 
-        if (CoreGetCachedRomHeaderAndSettings(file.toStdU32String(), &type, &header, nullptr, &settings))
+        for (int j = i; j < batchEnd; j++)
         {
-            data.push_back(
+            threadPool.start([this, &roms, &results, i, j]()
             {
-                file,
-                type,
-                header,
-                settings
+                RomSearcherThreadResult& result = results[j - i];
+                const std::filesystem::path file = roms.at(j).toStdU32String();
+
+                result = {};
+                result.cached = CoreHasCachedRomHeaderAndSettings(file, result.valid, &result.type, &result.header, &result.defaultSettings, &result.settings);
+                if (!result.cached)
+                {
+                    result.valid = CoreGetRomHeaderAndSettings(file, &result.type, &result.header, &result.defaultSettings, &result.settings);
+                }
+
+                // when the UI already has the file
+                // and it hasn't changed, we don't
+                // have to send it again
+                result.unchanged = result.cached && result.valid && this->files.contains(roms.at(j));
             });
         }
 
+        threadPool.waitForDone();
+
+        for (int j = i; j < batchEnd; j++)
+        {
+            const RomSearcherThreadResult& result = results[j - i];
+            const QString& file = roms.at(j);
+
+            if (!result.cached)
+            {
+                CoreAddCachedRomHeaderAndSettings(file.toStdU32String(), result.valid, result.type, result.header, result.defaultSettings, result.settings);
+            }
+
+            if (result.unchanged)
+            {
+                continue;
+            }
+
+            if (result.valid)
+            {
+                // don't go over the maximum amount of files
+                if (!this->files.contains(file) &&
+                    this->files.size() >= this->maxItems)
+                {
+                    continue;
+                }
+
+                data.push_back(
+                {
+                    file,
+                    result.type,
+                    result.header,
+                    result.settings
+                });
+                this->files.insert(file);
+            }
+            else if (this->files.remove(file))
+            {
+                removedFiles.push_back(file);
+            }
+        }
+
         // we need to give the UI some breathing room,
         // so when 10ms have passed,
         // send our data to the UI and
@@ -118,7 +319,14 @@ void RomSearcherThread::searchDirectory(QString directory)
         // the timer
         if (timer.elapsed() >= 10)
         {
-            emit this->RomsFound(data, (i + 1), romAmount);
+            if (refreshing)
+            {
+                emit this->RomsFound(data, batchEnd, romAmount);
+            }
+            else if (!data.isEmpty())
+            {
+                emit this->RomsChanged(data);
+            }
             data.clear();
             timer.start();
         }
@@ -134,9 +342,115 @@ void RomSearcherThread::searchDirectory(QString directory)
     // send it to the UI before we finish
     if (!data.isEmpty())
     {
-        emit this->RomsFound(data, romAmount, romAmount);
+        if (refreshing)
+        {
+            emit this->RomsFound(data, romAmount, romAmount);
+        }
+        else
+        {
+            emit this->RomsChanged(data);
+        }
+    }
+
+    if (!removedFiles.isEmpty())
+    {
+        emit this->RomsRemoved(removedFiles);
     }
 
-    emit this->Finished(this->stop);
+    // the decompressed 7zip blocks are only
+    // shared during the search, so release them
+    CoreClearArchiveCache();
+}
+
+void RomSearcherThread::watchDirectory(QString directory)
+{
+    std::vector<CoreRomDirectoryEvent> events;
+
+    while (!this->stop)
+    {
+        if (!CoreWaitForRomDirectoryEvents(events, 50))
+        {
+            return;
+        }
+
+        QList<QString> changedFiles;
+        QList<QString> removedFiles;
+        bool rescan = false;
+
+        for (const CoreRomDirectoryEvent& event : events)
+        {
+            QString path = QString::fromStdU32String(event.Path.u32string());
+
+            switch (event.Type)
+            {
+            case CoreRomDirectoryEventType::FileChanged:
+            {
+                if (!changedFiles.contains(path))
+                {
+                    changedFiles.push_back(path);
+                }
+            } break;
+            case CoreRomDirectoryEventType::FileRemoved:
+            {
+                changedFiles.removeAll(path);
+                if (this->files.remove(path))
+                {
+                    removedFiles.push_back(path);
+                }
+            } break;
+            case CoreRomDirectoryEventType::DirectoryRemoved:
+            {
+                const QString prefix = path + "/";
+                changedFiles.removeIf([&prefix](const QString& file)
+                {
+                    return file.startsWith(prefix);
+                });
+                for (auto iter = this->files.begin(); iter != this->files.end();)
+                {
+                    if ((*iter).startsWith(prefix))
+                    {
+                        removedFiles.push_back(*iter);
+                        iter = this->files.erase(iter);
+                    }
+                    else
+                    {
+                        iter++;
+                    }
+                }
+            } break;
+            case CoreRomDirectoryEventType::Rescan:
+            {
+                rescan = true;
+            } break;
+            }
+        }
+
+        if (!removedFiles.isEmpty())
+        {
+            emit this->RomsRemoved(removedFiles);
+        }
+
+        if (rescan)
+        {
+            // restart the watcher because the events
+            // could've been lost due to the watched
+            // directory being removed or moved
+            bool watching = CoreStartRomDirectoryWatcher(directory.toStdU32String(), this->recursive);
+            this->searchDirectory(directory);
+            if (!watching)
+            {
+                return;
+            }
+        }
+        else if (!changedFiles.isEmpty())
+        {
+            this->searchFiles(changedFiles, false);
+        }
+    }
 }
 
+void RomSearcherThread::finishRefresh(void)
+{
+    this->refreshing = false;
+    emit this->Finished(this->stop);
+}
@@ -16,6 +16,7 @@
 
 #include <QString>
 #include <QThread>
+#include <QSet>
 
 struct RomSearcherThreadData
 {
@@ -40,6 +41,9 @@ class RomSearcherThread : public QThread
     void SetMaximumFiles(int);
     void Stop(void);
 
+    bool IsRefreshing(void);
+    bool IsWatching(void);
+
     void run(void) override;
 
   private:
@@ -47,11 +51,22 @@ class RomSearcherThread : public QThread
     bool recursive = false;
     int  maxItems = 0;
     bool stop = false;
+    bool refreshing = false;
+
+    // files which have been sent to the UI
+    QSet<QString> files;
 
+    bool searchCachedDirectory(QString);
     void searchDirectory(QString);
+    void searchFiles(QList<QString> roms, bool refreshing);
+    void watchDirectory(QString);
+
+    void finishRefresh(void);
 
   signals:
     void RomsFound(QList<RomSearcherThreadData> data, int index, int count);
+    void RomsChanged(QList<RomSearcherThreadData> data);
+    void RomsRemoved(QList<QString> files);
     void Finished(bool canceled);
 };
 } // namespace Thread
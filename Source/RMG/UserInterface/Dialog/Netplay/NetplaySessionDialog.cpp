@@ -19,6 +19,7 @@
 #include <QJsonObject>
 #include <QJsonArray>
 
+#include <RMG-Core/Netplay.hpp>
 #include <RMG-Core/Error.hpp>
 #include <RMG-Core/Rom.hpp>
 
@@ -73,6 +74,12 @@ NetplaySessionDialog::NetplaySessionDialog(QWidget *parent, QWebSocket* webSocke
     cheatsButton->setIcon(QIcon::fromTheme("code-box-line"));
 
     this->updateCheatsTreeWidget();
+
+    // the statistics are shown once the game runs
+    this->statsLabel->setVisible(false);
+    this->statsTimer = new QTimer(this);
+    this->statsTimer->setInterval(1000);
+    connect(this->statsTimer, &QTimer::timeout, this, &NetplaySessionDialog::updateStatsLabel);
 }
 
 NetplaySessionDialog::~NetplaySessionDialog(void)
@@ -83,6 +90,11 @@ NetplaySessionDialog::~NetplaySessionDialog(void)
     }
 }
 
+void NetplaySessionDialog::StopStatistics(void)
+{
+    this->statsTimer->stop();
+}
+
 bool NetplaySessionDialog::getCheats(std::vector<CoreCheat>& cheats, QJsonArray& cheatsArray)
 {
     QJsonObject session  = this->sessionJson;
@@ -141,6 +153,25 @@ void NetplaySessionDialog::updateCheatsTreeWidget(void)
     CheatsCommon::AddCheatsToTreeWidget(true, cheatsArray, this->sessionFile, cheats, this->cheatsTreeWidget, true);    
 }
 
+void NetplaySessionDialog::updateStatsLabel(void)
+{
+    CoreNetplayStats stats;
+
+    if (!CoreHasInitNetplay() || !CoreGetNetplayStats(stats))
+    {
+        return;
+    }
+
+    QString text;
+    text = QString("Stalls: %1 (%2 ms)").arg(stats.Stalls).arg(stats.StallTime);
+    text += QString(" | Fast-forwarded VIs: %1/%2").arg(stats.FastForwardVIs).arg(stats.VIs);
+    text += QString(" | Rollbacks: %1 (last %2, max %3)").arg(stats.Rollbacks).arg(stats.LastDepth).arg(stats.MaxDepth);
+    text += QString(" | Desyncs: %1").arg(stats.Desyncs);
+
+    this->statsLabel->setText(text);
+    this->statsLabel->setVisible(true);
+}
+
 void NetplaySessionDialog::on_webSocket_textMessageReceived(const QString& message)
 {
     QJsonDocument jsonDocument = QJsonDocument::fromJson(message.toUtf8());
@@ -192,6 +223,7 @@ void NetplaySessionDialog::on_webSocket_textMessageReceived(const QString& messa
         {
             this->started = true;
             this->applyCheats();
+            this->statsTimer->start();
             emit OnPlayGame(this->sessionFile, this->webSocket->peerAddress().toString(), this->sessionPort, this->sessionNumber);
         }
         else
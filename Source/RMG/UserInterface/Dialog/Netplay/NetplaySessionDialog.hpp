@@ -14,6 +14,7 @@
 #include <QWebSocket>
 #include <QDialog>
 #include <QString>
+#include <QTimer>
 
 #include <RMG-Core/Cheats.hpp>
 
@@ -31,6 +32,10 @@ class NetplaySessionDialog : public QDialog, private Ui::NetplaySessionDialog
     NetplaySessionDialog(QWidget *parent, QWebSocket* webSocket, QJsonObject json, QString sessionFile);
     ~NetplaySessionDialog(void);
 
+    // stops updating the statistics,
+    // must be called when emulation stops
+    void StopStatistics(void);
+
   private:
     QString sessionFile;
     QString nickName;
@@ -41,10 +46,12 @@ class NetplaySessionDialog : public QDialog, private Ui::NetplaySessionDialog
     bool started = false;
 
   	QWebSocket* webSocket;
+    QTimer* statsTimer;
 
     bool getCheats(std::vector<CoreCheat>& cheats, QJsonArray& cheatsArray);
     bool applyCheats(void);
     void updateCheatsTreeWidget(void);
+    void updateStatsLabel(void);
 
   private slots:
   	void on_webSocket_textMessageReceived(const QString& message);
@@ -290,6 +290,9 @@ void SettingsDialog::loadCoreSettings(void)
     const int saveFilenameFormat = CoreSettingsGetIntValue(SettingsID::CoreOverLay_SaveFileNameFormat);
     int siDmaDuration = CoreSettingsGetIntValue(SettingsID::CoreOverlay_SiDmaDuration);
     const bool randomizeInterrupt = CoreSettingsGetBoolValue(SettingsID::CoreOverlay_RandomizeInterrupt);
+    const bool rewind = CoreSettingsGetBoolValue(SettingsID::Core_Rewind_Enabled);
+    const bool fastSaveStates = CoreSettingsGetBoolValue(SettingsID::Core_FastSaveStates);
+    const bool paceToHostRefreshRate = CoreSettingsGetBoolValue(SettingsID::Core_PaceToHostRefreshRate);
     const bool usePIFROM = CoreSettingsGetBoolValue(SettingsID::Core_PIF_Use);
     const QString ntscPifROM = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::Core_PIF_NTSC));
     const QString palPifRom = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::Core_PIF_PAL));
@@ -299,6 +302,9 @@ void SettingsDialog::loadCoreSettings(void)
     this->coreVideoCaptureBackendComboBox->setCurrentIndex(videoCaptureBackend == "sdl3" ? 1 : 0);
     this->coreSaveFilenameFormatComboBox->setCurrentIndex(saveFilenameFormat);
     this->coreRandomizeTimingCheckBox->setChecked(randomizeInterrupt);
+    this->coreRewindCheckBox->setChecked(rewind);
+    this->coreFastSaveStatesCheckBox->setChecked(fastSaveStates);
+    this->corePaceToHostRefreshRateCheckBox->setChecked(paceToHostRefreshRate);
 
     this->usePifRomGroupBox->setChecked(usePIFROM);
     this->ntscPifRomLineEdit->setText(ntscPifROM);
@@ -534,6 +540,7 @@ void SettingsDialog::loadInterfaceNetplaySettings(void)
     this->netplayNicknameLineEdit->setText(QString::fromStdString(CoreSettingsGetStringValue(SettingsID::Netplay_Nickname)));
     this->netplayServerUrlLineEdit->setText(QString::fromStdString(CoreSettingsGetStringValue(SettingsID::Netplay_ServerJsonUrl)));
     this->netplayDispatcherUrlLineEdit->setText(QString::fromStdString(CoreSettingsGetStringValue(SettingsID::Netplay_DispatcherUrl)));
+    this->netplayRollbackFramesSpinBox->setValue(CoreSettingsGetIntValue(SettingsID::Netplay_RollbackFrames));
 }
 
 void SettingsDialog::loadDefaultCoreSettings(void)
@@ -545,6 +552,9 @@ void SettingsDialog::loadDefaultCoreSettings(void)
     int siDmaDuration = CoreSettingsGetDefaultIntValue(SettingsID::CoreOverlay_SiDmaDuration);
     const int saveFilenameFormat = CoreSettingsGetDefaultIntValue(SettingsID::CoreOverLay_SaveFileNameFormat);
     const bool randomizeInterrupt = CoreSettingsGetDefaultBoolValue(SettingsID::CoreOverlay_RandomizeInterrupt);
+    const bool rewind = CoreSettingsGetDefaultBoolValue(SettingsID::Core_Rewind_Enabled);
+    const bool fastSaveStates = CoreSettingsGetDefaultBoolValue(SettingsID::Core_FastSaveStates);
+    const bool paceToHostRefreshRate = CoreSettingsGetDefaultBoolValue(SettingsID::Core_PaceToHostRefreshRate);
     const bool usePIFROM = CoreSettingsGetDefaultBoolValue(SettingsID::Core_PIF_Use);
     const QString ntscPifROM = QString::fromStdString(CoreSettingsGetDefaultStringValue(SettingsID::Core_PIF_NTSC));
     const QString palPifRom = QString::fromStdString(CoreSettingsGetDefaultStringValue(SettingsID::Core_PIF_PAL));
@@ -554,6 +564,9 @@ void SettingsDialog::loadDefaultCoreSettings(void)
     this->coreVideoCaptureBackendComboBox->setCurrentIndex(videoCaptureBackend == "sdl3" ? 1 : 0);
     this->coreSaveFilenameFormatComboBox->setCurrentIndex(saveFilenameFormat);
     this->coreRandomizeTimingCheckBox->setChecked(randomizeInterrupt);
+    this->coreRewindCheckBox->setChecked(rewind);
+    this->coreFastSaveStatesCheckBox->setChecked(fastSaveStates);
+    this->corePaceToHostRefreshRateCheckBox->setChecked(paceToHostRefreshRate);
 
     this->usePifRomGroupBox->setChecked(usePIFROM);
     this->ntscPifRomLineEdit->setText(ntscPifROM);
@@ -689,10 +702,13 @@ void SettingsDialog::loadDefaultInterfaceNetplaySettings(void)
     this->netplayNicknameLineEdit->setText(QString::fromStdString(CoreSettingsGetDefaultStringValue(SettingsID::Netplay_Nickname)));
     this->netplayServerUrlLineEdit->setText(QString::fromStdString(CoreSettingsGetDefaultStringValue(SettingsID::Netplay_ServerJsonUrl)));
     this->netplayDispatcherUrlLineEdit->setText(QString::fromStdString(CoreSettingsGetDefaultStringValue(SettingsID::Netplay_DispatcherUrl)));
+    this->netplayRollbackFramesSpinBox->setValue(CoreSettingsGetDefaultIntValue(SettingsID::Netplay_RollbackFrames));
 }
 
 void SettingsDialog::saveSettings(void)
 {
+    CoreSettingsBeginTransaction();
+
     this->saveCoreSettings();
     if (this->showGameSettings)
     {
@@ -713,6 +729,8 @@ void SettingsDialog::saveSettings(void)
     this->saveInterfaceOSDSettings();
     this->saveInterfaceNetplaySettings();
     CoreSettingsSave();
+
+    CoreSettingsCommitTransaction();
 }
 
 void SettingsDialog::saveCoreSettings(void)
@@ -724,6 +742,9 @@ void SettingsDialog::saveCoreSettings(void)
     const int saveFilenameFormat = this->coreSaveFilenameFormatComboBox->currentIndex();
     int siDmaDuration = this->coreSiDmaDurationSpinBox->value();
     const bool randomizeInterrupt = this->coreRandomizeTimingCheckBox->isChecked();
+    const bool rewind = this->coreRewindCheckBox->isChecked();
+    const bool fastSaveStates = this->coreFastSaveStatesCheckBox->isChecked();
+    const bool paceToHostRefreshRate = this->corePaceToHostRefreshRateCheckBox->isChecked();
     const bool usePIF = this->usePifRomGroupBox->isChecked();
     const QString ntscPifROM = this->ntscPifRomLineEdit->text();
     const QString palPifROM = this->palPifRomLineEdit->text();
@@ -733,6 +754,9 @@ void SettingsDialog::saveCoreSettings(void)
     CoreSettingsSetValue(SettingsID::CoreOverlay_GbCameraVideoCaptureBackend1, std::string((videoCaptureBackend == 1) ? "sdl3" : ""));
     CoreSettingsSetValue(SettingsID::CoreOverLay_SaveFileNameFormat, saveFilenameFormat);
     CoreSettingsSetValue(SettingsID::CoreOverlay_RandomizeInterrupt, randomizeInterrupt);
+    CoreSettingsSetValue(SettingsID::Core_Rewind_Enabled, rewind);
+    CoreSettingsSetValue(SettingsID::Core_FastSaveStates, fastSaveStates);
+    CoreSettingsSetValue(SettingsID::Core_PaceToHostRefreshRate, paceToHostRefreshRate);
     CoreSettingsSetValue(SettingsID::Core_PIF_Use, usePIF);
     CoreSettingsSetValue(SettingsID::Core_PIF_NTSC, ntscPifROM.toStdString());
     CoreSettingsSetValue(SettingsID::Core_PIF_PAL, palPifROM.toStdString());
@@ -928,6 +952,7 @@ void SettingsDialog::saveInterfaceNetplaySettings(void)
     CoreSettingsSetValue(SettingsID::Netplay_Nickname, this->netplayNicknameLineEdit->text().toStdString());
     CoreSettingsSetValue(SettingsID::Netplay_ServerJsonUrl, this->netplayServerUrlLineEdit->text().toStdString());
     CoreSettingsSetValue(SettingsID::Netplay_DispatcherUrl, this->netplayDispatcherUrlLineEdit->text().toStdString());
+    CoreSettingsSetValue(SettingsID::Netplay_RollbackFrames, this->netplayRollbackFramesSpinBox->value());
 }
 
 void SettingsDialog::commonHotkeySettings(SettingsDialogAction action)
@@ -955,6 +980,7 @@ void SettingsDialog::commonHotkeySettings(SettingsDialogAction action)
         { this->saveStateKeyButton, SettingsID::KeyBinding_SaveState },
         { this->saveAsKeyButton, SettingsID::KeyBinding_SaveAs },
         { this->loadStateKeyButton, SettingsID::KeyBinding_LoadState },
+        { this->rewindKeyButton, SettingsID::KeyBinding_Rewind },
         { this->loadKeyButton, SettingsID::KeyBinding_Load },
         { this->cheatsKeyButton, SettingsID::KeyBinding_Cheats },
         { this->gsButtonKeyButton, SettingsID::KeyBinding_GSButton },
@@ -1493,6 +1519,7 @@ void SettingsDialog::on_KeybindButton_KeybindingChanged(KeybindButton* button)
         this->saveStateKeyButton,
         this->saveAsKeyButton, 
         this->loadStateKeyButton,
+        this->rewindKeyButton,
         this->loadKeyButton,
         this->cheatsKeyButton, 
         this->gsButtonKeyButton,
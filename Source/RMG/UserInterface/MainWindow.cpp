@@ -48,6 +48,7 @@
 #include <QMimeData>
 #include <QSettings>
 #include <QStatusBar>
+#include <QScreen>
 #include <QMenuBar>
 #include <QString>
 #include <QTimer>
@@ -66,6 +67,7 @@
 #include <RMG-Core/Directories.hpp>
 #include <RMG-Core/SpeedFactor.hpp>
 #include <RMG-Core/Screenshot.hpp>
+#include <RMG-Core/Rewind.hpp>
 #include <RMG-Core/Emulation.hpp>
 #include <RMG-Core/SaveState.hpp>
 #include <RMG-Core/Settings.hpp>
@@ -762,7 +764,13 @@ void MainWindow::launchEmulationThread(QString cartRom, QString diskRom, bool re
         }
     }
 
-    this->ui_RefreshRomListAfterEmulation = refreshRomListAfterEmulation || this->ui_Widget_RomBrowser->IsRefreshingRomList();
+    // stop watching the ROM directory as well, because
+    // retrieving the header and settings of disks requires
+    // the core, the ROM list is quickly restored from the
+    // cache after emulation has finished
+    this->ui_RefreshRomListAfterEmulation = refreshRomListAfterEmulation ||
+                                            this->ui_Widget_RomBrowser->IsRefreshingRomList() ||
+                                            this->ui_Widget_RomBrowser->IsWatchingRomList();
     if (this->ui_RefreshRomListAfterEmulation)
     {
         this->ui_Widget_RomBrowser->StopRefreshRomList();
@@ -851,6 +859,9 @@ void MainWindow::updateActions(bool inEmulation, bool isPaused)
     keyBinding = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::KeyBinding_Load));
     this->action_System_Load->setEnabled(inEmulation && !CoreHasInitNetplay());
     this->action_System_Load->setShortcut(QKeySequence(keyBinding));
+    keyBinding = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::KeyBinding_Rewind));
+    this->action_System_Rewind->setEnabled(inEmulation && !CoreHasInitNetplay());
+    this->action_System_Rewind->setShortcut(QKeySequence(keyBinding));
     this->menuCurrent_Save_State->setEnabled(inEmulation);
     keyBinding = QString::fromStdString(CoreSettingsGetStringValue(SettingsID::KeyBinding_Cheats));
     this->action_System_Cheats->setEnabled(inEmulation && !CoreHasInitNetplay());
@@ -1115,6 +1126,7 @@ void MainWindow::configureActions(void)
         this->actionSpeed250, this->actionSpeed275, this->actionSpeed300,
         this->action_System_SaveState, this->action_System_SaveAs,
         this->action_System_LoadState, this->action_System_Load,
+        this->action_System_Rewind,
         this->actionSlot_0, this->actionSlot_1, this->actionSlot_2,
         this->actionSlot_3, this->actionSlot_4, this->actionSlot_5,
         this->actionSlot_6, this->actionSlot_7, this->actionSlot_8,
@@ -1239,6 +1251,7 @@ void MainWindow::connectActionSignals(void)
     connect(this->action_System_SaveAs, &QAction::triggered, this, &MainWindow::on_Action_System_SaveAs);
     connect(this->action_System_LoadState, &QAction::triggered, this, &MainWindow::on_Action_System_LoadState);
     connect(this->action_System_Load, &QAction::triggered, this, &MainWindow::on_Action_System_Load);
+    connect(this->action_System_Rewind, &QAction::triggered, this, &MainWindow::on_Action_System_Rewind);
     connect(this->action_System_Cheats, &QAction::triggered, this, &MainWindow::on_Action_System_Cheats);
     connect(this->action_System_GSButton, &QAction::triggered, this, &MainWindow::on_Action_System_GSButton);
 
@@ -1880,6 +1893,20 @@ void MainWindow::on_Action_System_Load(void)
     }
 }
 
+void MainWindow::on_Action_System_Rewind(void)
+{
+    // the rewind hotkey is usually held down,
+    // so don't show a message box when it fails
+    if (!CoreRewindIsInitialized())
+    {
+        OnScreenDisplaySetMessage("Rewind is disabled, enable it in the settings and restart the game");
+    }
+    else if (!CoreRewindStepBack())
+    {
+        OnScreenDisplaySetMessage(CoreGetError());
+    }
+}
+
 void MainWindow::on_Action_System_CurrentSaveState(int slot)
 {
     if (!CoreSetSaveStateSlot(slot))
@@ -2137,6 +2164,14 @@ void MainWindow::on_Emulation_Started(void)
 
     this->ui_MessageBoxList.clear();
     this->ui_DebugCallbackErrors.clear();
+
+    // let the speed limiter pace to the display when enabled
+    int refreshRate = 0;
+    if (CoreSettingsGetBoolValue(SettingsID::Core_PaceToHostRefreshRate) && this->screen() != nullptr)
+    {
+        refreshRate = static_cast<int>(this->screen()->refreshRate() * 1000);
+    }
+    CoreSetSpeedLimiterHostRefreshRate(refreshRate);
 }
 
 void MainWindow::on_Emulation_Finished(bool ret, QString error)
@@ -2151,6 +2186,7 @@ void MainWindow::on_Emulation_Finished(bool ret, QString error)
 #ifdef NETPLAY
     if (this->netplaySessionDialog != nullptr)
     {
+        this->netplaySessionDialog->StopStatistics();
         this->netplaySessionDialog->deleteLater();
         this->netplaySessionDialog = nullptr;
     }
@@ -2734,6 +2770,13 @@ void MainWindow::on_Core_StateCallback(CoreStateCallbackType type, int value)
             {
                 OnScreenDisplayResume();
             }
+#ifdef NETPLAY
+            else if (value == (int)CoreEmulationState::Stopped &&
+                     this->netplaySessionDialog != nullptr)
+            {
+                this->netplaySessionDialog->StopStatistics();
+            }
+#endif // NETPLAY
         } break;
         case CoreStateCallbackType::SaveStateSlot:
         {
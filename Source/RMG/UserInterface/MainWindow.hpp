@@ -194,6 +194,7 @@ class MainWindow : public QMainWindow, private Ui::MainWindow
     void on_Action_System_SaveAs(void);
     void on_Action_System_LoadState(void);
     void on_Action_System_Load(void);
+    void on_Action_System_Rewind(void);
     void on_Action_System_CurrentSaveState(int slot);
     void on_Action_System_Cheats(void);
     void on_Action_System_GSButton(void);
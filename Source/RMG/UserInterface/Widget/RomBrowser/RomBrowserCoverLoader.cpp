@@ -0,0 +1,340 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "RomBrowserCoverLoader.hpp"
+
+#include <RMG-Core/Directories.hpp>
+
+#include <QCryptographicHash>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QThread>
+#include <QFile>
+#include <QDir>
+
+#include <algorithm>
+
+using namespace UserInterface::Widget;
+
+//
+// Local Defines
+//
+
+// maximum size of the loaded covers in KiB
+#define COVER_CACHE_MAX_COST 131072 /* 128 MiB */
+// maximum amount of requests which haven't been processed,
+// the oldest requests are dropped first because those
+// covers most likely aren't visible anymore
+#define COVER_REQUEST_MAX 256
+// thumbnail sizes are rounded up to a multiple of this,
+// this prevents creating new thumbnails for every zoom step
+#define COVER_THUMBNAIL_SIZE_STEP 64
+
+//
+// Exported Functions
+//
+
+RomBrowserCoverLoader::RomBrowserCoverLoader(QObject* parent) : QObject(parent)
+{
+    this->covers.setMaxCost(COVER_CACHE_MAX_COST);
+    this->fallbackIcon = QIcon(QPixmap(":Resource/CoverFallback.png"));
+
+    this->thumbnailDirectory = QString::fromStdU32String(CoreGetUserCacheDirectory().u32string());
+    this->thumbnailDirectory += CORE_DIR_SEPERATOR_STR;
+    this->thumbnailDirectory += "CoverThumbnails";
+
+    // leave some threads for the ROM searcher
+    this->threadPool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() / 2));
+}
+
+RomBrowserCoverLoader::~RomBrowserCoverLoader(void)
+{
+    this->Clear();
+    this->threadPool.waitForDone();
+}
+
+void RomBrowserCoverLoader::SetCoversDirectory(QString directory)
+{
+    if (this->coversDirectory == directory)
+    {
+        return;
+    }
+
+    this->coversDirectory = directory;
+    this->Clear();
+}
+
+void RomBrowserCoverLoader::SetIconSize(QSize size, qreal devicePixelRatio)
+{
+    QSize thumbnailSize;
+
+    thumbnailSize = size * devicePixelRatio;
+    thumbnailSize.setWidth(((thumbnailSize.width() + COVER_THUMBNAIL_SIZE_STEP - 1) / COVER_THUMBNAIL_SIZE_STEP) * COVER_THUMBNAIL_SIZE_STEP);
+    thumbnailSize.setHeight(((thumbnailSize.height() + COVER_THUMBNAIL_SIZE_STEP - 1) / COVER_THUMBNAIL_SIZE_STEP) * COVER_THUMBNAIL_SIZE_STEP);
+
+    if (this->thumbnailSize == thumbnailSize)
+    {
+        return;
+    }
+
+    this->thumbnailSize = thumbnailSize;
+    this->Clear();
+}
+
+void RomBrowserCoverLoader::Clear(void)
+{
+    // increase the generation so we'll ignore
+    // the results of requests which are
+    // still being processed
+    this->generation++;
+
+    this->covers.clear();
+    this->noCovers.clear();
+    this->requestedCovers.clear();
+
+    QMutexLocker locker(&this->requestMutex);
+    this->requests.clear();
+}
+
+void RomBrowserCoverLoader::Remove(QString file)
+{
+    this->covers.remove(file);
+    this->noCovers.remove(file);
+    this->requestedCovers.remove(file);
+}
+
+QIcon RomBrowserCoverLoader::GetCover(const RomBrowserModelData& data)
+{
+    QIcon* icon = this->covers.object(data.file);
+    if (icon != nullptr)
+    {
+        return *icon;
+    }
+
+    if (this->coversDirectory.isEmpty() ||
+        this->noCovers.contains(data.file) ||
+        this->requestedCovers.contains(data.file))
+    {
+        return this->fallbackIcon;
+    }
+
+    RomBrowserCoverRequest droppedRequest;
+    bool hasDroppedRequest = false;
+
+    {
+        QMutexLocker locker(&this->requestMutex);
+
+        this->requests.push_back(
+        {
+            data,
+            this->coversDirectory,
+            this->thumbnailDirectory,
+            this->thumbnailSize,
+            this->generation
+        });
+
+        if (this->requests.size() > COVER_REQUEST_MAX)
+        {
+            droppedRequest    = this->requests.takeFirst();
+            hasDroppedRequest = true;
+        }
+    }
+
+    // allow the dropped request
+    // to be requested again
+    if (hasDroppedRequest)
+    {
+        this->requestedCovers.remove(droppedRequest.data.file);
+    }
+
+    this->requestedCovers.insert(data.file);
+    this->threadPool.start([this]()
+    {
+        this->processRequest();
+    });
+
+    return this->fallbackIcon;
+}
+
+QIcon RomBrowserCoverLoader::GetFallbackCover(void)
+{
+    return this->fallbackIcon;
+}
+
+QString RomBrowserCoverLoader::FindCoverFile(QString coversDirectory, const RomBrowserModelData& data)
+{
+    // construct basename of file,
+    // by retrieving the last index of '.'
+    // and removing all characters from that index
+    // until the end of the string
+    QString baseName         = QFileInfo(data.file).fileName();
+    qsizetype lastIndexOfDot = baseName.lastIndexOf(".");
+    if (lastIndexOfDot != -1)
+    { // only remove when index was found
+        baseName.remove(lastIndexOfDot, baseName.size() - lastIndexOfDot);
+    }
+
+    // try to find cover using
+    // 1) basename of file
+    // 2) MD5
+    // 3) good name
+    // 4) internal name
+    for (QString name : { 
+        baseName,
+        QString::fromStdString(data.settings.MD5), 
+        QString::fromStdString(data.settings.GoodName), 
+        QString::fromStdString(data.header.Name) })
+    {
+        // fixup file name
+        QString fixedName = name;
+        for (const QChar c : QString(":<>\"/\\|?*"))
+        {
+            fixedName.replace(c, "_");
+        }
+
+        // skip empty names,
+        // this can i.e happen
+        // when ROMs don't have 
+        // an internal ROM name
+        if (fixedName.isEmpty())
+        {
+            continue;
+        }
+
+        // we support jpg & png as file extensions
+        for (QString ext : { ".png", ".jpg", ".jpeg" })
+        {
+            QString coverPath = coversDirectory;
+            coverPath += CORE_DIR_SEPERATOR_STR;
+            coverPath += fixedName;
+            coverPath += ext;
+
+            if (QFile::exists(coverPath))
+            {
+                return coverPath;
+            }
+        }
+    }
+
+    return QString();
+}
+
+void RomBrowserCoverLoader::processRequest(void)
+{
+    RomBrowserCoverRequest request;
+
+    // process the newest request first,
+    // because that cover is most likely
+    // still visible
+    {
+        QMutexLocker locker(&this->requestMutex);
+        if (this->requests.isEmpty())
+        {
+            return;
+        }
+
+        request = this->requests.takeLast();
+    }
+
+    QImage image;
+    bool found = loadCover(request, image);
+
+    QMetaObject::invokeMethod(this, [this, request, image, found]()
+    {
+        this->on_CoverLoaded(request.data.file, request.generation, image, found);
+    }, Qt::QueuedConnection);
+}
+
+bool RomBrowserCoverLoader::loadCover(const RomBrowserCoverRequest& request, QImage& image)
+{
+    QString coverFile = FindCoverFile(request.coversDirectory, request.data);
+    if (coverFile.isEmpty())
+    {
+        return false;
+    }
+
+    // thumbnails are named after the hash of the cover file name,
+    // its modification time, its size and the thumbnail size,
+    // so changed covers will get a new thumbnail
+    QFileInfo coverFileInfo(coverFile);
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(coverFile.toUtf8());
+    hash.addData(QByteArray::number(coverFileInfo.lastModified().toMSecsSinceEpoch()));
+    hash.addData(QByteArray::number(coverFileInfo.size()));
+    hash.addData(QByteArray::number(request.thumbnailSize.width()));
+    hash.addData(QByteArray::number(request.thumbnailSize.height()));
+
+    QString thumbnailFile = request.thumbnailDirectory;
+    thumbnailFile += CORE_DIR_SEPERATOR_STR;
+    thumbnailFile += QString::fromLatin1(hash.result().toHex());
+    thumbnailFile += ".png";
+
+    if (image.load(thumbnailFile))
+    {
+        return true;
+    }
+
+    // only decode the cover at the thumbnail size,
+    // this is a lot faster for large jpg files
+    QImageReader reader(coverFile);
+    QSize coverSize = reader.size();
+    if (coverSize.isValid() && !request.thumbnailSize.isEmpty() &&
+        (coverSize.width() > request.thumbnailSize.width() || 
+         coverSize.height() > request.thumbnailSize.height()))
+    {
+        reader.setScaledSize(coverSize.scaled(request.thumbnailSize, Qt::KeepAspectRatio));
+    }
+
+    if (!reader.read(&image))
+    {
+        return false;
+    }
+
+    // save the thumbnail, failing to do so
+    // isn't fatal, we'll just create it again
+    // next time
+    if (QDir().mkpath(request.thumbnailDirectory))
+    {
+        QSaveFile saveFile(thumbnailFile);
+        if (saveFile.open(QIODevice::WriteOnly) &&
+            image.save(&saveFile, "PNG"))
+        {
+            saveFile.commit();
+        }
+    }
+
+    return true;
+}
+
+void RomBrowserCoverLoader::on_CoverLoaded(QString file, int generation, QImage image, bool found)
+{
+    // ignore results from before the
+    // loader was cleared or the cover
+    // was removed
+    if (generation != this->generation ||
+        !this->requestedCovers.remove(file))
+    {
+        return;
+    }
+
+    if (found)
+    {
+        this->covers.insert(file, new QIcon(QPixmap::fromImage(image)), 
+                            std::max<qsizetype>(1, image.sizeInBytes() / 1024));
+    }
+    else
+    {
+        this->noCovers.insert(file);
+    }
+
+    emit this->CoverLoaded(file);
+}
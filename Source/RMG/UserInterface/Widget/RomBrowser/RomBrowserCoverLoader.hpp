@@ -0,0 +1,105 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ROMBROWSERCOVERLOADER_HPP
+#define ROMBROWSERCOVERLOADER_HPP
+
+#include "RomBrowserModelData.hpp"
+
+#include <QThreadPool>
+#include <QPixmap>
+#include <QObject>
+#include <QCache>
+#include <QMutex>
+#include <QImage>
+#include <QIcon>
+#include <QList>
+#include <QSize>
+#include <QSet>
+
+namespace UserInterface
+{
+namespace Widget
+{
+struct RomBrowserCoverRequest
+{
+    RomBrowserModelData data;
+    QString coversDirectory;
+    QString thumbnailDirectory;
+    QSize   thumbnailSize;
+    int     generation;
+};
+
+class RomBrowserCoverLoader : public QObject
+{
+    Q_OBJECT
+
+  public:
+    RomBrowserCoverLoader(QObject* parent);
+    ~RomBrowserCoverLoader(void);
+
+    void SetCoversDirectory(QString directory);
+    void SetIconSize(QSize size, qreal devicePixelRatio);
+
+    // clears all loaded covers and cancels
+    // all requests which haven't been processed yet
+    void Clear(void);
+
+    // removes the loaded cover of given file
+    void Remove(QString file);
+
+    // returns the loaded cover for the given data,
+    // when it hasn't been loaded yet, a request to
+    // load it is made and the fallback is returned
+    QIcon GetCover(const RomBrowserModelData& data);
+
+    // returns the cover used when there's no cover
+    QIcon GetFallbackCover(void);
+
+    // returns the cover file for the given data,
+    // returns an empty string when there isn't one
+    static QString FindCoverFile(QString coversDirectory, const RomBrowserModelData& data);
+
+  private:
+    QThreadPool threadPool;
+
+    QString coversDirectory;
+    QString thumbnailDirectory;
+    QSize   thumbnailSize;
+    int     generation = 0;
+
+    QIcon fallbackIcon;
+
+    // loaded covers, the cost of
+    // each cover is its size in KiB
+    QCache<QString, QIcon> covers;
+    // files without a cover
+    QSet<QString> noCovers;
+    // requested files
+    QSet<QString> requestedCovers;
+
+    // requests which haven't been
+    // picked up by a worker thread
+    QMutex requestMutex;
+    QList<RomBrowserCoverRequest> requests;
+
+    void processRequest(void);
+
+    static bool loadCover(const RomBrowserCoverRequest& request, QImage& image);
+
+  private slots:
+    void on_CoverLoaded(QString file, int generation, QImage image, bool found);
+
+  signals:
+    void CoverLoaded(QString file);
+};
+} // namespace Widget
+} // namespace UserInterface
+
+#endif // ROMBROWSERCOVERLOADER_HPP
@@ -0,0 +1,48 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "RomBrowserGridViewDelegate.hpp"
+
+using namespace UserInterface::Widget;
+
+RomBrowserGridViewDelegate::RomBrowserGridViewDelegate(QWidget* parent, RomBrowserCoverLoader* coverLoader) : QStyledItemDelegate(parent)
+{
+    this->coverLoader = coverLoader;
+}
+
+RomBrowserGridViewDelegate::~RomBrowserGridViewDelegate(void)
+{
+}
+
+void RomBrowserGridViewDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    // only request covers when an item is painted,
+    // that way we only load covers of visible items
+    this->painting = true;
+    QStyledItemDelegate::paint(painter, option, index);
+    this->painting = false;
+}
+
+void RomBrowserGridViewDelegate::initStyleOption(QStyleOptionViewItem* option, const QModelIndex& index) const
+{
+    QStyledItemDelegate::initStyleOption(option, index);
+
+    if (this->painting)
+    {
+        RomBrowserModelData data = index.data(Qt::UserRole + 1).value<RomBrowserModelData>();
+        option->icon = this->coverLoader->GetCover(data);
+    }
+    else
+    { // the icon size is fixed, so the fallback
+      // can be used to calculate the size hint
+        option->icon = this->coverLoader->GetFallbackCover();
+    }
+
+    option->features |= QStyleOptionViewItem::HasDecoration;
+}
@@ -0,0 +1,38 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ROMBROWSERGRIDVIEWDELEGATE_HPP
+#define ROMBROWSERGRIDVIEWDELEGATE_HPP
+
+#include "RomBrowserCoverLoader.hpp"
+
+#include <QStyledItemDelegate>
+
+namespace UserInterface
+{
+namespace Widget
+{
+class RomBrowserGridViewDelegate : public QStyledItemDelegate
+{
+  public:
+    RomBrowserGridViewDelegate(QWidget* parent, RomBrowserCoverLoader* coverLoader);
+    ~RomBrowserGridViewDelegate(void);
+
+  protected:
+    void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    void initStyleOption(QStyleOptionViewItem* option, const QModelIndex& index) const override;
+
+  private:
+    RomBrowserCoverLoader* coverLoader = nullptr;
+    mutable bool painting = false;
+};
+} // namespace Widget
+} // namespace UserInterface
+
+#endif // ROMBROWSERGRIDVIEWDELEGATE_HPP
@@ -0,0 +1,563 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "RomBrowserModel.hpp"
+
+#include <QFileInfo>
+
+#include <algorithm>
+#include <numeric>
+
+using namespace UserInterface::Widget;
+
+//
+// Local Defines
+//
+
+#define COLUMN_INDEX(column) static_cast<int>(RomBrowserColumn::column)
+
+//
+// Local Functions
+//
+
+static bool has_wildcards(const QString& text)
+{
+    return text.contains('*') || text.contains('?') || text.contains('[');
+}
+
+//
+// Exported Functions
+//
+
+RomBrowserModel::RomBrowserModel(QObject* parent) : QAbstractTableModel(parent)
+{
+    this->columnLabels << "Name";
+    this->columnLabels << "Internal Name";
+    this->columnLabels << "MD5";
+    this->columnLabels << "Format";
+    this->columnLabels << "File Name";
+    this->columnLabels << "File Ext.";
+    this->columnLabels << "File Size";
+    this->columnLabels << "I.D.";
+    this->columnLabels << "Region";
+
+    this->filterThreadPool.setMaxThreadCount(1);
+}
+
+RomBrowserModel::~RomBrowserModel(void)
+{
+    this->filterGeneration++;
+    this->filterThreadPool.waitForDone();
+}
+
+int RomBrowserModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+
+    return static_cast<int>(this->rows.size());
+}
+
+int RomBrowserModel::columnCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+
+    return COLUMN_INDEX(Count);
+}
+
+QVariant RomBrowserModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() ||
+        index.row() >= static_cast<int>(this->rows.size()) ||
+        index.column() >= COLUMN_INDEX(Count))
+    {
+        return QVariant();
+    }
+
+    const int romDataIndex = this->rows[index.row()];
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        return this->columnText[index.column()][romDataIndex];
+    case Qt::UserRole + 1:
+        return QVariant::fromValue<RomBrowserModelData>(this->romData[romDataIndex]);
+    default:
+        return QVariant();
+    }
+}
+
+QVariant RomBrowserModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal ||
+        role != Qt::DisplayRole ||
+        section < 0 || section >= this->columnLabels.size())
+    {
+        return QVariant();
+    }
+
+    return this->columnLabels.at(section);
+}
+
+void RomBrowserModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0 || column >= COLUMN_INDEX(Count))
+    {
+        return;
+    }
+
+    emit this->layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    // keep track of the ROM data of the persistent
+    // indexes, so we can update them afterwards
+    const QModelIndexList persistentIndexes = this->persistentIndexList();
+    std::vector<int> persistentRomDataIndices;
+    persistentRomDataIndices.reserve(persistentIndexes.size());
+    for (const QModelIndex& index : persistentIndexes)
+    {
+        persistentRomDataIndices.push_back(this->rows[index.row()]);
+    }
+
+    this->sorted     = true;
+    this->sortColumn = column;
+    this->sortOrder  = order;
+
+    std::stable_sort(this->order.begin(), this->order.end(), [this](int left, int right)
+    {
+        return this->lessThan(left, right);
+    });
+    this->rebuildRows();
+
+    // update persistent indexes
+    std::vector<int> romDataRows(this->romData.size(), -1);
+    for (size_t i = 0; i < this->rows.size(); i++)
+    {
+        romDataRows[this->rows[i]] = static_cast<int>(i);
+    }
+
+    QModelIndexList newPersistentIndexes;
+    newPersistentIndexes.reserve(persistentIndexes.size());
+    for (qsizetype i = 0; i < persistentIndexes.size(); i++)
+    {
+        const int row = romDataRows[persistentRomDataIndices[i]];
+        newPersistentIndexes.append(row == -1 ? QModelIndex() : this->index(row, persistentIndexes[i].column()));
+    }
+    this->changePersistentIndexList(persistentIndexes, newPersistentIndexes);
+
+    emit this->layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void RomBrowserModel::Clear(void)
+{
+    this->beginResetModel();
+
+    this->romData.clear();
+    for (int i = 0; i < COLUMN_INDEX(Count); i++)
+    {
+        this->columnText[i].clear();
+        this->columnSortKeys[i].clear();
+    }
+    this->fileSizes.clear();
+    this->filterMatches.clear();
+    this->fileIndices.clear();
+    this->order.clear();
+    this->rows.clear();
+    this->sorted = false;
+
+    // there's no data to filter anymore,
+    // so the filter has been applied
+    this->filterGeneration++;
+    this->appliedFilterText = this->filterText;
+    this->appliedFilterRegularExpression = createFilterRegularExpression(this->filterText);
+
+    this->endResetModel();
+}
+
+void RomBrowserModel::AddRomData(const QList<RomSearcherThreadData>& data)
+{
+    std::vector<int> appendedRows;
+
+    // appends the rows at once
+    // when the model hasn't been sorted
+    auto appendRows = [this, &appendedRows]()
+    {
+        if (appendedRows.empty())
+        {
+            return;
+        }
+
+        const int row = static_cast<int>(this->rows.size());
+        this->beginInsertRows(QModelIndex(), row, row + static_cast<int>(appendedRows.size()) - 1);
+        this->rows.insert(this->rows.end(), appendedRows.begin(), appendedRows.end());
+        this->endInsertRows();
+        appendedRows.clear();
+    };
+
+    for (const RomSearcherThreadData& romData : data)
+    {
+        // replace existing ROM data
+        if (this->fileIndices.contains(romData.File))
+        {
+            appendRows();
+            this->RemoveRomData({ romData.File });
+        }
+
+        const int index = static_cast<int>(this->romData.size());
+        QFileInfo fileInfo(romData.File);
+        std::array<QString, static_cast<int>(RomBrowserColumn::Count)> text;
+
+        // generate name to use in UI
+        text[COLUMN_INDEX(Name)] = QString::fromStdString(romData.Settings.GoodName);
+        if (text[COLUMN_INDEX(Name)].endsWith("(unknown rom)") ||
+            text[COLUMN_INDEX(Name)].endsWith("(unknown disk)"))
+        {
+            text[COLUMN_INDEX(Name)] = fileInfo.fileName();
+        }
+
+        // generate game format to use in UI
+        if (romData.Type == CoreRomType::Disk)
+        {
+            text[COLUMN_INDEX(Format)] = "Disk";
+        }
+        else
+        {
+            text[COLUMN_INDEX(Format)] = "Cartridge";
+        }
+
+        // generate file size to use in UI
+        const qint64 fileSize = fileInfo.size();
+        text[COLUMN_INDEX(FileSize)] = QString::number(fileSize / 1048576.0, 'f', 2).append(" MB");
+
+        text[COLUMN_INDEX(InternalName)]  = QString::fromStdString(romData.Header.Name);
+        text[COLUMN_INDEX(MD5)]           = QString::fromStdString(romData.Settings.MD5);
+        text[COLUMN_INDEX(FileName)]      = fileInfo.completeBaseName();
+        text[COLUMN_INDEX(FileExtension)] = fileInfo.suffix().prepend(".").toUpper();
+        text[COLUMN_INDEX(GameID)]        = QString::fromStdString(romData.Header.GameID);
+        text[COLUMN_INDEX(Region)]        = QString::fromStdString(romData.Header.Region);
+
+        for (int i = 0; i < COLUMN_INDEX(Count); i++)
+        {
+            // share the string with the sort key
+            // when case folding doesn't change it
+            QString sortKey = text[i].toCaseFolded();
+            this->columnSortKeys[i].push_back(sortKey == text[i] ? text[i] : sortKey);
+            this->columnText[i].push_back(text[i]);
+        }
+
+        this->romData.push_back(RomBrowserModelData(romData.File, romData.Type, romData.Header, romData.Settings));
+        this->fileSizes.push_back(fileSize);
+        this->filterMatches.push_back(matchesFilter(text[COLUMN_INDEX(Name)], this->appliedFilterText, this->appliedFilterRegularExpression));
+        this->fileIndices.insert(romData.File, index);
+
+        if (!this->sorted)
+        {
+            this->order.push_back(index);
+            if (this->filterMatches.back())
+            {
+                appendedRows.push_back(index);
+            }
+            continue;
+        }
+
+        // insert at the sorted position
+        auto compare = [this](int left, int right)
+        {
+            return this->lessThan(left, right);
+        };
+        this->order.insert(std::upper_bound(this->order.begin(), this->order.end(), index, compare), index);
+
+        if (this->filterMatches.back())
+        {
+            const int row = static_cast<int>(std::upper_bound(this->rows.begin(), this->rows.end(), index, compare) - this->rows.begin());
+            this->beginInsertRows(QModelIndex(), row, row);
+            this->rows.insert(this->rows.begin() + row, index);
+            this->endInsertRows();
+        }
+    }
+
+    appendRows();
+}
+
+void RomBrowserModel::RemoveRomData(const QSet<QString>& files)
+{
+    std::vector<char> removed(this->romData.size(), 0);
+    bool hasRemoved = false;
+
+    for (const QString& file : files)
+    {
+        auto iter = this->fileIndices.find(file);
+        if (iter != this->fileIndices.end())
+        {
+            removed[iter.value()] = 1;
+            this->fileIndices.erase(iter);
+            hasRemoved = true;
+        }
+    }
+
+    if (!hasRemoved)
+    {
+        return;
+    }
+
+    // remove the visible rows, starting at the end
+    // and removing consecutive rows at once
+    for (int i = static_cast<int>(this->rows.size()) - 1; i >= 0; i--)
+    {
+        if (!removed[this->rows[i]])
+        {
+            continue;
+        }
+
+        int first = i;
+        while (first > 0 && removed[this->rows[first - 1]])
+        {
+            first--;
+        }
+
+        this->beginRemoveRows(QModelIndex(), first, i);
+        this->rows.erase(this->rows.begin() + first, this->rows.begin() + i + 1);
+        this->endRemoveRows();
+
+        i = first;
+    }
+
+    // compact the ROM data, this doesn't
+    // change the rows which are visible
+    std::vector<int> newIndices(this->romData.size(), -1);
+    int count = 0;
+    for (int i = 0; i < static_cast<int>(this->romData.size()); i++)
+    {
+        if (removed[i])
+        {
+            continue;
+        }
+
+        newIndices[i] = count;
+        if (count != i)
+        {
+            this->romData[count] = std::move(this->romData[i]);
+            for (int j = 0; j < COLUMN_INDEX(Count); j++)
+            {
+                this->columnText[j][count]     = std::move(this->columnText[j][i]);
+                this->columnSortKeys[j][count] = std::move(this->columnSortKeys[j][i]);
+            }
+            this->fileSizes[count]     = this->fileSizes[i];
+            this->filterMatches[count] = this->filterMatches[i];
+            this->fileIndices[this->romData[count].file] = count;
+        }
+        count++;
+    }
+
+    this->romData.resize(count);
+    for (int i = 0; i < COLUMN_INDEX(Count); i++)
+    {
+        this->columnText[i].resize(count);
+        this->columnSortKeys[i].resize(count);
+    }
+    this->fileSizes.resize(count);
+    this->filterMatches.resize(count);
+
+    this->order.erase(std::remove_if(this->order.begin(), this->order.end(), [&removed](int index)
+    {
+        return removed[index];
+    }), this->order.end());
+    for (int& index : this->order)
+    {
+        index = newIndices[index];
+    }
+    for (int& index : this->rows)
+    {
+        index = newIndices[index];
+    }
+
+    // the indices have changed, so restart
+    // the filter when it hasn't been applied yet
+    this->filterGeneration++;
+    if (this->filterText != this->appliedFilterText)
+    {
+        this->SetFilter(this->filterText);
+    }
+}
+
+void RomBrowserModel::SetFilter(QString text)
+{
+    const int generation = ++this->filterGeneration;
+    const int romDataCount = static_cast<int>(this->romData.size());
+    std::vector<int> candidates;
+    std::vector<QString> names;
+
+    this->filterText = text;
+
+    // when the new filter only narrows down the
+    // applied filter, we only have to check the
+    // rows which are currently visible
+    if (!this->appliedFilterText.isEmpty() &&
+        !has_wildcards(this->appliedFilterText) &&
+        !has_wildcards(text) &&
+        text.contains(this->appliedFilterText, Qt::CaseInsensitive))
+    {
+        candidates = this->rows;
+    }
+    else
+    {
+        candidates.resize(romDataCount);
+        std::iota(candidates.begin(), candidates.end(), 0);
+    }
+
+    names.reserve(candidates.size());
+    for (int index : candidates)
+    {
+        names.push_back(this->columnText[COLUMN_INDEX(Name)][index]);
+    }
+
+    this->filterThreadPool.start([this, generation, text, romDataCount, candidates, names]()
+    {
+        const QRegularExpression regularExpression = createFilterRegularExpression(text);
+        std::vector<int> matches;
+
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            // stop early when there's a newer filter
+            if ((i % 1024) == 0 && generation != this->filterGeneration)
+            {
+                return;
+            }
+
+            if (matchesFilter(names[i], text, regularExpression))
+            {
+                matches.push_back(candidates[i]);
+            }
+        }
+
+        QMetaObject::invokeMethod(this, [this, generation, text, romDataCount, candidates, matches]()
+        {
+            this->applyFilter(generation, text, romDataCount, candidates, matches);
+        }, Qt::QueuedConnection);
+    });
+}
+
+int RomBrowserModel::GetRomDataCount(void) const
+{
+    return static_cast<int>(this->romData.size());
+}
+
+const RomBrowserModelData& RomBrowserModel::GetRomData(int index) const
+{
+    return this->romData.at(index);
+}
+
+QString RomBrowserModel::GetRomName(int index) const
+{
+    return this->columnText[COLUMN_INDEX(Name)].at(index);
+}
+
+bool RomBrowserModel::GetRomData(const QModelIndex& index, RomBrowserModelData& data) const
+{
+    if (!index.isValid() ||
+        index.row() >= static_cast<int>(this->rows.size()))
+    {
+        return false;
+    }
+
+    data = this->romData[this->rows[index.row()]];
+    return true;
+}
+
+bool RomBrowserModel::lessThan(int left, int right) const
+{
+    if (this->sortOrder == Qt::DescendingOrder)
+    {
+        std::swap(left, right);
+    }
+
+    if (this->sortColumn == COLUMN_INDEX(FileSize))
+    {
+        return this->fileSizes[left] < this->fileSizes[right];
+    }
+
+    const std::vector<QString>& sortKeys = this->columnSortKeys[this->sortColumn];
+    return sortKeys[left] < sortKeys[right];
+}
+
+void RomBrowserModel::rebuildRows(void)
+{
+    this->rows.clear();
+    this->rows.reserve(this->order.size());
+
+    for (int index : this->order)
+    {
+        if (this->filterMatches[index])
+        {
+            this->rows.push_back(index);
+        }
+    }
+}
+
+QRegularExpression RomBrowserModel::createFilterRegularExpression(const QString& text)
+{
+    if (!has_wildcards(text))
+    {
+        return QRegularExpression();
+    }
+
+    return QRegularExpression(QRegularExpression::wildcardToRegularExpression(text, QRegularExpression::UnanchoredWildcardConversion),
+                              QRegularExpression::CaseInsensitiveOption);
+}
+
+bool RomBrowserModel::matchesFilter(const QString& name, const QString& text, const QRegularExpression& regularExpression)
+{
+    if (text.isEmpty())
+    {
+        return true;
+    }
+
+    if (!has_wildcards(text))
+    {
+        return name.contains(text, Qt::CaseInsensitive);
+    }
+
+    return regularExpression.match(name).hasMatch();
+}
+
+void RomBrowserModel::applyFilter(int generation, QString text, int romDataCount, const std::vector<int>& candidates, const std::vector<int>& matches)
+{
+    // ignore outdated results
+    if (generation != this->filterGeneration)
+    {
+        return;
+    }
+
+    this->appliedFilterText = text;
+    this->appliedFilterRegularExpression = createFilterRegularExpression(text);
+
+    for (int index : candidates)
+    {
+        this->filterMatches[index] = 0;
+    }
+    for (int index : matches)
+    {
+        this->filterMatches[index] = 1;
+    }
+
+    // ROM data which has been added after
+    // the filter was started hasn't been checked
+    for (int i = romDataCount; i < static_cast<int>(this->romData.size()); i++)
+    {
+        this->filterMatches[i] = matchesFilter(this->columnText[COLUMN_INDEX(Name)][i], text, this->appliedFilterRegularExpression);
+    }
+
+    this->beginResetModel();
+    this->rebuildRows();
+    this->endResetModel();
+}
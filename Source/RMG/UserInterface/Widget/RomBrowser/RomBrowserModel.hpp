@@ -0,0 +1,128 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ROMBROWSERMODEL_HPP
+#define ROMBROWSERMODEL_HPP
+
+#include "Thread/RomSearcherThread.hpp"
+#include "RomBrowserModelData.hpp"
+
+#include <QAbstractTableModel>
+#include <QRegularExpression>
+#include <QThreadPool>
+#include <QStringList>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QSet>
+
+#include <vector>
+#include <atomic>
+#include <array>
+
+namespace UserInterface
+{
+namespace Widget
+{
+enum class RomBrowserColumn
+{
+    Name = 0,
+    InternalName,
+    MD5,
+    Format,
+    FileName,
+    FileExtension,
+    FileSize,
+    GameID,
+    Region,
+    Count
+};
+
+class RomBrowserModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+  public:
+    RomBrowserModel(QObject* parent);
+    ~RomBrowserModel(void);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // removes all ROM data
+    void Clear(void);
+
+    // adds the given ROM data, when the model has been sorted
+    // the ROM data is inserted at its sorted position
+    void AddRomData(const QList<RomSearcherThreadData>& data);
+
+    // removes the ROM data of the given files
+    void RemoveRomData(const QSet<QString>& files);
+
+    // filters the ROM data by name on a worker thread,
+    // the filter supports wildcards
+    void SetFilter(QString text);
+
+    // returns the amount of ROM data, including
+    // the ROM data which has been filtered
+    int GetRomDataCount(void) const;
+
+    // returns the ROM data at the given index, including
+    // the ROM data which has been filtered
+    const RomBrowserModelData& GetRomData(int index) const;
+
+    // returns the name shown for the ROM data at the given index
+    QString GetRomName(int index) const;
+
+    // retrieves the ROM data of the given model index
+    bool GetRomData(const QModelIndex& index, RomBrowserModelData& data) const;
+
+  private:
+    QStringList columnLabels;
+
+    // the ROM data and the text of each column
+    // are stored in contiguous arrays, the sort
+    // keys are precomputed when the data is added
+    std::vector<RomBrowserModelData> romData;
+    std::array<std::vector<QString>, static_cast<int>(RomBrowserColumn::Count)> columnText;
+    std::array<std::vector<QString>, static_cast<int>(RomBrowserColumn::Count)> columnSortKeys;
+    std::vector<qint64> fileSizes;
+    std::vector<char>   filterMatches;
+    QHash<QString, int> fileIndices;
+
+    // all indices in sorted order
+    std::vector<int> order;
+    // the indices of the visible rows in sorted order
+    std::vector<int> rows;
+
+    bool sorted = false;
+    int  sortColumn = 0;
+    Qt::SortOrder sortOrder = Qt::AscendingOrder;
+
+    QThreadPool filterThreadPool;
+    QString filterText;
+    QString appliedFilterText;
+    QRegularExpression appliedFilterRegularExpression;
+    std::atomic<int> filterGeneration = 0;
+
+    bool lessThan(int left, int right) const;
+    void rebuildRows(void);
+
+    static QRegularExpression createFilterRegularExpression(const QString& text);
+    static bool matchesFilter(const QString& name, const QString& text, const QRegularExpression& regularExpression);
+
+    void applyFilter(int generation, QString text, int romDataCount, const std::vector<int>& candidates, const std::vector<int>& matches);
+};
+} // namespace Widget
+} // namespace UserInterface
+
+#endif // ROMBROWSERMODEL_HPP
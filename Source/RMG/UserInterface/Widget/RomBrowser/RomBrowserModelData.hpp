@@ -0,0 +1,40 @@
+/*
+ * Rosalie's Mupen GUI - https://github.com/Rosalie241/RMG
+ *  Copyright (C) 2020-2025 Rosalie Wanders <rosalie@mailbox.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 3.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef ROMBROWSERMODELDATA_HPP
+#define ROMBROWSERMODELDATA_HPP
+
+#include <RMG-Core/RomSettings.hpp>
+#include <RMG-Core/RomHeader.hpp>
+#include <RMG-Core/Rom.hpp>
+
+#include <QMetaType>
+#include <QString>
+
+struct RomBrowserModelData
+{
+    QString         file;
+    CoreRomType     type;
+    CoreRomHeader   header;
+    CoreRomSettings settings;
+
+    RomBrowserModelData() {}
+
+    RomBrowserModelData(QString file, CoreRomType type, CoreRomHeader header, CoreRomSettings settings)
+    {
+        this->file     = file;
+        this->type     = type;
+        this->header   = header;
+        this->settings = settings;
+    }
+};
+
+Q_DECLARE_METATYPE(RomBrowserModelData);
+
+#endif // ROMBROWSERMODELDATA_HPP
@@ -27,31 +27,6 @@
 
 using namespace UserInterface::Widget;
 
-//
-// Internal Struct
-//
-
-struct RomBrowserModelData
-{
-    QString         file;
-    CoreRomType     type;
-    CoreRomHeader   header;
-    CoreRomSettings settings;
-    QString         coverFile;
-
-    RomBrowserModelData() {}
-
-    RomBrowserModelData(QString file, CoreRomType type, CoreRomHeader header, CoreRomSettings settings)
-    {
-        this->file     = file;
-        this->type     = type;
-        this->header   = header;
-        this->settings = settings;
-    }
-};
-
-Q_DECLARE_METATYPE(RomBrowserModelData);
-
 //
 // Exported Functions
 // 
@@ -79,6 +54,8 @@ RomBrowserWidget::RomBrowserWidget(QWidget *parent) : QWidget(parent)
     // configure rom searcher thread
     this->romSearcherThread = new Thread::RomSearcherThread(this);
     connect(this->romSearcherThread, &Thread::RomSearcherThread::RomsFound, this, &RomBrowserWidget::on_RomBrowserThread_RomsFound);
+    connect(this->romSearcherThread, &Thread::RomSearcherThread::RomsChanged, this, &RomBrowserWidget::on_RomBrowserThread_RomsChanged);
+    connect(this->romSearcherThread, &Thread::RomSearcherThread::RomsRemoved, this, &RomBrowserWidget::on_RomBrowserThread_RomsRemoved);
     connect(this->romSearcherThread, &Thread::RomSearcherThread::Finished, this, &RomBrowserWidget::on_RomBrowserThread_Finished);
 
     // configure empty widget
@@ -94,12 +71,12 @@ RomBrowserWidget::RomBrowserWidget(QWidget *parent) : QWidget(parent)
     connect(this->loadingWidget, &RomBrowserLoadingWidget::FileDropped, this, &RomBrowserWidget::FileDropped);
     this->loadingWidget->SetWidgetIndex(this->stackedWidget->addWidget(this->loadingWidget));
 
+    // configure model
+    this->model = new Widget::RomBrowserModel(this);
+
     // configure list view widget
     this->listViewWidget = new Widget::RomBrowserListViewWidget(this);
-    this->listViewModel  = new QStandardItemModel(this);
-    this->listViewProxyModel = new QSortFilterProxyModel(this);
-    this->listViewProxyModel->setSourceModel(this->listViewModel);
-    this->listViewWidget->setModel(this->listViewProxyModel);
+    this->listViewWidget->setModel(this->model);
     this->listViewWidget->setFrameStyle(QFrame::NoFrame);
     this->listViewWidget->setItemDelegate(new NoFocusDelegate(this));
     this->listViewWidget->setWordWrap(false);
@@ -128,37 +105,20 @@ RomBrowserWidget::RomBrowserWidget(QWidget *parent) : QWidget(parent)
     connect(this->listViewWidget, &Widget::RomBrowserListViewWidget::ZoomOut, this, &RomBrowserWidget::on_ZoomOut);
     connect(this->listViewWidget, &Widget::RomBrowserListViewWidget::FileDropped, this, &RomBrowserWidget::FileDropped);
 
-    // set up list view's columns
-    QStringList labels;
-    labels << "Name";
-    labels << "Internal Name";
-    labels << "MD5";
-    labels << "Format";
-    labels << "File Name";
-    labels << "File Ext.";
-    labels << "File Size";
-    labels << "I.D.";
-    labels << "Region";
-    this->listViewModel->setColumnCount(labels.size());
-    this->listViewModel->setHorizontalHeaderLabels(labels);
-
     // set full names of list view's columns
-    this->columnNames << labels.at(0);
-    this->columnNames << labels.at(1);
-    this->columnNames << labels.at(2);
+    this->columnNames << "Name";
+    this->columnNames << "Internal Name";
+    this->columnNames << "MD5";
     this->columnNames << "Game Format";
-    this->columnNames << labels.at(4);
+    this->columnNames << "File Name";
     this->columnNames << "File Extension";
-    this->columnNames << labels.at(6);
+    this->columnNames << "File Size";
     this->columnNames << "Game I.D.";
     this->columnNames << "Game Region";
 
     // configure grid view widget
     this->gridViewWidget = new Widget::RomBrowserGridViewWidget(this);
-    this->gridViewModel  = new QStandardItemModel(this);
-    this->gridViewProxyModel = new QSortFilterProxyModel(this);
-    this->gridViewProxyModel->setSourceModel(this->gridViewModel);
-    this->gridViewWidget->setModel(this->gridViewProxyModel);
+    this->gridViewWidget->setModel(this->model);
     this->gridViewWidget->setFlow(QListView::Flow::LeftToRight);
     this->gridViewWidget->setResizeMode(QListView::Adjust);
     this->gridViewWidget->setUniformItemSizes(CoreSettingsGetBoolValue(SettingsID::RomBrowser_GridViewUniformItemSizes));
@@ -174,6 +134,10 @@ RomBrowserWidget::RomBrowserWidget(QWidget *parent) : QWidget(parent)
     int iconHeight = CoreSettingsGetIntValue(SettingsID::RomBrowser_GridViewIconHeight);
     this->gridViewWidget->setIconSize(QSize(iconWidth, iconHeight));
     this->stackedWidget->addWidget(this->gridViewWidget);
+    this->coverLoader = new Widget::RomBrowserCoverLoader(this);
+    this->coverLoader->SetIconSize(this->gridViewWidget->iconSize(), this->devicePixelRatioF());
+    this->gridViewWidget->setItemDelegate(new RomBrowserGridViewDelegate(this, this->coverLoader));
+    connect(this->coverLoader, &Widget::RomBrowserCoverLoader::CoverLoaded, this->gridViewWidget->viewport(), qOverload<>(&QWidget::update));
     connect(this->gridViewWidget, &QListView::doubleClicked, this, &RomBrowserWidget::on_DoubleClicked);
     connect(this->gridViewWidget, &QListView::iconSizeChanged, this, &RomBrowserWidget::on_gridViewWidget_iconSizeChanged);
     connect(this->gridViewWidget, &Widget::RomBrowserGridViewWidget::ZoomIn, this, &RomBrowserWidget::on_ZoomIn);
@@ -293,14 +257,23 @@ RomBrowserWidget::~RomBrowserWidget()
 
 void RomBrowserWidget::RefreshRomList(void)
 {
-    this->listViewModel->removeRows(0, this->listViewModel->rowCount());
-    this->gridViewModel->removeRows(0, this->gridViewModel->rowCount());
+    // the ROM searcher thread keeps running
+    // while watching the ROM directory,
+    // so we have to stop it first
+    if (this->IsWatchingRomList())
+    {
+        this->StopRefreshRomList();
+    }
+
+    this->model->Clear();
 
     this->menu_PlayGameWithDisk->clear();
 
     this->coversDirectory = QString::fromStdString(CoreGetUserDataDirectory().string());
     this->coversDirectory += CORE_DIR_SEPERATOR_STR;
     this->coversDirectory += "Covers";
+    this->coverLoader->SetCoversDirectory(this->coversDirectory);
+    this->coverLoader->Clear();
 
     this->listViewSortSection = CoreSettingsGetIntValue(SettingsID::RomBrowser_ListViewSortSection);
     this->listViewSortOrder   = CoreSettingsGetIntValue(SettingsID::RomBrowser_ListViewSortOrder);
@@ -327,7 +300,12 @@ void RomBrowserWidget::RefreshRomList(void)
 
 bool RomBrowserWidget::IsRefreshingRomList(void)
 {
-    return this->romSearcherThread->isRunning();
+    return this->romSearcherThread->IsRefreshing();
+}
+
+bool RomBrowserWidget::IsWatchingRomList(void)
+{
+    return this->romSearcherThread->IsWatching();
 }
 
 void RomBrowserWidget::StopRefreshRomList(void)
@@ -406,17 +384,10 @@ void RomBrowserWidget::SetToggleSearch(void)
 QMap<QString, CoreRomSettings> RomBrowserWidget::GetModelData(void)
 {
     QMap<QString, CoreRomSettings> data;
-    QPair<QStandardItemModel*, QSortFilterProxyModel*> model = this->getCurrentModel();
-    RomBrowserModelData modelData;
 
-    if (model.first == nullptr)
+    for (int i = 0; i < this->model->GetRomDataCount(); i++)
     {
-        return data;
-    }
-
-    for (int i = 0; i < model.first->rowCount(); i++)
-    {
-        modelData = model.first->item(i)->data().value<RomBrowserModelData>();
+        const RomBrowserModelData& modelData = this->model->GetRomData(i);
         // only add cartridges, 64dd disks aren't supported
         if (modelData.type == CoreRomType::Cartridge)
         {
@@ -427,26 +398,6 @@ QMap<QString, CoreRomSettings> RomBrowserWidget::GetModelData(void)
     return data;
 }
 
-QPair<QStandardItemModel*, QSortFilterProxyModel*> RomBrowserWidget::getCurrentModel(void)
-{
-    QWidget* currentWidget = this->stackedWidget->currentWidget();
-    if (currentWidget == this->loadingWidget)
-    {
-        currentWidget = this->currentViewWidget;
-    }
-
-    if (currentWidget == this->listViewWidget)
-    {
-        return qMakePair(this->listViewModel, this->listViewProxyModel);
-    }
-    else if (currentWidget == this->gridViewWidget)
-    {
-        return qMakePair(this->gridViewModel, this->gridViewProxyModel);
-    }
-
-    return qMakePair(nullptr, nullptr);
-}
-
 QAbstractItemView* RomBrowserWidget::getCurrentModelView(void)
 {
     QWidget* currentWidget = this->stackedWidget->currentWidget();
@@ -469,24 +420,14 @@ QAbstractItemView* RomBrowserWidget::getCurrentModelView(void)
 
 bool RomBrowserWidget::getCurrentData(RomBrowserModelData& data)
 {
-    QPair<QStandardItemModel*, QSortFilterProxyModel*> model = this->getCurrentModel();
     QAbstractItemView* view = this->getCurrentModelView();
 
-    if (model.first == nullptr || model.second == nullptr || view == nullptr)
-    {
-        return false;
-    }
-
-    QModelIndex    index = model.second->mapToSource(view->currentIndex());
-    QStandardItem* item  = model.first->item(index.row(), 0);
-
-    if (item == nullptr)
+    if (view == nullptr)
     {
         return false;
     }
 
-    data = item->data().value<RomBrowserModelData>();
-    return true;
+    return this->model->GetRomData(view->currentIndex(), data);
 }
 
 
@@ -502,172 +443,27 @@ QString RomBrowserWidget::getCurrentRom(void)
     return data.file;
 }
 
-void RomBrowserWidget::addRomData(QString file, CoreRomType type, CoreRomHeader header, CoreRomSettings settings)
+void RomBrowserWidget::updateCurrentWidget(void)
 {
-    QString name;
-    QString gameFormat;
-    float fileSize;
-    QString fileSizeString;
-    QString coverFile;
-    QIcon   coverIcon;
-    QVariant itemData;
-    RomBrowserModelData modelData;
-
-    // create item data
-    modelData = RomBrowserModelData(file, type, header, settings);
-
-    // generate name to use in UI
-    name = QString::fromStdString(settings.GoodName);
-    if (name.endsWith("(unknown rom)") ||
-        name.endsWith("(unknown disk)"))
-    {
-        name = QFileInfo(file).fileName();
-    }
-
-    // generate game format to use in UI
-    if (type == CoreRomType::Disk)
-    {
-        gameFormat = "Disk";
-    }
-    else
-    {
-        gameFormat = "Cartridge";
-    }
-
-    // generate file size to use in UI
-    fileSize = QFileInfo(file).size()/1048576.0;
-    fileSizeString = (QString::number(fileSize, 'f', 2)).append(" MB");
-    if (fileSizeString.size() == 7)
+    // don't change the widget while we're refreshing
+    if (this->IsRefreshingRomList())
     {
-        fileSizeString = fileSizeString.prepend("  ");
+        return;
     }
 
-    // retrieve cover image
-    coverIcon = this->getCurrentCover(file, header, settings, coverFile);
-    modelData.coverFile = coverFile;
-
-    // create item data
-    itemData = QVariant::fromValue<RomBrowserModelData>(modelData);
-
-    QList<QStandardItem*> listViewRow;
-    // goodname
-    QStandardItem* listViewItem1 = new QStandardItem();
-    listViewItem1->setText(name);
-    listViewItem1->setData(itemData);
-    listViewRow.append(listViewItem1);
-    // internal name
-    QStandardItem* listViewItem2 = new QStandardItem();
-    listViewItem2->setText(QString::fromStdString(header.Name));
-    listViewRow.append(listViewItem2);
-    // MD5
-    QStandardItem* listViewItem3 = new QStandardItem();
-    listViewItem3->setText(QString::fromStdString(settings.MD5));
-    listViewRow.append(listViewItem3);
-    // game format
-    QStandardItem* listViewItem4 = new QStandardItem();
-    listViewItem4->setText(gameFormat);
-    listViewRow.append(listViewItem4);
-    // file name
-    QStandardItem* listViewItem5 = new QStandardItem();
-    listViewItem5->setText(QFileInfo(file).completeBaseName());
-    listViewRow.append(listViewItem5);
-    // file extension
-    QStandardItem* listViewItem6 = new QStandardItem();
-    listViewItem6->setText(((QFileInfo(file).suffix()).prepend(".")).toUpper());
-    listViewRow.append(listViewItem6);
-    // file size
-    QStandardItem* listViewItem7 = new QStandardItem();
-    listViewItem7->setText(fileSizeString);
-    listViewRow.append(listViewItem7);
-    // game i.d.
-    QStandardItem* listViewItem8 = new QStandardItem();
-    listViewItem8->setText(QString::fromStdString(header.GameID));
-    listViewRow.append(listViewItem8);
-    // region
-    QStandardItem* listViewItem9 = new QStandardItem();
-    listViewItem9->setText(QString::fromStdString(header.Region));
-    listViewRow.append(listViewItem9);
-    this->listViewModel->appendRow(listViewRow);
-
-    QStandardItem* gridViewItem = new QStandardItem();
-    gridViewItem->setIcon(coverIcon);
-    gridViewItem->setText(name);
-    gridViewItem->setData(itemData);
-    this->gridViewModel->appendRow(gridViewItem);
-}
-
-QIcon RomBrowserWidget::getCurrentCover(QString file, CoreRomHeader header, CoreRomSettings settings, QString& coverFileName)
-{
-    QPixmap pixmap;
-
-    // construct basename of file,
-    // by retrieving the last index of '.'
-    // and removing all characters from that index
-    // until the end of the string
-    QString baseName         = QFileInfo(file).fileName();
-    qsizetype lastIndexOfDot = baseName.lastIndexOf(".");
-    if (lastIndexOfDot != -1)
-    { // only remove when index was found
-        baseName.remove(lastIndexOfDot, baseName.size() - lastIndexOfDot);
-    }
+    this->generatePlayWithDiskMenu();
 
-    // try to load cover using
-    // 1) basename of file
-    // 2) MD5
-    // 3) good name
-    // 4) internal name
-    bool foundCover = false;
-    for (QString name : { 
-        baseName,
-        QString::fromStdString(settings.MD5), 
-        QString::fromStdString(settings.GoodName), 
-        QString::fromStdString(header.Name) })
+    if (this->model->GetRomDataCount() == 0)
     {
-        // fixup file name
-        QString fixedName = name;
-        for (const QChar c : QString(":<>\"/\\|?*"))
-        {
-            fixedName.replace(c, "_");
-        }
-
-        // skip empty names,
-        // this can i.e happen
-        // when ROMs don't have 
-        // an internal ROM name
-        if (fixedName.isEmpty())
-        {
-            continue;
-        }
-
-        // we support jpg & png as file extensions
-        for (QString ext : { ".png", ".jpg", ".jpeg" })
-        {
-            QString coverPath = this->coversDirectory;
-            coverPath += CORE_DIR_SEPERATOR_STR;
-            coverPath += fixedName;
-            coverPath += ext;
-
-            if (QFile::exists(coverPath) && 
-                pixmap.load(coverPath))
-            {
-                coverFileName = coverPath;
-                foundCover = true;
-                break;
-            }
-        }
-
-        if (foundCover)
-        {
-            break;
-        }
+        this->showSearchWidget = this->searchWidget->isVisible();
+        this->searchWidget->hide();
+        this->stackedWidget->setCurrentWidget(this->emptyWidget);
     }
-    // fallback
-    if (!foundCover)
+    else if (this->stackedWidget->currentWidget() == this->emptyWidget)
     {
-        pixmap.load(":Resource/CoverFallback.png");
+        this->stackedWidget->setCurrentWidget(this->currentViewWidget);
+        this->searchWidget->setVisible(this->showSearchWidget);
     }
-
-    return QIcon(pixmap);
 }
 
 void RomBrowserWidget::timerEvent(QTimerEvent* event)
@@ -691,6 +487,7 @@ void RomBrowserWidget::customContextMenuRequested(QPoint position)
     }
 
     RomBrowserModelData data;
+    QString coverFile;
     bool hasSelection = view->selectionModel()->hasSelection();
     bool showPlayWithDiskMenu;
 
@@ -699,6 +496,11 @@ void RomBrowserWidget::customContextMenuRequested(QPoint position)
         return;
     }
 
+    if (view == this->gridViewWidget)
+    {
+        coverFile = RomBrowserCoverLoader::FindCoverFile(this->coversDirectory, data);
+    }
+
     showPlayWithDiskMenu = data.type == CoreRomType::Cartridge && !this->menu_PlayGameWithDisk->isEmpty();
 
     this->action_PlayGame->setEnabled(hasSelection);
@@ -714,7 +516,7 @@ void RomBrowserWidget::customContextMenuRequested(QPoint position)
     this->menu_Columns->menuAction()->setVisible(view == this->listViewWidget);
     this->action_SetCoverImage->setEnabled(hasSelection);
     this->action_SetCoverImage->setVisible(view == this->gridViewWidget);
-    this->action_RemoveCoverImage->setEnabled(hasSelection && !data.coverFile.isEmpty());
+    this->action_RemoveCoverImage->setEnabled(hasSelection && !coverFile.isEmpty());
     this->action_RemoveCoverImage->setVisible(view == this->gridViewWidget);
 
     if (hasSelection)
@@ -738,7 +540,7 @@ void RomBrowserWidget::customContextMenuRequested(QPoint position)
 
     if (view == this->gridViewWidget)
     { // grid view
-        if (data.coverFile.isEmpty())
+        if (coverFile.isEmpty())
         {
             this->action_SetCoverImage->setText("Set Cover Image...");
         }
@@ -755,7 +557,7 @@ void RomBrowserWidget::generateColumnsMenu(void)
 {
     this->menu_Columns->clear();
 
-    for (int i = 0; i < this->listViewModel->columnCount(); i++)
+    for (int i = 0; i < this->model->columnCount(); i++)
     {
         int column = this->listViewWidget->horizontalHeader()->logicalIndex(i);
 
@@ -772,20 +574,13 @@ void RomBrowserWidget::generateColumnsMenu(void)
 void RomBrowserWidget::generatePlayWithDiskMenu(void)
 {
     QAction* playGameWithAction;
-    QPair<QStandardItemModel*, QSortFilterProxyModel*> model = this->getCurrentModel();
-    RomBrowserModelData modelData;
     int count = 0;
 
     this->menu_PlayGameWithDisk->clear();
 
-    if (model.first == nullptr)
+    for (int i = 0; i < this->model->GetRomDataCount(); i++)
     {
-        return;
-    }
-
-    for (int i = 0; i < model.first->rowCount(); i++)
-    {
-        modelData = model.first->item(i)->data().value<RomBrowserModelData>();
+        const RomBrowserModelData& modelData = this->model->GetRomData(i);
         if (modelData.type == CoreRomType::Disk)
         {
             if (count == 0)
@@ -795,8 +590,8 @@ void RomBrowserWidget::generatePlayWithDiskMenu(void)
             }
 
             playGameWithAction = new QAction(this);
-            playGameWithAction->setText(model.first->item(i)->text());
-            playGameWithAction->setData(model.first->item(i)->data());
+            playGameWithAction->setText(this->model->GetRomName(i));
+            playGameWithAction->setData(QVariant::fromValue<RomBrowserModelData>(modelData));
             this->menu_PlayGameWithDisk->addAction(playGameWithAction);
 
             // only add 10 disks to menu,
@@ -850,15 +645,7 @@ void RomBrowserWidget::generateStateMenu(void)
 
 void RomBrowserWidget::on_searchWidget_SearchTextChanged(const QString& text)
 {
-    // TODO: I should really make a custom data
-    // model at this point to save memory & CPU cycles...
-    this->listViewProxyModel->setFilterCaseSensitivity(Qt::CaseInsensitive);
-    this->listViewProxyModel->setFilterWildcard(text);
-    this->listViewProxyModel->setFilterKeyColumn(0);
-
-    this->gridViewProxyModel->setFilterCaseSensitivity(Qt::CaseInsensitive);
-    this->gridViewProxyModel->setFilterWildcard(text);
-    this->gridViewProxyModel->setFilterKeyColumn(0);
+    this->model->SetFilter(text);
 }
 
 void RomBrowserWidget::on_listViewWidget_sortIndicatorChanged(int logicalIndex, Qt::SortOrder sortOrder)
@@ -898,7 +685,7 @@ void RomBrowserWidget::on_listViewWidget_sectionResized(int logicalIndex, int ol
             CoreSettingsSetValue(SettingsID::RomBrowser_ColumnVisibility, columnVisibility);
 
             int lastVisibleColumn = -1;
-            for (int i = 0; i < this->listViewModel->columnCount(); i++)
+            for (int i = 0; i < this->model->columnCount(); i++)
             {
                 int column = this->listViewWidget->horizontalHeader()->logicalIndex(i);
                 if (!this->listViewWidget->horizontalHeader()->isSectionHidden(column))
@@ -936,6 +723,8 @@ void RomBrowserWidget::on_listViewWidget_headerContextMenuRequested(QPoint posit
 
 void RomBrowserWidget::on_gridViewWidget_iconSizeChanged(const QSize& size)
 {
+    this->coverLoader->SetIconSize(size, this->devicePixelRatioF());
+
     CoreSettingsSetValue(SettingsID::RomBrowser_GridViewIconWidth, size.width());
     CoreSettingsSetValue(SettingsID::RomBrowser_GridViewIconHeight, size.height());
 }
@@ -965,20 +754,29 @@ void RomBrowserWidget::on_ZoomOut(void)
 void RomBrowserWidget::on_RomBrowserThread_RomsFound(QList<RomSearcherThreadData> data, int index, int count)
 {
     // add every item to our dataset
-    for (qsizetype i = 0; i < data.size(); i++)
-    {
-        this->addRomData(data[i].File, data[i].Type, data[i].Header, data[i].Settings);
-    }
+    this->model->AddRomData(data);
 
     // update loading widget
     this->loadingWidget->SetCurrentRomIndex(index, count);
 }
 
+void RomBrowserWidget::on_RomBrowserThread_RomsChanged(QList<RomSearcherThreadData> data)
+{
+    // the model replaces the old items of the changed files
+    this->model->AddRomData(data);
+    this->updateCurrentWidget();
+}
+
+void RomBrowserWidget::on_RomBrowserThread_RomsRemoved(QList<QString> files)
+{
+    this->model->RemoveRomData(QSet<QString>(files.begin(), files.end()));
+    this->updateCurrentWidget();
+}
+
 void RomBrowserWidget::on_RomBrowserThread_Finished(bool canceled)
 {
     // sort data
-    this->listViewProxyModel->sort(this->listViewSortSection, static_cast<Qt::SortOrder>(this->listViewSortOrder));
-    this->gridViewProxyModel->sort(0, Qt::SortOrder::AscendingOrder);
+    this->model->sort(this->listViewSortSection, static_cast<Qt::SortOrder>(this->listViewSortOrder));
 
     // retrieve column settings
     std::vector<int> columnSizes = CoreSettingsGetIntListValue(SettingsID::RomBrowser_ColumnSizes);
@@ -990,16 +788,16 @@ void RomBrowserWidget::on_RomBrowserThread_Finished(bool canceled)
 
     // reset column sizes setting in config file if number of values is incorrect
     if (!columnSizes.empty() && 
-        columnSizes.size() != this->listViewModel->columnCount())
+        columnSizes.size() != this->model->columnCount())
     {
         columnSizes.clear();
-        columnSizes.resize(this->listViewModel->columnCount(), -1);
+        columnSizes.resize(this->model->columnCount(), -1);
         CoreSettingsSetValue(SettingsID::RomBrowser_ColumnSizes, columnSizes);
     }
 
     // update list view's column sizes when
     // we have any rows in our list view
-    if (this->listViewModel->rowCount() != 0)
+    if (this->model->GetRomDataCount() != 0)
     {
         for (size_t i = 0; i < columnSizes.size(); i++)
         {
@@ -1020,10 +818,10 @@ void RomBrowserWidget::on_RomBrowserThread_Finished(bool canceled)
 
     // reset column order setting in config file if number of values is incorrect
     if (!columnOrder.empty() &&
-        columnOrder.size() != this->listViewModel->columnCount())
+        columnOrder.size() != this->model->columnCount())
     {
         columnOrder.clear();
-        for (int i = 0; i < this->listViewModel->columnCount(); i++)
+        for (int i = 0; i < this->model->columnCount(); i++)
         {
             columnOrder.push_back(i);
         }
@@ -1038,10 +836,10 @@ void RomBrowserWidget::on_RomBrowserThread_Finished(bool canceled)
 
     // reset column visibility setting in config file if number of values is incorrect
     if (!columnVisibility.empty() &&
-        columnVisibility.size() != this->listViewModel->columnCount())
+        columnVisibility.size() != this->model->columnCount())
     {
         columnVisibility.clear();
-        columnVisibility.resize(this->listViewModel->columnCount(), 0);
+        columnVisibility.resize(this->model->columnCount(), 0);
         for (int i = 0; i < 3; i++)
         {
             columnVisibility.at(i) = 1;
@@ -1072,7 +870,7 @@ void RomBrowserWidget::on_RomBrowserThread_Finished(bool canceled)
         return;
     }
 
-    if (this->listViewModel->rowCount() == 0)
+    if (this->model->GetRomDataCount() == 0)
     {
         this->stackedWidget->setCurrentWidget(this->emptyWidget);
         return;
@@ -1189,7 +987,7 @@ void RomBrowserWidget::on_Action_ResetColumnSizes(void)
     std::vector<int> columnVisibility = CoreSettingsGetIntListValue(SettingsID::RomBrowser_ColumnVisibility);
     this->listViewWidget->horizontalHeader()->setStretchLastSection(false);
 
-    for (int i = 0; i < this->listViewModel->columnCount(); i++)
+    for (int i = 0; i < this->model->columnCount(); i++)
     {
         this->listViewWidget->horizontalHeader()->setSectionHidden(i, false);
     }
@@ -1212,9 +1010,9 @@ void RomBrowserWidget::on_Action_SetCoverImage(void)
     QFileInfo sourceFileInfo;
     QString coverFile;
 
-    QPair<QStandardItemModel*, QSortFilterProxyModel*> model = this->getCurrentModel();
-    QAbstractItemView* view  = this->getCurrentModelView();
-    if (model.first == nullptr || model.second == nullptr || view == nullptr)
+    RomBrowserModelData data;
+    QAbstractItemView* view = this->getCurrentModelView();
+    if (view == nullptr || !this->getCurrentData(data))
     {
         return;
     }
@@ -1233,10 +1031,6 @@ void RomBrowserWidget::on_Action_SetCoverImage(void)
     // retrieve file info
     sourceFileInfo = QFileInfo(sourceFile);
 
-    QModelIndex         index = model.second->mapToSource(view->currentIndex());
-    QStandardItem*      item  = model.first->item(index.row(), index.column());
-    RomBrowserModelData data  = model.first->itemData(index).last().value<RomBrowserModelData>();
-
     // construct new file name (for the cover)
     QString newFileName = this->coversDirectory;
     newFileName += CORE_DIR_SEPERATOR_STR;
@@ -1253,43 +1047,38 @@ void RomBrowserWidget::on_Action_SetCoverImage(void)
     // remove old cover when
     // cover file exists
     // and contains the MD5
-    if (!data.coverFile.isEmpty() && 
-        QFile::exists(data.coverFile) &&
-        data.coverFile.contains(QString::fromStdString(data.settings.MD5)))
+    coverFile = RomBrowserCoverLoader::FindCoverFile(this->coversDirectory, data);
+    if (!coverFile.isEmpty() && 
+        coverFile.contains(QString::fromStdString(data.settings.MD5)))
     {
-        QFile::remove(data.coverFile);
+        QFile::remove(coverFile);
     }
 
     // copy new one
     QFile::copy(sourceFile, newFileName);
 
-    // update item
-    item->setIcon(this->getCurrentCover(data.file, data.header, data.settings, coverFile));
-    data.coverFile = coverFile;
-    item->setData(QVariant::fromValue<RomBrowserModelData>(data));
+    // reload cover
+    this->coverLoader->Remove(data.file);
+    view->viewport()->update();
 }
 
 void RomBrowserWidget::on_Action_RemoveCoverImage(void)
 {
-    QPair<QStandardItemModel*, QSortFilterProxyModel*> model = this->getCurrentModel();
-    QAbstractItemView*  view  = this->getCurrentModelView();
-    if (model.first == nullptr || model.second == nullptr || view == nullptr)
+    RomBrowserModelData data;
+    QAbstractItemView* view = this->getCurrentModelView();
+    if (view == nullptr || !this->getCurrentData(data))
     {
         return;
     }
 
-    QModelIndex         index = model.second->mapToSource(view->currentIndex());
-    QStandardItem*      item  = model.first->item(index.row(), index.column());
-    RomBrowserModelData data  = model.first->itemData(index).last().value<RomBrowserModelData>();
-    QString coverFile;
+    QString coverFile = RomBrowserCoverLoader::FindCoverFile(this->coversDirectory, data);
 
-    if (!data.coverFile.isEmpty() && QFile::exists(data.coverFile))
+    if (!coverFile.isEmpty())
     {
-        QFile::remove(data.coverFile);
+        QFile::remove(coverFile);
     }
 
-    // update item
-    item->setIcon(this->getCurrentCover(data.file, data.header, data.settings, coverFile));
-    data.coverFile = coverFile;
-    item->setData(QVariant::fromValue<RomBrowserModelData>(data));
+    // reload cover
+    this->coverLoader->Remove(data.file);
+    view->viewport()->update();
 }
@@ -13,14 +13,16 @@
 #include "Thread/RomSearcherThread.hpp"
 #include "UserInterface/NoFocusDelegate.hpp"
 
+#include "RomBrowserGridViewDelegate.hpp"
+#include "RomBrowserCoverLoader.hpp"
+#include "RomBrowserModelData.hpp"
+#include "RomBrowserModel.hpp"
 #include "RomBrowserListViewWidget.hpp"
 #include "RomBrowserGridViewWidget.hpp"
 #include "RomBrowserLoadingWidget.hpp"
 #include "RomBrowserSearchWidget.hpp"
 #include "RomBrowserEmptyWidget.hpp"
 
-#include <QSortFilterProxyModel>
-#include <QStandardItemModel>
 #include <QStackedWidget>
 #include <QGridLayout>
 #include <QListWidget>
@@ -31,12 +33,9 @@
 #include <QString>
 #include <QList>
 #include <QMenu>
-#include <QPair>
+#include <QSet>
 #include <QMap>
 
-// forward declaration of internal struct
-struct RomBrowserModelData;
-
 namespace UserInterface
 {
 namespace Widget
@@ -51,6 +50,7 @@ class RomBrowserWidget : public QWidget
 
     void RefreshRomList(void);
     bool IsRefreshingRomList(void);
+    bool IsWatchingRomList(void);
     void StopRefreshRomList(void);
 
     void ShowList(void);
@@ -66,12 +66,10 @@ class RomBrowserWidget : public QWidget
     Widget::RomBrowserEmptyWidget*    emptyWidget    = nullptr;
     Widget::RomBrowserLoadingWidget*  loadingWidget  = nullptr;
 
+    // the list & grid view share the same model
+    Widget::RomBrowserModel* model                   = nullptr;
     Widget::RomBrowserListViewWidget* listViewWidget = nullptr;
-    QStandardItemModel* listViewModel                = nullptr;
-    QSortFilterProxyModel* listViewProxyModel        = nullptr;
     Widget::RomBrowserGridViewWidget* gridViewWidget = nullptr;
-    QStandardItemModel* gridViewModel                = nullptr;
-    QSortFilterProxyModel* gridViewProxyModel        = nullptr;
 
     Widget::RomBrowserSearchWidget* searchWidget = nullptr;
     bool showSearchWidget = false;
@@ -106,16 +104,14 @@ class RomBrowserWidget : public QWidget
     QAction* action_ColumnsMenuEntry;
 
     QString coversDirectory;
+    Widget::RomBrowserCoverLoader* coverLoader = nullptr;
 
-    QPair<QStandardItemModel*, QSortFilterProxyModel*> getCurrentModel(void);
     QAbstractItemView*  getCurrentModelView(void);
     bool getCurrentData(RomBrowserModelData& data);
 
     QString getCurrentRom(void);
 
-    void addRomData(QString file, CoreRomType type, CoreRomHeader header, CoreRomSettings settings);
-
-    QIcon getCurrentCover(QString file, CoreRomHeader header, CoreRomSettings settings, QString& coverFileName);
+    void updateCurrentWidget(void);
 
   protected:
     void timerEvent(QTimerEvent *event) Q_DECL_OVERRIDE;
@@ -140,6 +136,8 @@ class RomBrowserWidget : public QWidget
     void on_ZoomOut(void);
 
     void on_RomBrowserThread_RomsFound(QList<RomSearcherThreadData> data, int index, int count);
+    void on_RomBrowserThread_RomsChanged(QList<RomSearcherThreadData> data);
+    void on_RomBrowserThread_RomsRemoved(QList<QString> files);
     void on_RomBrowserThread_Finished(bool canceled);
 
     void on_Action_PlayGame(void);
@@ -0,0 +1,76 @@
+#!/usr/bin/env bash
+set -e
+script_dir="$(dirname "$0")"
+toplvl_dir="$(realpath "$script_dir/../../")"
+bin_dir="$toplvl_dir/Bin/Release"
+port="45000"
+vis="10000"
+latency="0"
+jitter="0"
+loss="0"
+input_delay="2"
+rollback="0"
+input=""
+rom=""
+
+# runs RMG-NetplayServer with two RMG-Bench netplay clients
+# and prints the netplay statistics of both clients,
+# RMG needs to be built with BENCH and NETPLAY_SERVER enabled
+while [[ $# -gt 0 ]]
+do
+    case "$1" in
+        -h|--help)
+            echo "$0 [--bin-dir <dir>] [--port <port>] [--vis <count>] [--latency <ms>] [--jitter <ms>]"
+            echo "    [--loss <percent>] [--input-delay <VIs>] [--rollback <frames>] [--input <file>] ROM"
+            exit
+            ;;
+        --bin-dir)     bin_dir="$2"; shift ;;
+        --port)        port="$2"; shift ;;
+        --vis)         vis="$2"; shift ;;
+        --latency)     latency="$2"; shift ;;
+        --jitter)      jitter="$2"; shift ;;
+        --loss)        loss="$2"; shift ;;
+        --input-delay) input_delay="$2"; shift ;;
+        --rollback)    rollback="$2"; shift ;;
+        --input)       input="$(realpath "$2")"; shift ;;
+        *)             rom="$(realpath "$1")" ;;
+    esac
+    shift
+done
+
+if [[ -z "$rom" ]]
+then
+    echo "$0: no ROM specified"
+    exit 1
+fi
+
+bench_args=(--vis "$vis" --netplay 127.0.0.1 --port "$port" --rollback "$rollback")
+if [[ -n "$input" ]]
+then
+    bench_args+=(--input "$input")
+fi
+
+output_dir="$(mktemp -d)"
+trap 'kill $server_pid 2>/dev/null || true; rm -rf "$output_dir"' EXIT
+
+"$bin_dir/RMG-NetplayServer" --port "$port" --players 2 --input-delay "$input_delay" \
+    --latency "$latency" --jitter "$jitter" --loss "$loss" > "$output_dir/server.txt" 2>&1 &
+server_pid=$!
+sleep 1
+
+"$bin_dir/RMG-Bench" "${bench_args[@]}" --player 1 "$rom" > "$output_dir/player1.txt" 2>&1 &
+player1_pid=$!
+"$bin_dir/RMG-Bench" "${bench_args[@]}" --player 2 "$rom" > "$output_dir/player2.txt" 2>&1 &
+player2_pid=$!
+
+ret=0
+wait $player1_pid || ret=1
+wait $player2_pid || ret=1
+
+for file in server player1 player2
+do
+    echo "== $file"
+    cat "$output_dir/$file.txt"
+done
+
+exit $ret